@@ -33,6 +33,10 @@ buffer used by the compiler to store all messages"
     "LLVM" # for now only possible value is LLVM
     LLVM)
 
+  rf_bool_option(${TARGET} OWNERSHIP_DOT
+    "Write the ownership graphs of each module to a plain DOT file. Does not need Graphviz."
+    FALSE)
+
   # try to find GraphViz and if requested, link to it
   find_package(GraphViz)
   if (${GRAPHVIZ_FOUND})
@@ -66,6 +70,9 @@ buffer used by the compiler to store all messages"
 
   # link with rfbase
   target_link_libraries(${TARGET} PUBLIC rfbase)
+  # function bodies of a module can be lowered to RIR in multiple threads
+  find_package(Threads REQUIRED)
+  target_link_libraries(${TARGET} PUBLIC Threads::Threads)
   # Let the compiler know the root directory. Used for finding the location of the
   # compiled librfbase when running the refu compiler itself
   target_compile_definitions(${TARGET} PUBLIC "RF_LANG_CORE_ROOT=\"${CMAKE_CURRENT_SOURCE_DIR}\"")
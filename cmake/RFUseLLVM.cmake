@@ -14,7 +14,7 @@ function(rf_use_llvm TARGET)
   target_include_directories(${TARGET} PUBLIC ${LLVM_INCLUDE_DIRS})
   message("LLVM DEFS: ${LLVM_DEFINITIONS}")
   target_compile_definitions(${TARGET} PUBLIC ${LLVM_DEFINITIONS})
-  llvm_map_components_to_libnames(llvm_libs core analysis executionengine interpreter native linker)
+  llvm_map_components_to_libnames(llvm_libs core analysis bitreader bitwriter executionengine interpreter mcjit native linker)
   target_link_libraries(${TARGET} PUBLIC ${llvm_libs})
   target_link_libraries(${TARGET} PUBLIC stdc++)
   target_compile_definitions(${TARGET} PUBLIC "RF_LLVM_VERSION=\"${LLVM_VERSION}\"")
@@ -8,11 +8,13 @@
 
 #include <utils/common.h>
 #include <module.h>
+#include <compiler_cache.h>
 
 struct compiler_args;
 struct serializer;
 struct rir;
 struct info_ctx;
+struct info_diag;
 
 struct compiler {
     //! An error buffer for the compiler
@@ -33,6 +35,12 @@ struct compiler {
     //! Pointer to the main front_ctxs
     struct front_ctx *main_front;
     struct RFstring llc_exec_path;
+    //! The value returned by the program's main() if it was run with --run
+    int run_retcode;
+    //! The on-disk cache of compiled executables
+    struct compiler_cache cache;
+    //! Writer of machine readable messages, if requested. NULL otherwise.
+    struct info_diag *diag;
 };
 
 // a compiler will always be a unique singleton so we can get its instance
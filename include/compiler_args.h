@@ -11,6 +11,9 @@
 
 #include <rfbase/string/xdecl.h>
 
+#include <info/diagnostics.h>
+#include <utils/stats.h>
+
 struct arg_file;
 struct arg_lit;
 struct arg_int;
@@ -35,6 +38,14 @@ struct compiler_args {
     struct arg_lit *input_rir;
     struct arg_lit *rir_print;
     struct arg_lit *llvm_ir_print;
+    struct arg_lit *jit_run;
+    struct arg_lit *interpret;
+    struct arg_lit *no_cache;
+    struct arg_lit *no_rir_opt;
+    struct arg_int *rir_jobs;
+    struct arg_rex *diagnostics_format;
+    struct arg_lit *time_passes;
+    struct arg_rex *stats_format;
     struct arg_file *positional_file;
     struct arg_end *end;
 };
@@ -67,6 +78,11 @@ bool compiler_args_help_is_requested(const struct compiler_args *args);
  */
 bool compiler_args_have_input(const struct compiler_args *args);
 
+/**
+ * Get the name of the requested backend or NULL if none was given
+ */
+const char *compiler_args_backend(const struct compiler_args *args);
+
 /**
  * Should we print backend llvm debug information?
  */
@@ -75,8 +91,59 @@ bool compiler_args_print_backend_debug(const struct compiler_args *args);
 bool compiler_args_print_llvm_ir(const struct compiler_args *args);
 
 bool compiler_args_print_rir(const struct compiler_args *args);
+/**
+ * Should we JIT compile and run the program in process instead of creating
+ * an executable?
+ */
+bool compiler_args_jit_run(const struct compiler_args *args);
+/**
+ * Should we run the program's RIR with the interpreter instead of creating
+ * an executable?
+ */
+bool compiler_args_interpret(const struct compiler_args *args);
 bool compiler_arg_input_is_rir(const struct compiler_args *args);
 
+/**
+ * Should the on-disk compilation cache be bypassed?
+ */
+bool compiler_args_no_cache(const struct compiler_args *args);
+
+/**
+ * Should the RIR optimization passes be skipped?
+ */
+bool compiler_args_no_rir_opt(const struct compiler_args *args);
+
+/**
+ * Get the number of threads that should lower function definitions to RIR
+ * and analyze their ownership.
+ * Always at least 1, which means no extra threads are created.
+ */
+unsigned compiler_args_rir_jobs(const struct compiler_args *args);
+
+/**
+ * Get the format in which compiler messages should be output
+ *
+ * @param format         Returns the format. Text if none was given.
+ * @return               false if the given format is not known
+ */
+bool compiler_args_diagnostics_format(const struct compiler_args *args,
+                                      enum info_diag_format *format);
+
+/**
+ * Should the time and counters of each compilation phase be printed?
+ */
+bool compiler_args_time_passes(const struct compiler_args *args);
+
+/**
+ * Get the format in which the phase statistics should be printed
+ */
+enum stats_format compiler_args_stats_format(const struct compiler_args *args);
+
+/**
+ * Get the requested verbosity level of the compiler
+ */
+int compiler_args_get_verbosity(const struct compiler_args *args);
+
 /**
  * Should we output the ast?
  *
@@ -0,0 +1,103 @@
+#ifndef LFR_COMPILER_CACHE_H
+#define LFR_COMPILER_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <rfbase/string/decl.h>
+
+struct compiler_args;
+
+/**
+ * An on-disk cache of compiled executables.
+ *
+ * Since all modules of a program are linked into a single LLVM module before
+ * code generation, the cached artifact is the final executable. Its key is a
+ * hash of the compiler version and build, the LLVM version, the arguments that
+ * change the generated code, the standard library source and the name and
+ * contents of every input file, so any change to a module or to one of its
+ * dependencies produces a different key.
+ *
+ * The cache lives under $XDG_CACHE_HOME/refu, or ~/.cache/refu if that is
+ * not set. It also holds the precompiled standard library bitcode, which
+ * is keyed by the compiler version and build, the arguments that change the
+ * generated code and the standard library source. The executable key is
+ * derived from it.
+ *
+ * Only the generated code of the standard library is precompiled. Its source
+ * is still parsed and analyzed for every compilation since the inputs are
+ * type checked against its declarations.
+ */
+struct compiler_cache {
+    //! Directory where the cached artifacts are stored
+    struct RFstring dir;
+    //! Hash of all the inputs of the current compilation
+    uint64_t key;
+    //! Hash of the compiler build, the arguments and the standard library source
+    uint64_t stdlib_key;
+    //! True if the cache directory exists and @ref dir is initialized
+    bool have_dir;
+    //! False if cached executables can't or should not be used for this compilation
+    bool enabled;
+    //! False if the precompiled standard library can't be used for this compilation
+    bool stdlib_enabled;
+    //! Number of times a cached artifact was used
+    unsigned hits;
+    //! Number of times an artifact was not found and had to be compiled
+    unsigned misses;
+    //! Number of times the precompiled standard library was used
+    unsigned stdlib_hits;
+    //! Number of times the standard library had to be lowered again
+    unsigned stdlib_misses;
+};
+
+/**
+ * Initialize the cache for the compilation described by @a args
+ *
+ * Failure to initialize only disables the cache.
+ *
+ * @param c          The cache to initialize
+ * @param args       The compiler arguments. Determine the inputs and whether
+ *                   the cache can be used at all.
+ * @param stdlib     Path to the standard library source, which is part of the key
+ */
+void compiler_cache_init(struct compiler_cache *c,
+                         struct compiler_args *args,
+                         const struct RFstring *stdlib);
+void compiler_cache_deinit(struct compiler_cache *c);
+
+/**
+ * Look for a cached executable and if found copy it to @a exe_name
+ *
+ * @return          true for a cache hit, false otherwise
+ */
+bool compiler_cache_fetch(struct compiler_cache *c, const struct RFstring *exe_name);
+
+/**
+ * Store the freshly compiled executable @a exe_name in the cache
+ */
+void compiler_cache_store(struct compiler_cache *c, const struct RFstring *exe_name);
+
+/**
+ * Get the path of the precompiled standard library bitcode
+ *
+ * Needs to be surrounded by RFS_PUSH()/RFS_POP().
+ *
+ * @return          A temporary null terminated string with the path or NULL
+ *                  if the precompiled standard library should not be used
+ */
+const struct RFstring *compiler_cache_stdlib_path(const struct compiler_cache *c);
+
+/**
+ * Record whether the precompiled standard library at
+ * compiler_cache_stdlib_path() could be used
+ */
+void compiler_cache_stdlib_loaded(struct compiler_cache *c, bool hit);
+
+/**
+ * Print cache hit/miss statistics if the verbosity level is high enough
+ */
+void compiler_cache_print_stats(const struct compiler_cache *c,
+                                const struct compiler_args *args);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef LFR_INFO_ARENA_H
+#define LFR_INFO_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <rfbase/datastructs/darray.h>
+
+//! Default size in bytes of each chunk of an info arena
+#define INFO_ARENA_CHUNK_SIZE 4096
+
+struct info_arena_chunk {
+    char *data;
+    size_t size;
+};
+
+/**
+ * Bump allocator for the messages of an info context and their arguments.
+ * Memory is never freed on its own but the arena can be rewound to a
+ * previous mark, which is what speculative parsing needs when it rolls back
+ * the messages it produced.
+ */
+struct info_arena {
+    struct {darray(struct info_arena_chunk);} chunks;
+    //! Index of the chunk allocations currently come from
+    unsigned int curr;
+    //! Bytes used in the current chunk
+    size_t used;
+};
+
+//! A position in an info arena to rewind to
+struct info_arena_mark {
+    unsigned int chunk;
+    size_t used;
+};
+
+void info_arena_init(struct info_arena *a);
+void info_arena_deinit(struct info_arena *a);
+
+/**
+ * @return @a size bytes from the arena, aligned for any type, or NULL in
+ *         failure
+ */
+void *info_arena_alloc(struct info_arena *a, size_t size);
+
+/**
+ * @return A copy of the first @a len bytes of @a s terminated with a null
+ *         character, or NULL in failure
+ */
+char *info_arena_strndup(struct info_arena *a, const char *s, size_t len);
+
+void info_arena_get_mark(const struct info_arena *a, struct info_arena_mark *m);
+/**
+ * Free everything allocated after @a m was taken. The chunks are kept for
+ * reuse.
+ */
+void info_arena_rewind(struct info_arena *a, const struct info_arena_mark *m);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef LFR_INFO_DIAGNOSTICS_H
+#define LFR_INFO_DIAGNOSTICS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+struct info_msg;
+struct inpfile;
+
+enum info_diag_format {
+    //! The human readable messages gathered and printed at the end
+    INFO_DIAG_FORMAT_TEXT = 0,
+    //! One JSON object per line for each message
+    INFO_DIAG_FORMAT_JSON,
+    //! A SARIF 2.1.0 log with one result for each message
+    INFO_DIAG_FORMAT_SARIF,
+};
+
+/**
+ * Writes the messages of all info contexts in a machine readable format as
+ * soon as they can no longer be rolled back.
+ *
+ * Lines and columns are written starting from 1. In both formats the end
+ * column of a message is the one right after its last character, as SARIF
+ * defines it.
+ */
+struct info_diag {
+    enum info_diag_format format;
+    //! Where to write. Not owned.
+    FILE *f;
+    //! Number of messages written so far
+    unsigned int written;
+    //! True once the closing part of the output has been written
+    bool ended;
+};
+
+struct info_diag *info_diag_create(enum info_diag_format format, FILE *f);
+/**
+ * End the output if not already done and free the writer
+ */
+void info_diag_destroy(struct info_diag *d);
+
+/**
+ * Write a message that refers to @a file
+ */
+bool info_diag_write(struct info_diag *d, struct info_msg *m, struct inpfile *file);
+
+/**
+ * Write what has to come after the last message, like the closing of the
+ * SARIF document. No messages can be written after this.
+ */
+void info_diag_end(struct info_diag *d);
+
+#endif
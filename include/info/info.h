@@ -7,6 +7,8 @@
 #include <rfbase/datastructs/intrusive_list.h>
 #include <rfbase/string/corex.h>
 
+#include <info/arena.h>
+
 enum info_msg_type {
     MESSAGE_ANY = 0xFF,
     MESSAGE_SEMANTIC_WARNING = 0x2,
@@ -19,16 +21,34 @@ enum info_msg_type {
 struct inplocation;
 struct inplocation_mark;
 struct info_msg;
+struct info_diag;
+
+//! What info_ctx_push() saves to roll back to
+struct info_ctx_state {
+    //! The last message at the time of the push
+    struct info_msg *last;
+    //! Where the arena was at the time of the push
+    struct info_arena_mark mark;
+};
 
 struct info_ctx {
     RFilist_head msg_list;
     size_t msg_num;
+    //! Number of messages of each type, indexed by info_msg_type_index()
+    size_t type_counts[INFO_MESSAGE_TYPES_NUM];
     int verbose_level;
     struct RFstringx buff;
     bool syntax_error; /* maybe to avoid searching the whole list? */
-    struct {darray(struct info_msg*);} last_msgs_arr;
+    struct {darray(struct info_ctx_state);} last_msgs_arr;
+    //! Where the messages and their arguments are allocated
+    struct info_arena arena;
     // a pointer to the file all the info messages will refer to (not owned)
     struct inpfile *file;
+    //! If set, messages are written to it as soon as they can no longer be
+    //! rolled back. Not owned.
+    struct info_diag *diag;
+    //! The last message written to @a diag
+    struct info_msg *diag_last;
 };
 
 
@@ -37,6 +57,11 @@ void info_ctx_destroy(struct info_ctx *ctx);
 
 void info_print_cond(int vlevel, const char *fmt, ...);
 
+/**
+ * Add a message to the info context. Formatting is deferred until the
+ * message is needed, so @a fmt must outlive the context. String literals,
+ * which is what all callers give, do.
+ */
 bool i_info_ctx_add_msg(struct info_ctx *ctx,
                         enum info_msg_type type,
                         const struct inplocation_mark *start,
@@ -75,6 +100,14 @@ i_INLINE_DECL void info_ctx_inject_input_file(struct info_ctx *ctx, struct inpfi
     ctx->file = f;
 }
 
+/**
+ * Stream the messages of the context to @a diag from now on
+ */
+i_INLINE_DECL void info_ctx_inject_diag(struct info_ctx *ctx, struct info_diag *diag)
+{
+    ctx->diag = diag;
+}
+
 /**
  * Gets all messages of a certain type, properly formatted and returns them
  * in the given RFstringx
@@ -1,6 +1,9 @@
 #ifndef LFR_INFO_MSG_H
 #define LFR_INFO_MSG_H
 
+#include <stdarg.h>
+#include <stdint.h>
+
 #include <rfbase/string.h>
 #include <rfbase/datastructs/intrusive_list.h>
 
@@ -9,9 +12,43 @@
 
 #define MSG_COORD_STR_BUFF 128
 
+struct info_arena;
+
+enum info_msg_arg_type {
+    INFO_MSG_ARG_SIGNED,
+    INFO_MSG_ARG_UNSIGNED,
+    INFO_MSG_ARG_DOUBLE,
+    INFO_MSG_ARG_LDOUBLE,
+    INFO_MSG_ARG_STRING,
+    INFO_MSG_ARG_POINTER,
+};
+
+//! A value given for a conversion of the format of a message
+struct info_msg_arg {
+    enum info_msg_arg_type type;
+    union {
+        intmax_t i;
+        uintmax_t u;
+        double d;
+        long double ld;
+        //! Copied to the arena, so it's fine if the original goes away
+        const char *s;
+        const void *p;
+    };
+};
+
 struct info_msg {
-    //! The actual message string
+    //! The actual message string. Only valid after info_msg_str() unless
+    //! @a fmt is NULL, in which case the message was given as a string.
     struct RFstring s;
+    //! The format of the message as given when adding it. Formatting is
+    //! deferred until the message is actually needed since many messages
+    //! get rolled back without ever being looked at.
+    const char *fmt;
+    //! The arguments for the conversions of @a fmt
+    struct info_msg_arg *args;
+    //! True if @a s got allocated by formatting the message
+    bool formatted;
     //! Can attach the message to a list
     RFilist_node ln;
     //! The type of the message. Either warning or error for now.
@@ -27,16 +64,36 @@ i_INLINE_DECL bool info_msg_has_end_mark(struct info_msg *msg)
     return msg->end_mark.p != NULL;
 }
 
-struct info_msg *info_msg_create(enum info_msg_type type,
+/**
+ * Create a message in @a arena, keeping the arguments it needs to be
+ * formatted later
+ *
+ * @param fmt        The printf-like format of the message. Should outlive the
+ *                   message, which string literals do.
+ */
+struct info_msg *info_msg_create(struct info_arena *arena,
+                                 enum info_msg_type type,
                                  const struct inplocation_mark *start,
                                  const struct inplocation_mark *end,
                                  const char *fmt,
                                  va_list args);
+/**
+ * Release what the message holds outside of the arena it was created in
+ */
 void info_msg_destroy(struct info_msg *m);
 void info_msg_print(struct info_msg *m, FILE *f, struct inpfile *input_file);
 
+/**
+ * @return The text of the message, formatting it if not done yet
+ */
+const struct RFstring *info_msg_str(struct info_msg *m);
+
 bool info_msg_get_formatted(struct info_msg *m, struct RFstringx *s,
                             struct inpfile *input_file);
 
+/**
+ * @return The position of @a type in [0, INFO_MESSAGE_TYPES_NUM)
+ */
+unsigned int info_msg_type_index(enum info_msg_type type);
 const struct RFstring *info_msg_type_to_str(enum info_msg_type type);
 #endif
@@ -53,6 +53,7 @@ enum rir_token_type {
     RIR_TOK_RETURN,
     RIR_TOK_BRANCH,
     RIR_TOK_CONDBRANCH,
+    RIR_TOK_SWITCH,
     RIR_TOK_CONVERT,
     RIR_TOK_WRITE,
     RIR_TOK_READ,
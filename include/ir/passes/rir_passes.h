@@ -0,0 +1,63 @@
+#ifndef LFR_IR_PASSES_RIR_PASSES_H
+#define LFR_IR_PASSES_RIR_PASSES_H
+
+#include <stdbool.h>
+
+struct compiler;
+struct compiler_args;
+struct rir;
+
+//! Number of passes in the optimization pipeline
+#define RIR_PASSES_NUM 7
+
+/**
+ * Statistics of one pass of the pipeline, summed over all the functions it
+ * ran on
+ */
+struct rir_pass_stats {
+    //! Name of the pass
+    const char *name;
+    //! Number of expressions before the pass ran
+    unsigned expressions_before;
+    //! Number of expressions after the pass ran
+    unsigned expressions_after;
+    //! Number of changes the pass made
+    unsigned changes;
+};
+
+struct rir_passes_stats {
+    struct rir_pass_stats passes[RIR_PASSES_NUM];
+};
+
+void rir_passes_stats_init(struct rir_passes_stats *stats);
+
+/**
+ * Run the optimization pipeline over all the functions of a rir module
+ *
+ * The pipeline is inlining of small functions, constant folding, promotion
+ * of local variables to SSA values, constant folding again for what got
+ * exposed by the promotion, elimination of aggregate copies into the return
+ * slot, dead code elimination that removes what the other passes left unused
+ * and finally loop optimization on the SSA form.
+ *
+ * @param r          The rir module to optimize
+ * @param stats      Statistics of each pass are added here
+ * @return           true for success and false for failure
+ */
+bool rir_passes_run_module(struct rir *r, struct rir_passes_stats *stats);
+
+/**
+ * Run the optimization pipeline over all the modules created from source
+ *
+ * Does nothing if the passes are disabled by the compiler arguments.
+ */
+bool rir_passes_run(struct compiler *c);
+
+/**
+ * Print per pass expression and change counts if the verbosity level is
+ * high enough. The time of each pass is shown by --time-passes.
+ */
+void rir_passes_print_stats(const struct rir_passes_stats *stats,
+                            const struct compiler_args *args);
+
+#endif
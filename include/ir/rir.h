@@ -1,6 +1,8 @@
 #ifndef LFR_IR_RIR
 #define LFR_IR_RIR
 
+#include <pthread.h>
+
 #include <rfbase/datastructs/intrusive_list.h>
 #include <rfbase/datastructs/darray.h>
 #include <rfbase/string/decl.h>
@@ -20,6 +22,10 @@ struct rir_type;
 
 //! The size in bytes of the rir types memory pool
 #define RIR_TYPES_POOL_CHUNK_SIZE 2048
+//! The number of elements per chunk of the rir objects memory pool
+#define RIR_OBJECTS_POOL_CHUNK_SIZE 1024
+//! The number of elements per chunk of the free standing rir values memory pool
+#define RIR_VALUES_POOL_CHUNK_SIZE 256
 
 struct rir_arr {darray(struct rir*);};
 struct rir {
@@ -29,12 +35,18 @@ struct rir {
     struct rf_fixed_memorypool *types_pool;
     //! Map of all global string literals of the module
     struct rirobj_strmap global_literals;
-    //! Pointers to values that don't belong to any rir object. Will be destroyed at the end
-    struct {darray(struct rir_value*);} free_values;
+    //! Memory pool for values that don't belong to any rir object.
+    //! They are all released together with the module.
+    struct rf_fixed_memorypool *values_pool;
+    //! Memory pool for all rir objects of the module, including blocks
+    struct rf_fixed_memorypool *objects_pool;
     //! List of function declarations/definitions
     struct RFilist_head functions;
-    //! List of type definitions
+    //! List of the type definitions owned by this module
     struct RFilist_head typedefs;
+    //! Type definitions of dependencies this module refers to. They are owned
+    //! by the module that created them and are only declared by this one.
+    struct {darray(struct rir_typedef*);} imported_typedefs;
     //! List of all rir objects
     struct RFilist_head objects;
     //! A dynamic array of all other rir modules this rir module depends on
@@ -49,6 +61,13 @@ struct rir {
     struct rirtype_strmap types_map;
     //! Map from strings to rir objects.
     struct rirobj_strmap map;
+    //! Guards @a objects, @a objects_pool and @a values_pool while the
+    //! functions of the module are being lowered concurrently
+    pthread_mutex_t objects_lock;
+    //! Guards @a types_map and @a rir_types_pool
+    pthread_mutex_t types_lock;
+    //! Guards @a global_literals and @a map. Taken before any other lock.
+    pthread_mutex_t globals_lock;
 };
 
 struct RFstring *rir_tostring(struct rir *r);
@@ -70,7 +89,13 @@ struct rir_typedef *rir_typedef_byname(const struct rir *r, const struct RFstrin
 struct rir_type *rir_type_byname(struct rir *r, const struct RFstring *name);
 struct rir_object *rir_strlit_obj(const struct rir *r, const struct ast_node *lit);
 
-void rir_freevalues_add(struct rir *r, struct rir_value *v);
+/**
+ * Allocate a value that does not belong to any rir object
+ *
+ * @return             A zeroed value that lives as long as the module or NULL
+ *                     for failure. It is never freed on its own.
+ */
+struct rir_value *rir_freevalue_alloc(struct rir *r);
 
 
 /**
@@ -0,0 +1,118 @@
+#ifndef LFR_IR_RIR_BINARY_H
+#define LFR_IR_RIR_BINARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rfbase/datastructs/darray.h>
+
+struct RFstring;
+struct rir;
+struct rir_arr;
+struct rir_fndef;
+
+/**
+ * Binary representation of a RIR module
+ *
+ * The module is serialized as an array of 32-bit words in host byte order.
+ * It starts with a header describing the sections that follow it:
+ *
+ *  + strings:   A table of string offsets into a blob holding every string
+ *               of the module exactly once. All names, identifiers and
+ *               literals are references into this table.
+ *  + types:     Fixed size records, one for each distinct rir type. Array
+ *               types refer to their member type and composite types to
+ *               their typedef by index.
+ *  + typedefs:  Offsets into the data section, one for each typedef.
+ *  + globals:   Fixed size records of the global string literals.
+ *  + functions: Fixed size records of the declarations and definitions. A
+ *               definition points to a separate section of the data holding
+ *               its body, so that bodies can be materialized on demand.
+ *  + deps:      The names of the modules this module depends on.
+ *  + data:      Variable length records referred to by the tables above.
+ *
+ * Inside a function's section values are referred to by dense indices in
+ * the order: arguments, return slot, block labels and then the expressions
+ * with a value in the order they are stored. Expressions are stored so that
+ * their operands always come first, with the exception of phi incoming
+ * values which are resolved after all expressions have been loaded.
+ * Constants are stored inline and globals by name. Expressions also keep
+ * the integer id of their value so that printing the loaded rir gives back
+ * the same identifiers.
+ */
+
+//! Version of the binary rir format. Bump on any change to the layout.
+#define RIR_BINARY_VERSION 2
+
+struct rir_binary_buff {darray(uint32_t);};
+
+/**
+ * Serialize a rir module into a word buffer
+ *
+ * @param r            The rir module to serialize
+ * @param buff         An initialized buffer. Any previous contents are
+ *                     replaced by the serialized module
+ * @return             true for success and false for failure
+ */
+bool rir_binary_serialize(struct rir *r, struct rir_binary_buff *buff);
+
+/**
+ * Serialize a rir module and write it to a file with a single write
+ */
+bool rir_binary_write(struct rir *r, const struct RFstring *path);
+
+struct rir_binary;
+
+/**
+ * Map a binary rir file into memory and load its declarations
+ *
+ * The typedefs, globals and function declarations of the module are
+ * created immediately. Function definitions get their arguments and
+ * return slot but no blocks until they are materialized.
+ *
+ * @param path         The path to the binary rir file
+ * @param deps         The rir modules the module may depend on. The
+ *                     dependencies are looked up by name. Can be NULL.
+ * @return             The opened binary or NULL for failure
+ */
+struct rir_binary *rir_binary_open(const struct RFstring *path, const struct rir_arr *deps);
+
+/**
+ * Same as rir_binary_open() but with the serialized module already in
+ * memory. @a data should be aligned to 4 bytes and must outlive the
+ * returned binary.
+ */
+struct rir_binary *rir_binary_open_buffer(const void *data,
+                                          size_t size,
+                                          const struct rir_arr *deps);
+
+/**
+ * Unmap the binary. The rir module is not destroyed and belongs to the
+ * caller. Function bodies that were not materialized remain empty.
+ */
+void rir_binary_close(struct rir_binary *rb);
+
+/**
+ * @return the rir module loaded from the binary
+ */
+struct rir *rir_binary_rir(const struct rir_binary *rb);
+
+/**
+ * Load the body of a function definition of the binary's module.
+ * Does nothing if the body has already been materialized.
+ */
+bool rir_binary_materialize(struct rir_binary *rb, struct rir_fndef *fn);
+/**
+ * Load the bodies of all function definitions that are still pending
+ */
+bool rir_binary_materialize_all(struct rir_binary *rb);
+
+/**
+ * Open a binary rir file, materialize all of it and close it
+ *
+ * @return             The loaded rir module or NULL for failure
+ */
+struct rir *rir_binary_load(const struct RFstring *path, const struct rir_arr *deps);
+
+#endif
@@ -17,6 +17,7 @@ enum rir_block_exit_type {
     RIR_BLOCK_EXIT_BRANCH,
     RIR_BLOCK_EXIT_CONDBRANCH,
     RIR_BLOCK_EXIT_RETURN,
+    RIR_BLOCK_EXIT_SWITCH,
 };
 
 struct rir_block_exit {
@@ -25,6 +26,7 @@ struct rir_block_exit {
         struct rir_return retstmt;
         struct rir_branch branch;
         struct rir_condbranch condbranch;
+        struct rir_switch switchbr;
     };
 };
 
@@ -44,6 +46,15 @@ bool rir_block_exit_init_condbranch(
     struct rir_value *taken,
     struct rir_value *fallthrough
 );
+/**
+ * Initialize a block exit as a switch with no cases.
+ * Add cases with rir_switch_add_case() on @c exit->switchbr
+ */
+bool rir_block_exit_init_switch(
+    struct rir_block_exit *exit,
+    const struct rir_value *cond,
+    struct rir_value *fallthrough
+);
 void rir_block_exit_return_init(
     struct rir_block_exit *exit,
     const struct rir_value *val
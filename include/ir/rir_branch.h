@@ -2,6 +2,10 @@
 #define LFR_IR_RIR_BRANCH_H
 
 #include <stdbool.h>
+#include <stdint.h>
+
+#include <rfbase/defs/inline.h>
+#include <rfbase/datastructs/darray.h>
 
 struct rirtostr_ctx;
 struct rir_block;
@@ -9,6 +13,9 @@ struct rir_expression;
 
 struct rir_branch {
     struct rir_value *dst;
+    //! True if this is the back edge of an innermost loop with a known
+    //! induction variable, which the backend marks for vectorization
+    bool vectorize;
 };
 
 bool rir_branch_init(struct rir_branch *b, struct rir_value *dst);
@@ -35,4 +42,37 @@ struct rir_condbranch *rir_condbranch_create(const struct rir_value *cond,
 void rir_condbranch_deinit(struct rir_condbranch *b);
 void rir_condbranch_destroy(struct rir_condbranch *b);
 bool rir_condbranch_tostring(struct rirtostr_ctx *ctx, const struct rir_condbranch *b);
+
+struct rir_switch_case {
+    //! The constant value the switch condition is compared against
+    const struct rir_value *val;
+    //! The label to jump to if the condition equals @ref val
+    struct rir_value *dst;
+};
+
+/**
+ * A multiway branch. Compares an integer value against a number of
+ * constants and jumps to the label of the case that matches or to the
+ * fallthrough label if none does. Lets the backend choose between a
+ * jump table and a compare tree instead of a linear chain of condbranches.
+ */
+struct rir_switch {
+    const struct rir_value *cond;
+    struct rir_value *fallthrough;
+    struct {darray(struct rir_switch_case);} cases;
+};
+
+bool rir_switch_init(struct rir_switch *sw,
+                     const struct rir_value *cond,
+                     struct rir_value *fallthrough);
+void rir_switch_add_case(struct rir_switch *sw,
+                         const struct rir_value *val,
+                         struct rir_value *dst);
+void rir_switch_deinit(struct rir_switch *sw);
+bool rir_switch_tostring(struct rirtostr_ctx *ctx, const struct rir_switch *sw);
+
+i_INLINE_DECL unsigned rir_switch_cases_num(const struct rir_switch *sw)
+{
+    return darray_size(sw->cases);
+}
 #endif
@@ -0,0 +1,175 @@
+#ifndef LFR_IR_RIR_CODE_H
+#define LFR_IR_RIR_CODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <rfbase/defs/inline.h>
+#include <rfbase/datastructs/darray.h>
+
+struct rir;
+struct rir_block;
+struct rir_expression;
+struct rir_fndef;
+struct rir_value;
+
+//! Number of operands kept inside an instruction. Instructions with more,
+//! like calls, keep them in @ref rir_code::extra_ops.
+#define RIR_INSTR_INLINE_OPS 2
+//! Marks the absence of an index
+#define RIR_CODE_NONE UINT32_MAX
+//! Set in @ref rir_use::user when the use is the exit of a block. The rest
+//! of the bits are the index of the block.
+#define RIR_CODE_EXIT_USER 0x80000000u
+
+/**
+ * An expression in the dense form. Operands are indices into the value
+ * table of @ref rir_code.
+ */
+struct rir_instr {
+    //! The type of the expression. A value of enum rir_expression_type.
+    uint16_t op;
+    uint16_t ops_num;
+    //! Index of the block holding the instruction
+    uint32_t block;
+    //! The operands if there are at most RIR_INSTR_INLINE_OPS of them.
+    //! Otherwise ops[0] is the offset of the operands in
+    //! @ref rir_code::extra_ops.
+    uint32_t ops[RIR_INSTR_INLINE_OPS];
+    //! The expression the instruction stands for, holding everything that
+    //! is not an operand, like types and names
+    struct rir_expression *expr;
+};
+
+/**
+ * The instructions of a block, stored consecutively
+ */
+struct rir_code_block {
+    struct rir_block *block;
+    //! Index of the first instruction
+    uint32_t first;
+    uint32_t num;
+    //! The operand of the block's exit or RIR_CODE_NONE if it has none
+    uint32_t exit_op;
+};
+
+/**
+ * A use of a variable of the function
+ */
+struct rir_use {
+    //! The field of the expression or block exit holding the value
+    const struct rir_value **operand;
+    //! The operand in the dense form
+    uint32_t *slot;
+    //! Index of the using instruction or RIR_CODE_EXIT_USER | block index
+    uint32_t user;
+    //! Next use of the same value or RIR_CODE_NONE
+    uint32_t next;
+};
+
+/**
+ * A dense view of the code of a function
+ *
+ * The instructions of all blocks are stored in one array, block after block,
+ * each with its operands inline. Every variable of the function has a list
+ * of its uses so that replacing it does not need to go through the whole
+ * function.
+ *
+ * It is a snapshot: the function must only be changed through the functions
+ * below while it is alive. Removing expressions is done by killing their
+ * instructions, which keeps indices stable.
+ */
+struct rir_code {
+    struct rir_fndef *fn;
+    struct {darray(struct rir_instr);} instrs;
+    //! One entry per block of the function, in the same order
+    struct {darray(struct rir_code_block);} blocks;
+    //! Operands of instructions with more than RIR_INSTR_INLINE_OPS of them
+    struct {darray(uint32_t);} extra_ops;
+    //! The values operands refer to. Variables sit at the index of their id,
+    //! constants and literals follow.
+    struct {darray(const struct rir_value*);} values;
+    //! Per variable, the index of the instruction computing it or RIR_CODE_NONE
+    struct {darray(uint32_t);} defs;
+    //! Per variable, the index of its first use in @ref uses or RIR_CODE_NONE
+    struct {darray(uint32_t);} first_use;
+    //! Per variable, the number of its uses
+    struct {darray(uint32_t);} uses_num;
+    struct {darray(struct rir_use);} uses;
+    //! Number of variables of the function, the first entries of @ref values
+    uint32_t vars_num;
+};
+
+bool rir_code_init(struct rir_code *c, struct rir_fndef *fn);
+void rir_code_deinit(struct rir_code *c);
+
+i_INLINE_DECL const struct rir_value *rir_code_value(const struct rir_code *c, uint32_t idx)
+{
+    return darray_item(c->values, idx);
+}
+
+i_INLINE_DECL const uint32_t *rir_instr_ops(const struct rir_code *c,
+                                            const struct rir_instr *i)
+{
+    return i->ops_num > RIR_INSTR_INLINE_OPS
+        ? &darray_item(c->extra_ops, i->ops[0])
+        : i->ops;
+}
+
+i_INLINE_DECL const struct rir_value *rir_instr_operand(const struct rir_code *c,
+                                                        const struct rir_instr *i,
+                                                        unsigned n)
+{
+    return rir_code_value(c, rir_instr_ops(c, i)[n]);
+}
+
+/**
+ * @return true if the instruction's expression got removed
+ */
+i_INLINE_DECL bool rir_instr_is_dead(const struct rir_instr *i)
+{
+    return i->expr == NULL;
+}
+
+/**
+ * @return The number of uses of a variable value, 0 for other values
+ */
+uint32_t rir_code_uses_num(const struct rir_code *c, const struct rir_value *v);
+
+/**
+ * @return The instruction computing a variable or NULL if it is not
+ *         computed by an expression of the function, like an argument
+ */
+struct rir_instr *rir_code_def(const struct rir_code *c, const struct rir_value *v);
+
+/**
+ * Make every use of the variable @a from a use of @a to, both in the dense
+ * form and in the rir expressions. Takes time proportional to the uses
+ * of @a from.
+ */
+bool rir_code_replace_uses(struct rir_code *c,
+                           const struct rir_value *from,
+                           const struct rir_value *to);
+
+/**
+ * Remove the expression of an instruction from its block and free it. Its
+ * value must have no uses left.
+ *
+ * @param c            The code of the function
+ * @param i            The instruction to kill
+ * @param r            The module the function belongs to
+ */
+void rir_code_kill(struct rir_code *c, struct rir_instr *i, struct rir *r);
+
+/**
+ * Iterate the instructions of a block, including the dead ones
+ *
+ * @param code_        The struct rir_code
+ * @param cblock_      The struct rir_code_block whose instructions to visit
+ * @param instr_       A struct rir_instr pointer iterator
+ */
+#define rir_code_foreach_block_instr(code_, cblock_, instr_)            \
+    for (instr_ = (code_)->instrs.item + (cblock_)->first;              \
+         instr_ < (code_)->instrs.item + (cblock_)->first + (cblock_)->num; \
+         ++instr_)
+#endif
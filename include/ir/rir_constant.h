@@ -4,11 +4,15 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <types/type_decls.h>
+
 struct ast_node;
 struct rir_expression;
 struct rir_value;
 struct rir_ctx;
 struct rir;
+struct rir_type;
+struct ast_constant;
 struct rirtostr_ctx;
 
 struct rir_object *rir_constant_create_obj(const struct ast_node *c, struct rir_ctx *ctx);
@@ -30,6 +34,33 @@ bool rir_constantval_init_fromint64(struct rir_value *v, struct rir *r, int64_t
 struct rir_value *rir_constantval_create_fromint32(int32_t n, struct rir* r);
 bool rir_constantval_init_fromint32(struct rir_value *v, struct rir *r, int32_t n);
 
+/**
+ * Create a rir constant value of a specific elementary type
+ *
+ * Just like @ref rir_constantval_create_fromint64() the value is stored under
+ * the given rir module so that it can later be freed.
+ *
+ * @param c        The constant to create the value from
+ * @param t        The elementary type of the value
+ * @param r        The rir module object under which the value will be stored.
+ * @return         A pointer to the allocated value
+ */
+struct rir_value *rir_constantval_create_typed(const struct ast_constant *c,
+                                               struct rir_type *t,
+                                               struct rir *r);
+
+/**
+ * Bring an integer to the width of an elementary type the way the LLVM
+ * backend sees it. Signed types are sign extended, unsigned ones zero
+ * extended and booleans are one bit.
+ */
+int64_t rir_constant_int_to_width(int64_t v, enum elementary_type etype);
+/**
+ * Bring an integer to the width of an elementary type, always sign extending
+ * it as the backend does for integer comparisons
+ */
+int64_t rir_constant_int_to_signed_width(int64_t v, enum elementary_type etype);
+
 const struct RFstring *rir_constant_string(const struct rir_value *val);
 bool rir_constant_tostring(struct rirtostr_ctx *ctx, const struct rir_expression *e);
 
@@ -8,6 +8,7 @@
 #include <ast/constants_decls.h>
 #include <ir/rir_value.h>
 #include <ir/rir_argument.h>
+#include <ir/rir_phi.h>
 
 struct ast_node;
 struct rir;
@@ -41,6 +42,7 @@ enum rir_expression_type {
     RIR_EXPRESSION_CMP_LT,
     RIR_EXPRESSION_LOGIC_AND,
     RIR_EXPRESSION_LOGIC_OR,
+    RIR_EXPRESSION_PHI,
     // PLACEHOLDER, should not make it into any expression type
     RIR_EXPRESSION_PLACEHOLDER
 };
@@ -145,6 +147,9 @@ struct rir_getunionidx {
 struct rir_objidx {
     const struct rir_value *objmemory;
     const struct rir_value *idx;
+    //! True if the index is known to be inside the array, as for the index
+    //! of a loop over the array's members
+    bool inbounds;
 };
 
 struct rir_fixedarr {
@@ -266,6 +271,7 @@ struct rir_expression {
         struct rir_write write;
         struct rir_fixedarr fixedarr;
         struct rir_fixedarrsize fixedarrsize;
+        struct rir_phi phi;
     };
     struct rir_value val;
     // Control to be added to expression list of a rir block
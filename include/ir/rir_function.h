@@ -82,13 +82,35 @@ struct rir_fndef {
     struct rir_value *retslot_val;
     //! Label pointing to the function's end
     struct rir_value *end_label;
-    //! Stringmap from rir identifiers to rir objects
+    //! Stringmap from the names of labels to their block objects
     struct rirobj_strmap map;
+    //! Objects of the function's variables indexed by their value's id.
+    //! Slots of removed variables are NULL.
+    struct {darray(struct rir_object*);} values;
     //! Pointer to the symbol table of the function's arguments
     struct symbol_table *st;
 };
 
 struct rir_fndef *rir_fndef_create_from_ast(const struct ast_node *n, struct rir_ctx *ctx);
+/**
+ * Create a function definition from the AST, without lowering its body.
+ * Creates the argument variables and the return slot.
+ *
+ * @param n            The function implementation AST node
+ * @param ctx          The rir context
+ * @return             The definition or NULL for failure. Its body has to be
+ *                     created with rir_fndef_body_from_ast().
+ */
+struct rir_fndef *rir_fndef_create_decl_from_ast(const struct ast_node *n, struct rir_ctx *ctx);
+/**
+ * Lower the body of a function created with rir_fndef_create_decl_from_ast()
+ *
+ * Touches only @a def and the module's shared pools and maps so bodies of
+ * different functions can be lowered concurrently, each with its own @a ctx.
+ */
+bool rir_fndef_body_from_ast(struct rir_fndef *def,
+                             const struct ast_node *n,
+                             struct rir_ctx *ctx);
 /**
  * Initialize a function definition, without touching the declaration part.
  * The declation member of @a def must have already been initialized.
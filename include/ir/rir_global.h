@@ -31,7 +31,7 @@ bool rir_global_tostring(struct rirtostr_ctx *ctx, const struct rir_global *g);
 
 i_INLINE_DECL const struct RFstring *rir_global_name(const struct rir_global *g)
 {
-    return &g->val.id;
+    return &g->val.name;
 }
 
 i_INLINE_DECL struct rir_type *rir_global_type(const struct rir_global *g)
@@ -0,0 +1,114 @@
+#ifndef LFR_IR_RIR_INTERP_H
+#define LFR_IR_RIR_INTERP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <rfbase/string/decl.h>
+
+struct ast_constant;
+struct rir;
+struct rir_fndef;
+struct rir_type;
+struct rir_value;
+
+/**
+ * An interpreter executing RIR directly, without going through a backend
+ *
+ * Memory is modeled in cells. Every elementary value, including a string,
+ * occupies one cell. A struct occupies the cells of its members in order, a
+ * union one cell for its selector followed by the cells of its biggest
+ * member and an array the cells of its members one after the other.
+ *
+ * Strings, composites and arrays are always handled through a pointer to
+ * their cells, just like the backend passes them by reference.
+ *
+ * Each function is translated once, when it is first called, into a compact
+ * form whose operands are indices into a register file. Registers and
+ * the memory of allocas live in frames on a cell stack owned by the
+ * interpreter.
+ */
+struct rir_interp;
+
+union rir_interp_cell {
+    //! Integers, kept sign extended for signed types and zero extended for
+    //! unsigned types. Booleans are 0 or 1.
+    int64_t i;
+    uint64_t u;
+    double f;
+    struct RFstring s;
+    union rir_interp_cell *ptr;
+};
+
+/**
+ * Create an interpreter for a rir module
+ *
+ * @param r            The module whose functions to run. Calls to functions
+ *                     not defined in it are looked up in its dependencies.
+ * @return             The interpreter or NULL for failure
+ */
+struct rir_interp *rir_interp_create(struct rir *r);
+void rir_interp_destroy(struct rir_interp *in);
+
+/**
+ * Limit the number of blocks a single rir_interp_call() may execute.
+ * 0, the default, means no limit.
+ */
+void rir_interp_set_step_limit(struct rir_interp *in, uint64_t steps);
+
+/**
+ * @return A description of the reason the last call failed
+ */
+const char *rir_interp_error(const struct rir_interp *in);
+
+/**
+ * @return The definition of a function named @a name in the interpreter's
+ *         module or its dependencies or NULL if there is none
+ */
+const struct rir_fndef *rir_interp_fndef(const struct rir_interp *in,
+                                         const struct RFstring *name);
+
+/**
+ * Call a function
+ *
+ * @param in           The interpreter
+ * @param fn           The function to call
+ * @param args         One cell per argument of @a fn
+ * @param ret          The return value of the function is placed here. For
+ *                     types handled by reference the pointed to cells are
+ *                     only valid until the next call.
+ * @return             true for success and false if the function could
+ *                     not be executed. @see rir_interp_error()
+ */
+bool rir_interp_call(struct rir_interp *in,
+                     const struct rir_fndef *fn,
+                     const union rir_interp_cell *args,
+                     union rir_interp_cell *ret);
+
+/**
+ * Run the main() function of the interpreter's module
+ *
+ * @param in           The interpreter
+ * @param retcode      The value returned by main() is placed here
+ * @return             true for success and false for failure
+ */
+bool rir_interp_run_main(struct rir_interp *in, int *retcode);
+
+/**
+ * @return true if calling @a fn has no effect other than computing its
+ *         return value and both its arguments and return value are
+ *         elementary values that can be folded into constants
+ */
+bool rir_interp_fn_is_pure(struct rir_interp *in, const struct rir_fndef *fn);
+
+/**
+ * Load a constant value into a cell
+ */
+void rir_interp_cell_from_constant(union rir_interp_cell *c, const struct rir_value *v);
+/**
+ * Turn a cell holding an elementary value of type @a t into a constant
+ */
+void rir_interp_cell_to_constant(const union rir_interp_cell *c,
+                                 const struct rir_type *t,
+                                 struct ast_constant *out);
+#endif
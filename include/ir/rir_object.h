@@ -34,8 +34,25 @@ struct rir_object {
     struct RFilist_node ln;
 };
 
+/**
+ * Allocate a zeroed rir object from the module's pool and add it to the list
+ * of all rir objects of the module
+ */
 struct rir_object *rir_object_create(enum rir_obj_category category, struct rir *r);
-void rir_object_destroy(struct rir_object *obj);
+/**
+ * Free the resources held by a rir object but not its memory, which belongs
+ * to the module's pool
+ */
+void rir_object_deinit(struct rir_object *obj);
+/**
+ * Deinitialize a rir object and return its memory to the module's pool
+ */
+void rir_object_destroy(struct rir_object *obj, struct rir *r);
+/**
+ * Remove an object that failed to initialize from the module's object list
+ * and return its memory to the pool. Nothing inside it is freed.
+ */
+void rir_object_free(struct rir_object *obj, struct rir *r);
 
 struct rir_value *rir_object_value(struct rir_object *obj);
 
@@ -0,0 +1,63 @@
+#ifndef LFR_IR_RIR_PHI_H
+#define LFR_IR_RIR_PHI_H
+
+#include <stdbool.h>
+
+#include <rfbase/defs/inline.h>
+#include <rfbase/datastructs/darray.h>
+
+#include <ir/rir_common.h>
+
+struct rirtostr_ctx;
+struct rir_expression;
+struct rir_value;
+struct rir_type;
+
+struct rir_phi_incoming {
+    //! The value the phi takes when control comes from @ref block
+    const struct rir_value *val;
+    //! The label of the predecessor block
+    const struct rir_value *block;
+};
+
+/**
+ * Selects a value depending on the block control came from. Only created
+ * by the SSA construction pass and always at the start of a block.
+ */
+struct rir_phi {
+    //! The type of the phi's value. Same for all incoming values
+    const struct rir_type *type;
+    //! One entry per predecessor edge of the containing block
+    struct {darray(struct rir_phi_incoming);} incoming;
+};
+
+/**
+ * Create a phi expression with no incoming values.
+ * Add them with rir_phi_add_incoming().
+ *
+ * @param type           The elementary, non pointer type of the phi value
+ * @param pos            Denotes which code module the function is called from.
+ * @param data           The rir data. @see rir_value_variable_init()
+ */
+struct rir_object *rir_phi_create_obj(
+    const struct rir_type *type,
+    enum rir_pos pos,
+    rir_data data
+);
+struct rir_expression *rir_phi_create(
+    const struct rir_type *type,
+    enum rir_pos pos,
+    rir_data data
+);
+
+void rir_phi_add_incoming(struct rir_phi *phi,
+                          const struct rir_value *val,
+                          const struct rir_value *block);
+void rir_phi_deinit(struct rir_phi *phi);
+bool rir_phi_tostring(struct rirtostr_ctx *ctx, const struct rir_expression *e);
+
+i_INLINE_DECL unsigned rir_phi_incoming_num(const struct rir_phi *phi)
+{
+    return darray_size(phi->incoming);
+}
+#endif
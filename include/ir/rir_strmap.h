@@ -4,6 +4,8 @@
 #include <rfbase/datastructs/strmap.h>
 #include <rfbase/defs/inline.h>
 
+#include <stdint.h>
+
 struct symbol_table_record;
 struct rir_common;
 struct rir_block;
@@ -61,7 +63,22 @@ bool rir_map_addobj(struct rir_common *c,
                     const struct RFstring *id,
                     struct rir_object *obj);
 
+/**
+ * Add the object of a variable to the current function's values
+ *
+ * @param common         The common rir data containing the current function
+ * @param id             The id of the variable's value
+ * @param obj            The rir object to add
+ * @return               false if there is no current function or if a
+ *                       variable with that id already exists in it
+ */
+bool rir_map_addvar(struct rir_common *c, uint32_t id, struct rir_object *obj);
+
 
+/**
+ * Get the object of a rir identifier. Variables such as "$3" are looked up in
+ * the current function's values and anything else in the string maps.
+ */
 struct rir_object *rir_map_getobj(struct rir_common *c,
                                   const struct RFstring *id);
 struct rir_type *rirtype_strmap_get(struct rirtype_strmap *map, const struct RFstring *id);
@@ -3,11 +3,16 @@
 
 #include <stdbool.h>
 #include <rfbase/datastructs/darray.h>
+#include <rfbase/datastructs/htable.h>
 #include <ir/rir_argument.h>
 
 struct rir_ctx;
 struct rir_fndef;
 struct type;
+struct rf_fixed_memorypool;
+
+//! The number of entries per chunk of the typedef registry memory pool
+#define RIR_TYPEDEF_REGISTRY_CHUNK_SIZE 128
 
 struct rir_typedef {
     struct RFstring name;
@@ -17,8 +22,39 @@ struct rir_typedef {
     struct RFilist_node ln;
 };
 
+/**
+ * Program-wide registry of the typedefs created from the types of the modules
+ *
+ * A typedef is created once, by the first module whose types contain it, and
+ * is then shared by identity with every module depending on that one.
+ */
+struct rir_typedef_registry {
+    //! Entries hashed by the address of the type they were created from
+    struct htable table;
+    struct rf_fixed_memorypool *pool;
+};
+
+bool rir_typedef_registry_init(struct rir_typedef_registry *reg);
+void rir_typedef_registry_deinit(struct rir_typedef_registry *reg);
+
 struct rir_typedef *rir_typedef_create_from_type(struct type *t, struct rir_ctx *ctx);
 
+/**
+ * Make the typedef of a type available to the module being created
+ *
+ * If @a reg already holds a typedef for @a t it gets referred to by the
+ * module's imported typedefs. Otherwise a new typedef is created, added to
+ * the module's own typedefs and registered.
+ *
+ * @param t            The type whose typedef is needed
+ * @param reg          The typedef registry
+ * @param ctx          The rir context of the module being created
+ * @return             true for success and false for failure
+ */
+bool rir_typedef_add_from_type(struct type *t,
+                               struct rir_typedef_registry *reg,
+                               struct rir_ctx *ctx);
+
 struct rir_object *rir_typedef_create_obj(
     struct rir *r,
     struct rir_fndef *curr_fn,
@@ -1,6 +1,8 @@
 #ifndef LFR_IR_RIR_VALUE_H
 #define LFR_IR_RIR_VALUE_H
 
+#include <stdint.h>
+
 #include <rfbase/defs/inline.h>
 #include <rfbase/datastructs/darray.h>
 #include <rfbase/string/decl.h>
@@ -16,15 +18,6 @@ struct rirobj_strmap;
 struct rir_object;
 struct rirtostr_ctx;
 
-/**
- * Used to denote processing position of the value. Used mainly for proper
- * deletion
- */
-enum rvalue_pos {
-    RIR_VALUE_PARSING,
-    RIR_VALUE_NORMAL
-};
-
 enum rir_valtype {
     RIR_VALUE_CONSTANT,
     RIR_VALUE_VARIABLE,
@@ -36,8 +29,11 @@ enum rir_valtype {
 struct rir_value {
     //! General category of this value
     enum rir_valtype category;
-    //! A string to represent the value in the generated IR file
-    struct RFstring id;
+    //! Number of a variable, unique inside the function it belongs to. It is
+    //! only turned into its "$id" form when the rir is turned into a string.
+    uint32_t id;
+    //! Name of a label or a string literal. Empty for all other values.
+    struct RFstring name;
     //! The type of the value. Or NULL if this is a label or a NIL value
     struct rir_type *type;
     union {
@@ -49,7 +45,6 @@ struct rir_value {
 
 //! An array of values
 struct value_arr {darray(struct rir_value*);};
-void rir_valuearr_deinit(struct value_arr *arr, enum rvalue_pos pos);
 /**
  * Turn a rir value array to string and close a parentheses in that string
  * @param ctx         The rir to string context
@@ -66,7 +61,7 @@ bool rir_valuearr_tostring_close(struct rirtostr_ctx *ctx, const struct value_ar
  * increasing number like, $2, $3 e.t.c.
  *
  * If called from Parsing the rir_pctx (which should be the rir_data) should
- * contain the string value.
+ * contain the string value, whose number becomes the value's id.
  *
  * @param v            The value to initialize
  * @param obj          The rir object containing the value
@@ -128,21 +123,27 @@ void rir_value_nil_init(struct rir_value *v);
 
 
 void rir_value_deinit(struct rir_value *v);
+
 /**
- * Destroy a value and free its pointer too
+ * Get the id of a variable from its string representation
  *
- * @param v        The value to destroy
- * @param pos      The position in the compiler's processing pipeline
- *                 of value @a v. Depending on it and on the value type
- *                 the function may not do anything, to avoid double free.
+ * @param s        The identifier of the variable, like $3
+ * @param id       The number of the identifier is placed here
+ * @return         true if @a s is the identifier of a variable
  */
-void rir_value_destroy(struct rir_value *v, enum rvalue_pos pos);
+bool rir_value_id_from_string(const struct RFstring *s, uint32_t *id);
 
 struct rir_block *rir_value_label_dst(const struct rir_value *v);
 /**
  * Get a string representation of the rir value's identifier
  */
 bool rir_value_tostring(struct rir *r, const struct rir_value *v);
+/**
+ * Get the identifier of a rir value as it appears in the rir string
+ *
+ * Variables and constants are formatted on the fly so this needs to be
+ * enclosed in RFS_PUSH() and RFS_POP().
+ */
 const struct RFstring *rir_value_string(const struct rir_value *v);
 const struct RFstring *rir_valtype_string(enum rir_valtype t);
 i_INLINE_DECL const struct RFstring *rir_value_type_string(const struct rir_value *v)
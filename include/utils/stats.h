@@ -0,0 +1,74 @@
+#ifndef LFR_UTILS_STATS_H
+#define LFR_UTILS_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <rfbase/defs/inline.h>
+#include <rfbase/defs/threadspecific.h>
+
+enum stats_counter {
+    STATS_TOKENS = 0,
+    STATS_AST_NODES,
+    STATS_TYPES,
+    STATS_TYPE_COMPARISONS,
+    STATS_SYMBOL_LOOKUPS,
+    STATS_RIR_OBJECTS,
+    STATS_LLVM_INSTRUCTIONS,
+    STATS_COUNTERS_NUM
+};
+
+enum stats_format {
+    STATS_FORMAT_TABLE = 0,
+    STATS_FORMAT_JSON,
+};
+
+//! The counters of the calling thread. Use stats_add() to change them.
+extern i_THREAD__ uint64_t g_stats_counts[STATS_COUNTERS_NUM];
+
+/**
+ * Count @a n more of @a c for the calling thread. Always counts, since it
+ * costs no more than checking whether statistics were requested.
+ */
+i_INLINE_DECL void stats_add(enum stats_counter c, uint64_t n)
+{
+    g_stats_counts[c] += n;
+}
+
+/**
+ * Start measuring compilation phases. Until called, phases are not
+ * recorded at all.
+ */
+void stats_enable();
+bool stats_enabled();
+void stats_deinit();
+
+/**
+ * Start a phase of the compilation, nested in the currently running one.
+ * Phases of the same name and parent are accumulated, so a phase that runs
+ * once per module shows up once with the total of all modules.
+ *
+ * Only called from the main thread.
+ *
+ * @param name      The name of the phase. Must be a string literal.
+ */
+void stats_phase_begin(const char *name);
+/**
+ * End the most recently started phase
+ */
+void stats_phase_end();
+
+/**
+ * Add the counters of the calling thread to the totals. Threads other than
+ * the main one should call this before they exit.
+ */
+void stats_thread_flush();
+
+/**
+ * Print all recorded phases with their time, counters and the peak
+ * resident set size of the process at their end
+ */
+void stats_print(FILE *f, enum stats_format format);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef LFR_UTILS_WORKERS_H
+#define LFR_UTILS_WORKERS_H
+
+#include <stdbool.h>
+
+/**
+ * A pool of threads that share some work with the thread creating them.
+ * Every thread claims pieces of the work until none is left, so if some
+ * threads can't be created or set up the others still do all of it.
+ *
+ * Threads of the pool get their own string buffers and flush their
+ * statistics counters before they exit.
+ */
+struct workers {
+    //! What the threads do, used in error messages
+    const char *name;
+    /**
+     * Set up a thread before it runs
+     * @return The state of the thread given to @a run and @a deinit, or
+     *         NULL if it could not be set up
+     */
+    void *(*init)(void *data);
+    //! Do work until there is none left
+    void (*run)(void *data, void *state);
+    //! Undo what @a init did
+    void (*deinit)(void *data, void *state);
+};
+
+/**
+ * Do work with up to @a jobs threads, including the calling one
+ *
+ * @param w          The callbacks of the threads
+ * @param data       Given to all the callbacks. Shared by all threads.
+ * @param state      The state of the calling thread. If NULL the calling
+ *                   thread is set up with @a w->init like the others.
+ * @param jobs       Maximum number of threads to work with
+ * @param work       Number of pieces of work. No more threads than that
+ *                   are created.
+ * @return           false if the calling thread could not take part. Failure
+ *                   of the work itself is up to the callbacks to record.
+ */
+bool workers_run(const struct workers *w,
+                 void *data,
+                 void *state,
+                 unsigned int jobs,
+                 unsigned int work);
+
+#endif
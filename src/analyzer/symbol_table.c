@@ -15,6 +15,7 @@
 #include <types/type_function.h>
 #include <analyzer/analyzer.h>
 #include <ir/rir_object.h>
+#include <utils/stats.h>
 
 /* -- symbol table record related functions -- */
 
@@ -315,6 +316,7 @@ struct symbol_table_record *symbol_table_lookup_record(const struct symbol_table
     struct symbol_table_record *rec;
     const struct symbol_table *lp_table = t;
 
+    stats_add(STATS_SYMBOL_LOOKUPS, 1);
     if (at_first_symbol_table) {
         *at_first_symbol_table = false;
     }
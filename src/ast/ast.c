@@ -11,6 +11,7 @@
 #include <ast/matchexpr.h>
 #include <ast/forexpr.h>
 #include <ast/module.h>
+#include <utils/stats.h>
 
 static const struct RFstring ast_type_strings[] = {
     [AST_ROOT] = RF_STRING_STATIC_INIT("root"),
@@ -64,6 +65,7 @@ void ast_node_init(struct ast_node *n, enum ast_type type)
     n->state = AST_NODE_STATE_CREATED;
     n->type = type;
     darray_init(n->children);
+    stats_add(STATS_AST_NODES, 1);
 }
 
 struct ast_node *ast_node_create(enum ast_type type)
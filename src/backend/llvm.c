@@ -2,10 +2,14 @@
 
 #include <llvm-c/Core.h>
 #include <llvm-c/Analysis.h>
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
 #include <llvm-c/ExecutionEngine.h>
 #include <llvm-c/Target.h>
 #include <llvm-c/Transforms/Scalar.h>
 
+#include <unistd.h>
+
 #include <rfbase/string/core.h>
 #include <rfbase/system/system.h>
 #include <rfbase/persistent/buffers.h>
@@ -17,9 +21,11 @@
 #include <front_ctx.h>
 #include <module.h>
 #include <utils/common_strings.h>
+#include <utils/stats.h>
 
 #include "llvm_ast.h"
 #include "llvm_utils.h"
+#include "llvm_jit.h"
 
 static void bllvm_diagnostic_handler(struct LLVMOpaqueDiagnosticInfo *di, void *u)
 {
@@ -48,7 +54,8 @@ static inline void llvm_traversal_ctx_init(
     darray_init(ctx->params);
     darray_init(ctx->values);
     rir_types_map_init(&ctx->types_map);
-    strmap_init(&ctx->valmap);
+    darray_init(ctx->valmap);
+    strmap_init(&ctx->blockmap);
 }
 
 static inline void llvm_traversal_ctx_deinit(struct llvm_traversal_ctx *ctx)
@@ -67,7 +74,8 @@ static inline void llvm_traversal_ctx_set_singlepass(struct llvm_traversal_ctx *
     darray_init(ctx->params);
     darray_init(ctx->values);
     rir_types_map_init(&ctx->types_map);
-    strmap_init(&ctx->valmap);
+    darray_init(ctx->valmap);
+    strmap_init(&ctx->blockmap);
 }
 
 static inline void llvm_traversal_ctx_reset_singlepass(struct llvm_traversal_ctx *ctx)
@@ -77,7 +85,89 @@ static inline void llvm_traversal_ctx_reset_singlepass(struct llvm_traversal_ctx
     rir_types_map_deinit(&ctx->types_map);
     darray_free(ctx->params);
     darray_free(ctx->values);
-    strmap_clear(&ctx->valmap);
+    darray_free(ctx->valmap);
+    strmap_clear(&ctx->blockmap);
+}
+
+/**
+ * Load the precompiled standard library bitcode, if it exists, into the
+ * context instead of lowering the stdlib RIR again
+ */
+static struct LLVMOpaqueModule *bllvm_stdlib_load(struct llvm_traversal_ctx *ctx)
+{
+    struct LLVMOpaqueModule *mod = NULL;
+    LLVMMemoryBufferRef buff;
+    const struct RFstring *path;
+    char *error = NULL;
+    RFS_PUSH();
+    if (!(path = compiler_cache_stdlib_path(&compiler_instance_get()->cache))) {
+        goto end;
+    }
+    // not having the file yet is not an error, it will be created
+    if (LLVMCreateMemoryBufferWithContentsOfFile(rf_string_data(path), &buff, &error)) {
+        bllvm_error_dispose(&error);
+        goto end;
+    }
+#if (RF_LLVM_VERSION_MAJOR == 3 && RF_LLVM_VERSION_MINOR >= 9) || RF_LLVM_VERSION_MAJOR >= 4
+    if (LLVMParseBitcodeInContext2(ctx->llvm_context, buff, &mod)) {
+        mod = NULL;
+    }
+#else
+    if (LLVMParseBitcodeInContext(ctx->llvm_context, buff, &mod, &error)) {
+        bllvm_error_dispose(&error);
+        mod = NULL;
+    }
+#endif
+    LLVMDisposeMemoryBuffer(buff);
+    if (mod) {
+        // mimic what blvm_create_module() sets up for a module
+        ctx->llvm_mod = mod;
+        ctx->target_data = LLVMCreateTargetData(LLVMGetDataLayout(mod));
+    }
+end:
+    if (path) {
+        compiler_cache_stdlib_loaded(&compiler_instance_get()->cache, mod != NULL);
+    }
+    RFS_POP();
+    return mod;
+}
+
+/**
+ * Store the freshly lowered standard library as bitcode for later compilations
+ */
+static void bllvm_stdlib_store(struct LLVMOpaqueModule *mod)
+{
+    const struct RFstring *path;
+    RFS_PUSH();
+    if (!(path = compiler_cache_stdlib_path(&compiler_instance_get()->cache))) {
+        goto end;
+    }
+    // write to a temporary file and rename, so that concurrent compilations
+    // never load partially written bitcode
+    const struct RFstring *tmp = RFS_NT_OR_DIE(RFS_PF".%ld.tmp", RFS_PA(path), (long)getpid());
+    if (0 != LLVMWriteBitcodeToFile(mod, rf_string_data(tmp)) ||
+        0 != rename(rf_string_data(tmp), rf_string_data(path))) {
+        WARN("Could not store the precompiled standard library");
+        remove(rf_string_data(tmp));
+    }
+end:
+    RFS_POP();
+}
+
+static uint64_t bllvm_instructions_num(struct LLVMOpaqueModule *llvm_module)
+{
+    LLVMValueRef fn;
+    LLVMBasicBlockRef bb;
+    LLVMValueRef instr;
+    uint64_t num = 0;
+    for (fn = LLVMGetFirstFunction(llvm_module); fn; fn = LLVMGetNextFunction(fn)) {
+        for (bb = LLVMGetFirstBasicBlock(fn); bb; bb = LLVMGetNextBasicBlock(bb)) {
+            for (instr = LLVMGetFirstInstruction(bb); instr; instr = LLVMGetNextInstruction(instr)) {
+                ++num;
+            }
+        }
+    }
+    return num;
 }
 
 static bool bllvm_ir_generate(struct modules_arr *modules, struct compiler_args *args)
@@ -94,16 +184,23 @@ static bool bllvm_ir_generate(struct modules_arr *modules, struct compiler_args
     struct module **mod;
     llvm_traversal_ctx_init(&ctx, args);
     darray_foreach(mod, *modules) {
+        bool is_stdlib = rf_string_equal(module_name(*mod), &g_str_stdlib);
         llvm_traversal_ctx_set_singlepass(&ctx, *mod);
-        llvm_module = blvm_create_module((*mod)->rir, &ctx, stdlib_module);
+        llvm_module = is_stdlib ? bllvm_stdlib_load(&ctx) : NULL;
         if (!llvm_module) {
-            ERROR("Failed to form the LLVM IR ast");
-            llvm_traversal_ctx_reset_singlepass(&ctx);
-            goto end;
+            llvm_module = blvm_create_module((*mod)->rir, &ctx, stdlib_module);
+            if (!llvm_module) {
+                ERROR("Failed to form the LLVM IR ast");
+                llvm_traversal_ctx_reset_singlepass(&ctx);
+                goto end;
+            }
+            if (is_stdlib) {
+                bllvm_stdlib_store(llvm_module);
+            }
         }
 
         // if this was stdlib mark it
-        if (rf_string_equal(module_name(*mod), &g_str_stdlib)) {
+        if (is_stdlib) {
             RF_ASSERT(!stdlib_module, "Two modules with the stdlib name");
             stdlib_module = llvm_module;
         }
@@ -118,6 +215,23 @@ static bool bllvm_ir_generate(struct modules_arr *modules, struct compiler_args
 
         llvm_traversal_ctx_reset_singlepass(&ctx);
     }
+    // all modules end up in the last one
+    if (stats_enabled()) {
+        stats_add(STATS_LLVM_INSTRUCTIONS, bllvm_instructions_num(llvm_module));
+    }
+
+    if (compiler_args_jit_run(args)) {
+        // the execution engine takes ownership of the final module
+        ctx.llvm_mod = NULL;
+        stats_phase_begin("run");
+        ret = bllvm_jit_run(llvm_module, &compiler_instance_get()->run_retcode);
+        stats_phase_end();
+        if (stdlib_module && stdlib_module != llvm_module) {
+            LLVMDisposeModule(stdlib_module);
+        }
+        llvm_traversal_ctx_deinit(&ctx);
+        goto end;
+    }
 
     RFS_PUSH();
     struct RFstring *temp_s = RFS_NT_OR_DIE(
@@ -212,17 +326,31 @@ static bool backend_asm_to_exec(struct compiler_args *args)
 
 bool bllvm_generate(struct modules_arr *modules, struct compiler_args *args)
 {
-
-    if (!bllvm_ir_generate(modules, args)) {
+    bool ok;
+    stats_phase_begin("llvm_ir");
+    ok = bllvm_ir_generate(modules, args);
+    stats_phase_end();
+    if (!ok) {
         return false;
     }
 
-    if (!bllvm_ir_to_asm(args)) {
+    // when running in process there is no executable to create
+    if (compiler_args_jit_run(args)) {
+        return true;
+    }
+
+    stats_phase_begin("llc");
+    ok = bllvm_ir_to_asm(args);
+    stats_phase_end();
+    if (!ok) {
         ERROR("Failed to generate assembly from LLVM IR code");
         return false;
     }
 
-    if (!backend_asm_to_exec(args)) {
+    stats_phase_begin("link");
+    ok = backend_asm_to_exec(args);
+    stats_phase_end();
+    if (!ok) {
         ERROR("Failed to generate executable from assembly machine code");
         return false;
     }
@@ -53,12 +53,20 @@ struct LLVMOpaqueValue *bllvm_compile_objidx(
                      DEFAULT_PTR_ADDRESS_SPACE), 
         llvm_idxval
     };
-    LLVMValueRef gep = LLVMBuildGEP(
-        ctx->builder,
-        bllvm_value_from_rir_value_or_die(expr->objidx.objmemory, ctx),
-        indices,
-        2,
-        ""
-    );
+    LLVMValueRef gep = expr->objidx.inbounds
+        ? LLVMBuildInBoundsGEP(
+            ctx->builder,
+            bllvm_value_from_rir_value_or_die(expr->objidx.objmemory, ctx),
+            indices,
+            2,
+            ""
+        )
+        : LLVMBuildGEP(
+            ctx->builder,
+            bllvm_value_from_rir_value_or_die(expr->objidx.objmemory, ctx),
+            indices,
+            2,
+            ""
+        );
     return LLVMBuildLoad(ctx->builder, gep, "");
 }
@@ -98,7 +98,18 @@ static bool llvm_traversal_ctx_map_val(
 {
     bool ret;
     RF_ASSERT(rv->category != RIR_VALUE_NIL, "Nil RIR Value should never get here");
-    ret = strmap_add(&ctx->valmap, (struct RFstring*)&rv->id, lv);
+    if (rv->category == RIR_VALUE_VARIABLE) {
+        while (darray_size(ctx->valmap) <= rv->id) {
+            darray_append(ctx->valmap, NULL);
+        }
+        if (darray_item(ctx->valmap, rv->id)) {
+            RF_ERROR("Tried to add an already existing rir value to the llvm val mapping");
+            return false;
+        }
+        darray_item(ctx->valmap, rv->id) = lv;
+        return true;
+    }
+    ret = strmap_add(&ctx->blockmap, (struct RFstring*)&rv->name, lv);
     if (!ret) {
         if (errno == EEXIST) {
             RF_ERROR("Tried to add an already existing rir value string to the llvm val mapping");
@@ -124,9 +135,21 @@ bool llvm_traversal_ctx_map_llvmblock(
     return llvm_traversal_ctx_map_val(ctx, rv, lv);
 }
 
+void *llvm_traversal_ctx_mapped_val(struct llvm_traversal_ctx *ctx,
+                                    const struct rir_value *rv)
+{
+    if (rv->category == RIR_VALUE_VARIABLE) {
+        return rv->id < darray_size(ctx->valmap)
+            ? darray_item(ctx->valmap, rv->id)
+            : NULL;
+    }
+    return strmap_get(&ctx->blockmap, &rv->name);
+}
+
 void llvm_traversal_ctx_reset_valmap(struct llvm_traversal_ctx *ctx)
 {
-    strmap_clear(&ctx->valmap);
+    darray_resize(ctx->valmap, 0);
+    strmap_clear(&ctx->blockmap);
 }
 
 LLVMValueRef bllvm_cast_value_to_elementary_maybe(LLVMValueRef val,
@@ -199,16 +222,10 @@ static struct LLVMOpaqueValue *bllvm_compile_setunionidx(
         expr->setunionidx.unimemory->type->is_pointer,
         "You can only set an index to a pointer"
     );
-    LLVMValueRef llvm_mval = bllvm_value_from_rir_value_or_die(
-        expr->setunionidx.unimemory,
-        ctx
-    );
-    // the union index is the first member of the struct
-    LLVMValueRef llvm_idx_loc = bllvm_gep_to_struct(llvm_mval, 0, ctx);
-    return LLVMBuildStore(
-        ctx->builder,
+    return bllvm_union_set_selector(
+        bllvm_value_from_rir_value_or_die(expr->setunionidx.unimemory, ctx),
         bllvm_value_from_rir_value_or_die(expr->setunionidx.idx, ctx),
-        llvm_idx_loc
+        ctx
     );
 }
 
@@ -220,14 +237,10 @@ static struct LLVMOpaqueValue *bllvm_compile_getunionidx(
         expr->getunionidx.unimemory->type->is_pointer,
         "You can only get an index to a pointer"
     );
-    LLVMValueRef llvm_mval = bllvm_value_from_rir_value_or_die(
-        expr->getunionidx.unimemory,
+    return bllvm_union_get_selector(
+        bllvm_value_from_rir_value_or_die(expr->getunionidx.unimemory, ctx),
         ctx
     );
-    // the union index is the first member of the struct
-    LLVMValueRef llvm_idx_gep = bllvm_gep_to_struct(llvm_mval, 0, ctx);
-    // but since this was a gep you have to read it
-    return LLVMBuildLoad(ctx->builder, llvm_idx_gep, "");
 }
 
 static struct LLVMOpaqueValue *bllvm_compile_unionmemberat(
@@ -242,13 +255,14 @@ static struct LLVMOpaqueValue *bllvm_compile_unionmemberat(
         expr->unionmemberat.unimemory,
         ctx
     );
-    // get the member location, it's index is +1, in order to skip the selector index
-    LLVMValueRef llvm_member_gep = bllvm_gep_to_struct(
-        llvm_mval,
-        expr->unionmemberat.idx + 1,
-        ctx
+    // all members share the payload which comes right after the selector
+    LLVMValueRef llvm_payload_gep = bllvm_gep_to_struct(llvm_mval, 1, ctx);
+    return LLVMBuildBitCast(
+        ctx->builder,
+        llvm_payload_gep,
+        bllvm_type_from_rir_type(expr->val.type, ctx),
+        ""
     );
-    return llvm_member_gep;
 }
 
 
@@ -266,7 +280,7 @@ static struct LLVMOpaqueValue *bllvm_compile_alloca(const struct rir_expression
     RF_ASSERT(malloc_fn, "We should get a malloc function here");
     LLVMValueRef call_args[] = {
         LLVMConstInt(LLVMInt64TypeInContext(ctx->llvm_context),
-                     rir_type_bytesize(expr->alloca.type),
+                     LLVMABISizeOfType(ctx->target_data, type),
                      0)
     };
     LLVMValueRef retval = LLVMBuildCall(ctx->builder, malloc_fn, call_args, 1, "");
@@ -352,6 +366,14 @@ struct LLVMOpaqueValue *bllvm_compile_rirexpr(
     case RIR_EXPRESSION_OBJIDX:
         llvmval = bllvm_compile_objidx(expr, ctx);
         break;
+    case RIR_EXPRESSION_PHI:
+        // incoming values are added in llvm_connect_phis() once all blocks exist
+        llvmval = LLVMBuildPhi(
+            ctx->builder,
+            bllvm_type_from_rir_type(expr->val.type, ctx),
+            ""
+        );
+        break;
     default:
         RF_CRITICAL_FAIL("Unknown rir expression type encountered at LLVM backend generation");
         break;
@@ -379,6 +401,8 @@ struct LLVMOpaqueModule *blvm_create_module(
         return NULL;
     }
     ctx->llvm_mod = LLVMModuleCreateWithNameInContext(mod_name, ctx->llvm_context);
+    // lay out types for the target we are going to compile for
+    bllvm_set_native_target(ctx->llvm_mod);
     ctx->target_data = LLVMCreateTargetData(LLVMGetDataLayout(ctx->llvm_mod));
 
     if (!bllvm_create_global_functions(ctx)) {
@@ -54,8 +54,10 @@ struct llvm_traversal_ctx {
     //! Current rir function
     struct rir_fndef *current_rfn;
     struct compiler_args *args;
-    //! Map from a rir value's id to llvm values
-    struct rirval_strmap valmap;
+    //! Map from a rir variable's id to llvm values
+    struct {darray(void*);} valmap;
+    //! Map from a rir label's name to llvm basic blocks
+    struct rirval_strmap blockmap;
 };
 
 bool bllvm_create_ir_ast(struct llvm_traversal_ctx *ctx, struct ast_node *root);
@@ -135,6 +137,12 @@ bool llvm_traversal_ctx_map_llvmblock(
     struct llvm_traversal_ctx *ctx,
     const struct rir_value *rv,
     struct LLVMOpaqueBasicBlock *lb);
+/**
+ * @return the llvm value or basic block mapped to a rir variable or label
+ *         or NULL if there is none
+ */
+void *llvm_traversal_ctx_mapped_val(struct llvm_traversal_ctx *ctx,
+                                    const struct rir_value *rv);
 void llvm_traversal_ctx_reset_valmap(struct llvm_traversal_ctx *ctx);
 
 enum llvm_expression_compile_options {
@@ -15,6 +15,7 @@
 #include <types/type_function.h>
 #include <ir/rir_function.h>
 #include <ir/rir_block.h>
+#include <ir/rir_code.h>
 #include <ir/rir.h>
 
 #include "llvm_ast.h"
@@ -52,8 +53,40 @@ LLVMTypeRef bllvm_function_type(LLVMValueRef fn)
 }
 
 
+static bool llvm_create_switch(const struct rir_switch *sw, struct llvm_traversal_ctx *ctx)
+{
+    LLVMBasicBlockRef b;
+    LLVMValueRef cond;
+    LLVMValueRef llvm_sw;
+    LLVMValueRef caseval;
+    struct rir_switch_case *c;
+    if (!(cond = bllvm_value_from_rir_value(sw->cond, ctx))) {
+        RF_ERROR("Failed to retrieve llvm switch condition from value map");
+        return false;
+    }
+    if (!(b = bllvm_value_from_rir_value(sw->fallthrough, ctx))) {
+        RF_ERROR("Failed to retrieve llvm switch fallthrough block from values map");
+        return false;
+    }
+    llvm_sw = LLVMBuildSwitch(ctx->builder, cond, b, rir_switch_cases_num(sw));
+    darray_foreach(c, sw->cases) {
+        if (!(b = bllvm_value_from_rir_value(c->dst, ctx))) {
+            RF_ERROR("Failed to retrieve llvm switch case block from values map");
+            return false;
+        }
+        // case constants must have the exact type of the condition
+        caseval = bllvm_value_from_rir_value_or_die(c->val, ctx);
+        if (LLVMTypeOf(caseval) != LLVMTypeOf(cond)) {
+            caseval = LLVMConstIntCast(caseval, LLVMTypeOf(cond), false);
+        }
+        LLVMAddCase(llvm_sw, caseval, b);
+    }
+    return true;
+}
+
 static bool llvm_create_blockexit(const struct rir_block_exit *e, struct llvm_traversal_ctx *ctx)
 {
+    LLVMValueRef br;
     LLVMBasicBlockRef b;
     LLVMBasicBlockRef other_b;
     LLVMValueRef cond;
@@ -63,7 +96,10 @@ static bool llvm_create_blockexit(const struct rir_block_exit *e, struct llvm_tr
             RF_ERROR("Failed to retrieve llvm block from values map");
             return false;
         }
-        LLVMBuildBr(ctx->builder, b);
+        br = LLVMBuildBr(ctx->builder, b);
+        if (e->branch.vectorize) {
+            bllvm_add_vectorize_hint(br, ctx);
+        }
         break;
     case RIR_BLOCK_EXIT_CONDBRANCH:
         if (!(cond = bllvm_value_from_rir_value(e->condbranch.cond, ctx))) {
@@ -80,6 +116,8 @@ static bool llvm_create_blockexit(const struct rir_block_exit *e, struct llvm_tr
         }
         LLVMBuildCondBr(ctx->builder, cond, b, other_b);
         break;
+    case RIR_BLOCK_EXIT_SWITCH:
+        return llvm_create_switch(&e->switchbr, ctx);
     case RIR_BLOCK_EXIT_RETURN:
         if (e->retstmt.val) {
             LLVMBuildRet(ctx->builder, bllvm_value_from_rir_value_or_die(e->retstmt.val, ctx));
@@ -95,9 +133,12 @@ static bool llvm_create_blockexit(const struct rir_block_exit *e, struct llvm_tr
 }
 
 static bool llvm_create_block(
-    const struct rir_block *b,
+    const struct rir_code *code,
+    const struct rir_code_block *cb,
     struct llvm_traversal_ctx *ctx)
 {
+    const struct rir_block *b = cb->block;
+    struct rir_instr *instr;
     LLVMValueRef llvmval;
     // create and enter the block
     RFS_PUSH();
@@ -140,12 +181,11 @@ static bool llvm_create_block(
     }
 
     // now create llvm expressions out of the rir expressions of the block
-    struct rir_expression *expr;
-    rf_ilist_for_each(&b->expressions, expr, ln) {
-        if (!(llvmval = bllvm_compile_rirexpr(expr, ctx))) {
+    rir_code_foreach_block_instr(code, cb, instr) {
+        if (!(llvmval = bllvm_compile_rirexpr(instr->expr, ctx))) {
             RF_ERROR(
                 "Failed to compile rir expression \""RFS_PF"\"",
-                RFS_PA(rir_expression_type_string(expr))
+                RFS_PA(rir_expression_type_string(instr->expr))
             );
             return false;
         }
@@ -153,6 +193,41 @@ static bool llvm_create_block(
     return true;
 }
 
+/**
+ * Fill in the incoming values of the phis at the start of a block. Has to
+ * happen after all blocks got created since incoming values can come from
+ * blocks that follow.
+ */
+static bool llvm_connect_phis(const struct rir_code *code,
+                              const struct rir_code_block *cb,
+                              struct llvm_traversal_ctx *ctx)
+{
+    struct rir_instr *instr;
+    struct rir_phi_incoming *in;
+    LLVMValueRef llvm_phi;
+    LLVMValueRef llvm_val;
+    LLVMBasicBlockRef llvm_b;
+    rir_code_foreach_block_instr(code, cb, instr) {
+        if (instr->op != RIR_EXPRESSION_PHI) {
+            // phis only appear at the start of a block
+            break;
+        }
+        llvm_phi = bllvm_value_from_rir_value_or_die(&instr->expr->val, ctx);
+        darray_foreach(in, instr->expr->phi.incoming) {
+            if (!(llvm_val = bllvm_value_from_rir_value(in->val, ctx))) {
+                RF_ERROR("Failed to retrieve llvm phi incoming value from values map");
+                return false;
+            }
+            if (!(llvm_b = bllvm_value_from_rir_value(in->block, ctx))) {
+                RF_ERROR("Failed to retrieve llvm phi incoming block from values map");
+                return false;
+            }
+            LLVMAddIncoming(llvm_phi, &llvm_val, &llvm_b, 1);
+        }
+    }
+    return true;
+}
+
 static bool llvm_connect_block(const struct rir_block *b, struct llvm_traversal_ctx *ctx)
 {
     LLVMBasicBlockRef llvm_b = bllvm_value_from_rir_value_or_die(&b->label, ctx);
@@ -161,23 +236,31 @@ static bool llvm_connect_block(const struct rir_block *b, struct llvm_traversal_
 }
 
 static bool bllvm_create_fndef(
-    const struct rir_fndef *fn,
+    struct rir_fndef *fn,
     struct llvm_traversal_ctx *ctx)
 {
-    struct rir_block **b;
+    struct rir_code code;
+    struct rir_code_block *cb;
+    bool ret = false;
+    if (!rir_code_init(&code, fn)) {
+        return false;
+    }
     // create all blocks and their contents
-    darray_foreach(b, fn->blocks) {
-        if (!llvm_create_block(*b, ctx)) {
-            return false;
+    darray_foreach(cb, code.blocks) {
+        if (!llvm_create_block(&code, cb, ctx)) {
+            goto end;
         }
     }
     // and now that they are created connect them
-    darray_foreach(b, fn->blocks) {
-        if (!llvm_connect_block(*b, ctx)) {
-            return false;
+    darray_foreach(cb, code.blocks) {
+        if (!llvm_connect_phis(&code, cb, ctx) || !llvm_connect_block(cb->block, ctx)) {
+            goto end;
         }
     }
-    return true;
+    ret = true;
+end:
+    rir_code_deinit(&code);
+    return ret;
 }
 
 static struct LLVMOpaqueValue *bllvm_create_fndecl(
@@ -29,6 +29,13 @@
 bool bllvm_create_module_types(struct rir *r, struct llvm_traversal_ctx *ctx)
 {
     struct rir_typedef *def;
+    struct rir_typedef **idef;
+    // typedefs of dependencies first, since the module's own may contain them
+    darray_foreach(idef, r->imported_typedefs) {
+        if (!bllvm_declare_typedef(*idef, ctx)) {
+            return false;
+        }
+    }
     rf_ilist_for_each(&r->typedefs, def, ln) {
         if (!bllvm_compile_typedef(def, ctx)) {
             return false;
@@ -239,7 +246,7 @@ static bool iterate_literals_cb(const struct RFstring *member, struct rir_object
     RFS_PUSH();
     bllvm_create_global_const_string(
         // skip the initial '$'
-        rf_string_prune_start(&g->val.id, 1, RF_SOPT_ASCII | RF_SOPT_TMP, NULL),
+        rf_string_prune_start(&g->val.name, 1, RF_SOPT_ASCII | RF_SOPT_TMP, NULL),
         &g->val.literal,
         ctx
     );
@@ -0,0 +1,81 @@
+#include "llvm_jit.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <llvm-c/Core.h>
+#include <llvm-c/ExecutionEngine.h>
+#include <llvm-c/Target.h>
+
+#include <rfbase/string/decl.h>
+
+#include <info/info.h>
+
+#include "llvm_utils.h"
+
+// The foreign functions imported by stdlib/io.rf. They live in rfbase which
+// is linked into the compiler so we hand their addresses to the JIT directly.
+bool rf_stdlib_print_int64(int64_t i);
+bool rf_stdlib_print_uint64(uint64_t i);
+bool rf_stdlib_print_string(struct RFstring *s);
+
+struct bllvm_jit_symbol {
+    const char *name;
+    void *address;
+};
+
+static const struct bllvm_jit_symbol jit_symbols[] = {
+    {"rf_stdlib_print_int64", (void*)rf_stdlib_print_int64},
+    {"rf_stdlib_print_uint64", (void*)rf_stdlib_print_uint64},
+    {"rf_stdlib_print_string", (void*)rf_stdlib_print_string},
+};
+
+static void bllvm_jit_map_symbols(LLVMExecutionEngineRef engine,
+                                  LLVMModuleRef mod)
+{
+    unsigned i;
+    LLVMValueRef fn;
+    for (i = 0; i < sizeof(jit_symbols) / sizeof(jit_symbols[0]); ++i) {
+        // only the symbols actually used by the module are declared in it
+        if ((fn = LLVMGetNamedFunction(mod, jit_symbols[i].name))) {
+            LLVMAddGlobalMapping(engine, fn, jit_symbols[i].address);
+        }
+    }
+}
+
+bool bllvm_jit_run(struct LLVMOpaqueModule *mod, int *retcode)
+{
+    LLVMExecutionEngineRef engine;
+    struct LLVMMCJITCompilerOptions options;
+    char *error = NULL;
+    uint64_t main_addr;
+    bool ret = false;
+
+    LLVMLinkInMCJIT();
+    LLVMInitializeNativeAsmPrinter();
+    LLVMInitializeNativeAsmParser();
+
+    LLVMInitializeMCJITCompilerOptions(&options, sizeof(options));
+    // engine creation takes ownership of the module, even on failure
+    if (LLVMCreateMCJITCompilerForModule(&engine, mod, &options, sizeof(options), &error)) {
+        bllvm_error("Could not create the LLVM JIT execution engine", &error);
+        return false;
+    }
+    bllvm_jit_map_symbols(engine, mod);
+
+    // requesting an address finalizes the object so mappings must precede it
+    main_addr = LLVMGetFunctionAddress(engine, "main");
+    if (!main_addr) {
+        ERROR("Could not find main() in the JIT compiled module");
+        goto end;
+    }
+
+    *retcode = ((int (*)(void))(uintptr_t)main_addr)();
+    // the program shares stdout with us so make sure its output is not delayed
+    fflush(stdout);
+    ret = true;
+
+end:
+    LLVMDisposeExecutionEngine(engine);
+    return ret;
+}
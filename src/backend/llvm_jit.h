@@ -0,0 +1,21 @@
+#ifndef LFR_BACKEND_LLVM_JIT_H
+#define LFR_BACKEND_LLVM_JIT_H
+
+#include <stdbool.h>
+
+struct LLVMOpaqueModule;
+
+/**
+ * JIT compile the given fully linked module in process and run its main()
+ *
+ * The foreign imports of the refu standard library are resolved against the
+ * symbols of rfbase that are linked into the compiler itself.
+ *
+ * @param mod         The module to execute. Ownership of it is passed to the
+ *                    execution engine which disposes of it in all cases.
+ * @param retcode     Pointer to an int to receive the return value of main()
+ * @return            true if main() could be found and executed, false otherwise
+ */
+bool bllvm_jit_run(struct LLVMOpaqueModule *mod, int *retcode);
+
+#endif
@@ -9,6 +9,7 @@
 #include <llvm-c/Transforms/Scalar.h>
 
 #include <rfbase/utils/hash.h>
+#include <rfbase/math/math.h>
 #include <rfbase/string/common.h>
 #include <rfbase/string/conversion.h>
 
@@ -64,21 +65,133 @@ static LLVMTypeRef bllvm_create_struct(
     return llvm_type;
 }
 
+LLVMTypeRef bllvm_union_selector_type(size_t members_num,
+                                      struct llvm_traversal_ctx *ctx)
+{
+    if (members_num <= UINT8_MAX + 1) {
+        return LLVMInt8TypeInContext(ctx->llvm_context);
+    } else if (members_num <= UINT16_MAX + 1) {
+        return LLVMInt16TypeInContext(ctx->llvm_context);
+    }
+    return LLVMInt32TypeInContext(ctx->llvm_context);
+}
+
+/**
+ * Lay out a union as {selector, payload}
+ *
+ * The members overlap in the payload which is as big as the biggest member.
+ * It starts with the member of the strictest alignment, so that the whole
+ * payload gets that alignment, and is padded with bytes up to the biggest size.
+ * Members are accessed by casting a pointer to the payload.
+ */
+static void bllvm_union_set_body(LLVMTypeRef llvm_type,
+                                 size_t members_num,
+                                 struct llvm_traversal_ctx *ctx)
+{
+    LLVMTypeRef *members = llvm_traversal_ctx_get_params(ctx);
+    LLVMTypeRef body[3];
+    LLVMTypeRef align_type = NULL;
+    unsigned long long max_size = 0;
+    unsigned long long size;
+    unsigned max_align = 0;
+    unsigned align;
+    unsigned count = 0;
+    size_t i;
+    for (i = 0; i < members_num; ++i) {
+        if (members[i] == LLVMVoidTypeInContext(ctx->llvm_context)) {
+            continue;
+        }
+        size = LLVMABISizeOfType(ctx->target_data, members[i]);
+        align = LLVMABIAlignmentOfType(ctx->target_data, members[i]);
+        max_size = rf_max(max_size, size);
+        if (align > max_align) {
+            max_align = align;
+            align_type = members[i];
+        }
+    }
+
+    body[count++] = bllvm_union_selector_type(members_num, ctx);
+    if (align_type) {
+        body[count++] = align_type;
+        size = LLVMABISizeOfType(ctx->target_data, align_type);
+        if (max_size > size) {
+            body[count++] = LLVMArrayType(
+                LLVMInt8TypeInContext(ctx->llvm_context),
+                max_size - size
+            );
+        }
+    }
+    LLVMStructSetBody(llvm_type, body, count, false);
+}
+
+LLVMValueRef bllvm_union_set_selector(LLVMValueRef union_ptr,
+                                      LLVMValueRef idx,
+                                      struct llvm_traversal_ctx *ctx)
+{
+    // the selector is the first member of the struct
+    LLVMValueRef selector_loc = bllvm_gep_to_struct(union_ptr, 0, ctx);
+    // and is stored in the smallest integer type that can hold it
+    return LLVMBuildStore(
+        ctx->builder,
+        bllvm_cast_value_to_type_maybe(
+            idx,
+            LLVMGetElementType(LLVMTypeOf(selector_loc)),
+            ctx
+        ),
+        selector_loc
+    );
+}
+
+LLVMValueRef bllvm_union_get_selector(LLVMValueRef union_ptr,
+                                      struct llvm_traversal_ctx *ctx)
+{
+    LLVMValueRef selector = LLVMBuildLoad(
+        ctx->builder,
+        bllvm_gep_to_struct(union_ptr, 0, ctx),
+        ""
+    );
+    // widen it back from the compact selector type
+    return LLVMBuildZExtOrBitCast(
+        ctx->builder,
+        selector,
+        LLVMInt32TypeInContext(ctx->llvm_context),
+        ""
+    );
+}
+
 LLVMTypeRef bllvm_compile_typedef(const struct rir_typedef *def,
                                   struct llvm_traversal_ctx *ctx)
 {
     llvm_traversal_ctx_reset_params(ctx);
-    // else it's the same thing but just need to add an extra index for the union
     LLVMTypeRef llvm_type = bllvm_create_struct(ctx, &def->name);
     bllvm_rir_to_llvm_types(&def->argument_types, ctx);
-    if (def->is_union) { // add the member selector in the beginning
-        llvm_traversal_ctx_prepend_param(ctx, LLVMInt32TypeInContext(ctx->llvm_context));
+    if (def->is_union) {
+        bllvm_union_set_body(llvm_type, llvm_traversal_ctx_get_param_count(ctx), ctx);
+    } else {
+        // not packed, so that members get their natural target alignment
+        LLVMStructSetBody(
+            llvm_type,
+            llvm_traversal_ctx_get_params(ctx),
+            llvm_traversal_ctx_get_param_count(ctx),
+            false
+        );
     }
-    LLVMStructSetBody(llvm_type, llvm_traversal_ctx_get_params(ctx), llvm_traversal_ctx_get_param_count(ctx), true);
     llvm_traversal_ctx_reset_params(ctx);
     return llvm_type;
 }
 
+LLVMTypeRef bllvm_declare_typedef(const struct rir_typedef *def,
+                                  struct llvm_traversal_ctx *ctx)
+{
+    RFS_PUSH();
+    LLVMTypeRef llvm_type = LLVMGetTypeByName(
+        ctx->llvm_mod,
+        rf_string_cstr_from_buff_or_die(&def->name)
+    );
+    RFS_POP();
+    return llvm_type ? llvm_type : bllvm_compile_typedef(def, ctx);
+}
+
 LLVMTypeRef bllvm_elementary_to_type(enum elementary_type etype,
                                      struct llvm_traversal_ctx *ctx)
 {
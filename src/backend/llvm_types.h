@@ -12,6 +12,7 @@ struct rir_type;
 struct type;
 struct llvm_traversal_ctx;
 struct LLVMOpaqueType;
+struct LLVMOpaqueValue;
 struct rir_typedef;
 struct rir_type_arr;
 
@@ -47,6 +48,36 @@ bool rir_types_map_add(struct rir_types_map *m,
 struct LLVMOpaqueType *rir_types_map_get(struct rir_types_map *m,
                                          struct rir_type *rtype);
 
+/**
+ * Get the smallest integer type that can hold the selector of a union with
+ * @a members_num members
+ */
+struct LLVMOpaqueType *bllvm_union_selector_type(size_t members_num,
+                                                 struct llvm_traversal_ctx *ctx);
+
+/**
+ * Store the index of the active member of a union
+ *
+ * @param union_ptr   Pointer to the union
+ * @param idx         The index of the member. Any integer type, narrowed to
+ *                    the selector type of the union.
+ * @param ctx         The llvm traversal context
+ * @return            The store instruction
+ */
+struct LLVMOpaqueValue *bllvm_union_set_selector(struct LLVMOpaqueValue *union_ptr,
+                                                 struct LLVMOpaqueValue *idx,
+                                                 struct llvm_traversal_ctx *ctx);
+
+/**
+ * Load the index of the active member of a union as an i32
+ *
+ * @param union_ptr   Pointer to the union
+ * @param ctx         The llvm traversal context
+ * @return            The index widened to an i32
+ */
+struct LLVMOpaqueValue *bllvm_union_get_selector(struct LLVMOpaqueValue *union_ptr,
+                                                 struct llvm_traversal_ctx *ctx);
+
 /**
  * Compiles a typedef
  *
@@ -57,6 +88,20 @@ struct LLVMOpaqueType *rir_types_map_get(struct rir_types_map *m,
 struct LLVMOpaqueType *bllvm_compile_typedef(const struct rir_typedef *def,
                                              struct llvm_traversal_ctx *ctx);
 
+/**
+ * Declare a typedef owned by another module
+ *
+ * Named structs belong to the LLVM context, so a typedef already compiled
+ * for the module that created it is only looked up. It is compiled only if
+ * the context does not know it yet.
+ *
+ * @param def         The typedef to declare
+ * @param ctx         The llvm traversal context
+ * @return            The LLVM type for the struct or NULL in error
+ */
+struct LLVMOpaqueType *bllvm_declare_typedef(const struct rir_typedef *def,
+                                             struct llvm_traversal_ctx *ctx);
+
 /**
  * Compile a type as internal type declaration
  * @param type        The type to compile
@@ -5,9 +5,19 @@
 #include <stdio.h>
 #include <llvm-c/Core.h>
 #include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+#if RF_LLVM_VERSION_MAJOR >= 9
+#include <llvm-c/DebugInfo.h>
+#endif
+
+#include <info/info.h>
 
 #include "llvm_ast.h"
 
+// aggregates up to this size in bytes are copied through registers with a
+// load and a store, bigger ones with a call to memcpy
+#define BLLVM_SMALL_AGGREGATE_SIZE 16
+
 void bllvm_val_debug(LLVMValueRef v, const char *val_name)
 {
     char *str = LLVMPrintValueToString(v);
@@ -129,6 +139,10 @@ void bllvm_store(LLVMValueRef val,
 {
     LLVMTypeRef ptr_element_type = LLVMGetElementType(LLVMTypeOf(ptr));
     if (LLVMTypeOf(val) == LLVMTypeOf(ptr) && !bllvm_type_is_elementary(ctx, ptr_element_type)) {
+        if (val == ptr) {
+            // copying an aggregate onto itself
+            return;
+        }
         // string is a special case
         if (ptr_element_type == bllvm_type_string(ctx->llvm_mod)) {
             bllvm_copy_string(val, ptr, ctx);
@@ -183,6 +197,34 @@ LLVMValueRef bllvm_add_br(struct LLVMOpaqueBasicBlock *target,
     return (!last_instruction || !LLVMIsATerminatorInst(last_instruction))
         ? LLVMBuildBr(ctx->builder, target) : NULL;
 }
+
+void bllvm_add_vectorize_hint(LLVMValueRef br, struct llvm_traversal_ctx *ctx)
+{
+#if RF_LLVM_VERSION_MAJOR >= 9
+    static const char loop_kind[] = "llvm.loop";
+    static const char vectorize_enable[] = "llvm.loop.vectorize.enable";
+    LLVMMetadataRef enable_ops[] = {
+        LLVMMDStringInContext2(ctx->llvm_context, vectorize_enable, sizeof(vectorize_enable) - 1),
+        LLVMValueAsMetadata(LLVMConstInt(LLVMInt1TypeInContext(ctx->llvm_context), 1, 0))
+    };
+    // the first operand of a loop id has to be the loop id itself
+    LLVMMetadataRef self = LLVMTemporaryMDNode(ctx->llvm_context, NULL, 0);
+    LLVMMetadataRef loop_ops[] = {
+        self,
+        LLVMMDNodeInContext2(ctx->llvm_context, enable_ops, 2)
+    };
+    LLVMMetadataRef loop_id = LLVMMDNodeInContext2(ctx->llvm_context, loop_ops, 2);
+    LLVMMetadataReplaceAllUsesWith(self, loop_id);
+    LLVMSetMetadata(
+        br,
+        LLVMGetMDKindIDInContext(ctx->llvm_context, loop_kind, sizeof(loop_kind) - 1),
+        LLVMMetadataAsValue(ctx->llvm_context, loop_id)
+    );
+#else
+    (void)br;
+    (void)ctx;
+#endif
+}
  
 void bllvm_memcpy(struct LLVMOpaqueValue *from,
                   struct LLVMOpaqueValue *to,
@@ -195,6 +237,10 @@ void bllvm_memcpy(struct LLVMOpaqueValue *from,
     uint32_t from_size = LLVMStoreSizeOfType(ctx->target_data, from_elem_type);
     uint32_t to_size =  LLVMStoreSizeOfType(ctx->target_data, to_elem_type);
     RF_ASSERT(to_size >= from_size, "Called memcpy with to_size < from_size");
+    if (from_elem_type == to_elem_type && from_size <= BLLVM_SMALL_AGGREGATE_SIZE) {
+        LLVMBuildStore(ctx->builder, LLVMBuildLoad(ctx->builder, from, ""), to);
+        return;
+    }
     bllvm_memcpyn(from, to, from_size, ctx);
 }
 
@@ -241,6 +287,47 @@ struct LLVMOpaqueValue *bllvm_gep_to_struct(struct LLVMOpaqueValue *ptr,
     return LLVMBuildGEP(ctx->builder, ptr, indices, 2, "");    
 }
 
+bool bllvm_set_native_target(struct LLVMOpaqueModule *mod)
+{
+    LLVMTargetRef target;
+    LLVMTargetMachineRef machine;
+    char *error = NULL;
+    char *triple = LLVMGetDefaultTargetTriple();
+    bool ret = false;
+    if (LLVMGetTargetFromTriple(triple, &target, &error)) {
+        bllvm_error("Could not get the native LLVM target", &error);
+        goto end;
+    }
+    machine = LLVMCreateTargetMachine(
+        target,
+        triple,
+        "",
+        "",
+        LLVMCodeGenLevelDefault,
+        LLVMRelocDefault,
+        LLVMCodeModelDefault
+    );
+    if (!machine) {
+        ERROR("Could not create the native LLVM target machine");
+        goto end;
+    }
+    LLVMSetTarget(mod, triple);
+#if (RF_LLVM_VERSION_MAJOR == 3 && RF_LLVM_VERSION_MINOR >= 9) || RF_LLVM_VERSION_MAJOR >= 4
+    LLVMTargetDataRef tdata = LLVMCreateTargetDataLayout(machine);
+    LLVMSetModuleDataLayout(mod, tdata);
+    LLVMDisposeTargetData(tdata);
+#else
+    char *layout = LLVMCopyStringRepOfTargetData(LLVMGetTargetMachineData(machine));
+    LLVMSetDataLayout(mod, layout);
+    LLVMDisposeMessage(layout);
+#endif
+    LLVMDisposeTargetMachine(machine);
+    ret = true;
+end:
+    LLVMDisposeMessage(triple);
+    return ret;
+}
+
 unsigned long long bllvm_type_storagesize(
     struct LLVMOpaqueTargetData *tdata,
     struct LLVMOpaqueType *type,
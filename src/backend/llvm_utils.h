@@ -1,6 +1,7 @@
 #ifndef LFR_BACKEND_LLVM_UTILS_H
 #define LFR_BACKEND_LLVM_UTILS_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #if RF_LLVM_VERSION_MAJOR >= 3 && RF_LLVM_VERSION_MINOR > 7
@@ -99,6 +100,17 @@ struct LLVMOpaqueBasicBlock *bllvm_add_fatal_block_before(struct LLVMOpaqueBasic
 struct LLVMOpaqueValue *bllvm_add_br(struct LLVMOpaqueBasicBlock *target,
                                      struct llvm_traversal_ctx *ctx);
 
+/**
+ * Attach loop metadata to the back edge branch of a loop, asking LLVM to
+ * vectorize the loop. Does nothing for LLVM versions without the C API to
+ * create the self referencing loop id.
+ *
+ * @param br        The branch instruction of the loop's back edge
+ * @param ctx       The llvm traversal context
+ */
+void bllvm_add_vectorize_hint(struct LLVMOpaqueValue *br,
+                              struct llvm_traversal_ctx *ctx);
+
 /**
  * Memcpy a pointer value.
  *
@@ -140,6 +152,17 @@ struct LLVMOpaqueValue *bllvm_gep_to_struct(struct LLVMOpaqueValue *ptr,
                                             unsigned int member_num,
                                             struct llvm_traversal_ctx *ctx);
 
+/**
+ * Set the target triple and data layout of the host to a module
+ *
+ * Needs to happen before any type is laid out with the module's target data,
+ * since sizes, alignments and padding all depend on the target. On failure
+ * the module keeps LLVM's default layout.
+ *
+ * @return      true if the native target could be set, false otherwise
+ */
+bool bllvm_set_native_target(struct LLVMOpaqueModule *mod);
+
 unsigned long long  bllvm_type_storagesize(
     struct LLVMOpaqueTargetData *tdata,
     struct LLVMOpaqueType *type,
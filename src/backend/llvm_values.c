@@ -23,7 +23,7 @@ void *bllvm_value_from_rir_value(
         return bllvm_compile_literal(&v->literal, ctx);
     }
     // otherwise search the mapping
-    void *ret =  strmap_get(&ctx->valmap, &v->id);
+    void *ret = llvm_traversal_ctx_mapped_val(ctx, v);
     if (!ret) {
         // if not found in rir val to llvm map, it may not have been added yet.
         // This can happen for function arguments so check if value is one
@@ -7,7 +7,9 @@
 #include <rfbase/system/system.h>
 
 #include <utils/string_set.h>
+#include <utils/stats.h>
 #include <info/info.h>
+#include <info/diagnostics.h>
 #include <types/type_comparisons.h>
 #include <module.h>
 #include <compiler_args.h>
@@ -17,7 +19,9 @@
 #include <serializer/serializer.h>
 #include <backend/llvm.h>
 #include <ir/rir.h>
+#include <ir/rir_interp.h>
 #include <ir/rir_utils.h>
+#include <ir/passes/rir_passes.h>
 #include <ir/parser/rirparser.h>
 
 struct rir_module;
@@ -130,6 +134,9 @@ struct front_ctx *compiler_new_front(
         return NULL;
     }
 
+    if (c->diag) {
+        info_ctx_inject_diag(front->info, c->diag);
+    }
     rf_ilist_add(&c->front_ctxs, &front->ln);
     return front;
 }
@@ -151,11 +158,16 @@ static void compiler_deinit(struct compiler *c)
     rir_utils_destroy();
 
 
+    if (c->diag) {
+        info_diag_destroy(c->diag);
+    }
     serializer_destroy(c->serializer);
     compiler_args_destroy(c->args);
     typecmp_ctx_deinit();
     rf_stringx_deinit(&c->err_buff);
     rf_string_deinit(&c->llc_exec_path);
+    compiler_cache_deinit(&c->cache);
+    stats_deinit();
     rf_deinit();
 }
 
@@ -208,6 +220,20 @@ bool compiler_pass_args(int argc, char **argv)
         return true;
     }
 
+    if (compiler_args_time_passes(c->args)) {
+        stats_enable();
+    }
+
+    // machine readable messages are streamed while compiling
+    enum info_diag_format diag_format;
+    if (!compiler_args_diagnostics_format(c->args, &diag_format)) {
+        return false;
+    }
+    if (diag_format != INFO_DIAG_FORMAT_TEXT &&
+        !(c->diag = info_diag_create(diag_format, stderr))) {
+        return false;
+    }
+
     // add all input files as new fronts
     unsigned i;
     for (i = 0; i < compiler_args_get_input_num(c->args); ++i) {
@@ -333,11 +359,14 @@ bool compiler_preprocess_fronts()
     struct front_ctx *front;
     bool ret = false;
     // make sure all files are parsed
+    stats_phase_begin("frontend");
     rf_ilist_for_each(&c->front_ctxs, front, ln) {
         if (!front_ctx_parse(front)) {
+            stats_phase_end();
             return false;
         }
     }
+    stats_phase_end();
 
     // determine the dependencies of all the modules
     struct rf_objset_string mod_names_set;
@@ -384,23 +413,56 @@ bool compiler_analyze()
     struct compiler *c = g_compiler_instance;
     // analyze the modules that came from AST source parsing in the topologically sorted order
     struct module *mod;
+    bool ret = true;
+    stats_phase_begin("analyze");
     rf_ilist_for_each(&c->sorted_modules, mod, ln) {
         if (module_rir_codepath(mod) == RIRPOS_AST) {
             if (!module_analyze(mod)) {
-                return false;
+                ret = false;
+                break;
             }
         }
     }
-    return true;
+    stats_phase_end();
+    return ret;
 }
 
-bool compiler_process()
+/**
+ * Run the main module's RIR with the interpreter and keep its return value
+ */
+static bool compiler_interpret(struct compiler *c)
 {
-    struct compiler *c = g_compiler_instance;
+    struct module **mod;
+    struct rir_interp *in;
+    bool ret;
+    darray_foreach(mod, c->modules) {
+        if (module_is_main(*mod)) {
+            if (!(in = rir_interp_create((*mod)->rir))) {
+                return false;
+            }
+            ret = rir_interp_run_main(in, &c->run_retcode);
+            rir_interp_destroy(in);
+            return ret;
+        }
+    }
+    RF_ERROR("Could not find the main module to interpret");
+    return false;
+}
 
+static bool compiler_process_do(struct compiler *c)
+{
     // add the standard library to the front contexts
     struct front_ctx *stdlib_front;
     static const struct RFstring stdlib = RF_STRING_STATIC_INIT(RF_LANG_CORE_ROOT"/stdlib/io.rf");
+    bool ok;
+
+    // if nothing changed since the last compilation reuse its executable
+    compiler_cache_init(&c->cache, c->args, &stdlib);
+    if (compiler_cache_fetch(&c->cache, compiler_args_get_executable_name(c->args))) {
+        compiler_cache_print_stats(&c->cache, c->args);
+        return true;
+    }
+
     if (!(stdlib_front = compiler_new_front(c, RIRPOS_AST, &stdlib, NULL))) {
         RF_ERROR("Failed to add standard library to the front_ctxs");
         return false;
@@ -422,13 +484,28 @@ bool compiler_process()
 #endif
 
     // create the Refu Intermediate Format
-    if (!compiler_create_rir(c)) {
+    stats_phase_begin("rir");
+    ok = compiler_create_rir(c);
+    stats_phase_end();
+    if (!ok) {
         RF_ERROR("Failed to process the Refu IR");
         return false;
     }
 
+    // optimize the IR before analyzing it, so --print-rir shows the result
+    stats_phase_begin("rir_passes");
+    ok = rir_passes_run(c);
+    stats_phase_end();
+    if (!ok) {
+        RF_ERROR("Failed to optimize the Refu IR");
+        return false;
+    }
+
     // perform ownership analysis on the created IR
-    if (!ownership_pass(c)) {
+    stats_phase_begin("ownership");
+    ok = ownership_pass(c);
+    stats_phase_end();
+    if (!ok) {
         RF_ERROR("Failed at ownership pass");
         return false;
     }
@@ -443,14 +520,38 @@ bool compiler_process()
         return true;
     }
 
+    if (compiler_args_interpret(c->args)) {
+        if (!compiler_interpret(c)) {
+            RF_ERROR("Failed to interpret the Refu IR");
+            return false;
+        }
+        return true;
+    }
+
     if (!bllvm_generate(&c->modules, c->args)) {
         RF_ERROR("Failed to create the LLVM IR from the Refu IR");
         return false;
     }
 
+    compiler_cache_store(&c->cache, compiler_args_get_executable_name(c->args));
+    compiler_cache_print_stats(&c->cache, c->args);
     return true;
 }
 
+bool compiler_process()
+{
+    struct compiler *c = g_compiler_instance;
+    bool ret;
+    stats_phase_begin("total");
+    ret = compiler_process_do(c);
+    stats_phase_end();
+    // also printed on failure, to see how far compilation got
+    if (stats_enabled()) {
+        stats_print(stderr, compiler_args_stats_format(c->args));
+    }
+    return ret;
+}
+
 bool compiler_help_requested(struct compiler *c)
 {
     return compiler_args_check_and_display_help(c->args);
@@ -494,6 +595,11 @@ static inline void compiler_print_errors_common(struct RFstringx *str, struct co
 
 void compiler_print_errors(struct compiler *c)
 {
+    if (c->diag) {
+        // the messages got written as they were produced
+        info_diag_end(c->diag);
+        return;
+    }
     struct RFstringx *str = compiler_get_errors(c);
     compiler_print_errors_common(str, c);
 }
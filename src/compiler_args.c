@@ -34,6 +34,14 @@ static const char* version_message = ""
         (_ca)->input_rir,                       \
         (_ca)->rir_print,                       \
         (_ca)->llvm_ir_print,                   \
+        (_ca)->jit_run,                         \
+        (_ca)->interpret,                       \
+        (_ca)->no_cache,                        \
+        (_ca)->no_rir_opt,                      \
+        (_ca)->rir_jobs,                        \
+        (_ca)->diagnostics_format,              \
+        (_ca)->time_passes,                     \
+        (_ca)->stats_format,                    \
         (_ca)->positional_file,                 \
         (_ca)->end                              \
     }                                           \
@@ -90,6 +98,53 @@ bool compiler_args_init(struct compiler_args *a)
         "llvm-ir",
         "If given will output the LLVM IR in a file"
     );
+    a->jit_run = arg_lit0(
+        NULL,
+        "run",
+        "If given will JIT compile and run the program in process and exit with its return value"
+    );
+    a->interpret = arg_lit0(
+        NULL,
+        "interpret",
+        "If given will run the program's intermediate representation with the interpreter and exit with its return value"
+    );
+    a->no_cache = arg_lit0(
+        NULL,
+        "no-cache",
+        "If given the compilation cache will be neither read nor updated"
+    );
+    a->no_rir_opt = arg_lit0(
+        NULL,
+        "no-rir-opt",
+        "If given the intermediate representation will not be optimized"
+    );
+    a->rir_jobs = arg_int0(
+        NULL,
+        "rir-jobs",
+        "<n>",
+        "Number of threads to use for creating the intermediate representation of each module's functions and analyzing their ownership. Defaults to 1"
+    );
+    a->diagnostics_format = arg_rex0(
+        NULL,
+        "diagnostics-format",
+        "^(text|json|sarif)$",
+        "text|json|sarif",
+        0,
+        "Format of the compiler's messages. json and sarif are written to stderr as the messages are produced. Defaults to text"
+    );
+    a->time_passes = arg_lit0(
+        NULL,
+        "time-passes",
+        "If given will print to stderr the time, peak memory and counters of each compilation phase"
+    );
+    a->stats_format = arg_rex0(
+        NULL,
+        "stats",
+        "^(table|json)$",
+        "table|json",
+        0,
+        "Print the statistics of --time-passes in the given format. Implies --time-passes. Defaults to table"
+    );
     a->positional_file = arg_filen(
         NULL,
         NULL,
@@ -102,6 +157,7 @@ bool compiler_args_init(struct compiler_args *a)
 
     // set default values
     a->verbosity->ival[0] = RF_OPTION_VERBOSE_LEVEL_DEFAULT;
+    a->rir_jobs->ival[0] = 1;
 
     rf_stringx_init_buff(&a->buff, 128, "");
 
@@ -215,6 +271,12 @@ bool compiler_args_parse(struct compiler_args *args, int argc, char** argv)
         exit(1);
     }
 
+    // unknown values should not silently fall back to the default format
+    enum info_diag_format diag_format;
+    if (!compiler_args_diagnostics_format(args, &diag_format)) {
+        return false;
+    }
+
     // handle input new
     if (!compiler_args_read_input(args)) {
         return false;
@@ -249,6 +311,11 @@ bool compiler_args_help_is_requested(const struct compiler_args *args)
     return args->help->count > 0 || args->version->count > 0;
 }
 
+const char *compiler_args_backend(const struct compiler_args *args)
+{
+    return args->backend->count > 0 ? args->backend->sval[0] : NULL;
+}
+
 bool compiler_args_print_backend_debug(const struct compiler_args *args)
 {
     return args->backend_debug->count > 0;
@@ -264,11 +331,77 @@ bool compiler_args_print_rir(const struct compiler_args *args)
     return args->rir_print->count > 0;
 }
 
+bool compiler_args_jit_run(const struct compiler_args *args)
+{
+    return args->jit_run->count > 0;
+}
+
+bool compiler_args_interpret(const struct compiler_args *args)
+{
+    return args->interpret->count > 0;
+}
+
 bool compiler_arg_input_is_rir(const struct compiler_args *args)
 {
     return args->input_rir->count > 0;
 }
 
+bool compiler_args_no_cache(const struct compiler_args *args)
+{
+    return args->no_cache->count > 0;
+}
+
+bool compiler_args_no_rir_opt(const struct compiler_args *args)
+{
+    return args->no_rir_opt->count > 0;
+}
+
+unsigned compiler_args_rir_jobs(const struct compiler_args *args)
+{
+    return args->rir_jobs->ival[0] > 1 ? args->rir_jobs->ival[0] : 1;
+}
+
+bool compiler_args_diagnostics_format(const struct compiler_args *args,
+                                      enum info_diag_format *format)
+{
+    const char *s;
+    if (args->diagnostics_format->count == 0) {
+        *format = INFO_DIAG_FORMAT_TEXT;
+        return true;
+    }
+    s = args->diagnostics_format->sval[0];
+    if (strcmp(s, "text") == 0) {
+        *format = INFO_DIAG_FORMAT_TEXT;
+    } else if (strcmp(s, "json") == 0) {
+        *format = INFO_DIAG_FORMAT_JSON;
+    } else if (strcmp(s, "sarif") == 0) {
+        *format = INFO_DIAG_FORMAT_SARIF;
+    } else {
+        ERROR("Unknown diagnostics format \"%s\"", s);
+        return false;
+    }
+    return true;
+}
+
+bool compiler_args_time_passes(const struct compiler_args *args)
+{
+    return args->time_passes->count > 0 || args->stats_format->count > 0;
+}
+
+enum stats_format compiler_args_stats_format(const struct compiler_args *args)
+{
+    if (args->stats_format->count > 0 &&
+        strcmp(args->stats_format->sval[0], "json") == 0) {
+        return STATS_FORMAT_JSON;
+    }
+    return STATS_FORMAT_TABLE;
+}
+
+int compiler_args_get_verbosity(const struct compiler_args *args)
+{
+    return args->verbosity->ival[0];
+}
+
 bool compiler_args_output_ast(struct compiler_args *args,
                               struct RFstring **name)
 {
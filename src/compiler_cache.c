@@ -0,0 +1,307 @@
+#include <compiler_cache.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <rfbase/utils/memory.h>
+#include <rfbase/string/core.h>
+
+#include <info/info.h>
+#include <compiler_args.h>
+
+#define CACHE_FNV_OFFSET 14695981039346656037ULL
+#define CACHE_FNV_PRIME 1099511628211ULL
+// cache messages are only shown at this verbosity level or higher
+#define CACHE_VERBOSITY 2
+
+#define i_eval(_def) #_def
+#define i_str(_def) i_eval(_def)
+static const char *cache_version_str = ""
+    i_str(RF_LANG_MAJOR_VERSION) "." i_str(RF_LANG_MINOR_VERSION) "."
+    i_str(RF_LANG_PATCH_VERSION) "-llvm" RF_LLVM_VERSION;
+#undef i_str
+#undef i_eval
+// only used where the compiler executable can't be found
+static const char *cache_build_str = __DATE__ " " __TIME__;
+
+static uint64_t cache_hash_bytes(uint64_t h, const void *data, size_t size)
+{
+    const unsigned char *p = data;
+    size_t i;
+    for (i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= CACHE_FNV_PRIME;
+    }
+    return h;
+}
+
+static bool cache_hash_file(uint64_t *h, const char *name)
+{
+    char buff[4096];
+    size_t n;
+    FILE *f = fopen(name, "rb");
+    if (!f) {
+        return false;
+    }
+    // the name is part of the key since module names come from file names
+    *h = cache_hash_bytes(*h, name, strlen(name) + 1);
+    while ((n = fread(buff, 1, sizeof(buff), f)) > 0) {
+        *h = cache_hash_bytes(*h, buff, n);
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * Hash what identifies the build of the running compiler, so that rebuilding
+ * the compiler invalidates everything that it cached before
+ */
+static uint64_t cache_hash_build(uint64_t h)
+{
+    struct stat st;
+    h = cache_hash_bytes(h, cache_version_str, strlen(cache_version_str));
+    // like ccache, trust the size and modification time of the executable
+    // instead of reading all of it for every compilation
+    if (stat("/proc/self/exe", &st) == 0) {
+        h = cache_hash_bytes(h, &st.st_size, sizeof(st.st_size));
+        h = cache_hash_bytes(h, &st.st_mtime, sizeof(st.st_mtime));
+        h = cache_hash_bytes(h, &st.st_ino, sizeof(st.st_ino));
+    } else {
+        h = cache_hash_bytes(h, cache_build_str, strlen(cache_build_str));
+    }
+    return h;
+}
+
+/**
+ * Hash all the arguments that change the generated executable.
+ *
+ * Arguments that only change what is printed, where the output goes or how
+ * many threads do the work are left out.
+ */
+static uint64_t cache_hash_args(uint64_t h, const struct compiler_args *args)
+{
+    bool no_rir_opt = compiler_args_no_rir_opt(args);
+    const char *backend = compiler_args_backend(args);
+    h = cache_hash_bytes(h, &no_rir_opt, sizeof(no_rir_opt));
+    if (backend) {
+        h = cache_hash_bytes(h, backend, strlen(backend) + 1);
+    }
+    return h;
+}
+
+static bool cache_copy_file(const char *from, const char *to)
+{
+    char buff[4096];
+    size_t n;
+    bool ret = false;
+    FILE *in;
+    FILE *out;
+
+    if (!(in = fopen(from, "rb"))) {
+        return false;
+    }
+    if (!(out = fopen(to, "wb"))) {
+        goto close_in;
+    }
+    while ((n = fread(buff, 1, sizeof(buff), in)) > 0) {
+        if (fwrite(buff, 1, n, out) != n) {
+            goto close_out;
+        }
+    }
+    ret = !ferror(in);
+
+close_out:
+    if (fclose(out) != 0) {
+        ret = false;
+    }
+close_in:
+    fclose(in);
+    return ret;
+}
+
+static bool cache_make_dir(const char *name)
+{
+    return mkdir(name, 0755) == 0 || errno == EEXIST;
+}
+
+static bool compiler_cache_is_usable(const struct compiler_args *args)
+{
+    // anything that asks for intermediate output or does not produce an
+    // executable has to go through the whole pipeline
+    return !compiler_args_no_cache(args) &&
+        !compiler_args_jit_run(args) &&
+        !compiler_args_interpret(args) &&
+        !compiler_args_print_rir(args) &&
+        !compiler_args_print_llvm_ir(args) &&
+        !compiler_args_print_backend_debug(args) &&
+        !compiler_arg_input_is_rir(args) &&
+        args->output_ast->count == 0;
+}
+
+static bool compiler_cache_set_dir(struct compiler_cache *c)
+{
+    const char *base = getenv("XDG_CACHE_HOME");
+    bool ret = false;
+    RFS_PUSH();
+    if (!base || *base == '\0') {
+        const char *home = getenv("HOME");
+        if (!home) {
+            goto end;
+        }
+        base = rf_string_data(RFS_NT_OR_DIE("%s/.cache", home));
+    }
+    if (!cache_make_dir(base)) {
+        goto end;
+    }
+    if (!rf_string_initv(&c->dir, "%s/refu", base)) {
+        goto end;
+    }
+    if (!cache_make_dir(rf_string_data(RFS_NT_OR_DIE(RFS_PF, RFS_PA(&c->dir))))) {
+        rf_string_deinit(&c->dir);
+        goto end;
+    }
+    ret = true;
+end:
+    RFS_POP();
+    return ret;
+}
+
+void compiler_cache_init(struct compiler_cache *c,
+                         struct compiler_args *args,
+                         const struct RFstring *stdlib)
+{
+    unsigned i;
+    RF_STRUCT_ZERO(c);
+    if (compiler_args_no_cache(args)) {
+        return;
+    }
+
+    RFS_PUSH();
+    // the standard library is lowered by this build with the same arguments
+    // as the inputs, so whatever changes their code changes its code too
+    c->stdlib_key = cache_hash_build(CACHE_FNV_OFFSET);
+    c->stdlib_key = cache_hash_args(c->stdlib_key, args);
+    if (!cache_hash_file(&c->stdlib_key, rf_string_data(RFS_NT_OR_DIE(RFS_PF, RFS_PA(stdlib))))) {
+        goto end;
+    }
+    if (!(c->have_dir = compiler_cache_set_dir(c))) {
+        goto end;
+    }
+    // backend debug output is printed while lowering each module
+    c->stdlib_enabled = !compiler_args_print_backend_debug(args);
+
+    if (!compiler_cache_is_usable(args)) {
+        goto end;
+    }
+    c->key = c->stdlib_key;
+    for (i = 0; i < compiler_args_get_input_num(args); ++i) {
+        // stdin input can't be hashed before it's consumed
+        if (!cache_hash_file(
+                &c->key,
+                rf_string_data(RFS_NT_OR_DIE(RFS_PF, RFS_PA(&args->input_files[i])))
+            )) {
+            goto end;
+        }
+    }
+    c->enabled = true;
+end:
+    RFS_POP();
+}
+
+void compiler_cache_deinit(struct compiler_cache *c)
+{
+    if (c->have_dir) {
+        rf_string_deinit(&c->dir);
+    }
+}
+
+bool compiler_cache_fetch(struct compiler_cache *c, const struct RFstring *exe_name)
+{
+    bool hit = false;
+    if (!c->enabled) {
+        return false;
+    }
+    RFS_PUSH();
+    const char *cached = rf_string_data(
+        RFS_NT_OR_DIE(RFS_PF"/%016"PRIx64".exe", RFS_PA(&c->dir), c->key)
+    );
+    const char *out = rf_string_data(RFS_NT_OR_DIE(RFS_PF".exe", RFS_PA(exe_name)));
+    if (access(cached, R_OK) == 0 &&
+        cache_copy_file(cached, out) &&
+        chmod(out, 0755) == 0) {
+        hit = true;
+    }
+    RFS_POP();
+
+    if (hit) {
+        c->hits++;
+    } else {
+        c->misses++;
+    }
+    return hit;
+}
+
+void compiler_cache_store(struct compiler_cache *c, const struct RFstring *exe_name)
+{
+    if (!c->enabled) {
+        return;
+    }
+    RFS_PUSH();
+    const char *cached = rf_string_data(
+        RFS_NT_OR_DIE(RFS_PF"/%016"PRIx64".exe", RFS_PA(&c->dir), c->key)
+    );
+    // copy to a temporary file and rename, so that concurrent compilations
+    // never see a partially written artifact
+    const char *tmp = rf_string_data(
+        RFS_NT_OR_DIE(RFS_PF"/%016"PRIx64".%ld.tmp", RFS_PA(&c->dir), c->key, (long)getpid())
+    );
+    const char *out = rf_string_data(RFS_NT_OR_DIE(RFS_PF".exe", RFS_PA(exe_name)));
+    if (!cache_copy_file(out, tmp) || rename(tmp, cached) != 0) {
+        WARN("Could not store \"%s\" in the compilation cache", out);
+        remove(tmp);
+    }
+    RFS_POP();
+}
+
+const struct RFstring *compiler_cache_stdlib_path(const struct compiler_cache *c)
+{
+    if (!c->stdlib_enabled) {
+        return NULL;
+    }
+    return RFS_NT_OR_DIE(RFS_PF"/stdlib-%016"PRIx64".bc", RFS_PA(&c->dir), c->stdlib_key);
+}
+
+void compiler_cache_stdlib_loaded(struct compiler_cache *c, bool hit)
+{
+    if (hit) {
+        c->stdlib_hits++;
+    } else {
+        c->stdlib_misses++;
+    }
+}
+
+void compiler_cache_print_stats(const struct compiler_cache *c,
+                                const struct compiler_args *args)
+{
+    if (!c->enabled || compiler_args_get_verbosity(args) < CACHE_VERBOSITY) {
+        return;
+    }
+    printf(
+        "refu: [cache] key %016"PRIx64" in "RFS_PF": %u hit/s, %u miss/es\n",
+        c->key,
+        RFS_PA(&c->dir),
+        c->hits,
+        c->misses
+    );
+    printf(
+        "refu: [cache] stdlib key %016"PRIx64": %u hit/s, %u miss/es\n",
+        c->stdlib_key,
+        c->stdlib_hits,
+        c->stdlib_misses
+    );
+}
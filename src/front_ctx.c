@@ -1,6 +1,7 @@
 #include <front_ctx.h>
 
 #include <utils/common_strings.h>
+#include <utils/stats.h>
 #include <module.h>
 #include <compiler_args.h>
 #include <compiler.h>
@@ -123,11 +124,18 @@ bool front_ctx_make_main(struct front_ctx *f, struct ast_node *n, struct rir *ri
 
 bool front_ctx_parse(struct front_ctx *ctx)
 {
-    if (!lexer_scan(ctx->lexer)) {
+    bool ok;
+    stats_phase_begin("lex");
+    ok = lexer_scan(ctx->lexer);
+    stats_phase_end();
+    if (!ok) {
         return false;
     }
 
-    if (!parser_parse(ctx->parser)) {
+    stats_phase_begin("parse");
+    ok = parser_parse(ctx->parser);
+    stats_phase_end();
+    if (!ok) {
         return false;
     }
 
@@ -0,0 +1,68 @@
+#include <info/arena.h>
+
+#include <string.h>
+
+#include <rfbase/utils/memory.h>
+
+//! Alignment good for any of the values stored in the arena
+#define INFO_ARENA_ALIGN 16
+
+void info_arena_init(struct info_arena *a)
+{
+    darray_init(a->chunks);
+    a->curr = 0;
+    a->used = 0;
+}
+
+void info_arena_deinit(struct info_arena *a)
+{
+    struct info_arena_chunk *c;
+    darray_foreach(c, a->chunks) {
+        free(c->data);
+    }
+    darray_free(a->chunks);
+}
+
+void *info_arena_alloc(struct info_arena *a, size_t size)
+{
+    struct info_arena_chunk c;
+    size = (size + INFO_ARENA_ALIGN - 1) & ~(size_t)(INFO_ARENA_ALIGN - 1);
+    // chunks after the current one are free after a rewind
+    while (a->curr < darray_size(a->chunks)) {
+        if (a->used + size <= darray_item(a->chunks, a->curr).size) {
+            a->used += size;
+            return darray_item(a->chunks, a->curr).data + a->used - size;
+        }
+        ++a->curr;
+        a->used = 0;
+    }
+    c.size = size > INFO_ARENA_CHUNK_SIZE ? size : INFO_ARENA_CHUNK_SIZE;
+    RF_MALLOC(c.data, c.size, return NULL);
+    darray_append(a->chunks, c);
+    a->curr = darray_size(a->chunks) - 1;
+    a->used = size;
+    return c.data;
+}
+
+char *info_arena_strndup(struct info_arena *a, const char *s, size_t len)
+{
+    char *ret;
+    if (!(ret = info_arena_alloc(a, len + 1))) {
+        return NULL;
+    }
+    memcpy(ret, s, len);
+    ret[len] = '\0';
+    return ret;
+}
+
+void info_arena_get_mark(const struct info_arena *a, struct info_arena_mark *m)
+{
+    m->chunk = a->curr;
+    m->used = a->used;
+}
+
+void info_arena_rewind(struct info_arena *a, const struct info_arena_mark *m)
+{
+    a->curr = m->chunk;
+    a->used = m->used;
+}
@@ -0,0 +1,168 @@
+#include <info/diagnostics.h>
+
+#include <rfbase/string/core.h>
+#include <rfbase/utils/log.h>
+#include <rfbase/utils/memory.h>
+
+#include <info/info.h>
+#include <info/msg.h>
+#include <inpfile.h>
+
+#define i_eval(_def) #_def
+#define i_str(_def) i_eval(_def)
+#define INFO_DIAG_VERSION_STR                           \
+    i_str(RF_LANG_MAJOR_VERSION) "."                    \
+    i_str(RF_LANG_MINOR_VERSION) "."                    \
+    i_str(RF_LANG_PATCH_VERSION)
+
+struct info_diag *info_diag_create(enum info_diag_format format, FILE *f)
+{
+    struct info_diag *d;
+    RF_MALLOC(d, sizeof(*d), return NULL);
+    d->format = format;
+    d->f = f;
+    d->written = 0;
+    d->ended = false;
+    if (format == INFO_DIAG_FORMAT_SARIF) {
+        fprintf(
+            f,
+            "{\"version\":\"2.1.0\","
+            "\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\","
+            "\"runs\":[{\"tool\":{\"driver\":{\"name\":\"refu\","
+            "\"version\":\"" INFO_DIAG_VERSION_STR "\"}},"
+            "\"results\":[\n"
+        );
+        fflush(f);
+    }
+    return d;
+}
+
+void info_diag_destroy(struct info_diag *d)
+{
+    info_diag_end(d);
+    free(d);
+}
+
+void info_diag_end(struct info_diag *d)
+{
+    if (d->ended) {
+        return;
+    }
+    if (d->format == INFO_DIAG_FORMAT_SARIF) {
+        fprintf(d->f, "\n]}]}\n");
+    }
+    fflush(d->f);
+    d->ended = true;
+}
+
+/**
+ * Write @a len bytes of @a s as the contents of a JSON string
+ */
+static void info_diag_write_escaped(FILE *f, const char *s, size_t len)
+{
+    size_t i;
+    unsigned char c;
+    for (i = 0; i < len; ++i) {
+        c = s[i];
+        switch (c) {
+        case '"':
+            fputs("\\\"", f);
+            break;
+        case '\\':
+            fputs("\\\\", f);
+            break;
+        case '\n':
+            fputs("\\n", f);
+            break;
+        case '\r':
+            fputs("\\r", f);
+            break;
+        case '\t':
+            fputs("\\t", f);
+            break;
+        default:
+            if (c < 0x20) {
+                fprintf(f, "\\u%04x", c);
+            } else {
+                fputc(c, f);
+            }
+        }
+    }
+}
+
+static void info_diag_write_string(FILE *f, const struct RFstring *s)
+{
+    fputc('"', f);
+    info_diag_write_escaped(f, rf_string_data(s), rf_string_length_bytes(s));
+    fputc('"', f);
+}
+
+static bool info_diag_msg_is_error(const struct info_msg *m)
+{
+    return m->type == MESSAGE_SEMANTIC_ERROR || m->type == MESSAGE_SYNTAX_ERROR;
+}
+
+static void info_diag_write_json(struct info_diag *d, struct info_msg *m, struct inpfile *file)
+{
+    FILE *f = d->f;
+    fputs("{\"file\":", f);
+    info_diag_write_string(f, inpfile_name(file));
+    if (m->start_mark.p) {
+        fprintf(f, ",\"line\":%u,\"column\":%u",
+                m->start_mark.line + 1, m->start_mark.col + 1);
+    }
+    // like in SARIF the end is the column right after the last character
+    if (info_msg_has_end_mark(m)) {
+        fprintf(f, ",\"end_line\":%u,\"end_column\":%u",
+                m->end_mark.line + 1, m->end_mark.col + 2);
+    }
+    fprintf(f, ",\"severity\":\"%s\",\"type\":",
+            info_diag_msg_is_error(m) ? "error" : "warning");
+    info_diag_write_string(f, info_msg_type_to_str(m->type));
+    fputs(",\"message\":", f);
+    info_diag_write_string(f, info_msg_str(m));
+    fputs("}\n", f);
+}
+
+static void info_diag_write_sarif(struct info_diag *d, struct info_msg *m, struct inpfile *file)
+{
+    FILE *f = d->f;
+    if (d->written != 0) {
+        fputs(",\n", f);
+    }
+    fprintf(f, "{\"level\":\"%s\",\"message\":{\"text\":",
+            info_diag_msg_is_error(m) ? "error" : "warning");
+    info_diag_write_string(f, info_msg_str(m));
+    fputs("},\"locations\":[{\"physicalLocation\":{\"artifactLocation\":{\"uri\":", f);
+    info_diag_write_string(f, inpfile_name(file));
+    fputc('}', f);
+    if (m->start_mark.p) {
+        fprintf(f, ",\"region\":{\"startLine\":%u,\"startColumn\":%u",
+                m->start_mark.line + 1, m->start_mark.col + 1);
+        // the end mark points at the last character while SARIF wants the
+        // column right after it
+        if (info_msg_has_end_mark(m)) {
+            fprintf(f, ",\"endLine\":%u,\"endColumn\":%u",
+                    m->end_mark.line + 1, m->end_mark.col + 2);
+        }
+        fputc('}', f);
+    }
+    fputs("}}]}", f);
+}
+
+bool info_diag_write(struct info_diag *d, struct info_msg *m, struct inpfile *file)
+{
+    if (d->ended) {
+        RF_ERROR("Tried to write a diagnostic after the end of the output");
+        return false;
+    }
+    if (d->format == INFO_DIAG_FORMAT_SARIF) {
+        info_diag_write_sarif(d, m, file);
+    } else {
+        info_diag_write_json(d, m, file);
+    }
+    ++d->written;
+    // consumers read the output while the compiler is still running
+    fflush(d->f);
+    return true;
+}
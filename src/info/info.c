@@ -2,6 +2,8 @@
 
 #include <rfbase/utils/bits.h>
 
+#include <info/arena.h>
+#include <info/diagnostics.h>
 #include <info/msg.h>
 #include <compiler_args.h>
 #include <inplocation.h>
@@ -11,6 +13,7 @@ static bool info_ctx_init(struct info_ctx *ctx, struct inpfile *f)
 {
     RF_STRUCT_ZERO(ctx);
     darray_init(ctx->last_msgs_arr);
+    info_arena_init(&ctx->arena);
     rf_ilist_head_init(&ctx->msg_list);
     if (!rf_stringx_init_buff(&ctx->buff, RF_OPTION_INFO_CTX_BUFF_INITIAL_SIZE, "")) {
         return false;
@@ -41,6 +44,7 @@ void info_ctx_destroy(struct info_ctx *ctx)
         info_msg_destroy(m);
     }
     darray_free(ctx->last_msgs_arr);
+    info_arena_deinit(&ctx->arena);
     rf_stringx_deinit(&ctx->buff);
     free(ctx);
 }
@@ -59,6 +63,26 @@ void info_print_cond(int vlevel, const char *fmt, ...)
 #endif
 
 
+/**
+ * Write the messages added since the last call to the diagnostics output.
+ * While something is pushed messages may still get rolled back so they are
+ * held back until the outermost pop.
+ */
+static void info_ctx_stream(struct info_ctx *ctx)
+{
+    struct RFilist_node *n;
+    struct info_msg *m;
+    if (!ctx->diag || !darray_empty(ctx->last_msgs_arr)) {
+        return;
+    }
+    n = ctx->diag_last ? ctx->diag_last->ln.next : ctx->msg_list.n.next;
+    for (; n != &ctx->msg_list.n; n = n->next) {
+        m = rf_ilist_entry(n, struct info_msg, ln);
+        info_diag_write(ctx->diag, m, ctx->file);
+        ctx->diag_last = m;
+    }
+}
+
 bool i_info_ctx_add_msg(struct info_ctx *ctx,
                         enum info_msg_type type,
                         const struct inplocation_mark *start,
@@ -70,7 +94,7 @@ bool i_info_ctx_add_msg(struct info_ctx *ctx,
     struct info_msg *msg;
 
     va_start(args, fmt);
-    msg = info_msg_create(type, start, end, fmt, args);
+    msg = info_msg_create(&ctx->arena, type, start, end, fmt, args);
     va_end(args);
 
     if (!msg) {
@@ -79,18 +103,37 @@ bool i_info_ctx_add_msg(struct info_ctx *ctx,
 
     rf_ilist_add_tail(&ctx->msg_list, &msg->ln);
     ctx->msg_num++;
+    ctx->type_counts[info_msg_type_index(type)]++;
+    info_ctx_stream(ctx);
     return true;
 }
 
+/**
+ * Take a message out of the context. Its memory stays in the arena until the
+ * arena is rewound or the context destroyed.
+ */
+static void info_ctx_remove(struct info_ctx *ctx, struct info_msg *m)
+{
+    if (ctx->diag_last == m) {
+        ctx->diag_last = m->ln.prev == &ctx->msg_list.n
+            ? NULL
+            : rf_ilist_entry(m->ln.prev, struct info_msg, ln);
+    }
+    rf_ilist_delete_from(&ctx->msg_list, &m->ln);
+    ctx->msg_num--;
+    ctx->type_counts[info_msg_type_index(m->type)]--;
+    info_msg_destroy(m);
+}
+
 void info_ctx_rem_messages(struct info_ctx *ctx, size_t num)
 {
     struct info_msg *m;
     struct info_msg *tmp;
+    size_t total = ctx->msg_num;
     size_t i = 0;
     rf_ilist_for_each_safe(&ctx->msg_list, m, tmp, ln) {
-        if (ctx->msg_num - i <= num) {
-            rf_ilist_delete_from(&ctx->msg_list, &m->ln);
-            info_msg_destroy(m);
+        if (total - i <= num) {
+            info_ctx_remove(ctx, m);
         }
         ++i;
     }
@@ -98,40 +141,53 @@ void info_ctx_rem_messages(struct info_ctx *ctx, size_t num)
 
 void info_ctx_push(struct info_ctx *ctx)
 {
+    struct info_ctx_state state;
     // get the current last message in the list
-    struct info_msg *lastmsg = rf_ilist_tail(&ctx->msg_list, struct info_msg, ln);
-    // add it to the pushed last messages array
-    darray_append(ctx->last_msgs_arr, lastmsg);
+    state.last = rf_ilist_tail(&ctx->msg_list, struct info_msg, ln);
+    info_arena_get_mark(&ctx->arena, &state.mark);
+    // add it to the pushed states array
+    darray_append(ctx->last_msgs_arr, state);
 }
 
 void info_ctx_pop(struct info_ctx *ctx)
 {
     RF_ASSERT(!darray_empty(ctx->last_msgs_arr), "info_ctx_pop called with empty array");
     (void)darray_pop(ctx->last_msgs_arr);
+    // the messages added since the outermost push are now final
+    info_ctx_stream(ctx);
 }
 
 void info_ctx_rollback(struct info_ctx *ctx)
 {
     RF_ASSERT(!darray_empty(ctx->last_msgs_arr), "info_ctx_pop called with empty array");
-    struct info_msg *untilmsg = darray_pop(ctx->last_msgs_arr);
+    struct info_ctx_state state = darray_pop(ctx->last_msgs_arr);
     // now remove all messages after this message (non inclusive)
-    struct info_msg *tailmsg = rf_ilist_tail(&ctx->msg_list, struct info_msg, ln);
+    struct info_msg *tailmsg;
     while ((tailmsg = rf_ilist_tail(&ctx->msg_list, struct info_msg, ln)) &&
-           tailmsg != untilmsg) {
-        info_msg_destroy(rf_ilist_pop_back(&ctx->msg_list, struct info_msg, ln));
+           tailmsg != state.last) {
+        info_ctx_remove(ctx, tailmsg);
     }
+    // all that got allocated after the push belonged to those messages
+    info_arena_rewind(&ctx->arena, &state.mark);
 }
 
 
 bool info_ctx_has(struct info_ctx *ctx, enum info_msg_type type)
 {
-    struct info_msg *m;
+    static const enum info_msg_type types[] = {
+        MESSAGE_SEMANTIC_WARNING,
+        MESSAGE_SYNTAX_WARNING,
+        MESSAGE_SEMANTIC_ERROR,
+        MESSAGE_SYNTAX_ERROR,
+    };
+    unsigned int i;
     if (type == MESSAGE_ANY) {
-        return !rf_ilist_is_empty(&ctx->msg_list);
+        return ctx->msg_num != 0;
     }
 
-    rf_ilist_for_each(&ctx->msg_list, m, ln) {
-        if (RF_BITFLAG_ON(type, m->type)) {
+    for (i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+        if (RF_BITFLAG_ON(type, types[i]) &&
+            ctx->type_counts[info_msg_type_index(types[i])] != 0) {
             return true;
         }
     }
@@ -148,13 +204,13 @@ void info_ctx_flush(struct info_ctx *ctx, FILE *f, int type)
             RF_BITFLAG_ON(type, m->type)) {
 
             info_msg_print(m, f, ctx->file);
-            rf_ilist_delete_from(&ctx->msg_list, &m->ln);
-            info_msg_destroy(m);
+            info_ctx_remove(ctx, m);
         }
     }
 }
 
 i_INLINE_INS void info_ctx_inject_input_file(struct info_ctx *ctx, struct inpfile *f);
+i_INLINE_INS void info_ctx_inject_diag(struct info_ctx *ctx, struct info_diag *diag);
 
 bool info_ctx_get_messages_fmt(struct info_ctx *ctx,
                                enum info_msg_type type,
@@ -1,9 +1,17 @@
 #include <info/msg.h>
 
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rfbase/datastructs/darray.h>
+#include <rfbase/utils/log.h>
 #include <rfbase/utils/memory.h>
 #include <rfbase/utils/sanity.h>
 #include <rfbase/utils/build_assert.h>
 
+#include <info/arena.h>
 #include <inpfile.h>
 
 #define INFO_WARNING_STR "warning"
@@ -19,19 +27,301 @@
 
 i_INLINE_INS bool info_msg_has_end_mark(struct info_msg *msg);
 
-struct info_msg *info_msg_create(enum info_msg_type type,
+//! A conversion specification of a printf-like format
+struct info_msg_conv {
+    //! The '%' the conversion starts with
+    const char *start;
+    //! Right after the conversion character
+    const char *end;
+    const char *flags;
+    size_t flags_len;
+    //! True if the width is given as an argument
+    bool width_arg;
+    const char *width;
+    size_t width_len;
+    bool has_prec;
+    //! True if the precision is given as an argument
+    bool prec_arg;
+    const char *prec;
+    size_t prec_len;
+    //! True for the 'L' length modifier
+    bool long_double;
+    //! The size the integer argument was passed with
+    enum {
+        INFO_MSG_LEN_INT,
+        INFO_MSG_LEN_CHAR,
+        INFO_MSG_LEN_SHORT,
+        INFO_MSG_LEN_LONG,
+        INFO_MSG_LEN_LLONG,
+        INFO_MSG_LEN_INTMAX,
+        INFO_MSG_LEN_SIZE,
+        INFO_MSG_LEN_PTRDIFF,
+    } len;
+    char conv;
+};
+
+/**
+ * Find the next conversion in the format at @a p and move @a p after it
+ *
+ * @return false if there are no more conversions
+ */
+static bool info_msg_next_conv(const char **p, struct info_msg_conv *c)
+{
+    const char *s = strchr(*p, '%');
+    if (!s) {
+        return false;
+    }
+    RF_STRUCT_ZERO(c);
+    c->start = s++;
+    c->flags = s;
+    while (*s && strchr("-+ #0", *s)) {
+        ++s;
+    }
+    c->flags_len = s - c->flags;
+    if (*s == '*') {
+        c->width_arg = true;
+        ++s;
+    } else {
+        c->width = s;
+        while (isdigit(*s)) {
+            ++s;
+        }
+        c->width_len = s - c->width;
+    }
+    if (*s == '.') {
+        c->has_prec = true;
+        ++s;
+        if (*s == '*') {
+            c->prec_arg = true;
+            ++s;
+        } else {
+            c->prec = s;
+            while (isdigit(*s)) {
+                ++s;
+            }
+            c->prec_len = s - c->prec;
+        }
+    }
+    c->len = INFO_MSG_LEN_INT;
+    switch (*s) {
+    case 'h':
+        c->len = s[1] == 'h' ? INFO_MSG_LEN_CHAR : INFO_MSG_LEN_SHORT;
+        s += s[1] == 'h' ? 2 : 1;
+        break;
+    case 'l':
+        c->len = s[1] == 'l' ? INFO_MSG_LEN_LLONG : INFO_MSG_LEN_LONG;
+        s += s[1] == 'l' ? 2 : 1;
+        break;
+    case 'j':
+        c->len = INFO_MSG_LEN_INTMAX;
+        ++s;
+        break;
+    case 'z':
+        c->len = INFO_MSG_LEN_SIZE;
+        ++s;
+        break;
+    case 't':
+        c->len = INFO_MSG_LEN_PTRDIFF;
+        ++s;
+        break;
+    case 'L':
+        c->long_double = true;
+        ++s;
+        break;
+    }
+    if (!*s) {
+        return false;
+    }
+    c->conv = *s++;
+    c->end = s;
+    *p = s;
+    return true;
+}
+
+static intmax_t info_msg_va_signed(const struct info_msg_conv *c, va_list *args)
+{
+    switch (c->len) {
+    case INFO_MSG_LEN_CHAR:
+        // passed promoted to int but printed converted back
+        return (signed char)va_arg(*args, int);
+    case INFO_MSG_LEN_SHORT:
+        return (short)va_arg(*args, int);
+    case INFO_MSG_LEN_LONG:
+        return va_arg(*args, long);
+    case INFO_MSG_LEN_LLONG:
+        return va_arg(*args, long long);
+    case INFO_MSG_LEN_INTMAX:
+        return va_arg(*args, intmax_t);
+    case INFO_MSG_LEN_SIZE:
+        return va_arg(*args, size_t);
+    case INFO_MSG_LEN_PTRDIFF:
+        return va_arg(*args, ptrdiff_t);
+    default:
+        return va_arg(*args, int);
+    }
+}
+
+static uintmax_t info_msg_va_unsigned(const struct info_msg_conv *c, va_list *args)
+{
+    switch (c->len) {
+    case INFO_MSG_LEN_CHAR:
+        return (unsigned char)va_arg(*args, unsigned int);
+    case INFO_MSG_LEN_SHORT:
+        return (unsigned short)va_arg(*args, unsigned int);
+    case INFO_MSG_LEN_LONG:
+        return va_arg(*args, unsigned long);
+    case INFO_MSG_LEN_LLONG:
+        return va_arg(*args, unsigned long long);
+    case INFO_MSG_LEN_INTMAX:
+        return va_arg(*args, uintmax_t);
+    case INFO_MSG_LEN_SIZE:
+        return va_arg(*args, size_t);
+    case INFO_MSG_LEN_PTRDIFF:
+        return va_arg(*args, ptrdiff_t);
+    default:
+        return va_arg(*args, unsigned int);
+    }
+}
+
+/**
+ * Keep the arguments of the message's format so that it can be formatted
+ * later. Strings are copied since they are often temporary.
+ *
+ * @return false if the arena is out of memory or the format has a
+ *         conversion that can't be deferred
+ */
+static bool info_msg_capture(struct info_msg *m, struct info_arena *a, va_list *args)
+{
+    struct info_msg_conv c;
+    struct info_msg_arg *arg;
+    const char *p;
+    const char *str;
+    unsigned int n = 0;
+    long prec;
+    // each conversion may also take its width and precision as arguments
+    for (p = m->fmt; (p = strchr(p, '%')); ++p) {
+        n += 3;
+    }
+    if (n && !(m->args = info_arena_alloc(a, n * sizeof(*m->args)))) {
+        return false;
+    }
+    arg = m->args;
+    p = m->fmt;
+    while (info_msg_next_conv(&p, &c)) {
+        if (c.conv == '%') {
+            continue;
+        }
+        prec = -1;
+        if (c.width_arg) {
+            arg->type = INFO_MSG_ARG_SIGNED;
+            arg->i = va_arg(*args, int);
+            ++arg;
+        }
+        if (c.prec_arg) {
+            arg->type = INFO_MSG_ARG_SIGNED;
+            arg->i = va_arg(*args, int);
+            prec = arg->i;
+            ++arg;
+        } else if (c.has_prec) {
+            prec = strtol(c.prec, NULL, 10);
+        }
+        switch (c.conv) {
+        case 'd':
+        case 'i':
+            arg->type = INFO_MSG_ARG_SIGNED;
+            arg->i = info_msg_va_signed(&c, args);
+            break;
+        case 'c':
+            // wide characters are left to the eager fallback
+            if (c.len == INFO_MSG_LEN_LONG) {
+                return false;
+            }
+            arg->type = INFO_MSG_ARG_SIGNED;
+            arg->i = va_arg(*args, int);
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            arg->type = INFO_MSG_ARG_UNSIGNED;
+            arg->u = info_msg_va_unsigned(&c, args);
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (c.long_double) {
+                arg->type = INFO_MSG_ARG_LDOUBLE;
+                arg->ld = va_arg(*args, long double);
+            } else {
+                arg->type = INFO_MSG_ARG_DOUBLE;
+                arg->d = va_arg(*args, double);
+            }
+            break;
+        case 's':
+            if (c.len == INFO_MSG_LEN_LONG) {
+                return false;
+            }
+            // only what the precision lets be printed is needed, and with a
+            // precision the string does not have to be null terminated
+            str = va_arg(*args, const char*);
+            if (!str) {
+                str = "(null)";
+            }
+            arg->type = INFO_MSG_ARG_STRING;
+            arg->s = info_arena_strndup(a, str, prec >= 0 ? strnlen(str, prec) : strlen(str));
+            if (!arg->s) {
+                return false;
+            }
+            break;
+        case 'p':
+            arg->type = INFO_MSG_ARG_POINTER;
+            arg->p = va_arg(*args, const void*);
+            break;
+        default:
+            return false;
+        }
+        ++arg;
+    }
+    return true;
+}
+
+struct info_msg *info_msg_create(struct info_arena *arena,
+                                 enum info_msg_type type,
                                  const struct inplocation_mark *start,
                                  const struct inplocation_mark *end,
                                  const char *fmt,
                                  va_list args)
 {
     struct info_msg *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
-
-    if (!rf_string_initvl(&ret->s, fmt, args)) {
-        va_end(args);
+    struct info_arena_mark mark;
+    va_list captured;
+    bool deferred;
+    info_arena_get_mark(arena, &mark);
+    if (!(ret = info_arena_alloc(arena, sizeof(*ret)))) {
         return NULL;
     }
+    RF_STRUCT_ZERO(ret);
+    ret->fmt = fmt;
+    va_copy(captured, args);
+    deferred = info_msg_capture(ret, arena, &captured);
+    va_end(captured);
+    if (!deferred) {
+        // fall back to formatting right away
+        info_arena_rewind(arena, &mark);
+        if (!(ret = info_arena_alloc(arena, sizeof(*ret)))) {
+            return NULL;
+        }
+        RF_STRUCT_ZERO(ret);
+        if (!rf_string_initvl(&ret->s, fmt, args)) {
+            return NULL;
+        }
+        ret->formatted = true;
+    }
 
     ret->type = type;
 
@@ -52,8 +342,148 @@ struct info_msg *info_msg_create(enum info_msg_type type,
 
 void info_msg_destroy(struct info_msg *m)
 {
-    rf_string_deinit(&m->s);
-    free(m);
+    if (m->formatted) {
+        rf_string_deinit(&m->s);
+        m->formatted = false;
+    }
+}
+
+struct info_msg_buff {darray(char);};
+
+static void info_msg_buff_append(struct info_msg_buff *b, const char *s, size_t len)
+{
+    size_t at = darray_size(*b);
+    darray_resize(*b, at + len);
+    memcpy(b->item + at, s, len);
+}
+
+//! Append a single conversion formatted by the C library to the buffer
+#define INFO_MSG_BUFF_PRINTF(b_, spec_, val_)                           \
+    do {                                                                \
+        size_t at_ = darray_size(*(b_));                                \
+        int len_ = snprintf(NULL, 0, (spec_), (val_));                  \
+        if (len_ > 0) {                                                 \
+            darray_resize(*(b_), at_ + len_ + 1);                       \
+            snprintf((b_)->item + at_, len_ + 1, (spec_), (val_));      \
+            darray_resize(*(b_), at_ + len_);                           \
+        }                                                               \
+    } while (0)
+
+static bool info_msg_init_str(struct RFstring *s, const char *fmt, ...)
+{
+    va_list args;
+    bool ret;
+    va_start(args, fmt);
+    ret = rf_string_initvl(s, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+//! Enough for a '.' and the decimal digits of any intmax_t
+#define INFO_MSG_NUM_LEN 24
+
+/**
+ * Format a message from its kept arguments, one conversion at a time
+ */
+static bool info_msg_format(struct info_msg *m)
+{
+    struct info_msg_buff b;
+    struct info_msg_conv c;
+    const struct info_msg_arg *arg = m->args;
+    const char *p = m->fmt;
+    const char *lit = m->fmt;
+    // '%' + flags + width + '.' + precision + length + conversion
+    char spec[64];
+    size_t sl;
+    bool ret;
+    darray_init(b);
+    while (info_msg_next_conv(&p, &c)) {
+        info_msg_buff_append(&b, lit, c.start - lit);
+        lit = c.end;
+        if (c.conv == '%') {
+            info_msg_buff_append(&b, "%", 1);
+            continue;
+        }
+        // rebuild the conversion with widths and precisions given as
+        // arguments written out, and integers taken as the widest type
+        spec[0] = '%';
+        sl = 1;
+        if (c.flags_len + c.width_len + c.prec_len + 3 >= sizeof(spec) - INFO_MSG_NUM_LEN * 2) {
+            darray_free(b);
+            return false;
+        }
+        memcpy(spec + sl, c.flags, c.flags_len);
+        sl += c.flags_len;
+        if (c.width_arg) {
+            sl += snprintf(spec + sl, INFO_MSG_NUM_LEN, "%jd", (arg++)->i);
+        } else {
+            memcpy(spec + sl, c.width, c.width_len);
+            sl += c.width_len;
+        }
+        if (c.prec_arg) {
+            // a negative precision is as if none was given
+            if (arg->i >= 0) {
+                sl += snprintf(spec + sl, INFO_MSG_NUM_LEN, ".%jd", arg->i);
+            }
+            ++arg;
+        } else if (c.has_prec) {
+            spec[sl++] = '.';
+            memcpy(spec + sl, c.prec, c.prec_len);
+            sl += c.prec_len;
+        }
+        if (arg->type == INFO_MSG_ARG_SIGNED || arg->type == INFO_MSG_ARG_UNSIGNED) {
+            if (c.conv != 'c') {
+                spec[sl++] = 'j';
+            }
+        } else if (arg->type == INFO_MSG_ARG_LDOUBLE) {
+            spec[sl++] = 'L';
+        }
+        spec[sl++] = c.conv;
+        spec[sl] = '\0';
+        switch (arg->type) {
+        case INFO_MSG_ARG_SIGNED:
+            if (c.conv == 'c') {
+                INFO_MSG_BUFF_PRINTF(&b, spec, (int)arg->i);
+            } else {
+                INFO_MSG_BUFF_PRINTF(&b, spec, arg->i);
+            }
+            break;
+        case INFO_MSG_ARG_UNSIGNED:
+            INFO_MSG_BUFF_PRINTF(&b, spec, arg->u);
+            break;
+        case INFO_MSG_ARG_DOUBLE:
+            INFO_MSG_BUFF_PRINTF(&b, spec, arg->d);
+            break;
+        case INFO_MSG_ARG_LDOUBLE:
+            INFO_MSG_BUFF_PRINTF(&b, spec, arg->ld);
+            break;
+        case INFO_MSG_ARG_STRING:
+            INFO_MSG_BUFF_PRINTF(&b, spec, arg->s);
+            break;
+        case INFO_MSG_ARG_POINTER:
+            INFO_MSG_BUFF_PRINTF(&b, spec, arg->p);
+            break;
+        }
+        ++arg;
+    }
+    info_msg_buff_append(&b, lit, strlen(lit));
+    ret = info_msg_init_str(&m->s, "%.*s", (int)darray_size(b), b.item ? b.item : "");
+    darray_free(b);
+    return ret;
+}
+
+const struct RFstring *info_msg_str(struct info_msg *m)
+{
+    static const struct RFstring failed = RF_STRING_STATIC_INIT("<could not format message>");
+    if (!m->fmt || m->formatted) {
+        return &m->s;
+    }
+    if (!info_msg_format(m)) {
+        RF_ERROR("Failed to format a compiler message");
+        return &failed;
+    }
+    m->formatted = true;
+    return &m->s;
 }
 
 void info_msg_print(struct info_msg *m, FILE *f, struct inpfile *input_file)
@@ -67,7 +497,7 @@ void info_msg_print(struct info_msg *m, FILE *f, struct inpfile *input_file)
             f,
             INPLOCATION_FMT" "INFO_WARNING_STR": "RFS_PF"\n",
             INPLOCATION_ARG(input_file, &m->loc),
-            RFS_PA(&m->s));
+            RFS_PA(info_msg_str(m)));
 
         break;
     case MESSAGE_SYNTAX_WARNING:
@@ -75,7 +505,7 @@ void info_msg_print(struct info_msg *m, FILE *f, struct inpfile *input_file)
             f,
             INPLOCATION_FMT" "INFO_WARNING_STR": "RFS_PF"\n",
             INPLOCATION_ARG(input_file, &m->loc),
-            RFS_PA(&m->s));
+            RFS_PA(info_msg_str(m)));
 
         break;
     case MESSAGE_SEMANTIC_ERROR:
@@ -83,14 +513,14 @@ void info_msg_print(struct info_msg *m, FILE *f, struct inpfile *input_file)
             f,
             INPLOCATION_FMT" "INFO_ERROR_STR": "RFS_PF"\n",
             INPLOCATION_ARG(input_file, &m->loc),
-            RFS_PA(&m->s));
+            RFS_PA(info_msg_str(m)));
         break;
     case MESSAGE_SYNTAX_ERROR:
         fprintf(
             f,
             INPLOCATION_FMT" "INFO_ERROR_STR": "RFS_PF"\n",
             INPLOCATION_ARG(input_file, &m->loc),
-            RFS_PA(&m->s));
+            RFS_PA(info_msg_str(m)));
         if (!inpfile_line(input_file, m->loc.start.line, &line_str)) {
             ERROR("Could not locate line %u at file "RFS_PF,
                   m->loc.start.line,
@@ -117,7 +547,7 @@ bool info_msg_get_formatted(struct info_msg *m, struct RFstringx *s,
             s,
             INPLOCMARKS_FMT" "INFO_WARNING_STR": "RFS_PF"\n",
             INPLOCMARKS_ARG(input_file, &m->start_mark, &m->end_mark),
-            RFS_PA(&m->s));
+            RFS_PA(info_msg_str(m)));
 
         break;
     case MESSAGE_SYNTAX_WARNING:
@@ -125,7 +555,7 @@ bool info_msg_get_formatted(struct info_msg *m, struct RFstringx *s,
             s,
             INPLOCMARKS_FMT" "INFO_WARNING_STR": "RFS_PF"\n",
             INPLOCMARKS_ARG(input_file, &m->start_mark, &m->end_mark),
-            RFS_PA(&m->s));
+            RFS_PA(info_msg_str(m)));
 
         break;
     case MESSAGE_SEMANTIC_ERROR:
@@ -133,14 +563,14 @@ bool info_msg_get_formatted(struct info_msg *m, struct RFstringx *s,
             s,
             INPLOCMARKS_FMT" "INFO_ERROR_STR": "RFS_PF"\n",
             INPLOCMARKS_ARG(input_file, &m->start_mark, &m->end_mark),
-            RFS_PA(&m->s));
+            RFS_PA(info_msg_str(m)));
         break;
     case MESSAGE_SYNTAX_ERROR:
         rf_stringx_assignv(
             s,
             INPLOCMARKS_FMT" "INFO_ERROR_STR": "RFS_PF"\n",
             INPLOCMARKS_ARG(input_file, &m->start_mark, &m->end_mark),
-            RFS_PA(&m->s));
+            RFS_PA(info_msg_str(m)));
         if (!inpfile_line(input_file, m->start_mark.line, &line_str)) {
             ERROR(
                 "Could not locate line %u at file "RFS_PF,
@@ -183,28 +613,26 @@ static const struct RFstring info_msg_type_strings[] = {
     RF_STRING_STATIC_INIT("syntax error")
 };
 
-const struct RFstring *info_msg_type_to_str(enum info_msg_type type)
+unsigned int info_msg_type_index(enum info_msg_type type)
 {
-    int i = 0;
     switch (type) {
     case MESSAGE_ANY:
-        i = 0;
-        break;
+        return 0;
     case MESSAGE_SEMANTIC_WARNING:
-        i = 1;
-        break;
+        return 1;
     case MESSAGE_SYNTAX_WARNING:
-        i = 2;
-        break;
+        return 2;
     case MESSAGE_SEMANTIC_ERROR:
-        i = 3;
-        break;
+        return 3;
     case MESSAGE_SYNTAX_ERROR:
-        i = 4;
-        break;
+        return 4;
     default:
         RF_CRITICAL_FAIL("Illegal info_msg_type");
-        return NULL;
+        return 0;
     }
-    return &info_msg_type_strings[i];
+}
+
+const struct RFstring *info_msg_type_to_str(enum info_msg_type type)
+{
+    return &info_msg_type_strings[info_msg_type_index(type)];
 }
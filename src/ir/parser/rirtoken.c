@@ -36,6 +36,7 @@ static struct RFstring strings_[] = {
     RF_STRING_STATIC_INIT("return"),
     RF_STRING_STATIC_INIT("branch"),
     RF_STRING_STATIC_INIT("condbranch"),
+    RF_STRING_STATIC_INIT("switch"),
     RF_STRING_STATIC_INIT("convert"),
     RF_STRING_STATIC_INIT("write"),
     RF_STRING_STATIC_INIT("read"),
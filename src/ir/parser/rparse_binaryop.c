@@ -54,7 +54,7 @@ struct rir_object *rir_parse_binaryop(struct rir_parser *p, enum rir_token_type
         RFS("first argument of "RFS_PF"()", RFS_PA(rir_binaryoptype_string(bop_type)))
     );
     if (!valb) {
-        goto fail_free_vala;
+        goto fail_free_type;
     }
 
     // check that the parsed binary op type is correct
@@ -71,7 +71,7 @@ struct rir_object *rir_parse_binaryop(struct rir_parser *p, enum rir_token_type
             RFS_PA(rir_type_string(parsed_type))
         );
         RFS_POP();
-        goto fail_free_valb;
+        goto fail_free_type;
     }
     if (!rir_type_identical(parsed_type, valb->type)) {
         RFS_PUSH();
@@ -86,7 +86,7 @@ struct rir_object *rir_parse_binaryop(struct rir_parser *p, enum rir_token_type
             RFS_PA(rir_type_string(parsed_type))
         );
         RFS_POP();
-        goto fail_free_valb;
+        goto fail_free_type;
     }
 
     if (!lexer_expect_token(parser_lexer(p), RIR_TOK_SM_CPAREN)) {
@@ -97,7 +97,7 @@ struct rir_object *rir_parse_binaryop(struct rir_parser *p, enum rir_token_type
             "Expected a ')' at the end of \""RFS_PF"\"'.",
             RFS_PA(rir_binaryoptype_string(bop_type))
         );
-        goto fail_free_valb;
+        goto fail_free_type;
     }
 
     struct rir_object *bop = rir_binaryop_create_nonast_obj(
@@ -108,16 +108,12 @@ struct rir_object *rir_parse_binaryop(struct rir_parser *p, enum rir_token_type
         &p->ctx
     );
     if (!bop) {
-        goto fail_free_valb;
+        goto fail_free_type;
     }
 
     RFS_POP();
     return bop;
 
-fail_free_valb:
-    rir_value_destroy(valb, RIR_VALUE_PARSING);
-fail_free_vala:
-    rir_value_destroy(vala, RIR_VALUE_PARSING);
 fail_free_type:
     rir_type_destroy(parsed_type, rir_parser_rir(p));
 fail:
@@ -143,6 +143,55 @@ static bool rir_parse_condbranch(struct rir_parser *p, struct rir_block *b, stru
     return true;
 }
 
+static bool rir_parse_switch(struct rir_parser *p, struct rir_block *b, struct rirobj_strmap *map)
+{
+    struct token *tok;
+    // consume 'switch'
+    if (!rir_parse_instr_start(p, rir_tokentype_to_str(RIR_TOK_SWITCH))) {
+        return false;
+    }
+    // get the value to switch on
+    static const struct RFstring lmsg = RF_STRING_STATIC_INIT("switch() first argument");
+    struct rir_value *cond = rir_parse_val_and_comma(p, &lmsg);
+    if (!cond) {
+        return false;
+    }
+
+    struct rir_object *objdefault = rir_parse_label(p, b, map, "at second argument of switch()");
+    if (!objdefault) {
+        return false;
+    }
+    rir_block_exit_init_switch(&b->exit, cond, rir_object_block_label(objdefault));
+
+    // and now any number of ', constant, label' case pairs until the ')'
+    static const struct RFstring cmsg = RF_STRING_STATIC_INIT("switch() case value");
+    while ((tok = lexer_lookahead(parser_lexer(p), 1)) &&
+           rir_toktype(tok) == RIR_TOK_SM_COMMA) {
+        lexer_curr_token_advance(parser_lexer(p));
+        struct rir_value *val = rir_parse_val_and_comma(p, &cmsg);
+        if (!val) {
+            return false;
+        }
+        if (val->category != RIR_VALUE_CONSTANT) {
+            rirparser_synerr(p, lexer_last_token_start(parser_lexer(p)), NULL,
+                             "Expected a constant as a 'switch()' case value.");
+            return false;
+        }
+        struct rir_object *objcase = rir_parse_label(p, b, map, "at switch() case");
+        if (!objcase) {
+            return false;
+        }
+        rir_switch_add_case(&b->exit.switchbr, val, rir_object_block_label(objcase));
+    }
+
+    if (!lexer_expect_token(parser_lexer(p), RIR_TOK_SM_CPAREN)) {
+        rirparser_synerr(p, lexer_last_token_start(parser_lexer(p)), NULL,
+                         "Expected a ')' after 'switch()'.");
+        return false;
+    }
+    return true;
+}
+
 static bool rir_parse_return(struct rir_parser *p, struct rir_block *b)
 {
     struct rir_value *v = NULL;
@@ -219,6 +268,8 @@ static bool rir_parse_block_expr(
         return rir_parse_branch(p, b, map);
     case RIR_TOK_CONDBRANCH:
         return rir_parse_condbranch(p, b, map);
+    case RIR_TOK_SWITCH:
+        return rir_parse_switch(p, b, map);
     default:
         rirparser_synerr(
             p,
@@ -22,7 +22,7 @@ struct rir_object *rir_parse_convert(struct rir_parser *p)
     static const struct RFstring lmsg2 = RF_STRING_STATIC_INIT("second argument of convert()");
     struct rir_type *type = rir_parse_type(p, &lmsg2);
     if (!type) {
-        goto fail_destroy_val;
+        return NULL;
     }
 
     if (!lexer_expect_token(parser_lexer(p), RIR_TOK_SM_CPAREN)) {
@@ -39,8 +39,6 @@ struct rir_object *rir_parse_convert(struct rir_parser *p)
 
 fail_destroy_type:
     rir_type_destroy(type, rir_parser_rir(p));
-fail_destroy_val:
-    rir_value_destroy(val, RIR_VALUE_PARSING);
     return NULL;
 }
 
@@ -72,14 +70,14 @@ struct rir_object *rir_parse_write(struct rir_parser *p)
     static const struct RFstring lmsg3 = RF_STRING_STATIC_INIT("third argument of write()");
     struct rir_value *srcval = rir_parse_value(p, &lmsg3);
     if (!srcval) {
-        goto fail_destroy_dst;
+        goto fail_destroy_type;
     }
 
     struct token *end;
     if (!(end = lexer_expect_token(parser_lexer(p), RIR_TOK_SM_CPAREN))) {
         rirparser_synerr(p, lexer_last_token_start(parser_lexer(p)), NULL,
                          "Expected a ')' at the end of 'write'.");
-        goto fail_destroy_src;
+        goto fail_destroy_type;
     }
 
     if (!rir_type_identical(type, dstval->type)) {
@@ -94,7 +92,7 @@ struct rir_object *rir_parse_write(struct rir_parser *p)
             RFS_PA(rir_type_string(type))
         );
         RFS_POP();
-        goto fail_destroy_src;
+        goto fail_destroy_type;
     }
 
     struct rir_type *valtype = rir_type_get_or_create_from_other(type, rir_parser_rir(p), false);
@@ -110,19 +108,15 @@ struct rir_object *rir_parse_write(struct rir_parser *p)
             RFS_PA(rir_type_string(valtype))
         );
         RFS_POP();
-        goto fail_destroy_src;
+        goto fail_destroy_type;
     }
 
     struct rir_object *wrt;
     if (!(wrt = rir_write_create_obj(dstval, srcval, RIRPOS_PARSE, &p->ctx))) {
-        goto fail_destroy_src;
+        goto fail_destroy_type;
     }
     return wrt;
 
-fail_destroy_src:
-    rir_value_destroy(srcval, RIR_VALUE_PARSING);
-fail_destroy_dst:
-    rir_value_destroy(dstval, RIR_VALUE_PARSING);
 fail_destroy_type:
     rir_type_destroy(type, rir_parser_rir(p));
     return NULL;
@@ -143,18 +137,14 @@ struct rir_object *rir_parse_read(struct rir_parser *p)
     if (!lexer_expect_token(parser_lexer(p), RIR_TOK_SM_CPAREN)) {
         rirparser_synerr(p, lexer_last_token_start(parser_lexer(p)), NULL,
                          "Expected a ')' at the end of 'convert'.");
-        goto fail_destroy_val;
+        return NULL;
     }
 
     struct rir_object *rd = rir_read_create_obj(val, RIRPOS_PARSE, &p->ctx);
     if (!rd) {
-        goto fail_destroy_val;
+        return NULL;
     }
     return rd;
-
-fail_destroy_val:
-    rir_value_destroy(val, RIR_VALUE_PARSING);
-    return NULL;
 }
 
 struct rir_object *rir_parse_call(struct rir_parser *p)
@@ -244,6 +234,6 @@ struct rir_object *rir_parse_call(struct rir_parser *p)
     return call;
 
 fail_destroy_arr:
-    rir_valuearr_deinit(&arr, RIR_VALUE_PARSING);
+    darray_free(arr);
     return NULL;
 }
@@ -135,6 +135,8 @@ bool rir_parse_fndef(struct rir_parser *p)
     RF_MALLOC(def, sizeof(*def), return false);
     RF_STRUCT_ZERO(def);
     struct rir *r = rir_parser_rir(p);
+    // the arguments are added to the map of the current function
+    rir_data_curr_fn(&p->ctx) = def;
     if (!rir_parse_fn_common(p, false, &def->decl)) {
         free(def);
         return false;
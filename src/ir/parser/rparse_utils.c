@@ -33,7 +33,6 @@ struct rir_value *rir_parse_val_and_comma(struct rir_parser *p, const struct RFs
             NULL,
             "Expected a ',' after "RFS_PF".", RFS_PA(msg)
         );
-        rir_value_destroy(val, RIR_VALUE_PARSING);
         val = NULL;
         goto end;
     }
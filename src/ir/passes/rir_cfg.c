@@ -0,0 +1,253 @@
+#include "rir_cfg.h"
+
+#include <rfbase/utils/memory.h>
+#include <rfbase/utils/sanity.h>
+#include <rfbase/utils/log.h>
+
+#include <ir/rir_block.h>
+#include <ir/rir_function.h>
+#include <ir/rir_value.h>
+
+i_INLINE_INS bool rir_cfg_node_reachable(const struct rir_cfg_node *n);
+i_INLINE_INS unsigned rir_cfg_nodes_num(const struct rir_cfg *cfg);
+
+struct rir_cfg_node *rir_cfg_node_from_label(const struct rir_cfg *cfg,
+                                             const struct rir_value *label)
+{
+    return strmap_get(&cfg->map, &label->name);
+}
+
+static bool rir_cfg_add_edge(struct rir_cfg *cfg,
+                             struct rir_cfg_node *from,
+                             const struct rir_value *label)
+{
+    struct rir_cfg_node *to = rir_cfg_node_from_label(cfg, label);
+    if (!to) {
+        RF_ERROR("Block exit points to a label outside of the function");
+        return false;
+    }
+    darray_append(from->succs, to);
+    darray_append(to->preds, from);
+    return true;
+}
+
+static bool rir_cfg_add_exit_edges(struct rir_cfg *cfg, struct rir_cfg_node *n)
+{
+    const struct rir_block_exit *exit = &n->block->exit;
+    struct rir_switch_case *c;
+    switch (exit->type) {
+    case RIR_BLOCK_EXIT_BRANCH:
+        return rir_cfg_add_edge(cfg, n, exit->branch.dst);
+    case RIR_BLOCK_EXIT_CONDBRANCH:
+        return rir_cfg_add_edge(cfg, n, exit->condbranch.taken) &&
+            rir_cfg_add_edge(cfg, n, exit->condbranch.fallthrough);
+    case RIR_BLOCK_EXIT_SWITCH:
+        if (!rir_cfg_add_edge(cfg, n, exit->switchbr.fallthrough)) {
+            return false;
+        }
+        darray_foreach(c, exit->switchbr.cases) {
+            if (!rir_cfg_add_edge(cfg, n, c->dst)) {
+                return false;
+            }
+        }
+        return true;
+    case RIR_BLOCK_EXIT_RETURN:
+        return true;
+    case RIR_BLOCK_EXIT_INVALID:
+        break;
+    }
+    RF_ERROR("Block without a valid exit found while building the CFG");
+    return false;
+}
+
+/**
+ * Depth first traversal that numbers the nodes in postorder. The order is
+ * reversed afterwards.
+ */
+static void rir_cfg_postorder(struct rir_cfg *cfg, struct rir_cfg_node *n, bool *visited)
+{
+    struct rir_cfg_node **s;
+    visited[n->idx] = true;
+    darray_foreach(s, n->succs) {
+        if (!visited[(*s)->idx]) {
+            rir_cfg_postorder(cfg, *s, visited);
+        }
+    }
+    darray_append(cfg->rpo, n);
+}
+
+static bool rir_cfg_compute_rpo(struct rir_cfg *cfg)
+{
+    bool *visited;
+    unsigned i;
+    unsigned num;
+    struct rir_cfg_node *tmp;
+    RF_CALLOC(visited, rir_cfg_nodes_num(cfg), sizeof(*visited), return false);
+    rir_cfg_postorder(cfg, &darray_item(cfg->nodes, 0), visited);
+    free(visited);
+    num = darray_size(cfg->rpo);
+    for (i = 0; i < num / 2; ++i) {
+        tmp = darray_item(cfg->rpo, i);
+        darray_item(cfg->rpo, i) = darray_item(cfg->rpo, num - 1 - i);
+        darray_item(cfg->rpo, num - 1 - i) = tmp;
+    }
+    for (i = 0; i < num; ++i) {
+        darray_item(cfg->rpo, i)->rpo = i;
+    }
+    return true;
+}
+
+static struct rir_cfg_node *rir_cfg_intersect(struct rir_cfg_node *a, struct rir_cfg_node *b)
+{
+    while (a != b) {
+        while (a->rpo > b->rpo) {
+            a = a->idom;
+        }
+        while (b->rpo > a->rpo) {
+            b = b->idom;
+        }
+    }
+    return a;
+}
+
+static void rir_cfg_compute_dominators(struct rir_cfg *cfg)
+{
+    struct rir_cfg_node *entry = darray_item(cfg->rpo, 0);
+    struct rir_cfg_node *new_idom;
+    struct rir_cfg_node **n;
+    struct rir_cfg_node **p;
+    bool changed = true;
+    // during the computation the entry is its own dominator so that
+    // intersecting stops there
+    entry->idom = entry;
+    while (changed) {
+        changed = false;
+        darray_foreach(n, cfg->rpo) {
+            if (*n == entry) {
+                continue;
+            }
+            new_idom = NULL;
+            darray_foreach(p, (*n)->preds) {
+                if (!(*p)->idom) {
+                    // not processed yet or unreachable
+                    continue;
+                }
+                new_idom = new_idom ? rir_cfg_intersect(*p, new_idom) : *p;
+            }
+            if ((*n)->idom != new_idom) {
+                (*n)->idom = new_idom;
+                changed = true;
+            }
+        }
+    }
+    entry->idom = NULL;
+
+    darray_foreach(n, cfg->rpo) {
+        if ((*n)->idom) {
+            darray_append((*n)->idom->children, *n);
+        }
+    }
+}
+
+static void rir_cfg_add_to_frontier(struct rir_cfg_node *n, struct rir_cfg_node *f)
+{
+    struct rir_cfg_node **it;
+    darray_foreach(it, n->frontier) {
+        if (*it == f) {
+            return;
+        }
+    }
+    darray_append(n->frontier, f);
+}
+
+static void rir_cfg_compute_frontiers(struct rir_cfg *cfg)
+{
+    struct rir_cfg_node **n;
+    struct rir_cfg_node **p;
+    struct rir_cfg_node *runner;
+    darray_foreach(n, cfg->rpo) {
+        if (darray_size((*n)->preds) < 2) {
+            continue;
+        }
+        darray_foreach(p, (*n)->preds) {
+            if (!rir_cfg_node_reachable(*p)) {
+                continue;
+            }
+            for (runner = *p; runner && runner != (*n)->idom; runner = runner->idom) {
+                rir_cfg_add_to_frontier(runner, *n);
+            }
+        }
+    }
+}
+
+bool rir_cfg_init(struct rir_cfg *cfg, struct rir_fndef *fn)
+{
+    struct rir_cfg_node *n;
+    unsigned i;
+    RF_ASSERT(darray_size(fn->blocks) != 0, "A function definition should have blocks");
+    cfg->fn = fn;
+    darray_init(cfg->nodes);
+    darray_init(cfg->rpo);
+    strmap_init(&cfg->map);
+    // the nodes array is never resized after this so pointers to nodes stay valid
+    darray_resize(cfg->nodes, darray_size(fn->blocks));
+    for (i = 0; i < darray_size(fn->blocks); ++i) {
+        n = &darray_item(cfg->nodes, i);
+        n->block = darray_item(fn->blocks, i);
+        n->idx = i;
+        n->rpo = RIR_CFG_UNREACHABLE;
+        n->idom = NULL;
+        darray_init(n->preds);
+        darray_init(n->succs);
+        darray_init(n->children);
+        darray_init(n->frontier);
+    }
+    darray_foreach(n, cfg->nodes) {
+        if (!strmap_add(&cfg->map, &n->block->label.name, n)) {
+            RF_ERROR("Duplicate block label while building the CFG");
+            goto fail;
+        }
+    }
+    darray_foreach(n, cfg->nodes) {
+        if (!rir_cfg_add_exit_edges(cfg, n)) {
+            goto fail;
+        }
+    }
+    if (!rir_cfg_compute_rpo(cfg)) {
+        goto fail;
+    }
+    rir_cfg_compute_dominators(cfg);
+    rir_cfg_compute_frontiers(cfg);
+    return true;
+
+fail:
+    rir_cfg_deinit(cfg);
+    return false;
+}
+
+void rir_cfg_deinit(struct rir_cfg *cfg)
+{
+    struct rir_cfg_node *n;
+    darray_foreach(n, cfg->nodes) {
+        darray_free(n->preds);
+        darray_free(n->succs);
+        darray_free(n->children);
+        darray_free(n->frontier);
+    }
+    darray_free(cfg->nodes);
+    darray_free(cfg->rpo);
+    strmap_clear(&cfg->map);
+}
+
+bool rir_cfg_dominates(const struct rir_cfg_node *a, const struct rir_cfg_node *b)
+{
+    if (!rir_cfg_node_reachable(b)) {
+        return false;
+    }
+    for (; b; b = b->idom) {
+        if (a == b) {
+            return true;
+        }
+    }
+    return false;
+}
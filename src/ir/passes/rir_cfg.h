@@ -0,0 +1,85 @@
+#ifndef LFR_IR_PASSES_RIR_CFG_H
+#define LFR_IR_PASSES_RIR_CFG_H
+
+#include <stdbool.h>
+
+#include <rfbase/defs/inline.h>
+#include <rfbase/datastructs/darray.h>
+#include <rfbase/datastructs/strmap.h>
+
+struct rir_block;
+struct rir_fndef;
+struct rir_value;
+
+//! Reverse postorder number of the blocks that can't be reached from the entry
+#define RIR_CFG_UNREACHABLE ((unsigned)-1)
+
+struct rir_cfg_node;
+struct rir_cfg_node_arr {darray(struct rir_cfg_node*);};
+
+/**
+ * A basic block of a function along with its edges, its place in the
+ * dominator tree and its dominance frontier
+ */
+struct rir_cfg_node {
+    struct rir_block *block;
+    //! Index of the block in the function's blocks array
+    unsigned idx;
+    //! Position in reverse postorder or RIR_CFG_UNREACHABLE
+    unsigned rpo;
+    //! Immediate dominator. NULL for the entry and for unreachable blocks
+    struct rir_cfg_node *idom;
+    //! Predecessors, once per edge. A switch can have many edges to one block
+    struct rir_cfg_node_arr preds;
+    //! Successors, once per edge
+    struct rir_cfg_node_arr succs;
+    //! Nodes immediately dominated by this one
+    struct rir_cfg_node_arr children;
+    //! The dominance frontier of the node
+    struct rir_cfg_node_arr frontier;
+};
+
+struct rir_cfg_node_strmap {STRMAP_MEMBERS(struct rir_cfg_node*);};
+
+/**
+ * The control flow graph of a function
+ */
+struct rir_cfg {
+    struct rir_fndef *fn;
+    //! One node per block, in the order of the function's blocks
+    struct {darray(struct rir_cfg_node);} nodes;
+    //! The reachable nodes in reverse postorder. The first one is the entry.
+    struct rir_cfg_node_arr rpo;
+    //! Map from block label ids to nodes
+    struct rir_cfg_node_strmap map;
+};
+
+/**
+ * Build the control flow graph of a function along with its dominator tree
+ * and dominance frontiers
+ *
+ * Dominators are computed with the iterative algorithm of Cooper, Harvey
+ * and Kennedy over the reverse postorder. Must be rebuilt if the blocks or
+ * their exits change.
+ */
+bool rir_cfg_init(struct rir_cfg *cfg, struct rir_fndef *fn);
+void rir_cfg_deinit(struct rir_cfg *cfg);
+
+struct rir_cfg_node *rir_cfg_node_from_label(const struct rir_cfg *cfg,
+                                             const struct rir_value *label);
+
+/**
+ * @return true if every path from the entry to @a b goes through @a a
+ */
+bool rir_cfg_dominates(const struct rir_cfg_node *a, const struct rir_cfg_node *b);
+
+i_INLINE_DECL bool rir_cfg_node_reachable(const struct rir_cfg_node *n)
+{
+    return n->rpo != RIR_CFG_UNREACHABLE;
+}
+
+i_INLINE_DECL unsigned rir_cfg_nodes_num(const struct rir_cfg *cfg)
+{
+    return darray_size(cfg->nodes);
+}
+#endif
@@ -0,0 +1,251 @@
+#include "rir_pass.h"
+#include "rir_pass_utils.h"
+
+#include <rfbase/datastructs/intrusive_list.h>
+
+#include <ast/constants.h>
+#include <types/type_elementary.h>
+#include <ir/rir.h>
+#include <ir/rir_block.h>
+#include <ir/rir_constant.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_interp.h>
+#include <ir/rir_type.h>
+#include <ir/rir_value.h>
+
+// calls with more arguments than this are never evaluated at compile time
+#define CONSTFOLD_CALL_MAX_ARGS 8
+
+static bool constfold_int_constant(const struct rir_value *v, int64_t *out)
+{
+    if (v->category != RIR_VALUE_CONSTANT ||
+        v->constant.type != CONSTANT_NUMBER_INTEGER ||
+        !rir_type_is_elementary(v->type) ||
+        !elementary_type_is_int(v->type->etype)) {
+        return false;
+    }
+    *out = rir_constant_int_to_width(v->constant.value.integer, v->type->etype);
+    return true;
+}
+
+/**
+ * Compute the constant result of a binary operation, mirroring the
+ * semantics of the LLVM backend: wrapping arithmetic, unsigned division and
+ * signed comparisons at the width of the operand type.
+ *
+ * @return true if the expression could be folded into @a c
+ */
+static bool constfold_binaryop(const struct rir_expression *e,
+                               const struct rir_value *a,
+                               const struct rir_value *b,
+                               struct ast_constant *c)
+{
+    int64_t ia;
+    int64_t ib;
+    enum elementary_type etype;
+    if (!constfold_int_constant(a, &ia) || !constfold_int_constant(b, &ib) ||
+        a->type->etype != b->type->etype) {
+        return false;
+    }
+    etype = a->type->etype;
+
+    switch (e->type) {
+    case RIR_EXPRESSION_ADD:
+        ast_constant_init_int(c, rir_constant_int_to_width((int64_t)((uint64_t)ia + (uint64_t)ib), etype));
+        break;
+    case RIR_EXPRESSION_SUB:
+        ast_constant_init_int(c, rir_constant_int_to_width((int64_t)((uint64_t)ia - (uint64_t)ib), etype));
+        break;
+    case RIR_EXPRESSION_MUL:
+        ast_constant_init_int(c, rir_constant_int_to_width((int64_t)((uint64_t)ia * (uint64_t)ib), etype));
+        break;
+    case RIR_EXPRESSION_DIV:
+    {
+        int bits = elementary_type_to_bytesize(etype) * 8;
+        uint64_t mask = bits >= 64 ? UINT64_MAX : (UINT64_C(1) << bits) - 1;
+        uint64_t ua = (uint64_t)ia & mask;
+        uint64_t ub = (uint64_t)ib & mask;
+        if (ub == 0) {
+            // leave division by zero to happen at runtime
+            return false;
+        }
+        ast_constant_init_int(c, rir_constant_int_to_width((int64_t)(ua / ub), etype));
+        break;
+    }
+    case RIR_EXPRESSION_CMP_EQ:
+        ast_constant_init_bool(c, ia == ib);
+        break;
+    case RIR_EXPRESSION_CMP_NE:
+        ast_constant_init_bool(c, ia != ib);
+        break;
+    case RIR_EXPRESSION_CMP_GE:
+        ast_constant_init_bool(c, rir_constant_int_to_signed_width(ia, etype) >=
+                               rir_constant_int_to_signed_width(ib, etype));
+        break;
+    case RIR_EXPRESSION_CMP_GT:
+        ast_constant_init_bool(c, rir_constant_int_to_signed_width(ia, etype) >
+                               rir_constant_int_to_signed_width(ib, etype));
+        break;
+    case RIR_EXPRESSION_CMP_LE:
+        ast_constant_init_bool(c, rir_constant_int_to_signed_width(ia, etype) <=
+                               rir_constant_int_to_signed_width(ib, etype));
+        break;
+    case RIR_EXPRESSION_CMP_LT:
+        ast_constant_init_bool(c, rir_constant_int_to_signed_width(ia, etype) <
+                               rir_constant_int_to_signed_width(ib, etype));
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Fold an integer to integer conversion. Like in the backend, widening
+ * zero extends and narrowing truncates.
+ */
+static bool constfold_convert(const struct rir_expression *e,
+                              const struct rir_value *v,
+                              struct ast_constant *c)
+{
+    int64_t i;
+    const struct rir_type *totype = e->convert.type;
+    if (!constfold_int_constant(v, &i) ||
+        totype->is_pointer ||
+        !rir_type_is_elementary(totype) ||
+        !elementary_type_is_int(totype->etype)) {
+        return false;
+    }
+    // zero extend from the source width, then truncate to the target width
+    i = rir_constant_int_to_width(i, v->type->etype | 1);
+    ast_constant_init_int(c, rir_constant_int_to_width(i, totype->etype));
+    return true;
+}
+
+/**
+ * Evaluate a call to a pure function with constant arguments using the
+ * interpreter. Calls that fail to evaluate, for example because they divide
+ * by zero or do not finish within the interpreter's step limit, are left
+ * alone so that they behave the same at runtime.
+ */
+static bool constfold_call(const struct rir_expression *e,
+                           const struct rir_replacements *repl,
+                           struct rir_pass_ctx *ctx,
+                           struct ast_constant *c)
+{
+    union rir_interp_cell args[CONSTFOLD_CALL_MAX_ARGS];
+    union rir_interp_cell ret;
+    const struct rir_fndef *callee;
+    const struct rir_value *v;
+    struct rir_value **arg;
+    unsigned i = 0;
+    if (e->call.foreign ||
+        darray_size(e->call.args) > CONSTFOLD_CALL_MAX_ARGS ||
+        !(callee = rir_interp_fndef(ctx->interp, &e->call.name)) ||
+        darray_size(callee->decl.argument_types) != darray_size(e->call.args)) {
+        return false;
+    }
+    darray_foreach(arg, e->call.args) {
+        v = rir_replacements_resolve(repl, *arg);
+        if (v->category != RIR_VALUE_CONSTANT) {
+            return false;
+        }
+        rir_interp_cell_from_constant(&args[i++], v);
+    }
+    if (!rir_interp_fn_is_pure(ctx->interp, callee) ||
+        !rir_interp_call(ctx->interp, callee, args, &ret)) {
+        return false;
+    }
+    rir_interp_cell_to_constant(&ret, e->val.type, c);
+    return true;
+}
+
+/**
+ * Remove the calls that got folded. Unlike the other folded expressions
+ * they can't be left to dead code elimination since calls are not pure in
+ * general.
+ */
+static void constfold_remove_calls(struct rir_fndef *fn,
+                                   const struct rir_replacements *repl,
+                                   struct rir *r)
+{
+    struct rir_block **b;
+    struct rir_expression *e;
+    struct rir_expression *tmp;
+    darray_foreach(b, fn->blocks) {
+        rf_ilist_for_each_safe(&(*b)->expressions, e, tmp, ln) {
+            if (e->type == RIR_EXPRESSION_CALL &&
+                rir_replacements_resolve(repl, &e->val) != &e->val) {
+                rir_block_remove_expr(*b, e, r, fn);
+            }
+        }
+    }
+}
+
+bool rir_pass_constfold(struct rir_fndef *fn, struct rir_pass_ctx *ctx)
+{
+    struct rir_replacements repl;
+    struct rir_block **b;
+    struct rir_expression *e;
+    struct rir_value *folded;
+    struct ast_constant c;
+    bool can_fold;
+    bool ret = false;
+
+    rir_replacements_init(&repl);
+    darray_foreach(b, fn->blocks) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            switch (e->type) {
+            case RIR_EXPRESSION_ADD:
+            case RIR_EXPRESSION_SUB:
+            case RIR_EXPRESSION_MUL:
+            case RIR_EXPRESSION_DIV:
+            case RIR_EXPRESSION_CMP_EQ:
+            case RIR_EXPRESSION_CMP_NE:
+            case RIR_EXPRESSION_CMP_GE:
+            case RIR_EXPRESSION_CMP_GT:
+            case RIR_EXPRESSION_CMP_LE:
+            case RIR_EXPRESSION_CMP_LT:
+                // operands may themselves have been folded earlier in this walk
+                can_fold = constfold_binaryop(
+                    e,
+                    rir_replacements_resolve(&repl, e->binaryop.a),
+                    rir_replacements_resolve(&repl, e->binaryop.b),
+                    &c
+                );
+                break;
+            case RIR_EXPRESSION_CONVERT:
+                can_fold = constfold_convert(
+                    e,
+                    rir_replacements_resolve(&repl, e->convert.val),
+                    &c
+                );
+                break;
+            case RIR_EXPRESSION_CALL:
+                can_fold = constfold_call(e, &repl, ctx, &c);
+                break;
+            default:
+                can_fold = false;
+                break;
+            }
+            if (!can_fold) {
+                continue;
+            }
+            if (!(folded = rir_constantval_create_typed(&c, e->val.type, ctx->rir))) {
+                goto end;
+            }
+            if (!rir_replacements_add(&repl, &e->val, folded)) {
+                goto end;
+            }
+            ++ctx->changes;
+        }
+    }
+    // the folded expressions are left for dead code elimination to remove
+    rir_replacements_apply(&repl, fn);
+    constfold_remove_calls(fn, &repl, ctx->rir);
+    ret = true;
+end:
+    rir_replacements_deinit(&repl);
+    return ret;
+}
@@ -0,0 +1,121 @@
+#include "rir_pass.h"
+
+#include <rfbase/datastructs/darray.h>
+
+#include <analyzer/symbol_table.h>
+#include <ir/rir.h>
+#include <ir/rir_block.h>
+#include <ir/rir_code.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_object.h>
+#include <ir/rir_type.h>
+#include <ir/rir_value.h>
+
+/**
+ * Remove writes of a value onto itself, which would be lowered to a copy
+ */
+static void copyelim_self_writes(struct rir_code *code, struct rir_pass_ctx *ctx)
+{
+    struct rir_instr *i;
+    darray_foreach(i, code->instrs) {
+        if (!rir_instr_is_dead(i) && i->op == RIR_EXPRESSION_WRITE &&
+            i->expr->write.memory == i->expr->write.writeval) {
+            rir_code_kill(code, i, ctx->rir);
+            ++ctx->changes;
+        }
+    }
+}
+
+/**
+ * @return The single value every write into the return slot copies from, or
+ *         NULL if the return slot is used in any other way or written from
+ *         different values
+ */
+static const struct rir_value *copyelim_retslot_source(const struct rir_code *code,
+                                                       const struct rir_value *retslot)
+{
+    const struct rir_use *use;
+    const struct rir_instr *i;
+    const struct rir_value *src = NULL;
+    uint32_t u;
+    for (u = darray_item(code->first_use, retslot->id); u != RIR_CODE_NONE; u = use->next) {
+        use = &darray_item(code->uses, u);
+        if (!use->operand || (use->user & RIR_CODE_EXIT_USER)) {
+            // killed or the return of the function
+            continue;
+        }
+        i = &darray_item(code->instrs, use->user);
+        if (i->op != RIR_EXPRESSION_WRITE ||
+            i->expr->write.memory != retslot ||
+            (src && i->expr->write.writeval != src)) {
+            return NULL;
+        }
+        src = i->expr->write.writeval;
+    }
+    return src;
+}
+
+/**
+ * If all returns of the function copy the same local aggregate into the
+ * return slot, build that aggregate in the return slot directly. The local
+ * lives as long as the return slot so they can't be alive at the same time
+ * holding different contents.
+ *
+ * @return false in failure
+ */
+static bool copyelim_retslot(struct rir_code *code,
+                             struct rir_fndef *fn,
+                             struct rir_pass_ctx *ctx)
+{
+    const struct rir_value *retslot = fn->retslot_val;
+    const struct rir_value *src;
+    struct rir_instr *def;
+    struct rir_instr *i;
+    struct rir_object *obj;
+    struct symbol_table *st;
+    struct symbol_table_record *rec;
+    if (!retslot || !rir_type_is_composite(retslot->type) ||
+        rir_code_uses_num(code, retslot) == 0 ||
+        !(src = copyelim_retslot_source(code, retslot)) ||
+        !(def = rir_code_def(code, src)) ||
+        def->op != RIR_EXPRESSION_ALLOCA ||
+        !rir_type_identical(src->type, retslot->type)) {
+        return true;
+    }
+    // only touch the code once nothing can fail, so it is never left with
+    // the copies gone but the local still in use
+    if (!rir_code_replace_uses(code, src, retslot)) {
+        return false;
+    }
+    // the copies into the return slot are now writes of it onto itself
+    darray_foreach(i, code->instrs) {
+        if (!rir_instr_is_dead(i) && i->op == RIR_EXPRESSION_WRITE &&
+            i->expr->write.memory == retslot && i->expr->write.writeval == retslot) {
+            rir_code_kill(code, i, ctx->rir);
+            ++ctx->changes;
+        }
+    }
+    // like for promoted variables the symbol table must not point to it
+    obj = rir_expression_to_obj(def->expr);
+    st = darray_item(code->blocks, def->block).block->st;
+    if (st && (rec = symbol_table_lookup_rirobj(st, obj)) && rec->rirobj == obj) {
+        rec->rirobj = NULL;
+    }
+    rir_code_kill(code, def, ctx->rir);
+    ++ctx->changes;
+    return true;
+}
+
+bool rir_pass_copyelim(struct rir_fndef *fn, struct rir_pass_ctx *ctx)
+{
+    struct rir_code code;
+    bool ret;
+    if (!rir_code_init(&code, fn)) {
+        return false;
+    }
+    copyelim_self_writes(&code, ctx);
+    ret = copyelim_retslot(&code, fn, ctx);
+    rir_code_deinit(&code);
+    return ret;
+}
@@ -0,0 +1,67 @@
+#include "rir_pass.h"
+#include "rir_pass_utils.h"
+
+#include <rfbase/datastructs/darray.h>
+
+#include <ir/rir.h>
+#include <ir/rir_code.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_value.h>
+
+struct dce_worklist {darray(struct rir_instr*);};
+
+static bool dce_is_dead(const struct rir_code *c, const struct rir_instr *i)
+{
+    return !rir_instr_is_dead(i) &&
+        rir_expression_is_pure(i->expr) &&
+        rir_code_uses_num(c, &i->expr->val) == 0;
+}
+
+bool rir_pass_dce(struct rir_fndef *fn, struct rir_pass_ctx *ctx)
+{
+    struct rir_code code;
+    struct dce_worklist work;
+    struct dce_worklist operand_defs;
+    struct rir_instr *i;
+    struct rir_instr *def;
+    struct rir_instr **it;
+    const uint32_t *ops;
+    unsigned n;
+    if (!rir_code_init(&code, fn)) {
+        return false;
+    }
+    darray_init(work);
+    darray_init(operand_defs);
+    darray_foreach(i, code.instrs) {
+        if (dce_is_dead(&code, i)) {
+            darray_append(work, i);
+        }
+    }
+    // removing an expression may leave its operands unused, so those are
+    // checked right after instead of sweeping the whole function again
+    while (darray_size(work) != 0) {
+        i = darray_pop(work);
+        if (!dce_is_dead(&code, i)) {
+            continue;
+        }
+        darray_resize(operand_defs, 0);
+        ops = rir_instr_ops(&code, i);
+        for (n = 0; n < i->ops_num; ++n) {
+            if ((def = rir_code_def(&code, rir_code_value(&code, ops[n])))) {
+                darray_append(operand_defs, def);
+            }
+        }
+        rir_code_kill(&code, i, ctx->rir);
+        ++ctx->changes;
+        darray_foreach(it, operand_defs) {
+            if (dce_is_dead(&code, *it)) {
+                darray_append(work, *it);
+            }
+        }
+    }
+    darray_free(operand_defs);
+    darray_free(work);
+    rir_code_deinit(&code);
+    return true;
+}
@@ -0,0 +1,887 @@
+#include "rir_pass.h"
+#include "rir_pass_utils.h"
+
+#include <rfbase/datastructs/darray.h>
+#include <rfbase/datastructs/intrusive_list.h>
+#include <rfbase/string/core.h>
+#include <rfbase/utils/memory.h>
+
+#include <ast/constants.h>
+#include <ir/parser/rirparser.h>
+#include <ir/rir.h>
+#include <ir/rir_block.h>
+#include <ir/rir_constant.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_global.h>
+#include <ir/rir_object.h>
+#include <ir/rir_phi.h>
+#include <ir/rir_type.h>
+#include <ir/rir_value.h>
+
+// calls whose copied part of the callee has more expressions are not inlined
+#define INLINE_MAX_COST 40
+// a function stops inlining calls once it grew by this many expressions
+#define INLINE_MAX_GROWTH 400
+
+static const struct RFstring s_cont_label = RF_STRING_STATIC_INIT("cont");
+
+struct inline_block_arr {darray(struct rir_block*);};
+
+/**
+ * A call that can be inlined and what is known about it at the call site
+ */
+struct inline_site {
+    //! The call expression
+    struct rir_expression *call;
+    //! The block containing the call
+    struct rir_block *block;
+    //! Definition of the called function
+    struct rir_fndef *callee;
+    //! Argument of the callee holding a sum type whose index is set by the
+    //! caller right before the call. NULL if there is none.
+    const struct rir_value *sum_arg;
+    //! The union index of @ref sum_arg
+    int64_t sum_idx;
+    //! Blocks of the callee that can run for this call in reverse postorder
+    struct inline_block_arr order;
+    //! For each block of the callee its copy in the caller or NULL
+    struct inline_block_arr clones;
+    //! Number of expressions that get copied into the caller
+    unsigned cost;
+};
+
+struct inline_phi {
+    //! The callee block holding the phi
+    const struct rir_block *block;
+    const struct rir_expression *src;
+    struct rir_expression *copy;
+};
+
+struct inline_removal {
+    struct rir_block *block;
+    struct rir_expression *call;
+};
+
+struct inline_ctx {
+    struct rir *rir;
+    //! The function calls get inlined into
+    struct rir_fndef *fn;
+    //! Map from values of the callee to the values replacing them
+    struct rirvalue_idmap map;
+    //! Used to give the copied values their ids
+    struct rir_pctx pctx;
+    //! Uses of inlined calls get replaced by the values the callee returned
+    struct rir_replacements repl;
+    //! Inlined calls, removed once no expression uses their value anymore
+    struct {darray(struct inline_removal);} removals;
+    //! Allocations of the copied code, moved to the start of the function
+    struct {darray(struct rir_expression*);} allocas;
+    //! Phis of the copied code, whose incoming values are added last
+    struct {darray(struct inline_phi);} phis;
+    //! Number used to give the blocks of each inlined call unique labels
+    unsigned next_site;
+    //! Expressions added to the function so far
+    unsigned growth;
+};
+
+static int inline_block_idx(const struct rir_fndef *fn, const struct rir_block *b)
+{
+    unsigned i;
+    for (i = 0; i < darray_size(fn->blocks); ++i) {
+        if (darray_item(fn->blocks, i) == b) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static struct rir_block *inline_site_clone(const struct inline_site *site,
+                                           const struct rir_block *b)
+{
+    int idx = inline_block_idx(site->callee, b);
+    return idx == -1 ? NULL : darray_item(site->clones, idx);
+}
+
+/**
+ * @return true if @a v has an integer or boolean value known at the call
+ *         site, placing it in @a out
+ */
+static bool inline_site_known_int(const struct inline_site *site,
+                                  const struct rir_value *v,
+                                  int64_t *out)
+{
+    struct rir_object *obj;
+    int argnum;
+    if (v->category == RIR_VALUE_VARIABLE) {
+        if ((argnum = rir_fndef_value_to_argnum(site->callee, v)) != -1) {
+            v = darray_item(site->call->call.args, argnum);
+        } else if (site->sum_arg &&
+                   v->id < darray_size(site->callee->values) &&
+                   (obj = darray_item(site->callee->values, v->id)) &&
+                   obj->category == RIR_OBJ_EXPRESSION &&
+                   obj->expr.type == RIR_EXPRESSION_GETUNIONIDX &&
+                   obj->expr.getunionidx.unimemory == site->sum_arg) {
+            *out = site->sum_idx;
+            return true;
+        }
+    }
+    if (v->category != RIR_VALUE_CONSTANT) {
+        return false;
+    }
+    switch (v->constant.type) {
+    case CONSTANT_NUMBER_INTEGER:
+        *out = v->constant.value.integer;
+        return true;
+    case CONSTANT_BOOLEAN:
+        *out = v->constant.value.boolean;
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+/**
+ * @return The label a conditional exit always goes to for this call or NULL
+ *         if it depends on values only known at runtime
+ */
+static struct rir_value *inline_site_known_dst(const struct inline_site *site,
+                                               const struct rir_block_exit *exit)
+{
+    struct rir_switch_case *c;
+    int64_t known;
+    int64_t caseval;
+    switch (exit->type) {
+    case RIR_BLOCK_EXIT_CONDBRANCH:
+        if (inline_site_known_int(site, exit->condbranch.cond, &known)) {
+            return known ? exit->condbranch.taken : exit->condbranch.fallthrough;
+        }
+        break;
+    case RIR_BLOCK_EXIT_SWITCH:
+        if (inline_site_known_int(site, exit->switchbr.cond, &known)) {
+            darray_foreach(c, exit->switchbr.cases) {
+                if (inline_site_known_int(site, c->val, &caseval) && caseval == known) {
+                    return c->dst;
+                }
+            }
+            return exit->switchbr.fallthrough;
+        }
+        break;
+    default:
+        break;
+    }
+    return NULL;
+}
+
+/**
+ * Get the blocks control can go to after @a b when called from this site,
+ * leaving out the branches that can't be taken
+ */
+static void inline_site_succs(const struct inline_site *site,
+                              const struct rir_block *b,
+                              struct inline_block_arr *succs)
+{
+    struct rir_switch_case *c;
+    struct rir_value *known;
+    darray_resize(*succs, 0);
+    if ((known = inline_site_known_dst(site, &b->exit))) {
+        darray_append(*succs, rir_value_label_dst(known));
+        return;
+    }
+    switch (b->exit.type) {
+    case RIR_BLOCK_EXIT_BRANCH:
+        darray_append(*succs, rir_value_label_dst(b->exit.branch.dst));
+        break;
+    case RIR_BLOCK_EXIT_CONDBRANCH:
+        darray_append(*succs, rir_value_label_dst(b->exit.condbranch.taken));
+        darray_append(*succs, rir_value_label_dst(b->exit.condbranch.fallthrough));
+        break;
+    case RIR_BLOCK_EXIT_SWITCH:
+        darray_append(*succs, rir_value_label_dst(b->exit.switchbr.fallthrough));
+        darray_foreach(c, b->exit.switchbr.cases) {
+            darray_append(*succs, rir_value_label_dst(c->dst));
+        }
+        break;
+    case RIR_BLOCK_EXIT_RETURN:
+    case RIR_BLOCK_EXIT_INVALID:
+        break;
+    }
+}
+
+static void inline_site_postorder(struct inline_site *site,
+                                  struct rir_block *b,
+                                  bool *visited)
+{
+    struct inline_block_arr succs;
+    struct rir_block **s;
+    int idx;
+    visited[inline_block_idx(site->callee, b)] = true;
+    darray_init(succs);
+    inline_site_succs(site, b, &succs);
+    darray_foreach(s, succs) {
+        idx = inline_block_idx(site->callee, *s);
+        if (idx != -1 && !visited[idx]) {
+            inline_site_postorder(site, *s, visited);
+        }
+    }
+    darray_free(succs);
+    darray_append(site->order, b);
+}
+
+/**
+ * Find the blocks of the callee that can run for this call. Dominators come
+ * before the blocks they dominate so values get copied before their uses.
+ */
+static bool inline_site_order(struct inline_site *site)
+{
+    struct rir_block *tmp;
+    unsigned i;
+    unsigned n;
+    bool *visited;
+    RF_CALLOC(visited, darray_size(site->callee->blocks), sizeof(*visited), return false);
+    inline_site_postorder(site, darray_item(site->callee->blocks, 0), visited);
+    free(visited);
+    n = darray_size(site->order);
+    for (i = 0; i < n / 2; ++i) {
+        tmp = darray_item(site->order, i);
+        darray_item(site->order, i) = darray_item(site->order, n - i - 1);
+        darray_item(site->order, n - i - 1) = tmp;
+    }
+    return true;
+}
+
+/**
+ * If the call passes a sum type whose index is set right before the call, as
+ * the lowering of calls to functions with sum type arguments does, remember
+ * the index so that the callee's match on it can be resolved.
+ */
+static void inline_site_find_sum_idx(struct inline_site *site)
+{
+    const struct rir_value *arg;
+    const struct rir_value *idx;
+    struct rir_value **v;
+    struct rir_expression *e;
+    bool known = false;
+    if (darray_size(site->call->call.args) != 1) {
+        return;
+    }
+    arg = darray_item(site->call->call.args, 0);
+    if (arg->category != RIR_VALUE_VARIABLE || !rir_type_is_union(arg->type)) {
+        return;
+    }
+    rf_ilist_for_each(&site->block->expressions, e, ln) {
+        if (e == site->call) {
+            break;
+        }
+        if (e->type == RIR_EXPRESSION_SETUNIONIDX && e->setunionidx.unimemory == arg) {
+            idx = e->setunionidx.idx;
+            known = idx->category == RIR_VALUE_CONSTANT &&
+                idx->constant.type == CONSTANT_NUMBER_INTEGER;
+            site->sum_idx = known ? idx->constant.value.integer : 0;
+        } else if (e->type == RIR_EXPRESSION_WRITE && e->write.memory == arg) {
+            known = false;
+        } else if (e->type == RIR_EXPRESSION_CALL) {
+            // a function getting the union's memory may change its index
+            darray_foreach(v, e->call.args) {
+                known = known && *v != arg;
+            }
+        }
+    }
+    if (known) {
+        site->sum_arg = rir_object_value(darray_item(site->callee->variables, 0));
+    }
+}
+
+/**
+ * Sum up the cost of inlining the call and check that the part of the
+ * callee that would be copied can be copied
+ */
+static bool inline_site_check(struct inline_site *site, struct inline_ctx *ctx)
+{
+    struct rir_block **b;
+    struct rir_expression *e;
+    unsigned returns = 0;
+    darray_foreach(b, site->order) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            switch (e->type) {
+            case RIR_EXPRESSION_CONSTANT:
+            case RIR_EXPRESSION_RETURN:
+            case RIR_EXPRESSION_PLACEHOLDER:
+                return false;
+            case RIR_EXPRESSION_GETUNIONIDX:
+                if (site->sum_arg && e->getunionidx.unimemory == site->sum_arg) {
+                    // becomes a constant
+                    continue;
+                }
+                break;
+            case RIR_EXPRESSION_CALL:
+                // calls of the copy are resolved from the caller's module
+                if (!rir_fndecl_byname(ctx->rir, &e->call.name)) {
+                    return false;
+                }
+                break;
+            default:
+                break;
+            }
+            ++site->cost;
+        }
+        if ((*b)->exit.type == RIR_BLOCK_EXIT_RETURN) {
+            ++returns;
+        }
+    }
+    // a single return lets the copy continue in the caller without a phi
+    return returns == 1 &&
+        site->cost <= INLINE_MAX_COST &&
+        ctx->growth + site->cost <= INLINE_MAX_GROWTH;
+}
+
+static void inline_site_deinit(struct inline_site *site)
+{
+    darray_free(site->order);
+    darray_free(site->clones);
+}
+
+/**
+ * @return true if @a call should be inlined, in which case @a site gets
+ *         initialized and has to be freed with inline_site_deinit()
+ */
+static bool inline_site_init(struct inline_site *site,
+                             struct inline_ctx *ctx,
+                             struct rir_block *b,
+                             struct rir_expression *call)
+{
+    struct rir_fndecl *decl;
+    unsigned i;
+    if (call->call.foreign ||
+        !(decl = rir_fndecl_byname(ctx->rir, &call->call.name)) ||
+        decl->plain_decl) {
+        return false;
+    }
+    RF_STRUCT_ZERO(site);
+    site->call = call;
+    site->block = b;
+    site->callee = rir_fndecl_to_fndef(decl);
+    // bodies of binary rir modules may not have been loaded
+    if (site->callee == ctx->fn ||
+        darray_size(site->callee->blocks) == 0 ||
+        darray_size(site->callee->variables) != darray_size(call->call.args)) {
+        return false;
+    }
+    darray_init(site->order);
+    darray_init(site->clones);
+    for (i = 0; i < darray_size(site->callee->blocks); ++i) {
+        darray_append(site->clones, NULL);
+    }
+    inline_site_find_sum_idx(site);
+    if (!inline_site_order(site) || !inline_site_check(site, ctx)) {
+        inline_site_deinit(site);
+        return false;
+    }
+    return true;
+}
+
+static struct rir_type *inline_type(struct inline_ctx *ctx, const struct rir_type *t)
+{
+    // the callee may belong to another module
+    return rir_type_get_or_create_from_other(t, ctx->rir, t->is_pointer);
+}
+
+/**
+ * @return The value of the caller that replaces a value of the callee or
+ *         NULL for failure
+ */
+static const struct rir_value *inline_map_value(struct inline_ctx *ctx,
+                                                const struct rir_value *v)
+{
+    struct rir_object *obj;
+    const struct rir_value *mapped;
+    switch (v->category) {
+    case RIR_VALUE_VARIABLE:
+        mapped = rirvalue_idmap_get(&ctx->map, v);
+        RF_ASSERT(mapped, "A value of the callee was used before it got copied");
+        return mapped;
+    case RIR_VALUE_CONSTANT:
+        // constants can belong to another module or to an expression that
+        // is not copied so they are always created anew
+        return rir_constantval_create_typed(
+            &v->constant,
+            rir_type_get_or_create_from_other(v->type, ctx->rir, false),
+            ctx->rir
+        );
+    case RIR_VALUE_LITERAL:
+        obj = rir_global_addorget_string(ctx->rir, &v->literal);
+        return obj ? rir_object_value(obj) : NULL;
+    case RIR_VALUE_LABEL:
+        RF_CRITICAL_FAIL("Labels are not operands");
+        break;
+    case RIR_VALUE_NIL:
+        return v;
+    }
+    return NULL;
+}
+
+static struct rir_value *inline_map_label(const struct inline_site *site,
+                                          const struct rir_value *label)
+{
+    return &inline_site_clone(site, rir_value_label_dst(label))->label;
+}
+
+struct inline_operand_ctx {
+    struct inline_ctx *ctx;
+    bool failed;
+};
+
+static void inline_map_operand_cb(const struct rir_value **operand,
+                                  struct inline_operand_ctx *opctx)
+{
+    if (!(*operand = inline_map_value(opctx->ctx, *operand))) {
+        opctx->failed = true;
+    }
+}
+
+/**
+ * Copy an expression of the callee into the caller, with its operands
+ * replaced by the caller's values
+ */
+static struct rir_expression *inline_clone_expr(struct inline_ctx *ctx,
+                                                const struct rir_expression *src)
+{
+    struct rir_object *obj;
+    struct rir_expression *e;
+    struct rir_value **v;
+    struct inline_operand_ctx opctx;
+    bool ok = true;
+    if (!(obj = rir_object_create(RIR_OBJ_EXPRESSION, ctx->rir))) {
+        return NULL;
+    }
+    e = &obj->expr;
+    *e = *src;
+    RF_STRUCT_ZERO(&e->val);
+    switch (src->type) {
+    case RIR_EXPRESSION_CALL:
+        RF_STRUCT_ZERO(&e->call.name);
+        darray_init(e->call.args);
+        darray_foreach(v, src->call.args) {
+            darray_append(e->call.args, *v);
+        }
+        ok = rf_string_copy_in(&e->call.name, &src->call.name);
+        break;
+    case RIR_EXPRESSION_FIXEDARR:
+        e->fixedarr.member_type = inline_type(ctx, src->fixedarr.member_type);
+        darray_init(e->fixedarr.members);
+        darray_foreach(v, src->fixedarr.members) {
+            darray_append(e->fixedarr.members, *v);
+        }
+        break;
+    case RIR_EXPRESSION_PHI:
+        // incoming values are added once all blocks got copied
+        e->phi.type = inline_type(ctx, src->phi.type);
+        darray_init(e->phi.incoming);
+        break;
+    case RIR_EXPRESSION_ALLOCA:
+        e->alloca.type = inline_type(ctx, src->alloca.type);
+        break;
+    case RIR_EXPRESSION_CONVERT:
+        e->convert.type = inline_type(ctx, src->convert.type);
+        break;
+    default:
+        break;
+    }
+    opctx.ctx = ctx;
+    opctx.failed = false;
+    rir_expression_foreach_operand(e, (rir_operand_cb)inline_map_operand_cb, &opctx);
+    if (!ok || opctx.failed) {
+        goto fail;
+    }
+    RFS_PUSH();
+    // ids past the end of the function's values are always free
+    rir_pctx_set_id(&ctx->pctx, RFS("$%u", (unsigned)darray_size(ctx->fn->values)));
+    ok = rir_object_expression_init(obj, src->type, RIRPOS_PARSE, &ctx->pctx);
+    rir_pctx_reset_id(&ctx->pctx);
+    RFS_POP();
+    if (!ok) {
+        goto fail;
+    }
+    return e;
+
+fail:
+    rir_object_listrem_destroy(obj, ctx->rir, ctx->fn);
+    return NULL;
+}
+
+static struct rir_block *inline_create_block(struct inline_ctx *ctx,
+                                             const struct inline_site *site,
+                                             unsigned site_num,
+                                             const struct RFstring *name)
+{
+    struct rir_block *b;
+    RFS_PUSH();
+    b = rir_block_create(
+        RFS("inline%u_"RFS_PF, site_num, RFS_PA(name)),
+        RIRPOS_PARSE,
+        &ctx->pctx
+    );
+    RFS_POP();
+    if (b) {
+        b->st = site->block->st;
+    }
+    return b;
+}
+
+/**
+ * Move everything after the call to a new block that takes over the exit
+ * of the call's block
+ */
+static struct rir_block *inline_split_block(struct inline_ctx *ctx,
+                                            const struct inline_site *site,
+                                            unsigned site_num)
+{
+    struct rir_block *cont;
+    struct rir_block **b;
+    struct rir_expression *e;
+    struct rir_expression *tmp;
+    struct rir_phi_incoming *in;
+    bool after_call = false;
+    if (!(cont = inline_create_block(ctx, site, site_num, &s_cont_label))) {
+        return NULL;
+    }
+    rf_ilist_for_each_safe(&site->block->expressions, e, tmp, ln) {
+        if (after_call) {
+            rf_ilist_delete_from(&site->block->expressions, &e->ln);
+            rir_block_add_expr(cont, e);
+        }
+        after_call = after_call || e == site->call;
+    }
+    cont->exit = site->block->exit;
+    RF_STRUCT_ZERO(&site->block->exit);
+    // successors are now entered from the new block
+    darray_foreach(b, ctx->fn->blocks) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            if (e->type != RIR_EXPRESSION_PHI) {
+                break;
+            }
+            darray_foreach(in, e->phi.incoming) {
+                if (in->block == &site->block->label) {
+                    in->block = &cont->label;
+                }
+            }
+        }
+    }
+    return cont;
+}
+
+static bool inline_clone_exit(struct inline_ctx *ctx,
+                              const struct inline_site *site,
+                              const struct rir_block *src,
+                              struct rir_block *cont,
+                              const struct rir_value **retval)
+{
+    struct rir_block *dst = inline_site_clone(site, src);
+    const struct rir_block_exit *exit = &src->exit;
+    const struct rir_value *cond;
+    const struct rir_value *caseval;
+    struct rir_switch_case *c;
+    struct rir_value *known;
+    if ((known = inline_site_known_dst(site, exit))) {
+        return rir_block_exit_init_branch(&dst->exit, inline_map_label(site, known));
+    }
+    switch (exit->type) {
+    case RIR_BLOCK_EXIT_BRANCH:
+        return rir_block_exit_init_branch(&dst->exit, inline_map_label(site, exit->branch.dst));
+    case RIR_BLOCK_EXIT_CONDBRANCH:
+        if (!(cond = inline_map_value(ctx, exit->condbranch.cond))) {
+            return false;
+        }
+        return rir_block_exit_init_condbranch(
+            &dst->exit,
+            cond,
+            inline_map_label(site, exit->condbranch.taken),
+            inline_map_label(site, exit->condbranch.fallthrough)
+        );
+    case RIR_BLOCK_EXIT_SWITCH:
+        if (!(cond = inline_map_value(ctx, exit->switchbr.cond)) ||
+            !rir_block_exit_init_switch(&dst->exit, cond, inline_map_label(site, exit->switchbr.fallthrough))) {
+            return false;
+        }
+        darray_foreach(c, exit->switchbr.cases) {
+            if (!(caseval = inline_map_value(ctx, c->val))) {
+                return false;
+            }
+            rir_switch_add_case(&dst->exit.switchbr, caseval, inline_map_label(site, c->dst));
+        }
+        return true;
+    case RIR_BLOCK_EXIT_RETURN:
+        if (exit->retstmt.val && !(*retval = inline_map_value(ctx, exit->retstmt.val))) {
+            return false;
+        }
+        return rir_block_exit_init_branch(&dst->exit, &cont->label);
+    case RIR_BLOCK_EXIT_INVALID:
+        break;
+    }
+    RF_ERROR("Encountered a block without an exit while inlining");
+    return false;
+}
+
+static bool inline_clone_block(struct inline_ctx *ctx,
+                               const struct inline_site *site,
+                               const struct rir_block *src,
+                               struct rir_block *cont,
+                               const struct rir_value **retval)
+{
+    struct rir_block *dst = inline_site_clone(site, src);
+    struct rir_expression *e;
+    struct rir_expression *copy;
+    struct rir_value *v;
+    struct inline_phi phi;
+    rf_ilist_for_each(&src->expressions, e, ln) {
+        if (e->type == RIR_EXPRESSION_FIXEDARRSIZE) {
+            // its value is a constant and constants get copied at their uses
+            continue;
+        }
+        if (e->type == RIR_EXPRESSION_GETUNIONIDX &&
+            site->sum_arg && e->getunionidx.unimemory == site->sum_arg) {
+            // the index the caller set, which resolves the callee's match
+            if (!(v = rir_constantval_create_fromint64(site->sum_idx, ctx->rir)) ||
+                !rirvalue_idmap_add(&ctx->map, &e->val, v)) {
+                return false;
+            }
+            continue;
+        }
+        if (!(copy = inline_clone_expr(ctx, e))) {
+            return false;
+        }
+        if (copy->type == RIR_EXPRESSION_ALLOCA) {
+            darray_append(ctx->allocas, copy);
+        } else {
+            rir_block_add_expr(dst, copy);
+        }
+        if (copy->type == RIR_EXPRESSION_PHI) {
+            phi.block = src;
+            phi.src = e;
+            phi.copy = copy;
+            darray_append(ctx->phis, phi);
+        }
+        if (e->val.category == RIR_VALUE_VARIABLE &&
+            !rirvalue_idmap_add(&ctx->map, &e->val, &copy->val)) {
+            return false;
+        }
+    }
+    return inline_clone_exit(ctx, site, src, cont, retval);
+}
+
+/**
+ * Give the copied phis the incoming values of the edges that got copied
+ */
+static bool inline_connect_phis(struct inline_ctx *ctx, const struct inline_site *site)
+{
+    struct inline_block_arr succs;
+    struct inline_phi *phi;
+    struct rir_phi_incoming *in;
+    struct rir_block *pred;
+    struct rir_block **s;
+    const struct rir_value *val;
+    bool is_succ;
+    bool ret = false;
+    darray_init(succs);
+    darray_foreach(phi, ctx->phis) {
+        darray_foreach(in, phi->src->phi.incoming) {
+            pred = rir_value_label_dst(in->block);
+            if (!inline_site_clone(site, pred)) {
+                continue;
+            }
+            inline_site_succs(site, pred, &succs);
+            is_succ = false;
+            darray_foreach(s, succs) {
+                is_succ = is_succ || *s == phi->block;
+            }
+            if (!is_succ) {
+                continue;
+            }
+            if (!(val = inline_map_value(ctx, in->val))) {
+                goto end;
+            }
+            rir_phi_add_incoming(&phi->copy->phi, val, &inline_site_clone(site, pred)->label);
+        }
+    }
+    ret = true;
+end:
+    darray_free(succs);
+    return ret;
+}
+
+static void inline_insert_blocks(struct inline_ctx *ctx,
+                                 const struct inline_site *site,
+                                 struct rir_block *cont)
+{
+    struct inline_block_arr blocks;
+    struct rir_block **b;
+    struct rir_block **src;
+    struct rir_expression **e;
+    darray_init(blocks);
+    darray_foreach(b, ctx->fn->blocks) {
+        darray_append(blocks, *b);
+        if (*b != site->block) {
+            continue;
+        }
+        darray_foreach(src, site->order) {
+            darray_append(blocks, inline_site_clone(site, *src));
+        }
+        darray_append(blocks, cont);
+    }
+    darray_free(ctx->fn->blocks);
+    darray_shallow_copy(ctx->fn->blocks, blocks);
+    // allocations go to the start of the function, in their original order
+    darray_foreach_reverse(e, ctx->allocas) {
+        rf_ilist_add(&darray_item(ctx->fn->blocks, 0)->expressions, &(*e)->ln);
+    }
+}
+
+/**
+ * Replace a call with a copy of the part of the callee it can run
+ *
+ * @param cont         Returns the block holding the expressions that
+ *                     followed the call
+ */
+static bool inline_site_apply(struct inline_ctx *ctx,
+                              const struct inline_site *site,
+                              struct rir_block **cont)
+{
+    struct rir_block **src;
+    struct rir_block *copy;
+    struct rir_object **var;
+    struct rir_expression *retslot;
+    struct inline_removal removal;
+    const struct rir_value *retval = NULL;
+    unsigned site_num = ctx->next_site++;
+    unsigned i = 0;
+
+    rirvalue_idmap_deinit(&ctx->map);
+    rirvalue_idmap_init(&ctx->map);
+    darray_resize(ctx->allocas, 0);
+    darray_resize(ctx->phis, 0);
+    // the arguments become the values the call passes
+    darray_foreach(var, site->callee->variables) {
+        if (!rirvalue_idmap_add(&ctx->map,
+                                rir_object_value(*var),
+                                darray_item(site->call->call.args, i++))) {
+            return false;
+        }
+    }
+    // the return slot is not part of any block, so it's copied separately
+    if (site->callee->retslot_val) {
+        retslot = rir_object_to_expr(darray_item(site->callee->values, site->callee->retslot_val->id));
+        if (!(retslot = inline_clone_expr(ctx, retslot)) ||
+            !rirvalue_idmap_add(&ctx->map, site->callee->retslot_val, &retslot->val)) {
+            return false;
+        }
+        darray_append(ctx->allocas, retslot);
+    }
+    // create all blocks first since exits can go to blocks that follow
+    darray_foreach(src, site->order) {
+        if (!(copy = inline_create_block(ctx, site, site_num, &(*src)->label.name))) {
+            return false;
+        }
+        darray_item(site->clones, inline_block_idx(site->callee, *src)) = copy;
+    }
+    if (!(*cont = inline_split_block(ctx, site, site_num)) ||
+        !rir_block_exit_init_branch(&site->block->exit,
+                                    &darray_item(site->clones, 0)->label)) {
+        return false;
+    }
+    darray_foreach(src, site->order) {
+        if (!inline_clone_block(ctx, site, *src, *cont, &retval)) {
+            return false;
+        }
+    }
+    if (!inline_connect_phis(ctx, site)) {
+        return false;
+    }
+    if (!rir_value_is_nil(&site->call->val) &&
+        (!retval || !rir_replacements_add(&ctx->repl, &site->call->val, retval))) {
+        return false;
+    }
+    inline_insert_blocks(ctx, site, *cont);
+    removal.block = site->block;
+    removal.call = site->call;
+    darray_append(ctx->removals, removal);
+    ctx->growth += site->cost;
+    return true;
+}
+
+/**
+ * Inline the first call of a block worth inlining
+ *
+ * @param b            The block to search. Returns the block holding the
+ *                     rest of the block after the inlined call or NULL if
+ *                     there was nothing to inline.
+ */
+static bool inline_next_call(struct inline_ctx *ctx, struct rir_block **b)
+{
+    struct rir_expression *e;
+    struct inline_site site;
+    bool ret;
+    rf_ilist_for_each(&(*b)->expressions, e, ln) {
+        if (e->type == RIR_EXPRESSION_CALL && inline_site_init(&site, ctx, *b, e)) {
+            ret = inline_site_apply(ctx, &site, b);
+            inline_site_deinit(&site);
+            return ret;
+        }
+    }
+    *b = NULL;
+    return true;
+}
+
+bool rir_pass_inline(struct rir_fndef *fn, struct rir_pass_ctx *pctx)
+{
+    struct inline_ctx ctx;
+    struct inline_block_arr blocks;
+    struct inline_removal *removal;
+    struct rir_block **b;
+    struct rir_block *curr;
+    bool ret = false;
+    RF_STRUCT_ZERO(&ctx);
+    ctx.rir = pctx->rir;
+    ctx.fn = fn;
+    // each inlined call adds at least two blocks so numbering from the
+    // current number of blocks never repeats labels of an earlier run
+    ctx.next_site = darray_size(fn->blocks);
+    rirvalue_idmap_init(&ctx.map);
+    rir_pctx_init(&ctx.pctx, ctx.rir);
+    ctx.pctx.common.current_fn = fn;
+    rir_replacements_init(&ctx.repl);
+    darray_init(ctx.removals);
+    darray_init(ctx.allocas);
+    darray_init(ctx.phis);
+
+    // only search the blocks the function had to begin with. Calls in
+    // copied code are left alone so that recursion can't go on forever.
+    darray_init(blocks);
+    darray_foreach(b, fn->blocks) {
+        darray_append(blocks, *b);
+    }
+    darray_foreach(b, blocks) {
+        curr = *b;
+        while (curr) {
+            if (!inline_next_call(&ctx, &curr)) {
+                goto end;
+            }
+        }
+    }
+    rir_replacements_apply(&ctx.repl, fn);
+    // the calls are only removed once nothing refers to their values
+    darray_foreach(removal, ctx.removals) {
+        rir_block_remove_expr(removal->block, removal->call, ctx.rir, fn);
+    }
+    pctx->changes += darray_size(ctx.removals);
+    ret = true;
+
+end:
+    darray_free(blocks);
+    darray_free(ctx.phis);
+    darray_free(ctx.allocas);
+    darray_free(ctx.removals);
+    rir_replacements_deinit(&ctx.repl);
+    rirvalue_idmap_deinit(&ctx.map);
+    return ret;
+}
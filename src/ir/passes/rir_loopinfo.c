@@ -0,0 +1,343 @@
+#include "rir_loopinfo.h"
+
+#include <rfbase/datastructs/intrusive_list.h>
+#include <rfbase/utils/memory.h>
+
+#include <ast/constants.h>
+#include <ir/rir_block.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_object.h>
+#include <ir/rir_phi.h>
+#include <ir/rir_value.h>
+
+static struct rir_loop *rir_loop_create(struct rir_cfg *cfg, struct rir_cfg_node *header)
+{
+    struct rir_loop *l;
+    RF_MALLOC(l, sizeof(*l), return NULL);
+    RF_CALLOC(l->contains, rir_cfg_nodes_num(cfg), sizeof(*l->contains), free(l); return NULL);
+    l->header = header;
+    l->preheader = NULL;
+    l->parent = NULL;
+    l->depth = 1;
+    l->innermost = true;
+    darray_init(l->blocks);
+    darray_init(l->latches);
+    darray_init(l->ivs);
+    l->contains[header->idx] = true;
+    darray_append(l->blocks, header);
+    return l;
+}
+
+static void rir_loop_destroy(struct rir_loop *l)
+{
+    darray_free(l->blocks);
+    darray_free(l->latches);
+    darray_free(l->ivs);
+    free(l->contains);
+    free(l);
+}
+
+/**
+ * Add the blocks that reach @a latch without going through the header
+ */
+static void rir_loop_add_latch(struct rir_loop *l, struct rir_cfg_node *latch)
+{
+    struct rir_cfg_node_arr stack;
+    struct rir_cfg_node *n;
+    struct rir_cfg_node **p;
+    darray_append(l->latches, latch);
+    if (l->contains[latch->idx]) {
+        return;
+    }
+    darray_init(stack);
+    l->contains[latch->idx] = true;
+    darray_append(l->blocks, latch);
+    darray_append(stack, latch);
+    while (darray_size(stack) != 0) {
+        n = darray_pop(stack);
+        darray_foreach(p, n->preds) {
+            if (rir_cfg_node_reachable(*p) && !l->contains[(*p)->idx]) {
+                l->contains[(*p)->idx] = true;
+                darray_append(l->blocks, *p);
+                darray_append(stack, *p);
+            }
+        }
+    }
+    darray_free(stack);
+}
+
+static void rir_loop_find_preheader(struct rir_loop *l)
+{
+    struct rir_cfg_node **p;
+    struct rir_cfg_node *outside = NULL;
+    darray_foreach(p, l->header->preds) {
+        if (!rir_cfg_node_reachable(*p) || l->contains[(*p)->idx]) {
+            continue;
+        }
+        if (outside) {
+            // more than one edge enters the loop
+            return;
+        }
+        outside = *p;
+    }
+    if (outside && darray_size(outside->succs) == 1) {
+        l->preheader = outside;
+    }
+}
+
+static struct rir_expression *rir_loop_value_expr(const struct rir_cfg *cfg,
+                                                  const struct rir_value *v)
+{
+    struct rir_object *obj;
+    if (v->category != RIR_VALUE_VARIABLE || v->id >= darray_size(cfg->fn->values)) {
+        return NULL;
+    }
+    obj = darray_item(cfg->fn->values, v->id);
+    return obj && obj->category == RIR_OBJ_EXPRESSION ? &obj->expr : NULL;
+}
+
+static bool rir_loop_int_constant(const struct rir_value *v, int64_t *out)
+{
+    if (v->category != RIR_VALUE_CONSTANT ||
+        v->constant.type != CONSTANT_NUMBER_INTEGER ||
+        v->constant.value.integer < 0) {
+        return false;
+    }
+    *out = v->constant.value.integer;
+    return true;
+}
+
+/**
+ * @return The step if @a v is the phi's value plus a positive constant
+ */
+static bool rir_loop_iv_next(const struct rir_cfg *cfg,
+                             const struct rir_expression *phi,
+                             const struct rir_value *v,
+                             int64_t *step)
+{
+    const struct rir_expression *e = rir_loop_value_expr(cfg, v);
+    if (!e || e->type != RIR_EXPRESSION_ADD) {
+        return false;
+    }
+    if (e->binaryop.a == &phi->val) {
+        return rir_loop_int_constant(e->binaryop.b, step) && *step > 0;
+    }
+    if (e->binaryop.b == &phi->val) {
+        return rir_loop_int_constant(e->binaryop.a, step) && *step > 0;
+    }
+    return false;
+}
+
+static bool rir_loop_iv_init(struct rir_loop_iv *iv,
+                             const struct rir_loop *l,
+                             const struct rir_cfg *cfg,
+                             struct rir_expression *phi)
+{
+    struct rir_phi_incoming *in;
+    struct rir_cfg_node *pred;
+    bool has_init = false;
+    bool has_step = false;
+    int64_t step;
+    iv->phi = phi;
+    iv->bounded = false;
+    iv->bound = 0;
+    iv->inside = NULL;
+    darray_foreach(in, phi->phi.incoming) {
+        if (!(pred = rir_cfg_node_from_label(cfg, in->block))) {
+            return false;
+        }
+        if (!l->contains[pred->idx]) {
+            if (has_init || !rir_loop_int_constant(in->val, &iv->init)) {
+                return false;
+            }
+            has_init = true;
+        } else {
+            if (!rir_loop_iv_next(cfg, phi, in->val, &step) ||
+                (has_step && step != iv->step)) {
+                return false;
+            }
+            iv->step = step;
+            has_step = true;
+        }
+    }
+    return has_init && has_step;
+}
+
+/**
+ * Check if the header's exit compares the variable against a constant in a
+ * way that keeps it below that constant inside the loop
+ */
+static void rir_loop_iv_find_bound(struct rir_loop_iv *iv,
+                                   const struct rir_loop *l,
+                                   const struct rir_cfg *cfg)
+{
+    const struct rir_block_exit *exit = &l->header->block->exit;
+    const struct rir_expression *cmp;
+    struct rir_cfg_node *taken;
+    struct rir_cfg_node *fallthrough;
+    struct rir_cfg_node *inside;
+    bool exits_when_true;
+    int64_t bound;
+    if (exit->type != RIR_BLOCK_EXIT_CONDBRANCH ||
+        !(cmp = rir_loop_value_expr(cfg, exit->condbranch.cond)) ||
+        cmp->binaryop.a != &iv->phi->val ||
+        !rir_loop_int_constant(cmp->binaryop.b, &bound)) {
+        return;
+    }
+    switch (cmp->type) {
+    case RIR_EXPRESSION_CMP_EQ:
+    case RIR_EXPRESSION_CMP_GE:
+        exits_when_true = true;
+        break;
+    case RIR_EXPRESSION_CMP_NE:
+    case RIR_EXPRESSION_CMP_LT:
+        exits_when_true = false;
+        break;
+    default:
+        return;
+    }
+    taken = rir_cfg_node_from_label(cfg, exit->condbranch.taken);
+    fallthrough = rir_cfg_node_from_label(cfg, exit->condbranch.fallthrough);
+    if (!taken || !fallthrough) {
+        return;
+    }
+    inside = exits_when_true ? fallthrough : taken;
+    if (!l->contains[inside->idx] ||
+        l->contains[(exits_when_true ? taken : fallthrough)->idx] ||
+        // only entered from the header, so dominated blocks saw the check
+        darray_size(inside->preds) != 1) {
+        return;
+    }
+    // an equality check only stops the variable if it is hit exactly
+    if ((cmp->type == RIR_EXPRESSION_CMP_EQ || cmp->type == RIR_EXPRESSION_CMP_NE) &&
+        (iv->init > bound || (bound - iv->init) % iv->step != 0)) {
+        return;
+    }
+    // comparisons are signed so the variable must not wrap around
+    if (bound > INT64_MAX - iv->step) {
+        return;
+    }
+    iv->bounded = true;
+    iv->bound = bound;
+    iv->inside = inside;
+}
+
+static void rir_loop_find_ivs(struct rir_loop *l, const struct rir_cfg *cfg)
+{
+    struct rir_expression *e;
+    struct rir_loop_iv iv;
+    rf_ilist_for_each(&l->header->block->expressions, e, ln) {
+        if (e->type != RIR_EXPRESSION_PHI) {
+            // phis only appear at the start of a block
+            break;
+        }
+        if (rir_loop_iv_init(&iv, l, cfg, e)) {
+            rir_loop_iv_find_bound(&iv, l, cfg);
+            darray_append(l->ivs, iv);
+        }
+    }
+}
+
+static void rir_loopinfo_nest(struct rir_loopinfo *li)
+{
+    struct rir_loop **l;
+    struct rir_loop *other;
+    struct rir_loop *tmp;
+    unsigned i;
+    unsigned j;
+    // sort by size so that nested loops come before the loops containing them
+    for (i = 1; i < darray_size(li->loops); ++i) {
+        tmp = darray_item(li->loops, i);
+        for (j = i; j > 0 &&
+                 darray_size(darray_item(li->loops, j - 1)->blocks) > darray_size(tmp->blocks);
+             --j) {
+            darray_item(li->loops, j) = darray_item(li->loops, j - 1);
+        }
+        darray_item(li->loops, j) = tmp;
+    }
+    // the parent is the smallest bigger loop containing the header
+    for (i = 0; i < darray_size(li->loops); ++i) {
+        tmp = darray_item(li->loops, i);
+        for (j = i + 1; j < darray_size(li->loops); ++j) {
+            other = darray_item(li->loops, j);
+            if (other->contains[tmp->header->idx]) {
+                tmp->parent = other;
+                other->innermost = false;
+                break;
+            }
+        }
+    }
+    darray_foreach_reverse(l, li->loops) {
+        if ((*l)->parent) {
+            (*l)->depth = (*l)->parent->depth + 1;
+        }
+    }
+}
+
+bool rir_loopinfo_init(struct rir_loopinfo *li, struct rir_cfg *cfg)
+{
+    struct rir_cfg_node **n;
+    struct rir_cfg_node **s;
+    struct rir_loop **l;
+    struct rir_loop *loop;
+    li->cfg = cfg;
+    darray_init(li->loops);
+    // an edge to a block that dominates its source is a back edge
+    darray_foreach(n, cfg->rpo) {
+        darray_foreach(s, (*n)->succs) {
+            if (!rir_cfg_dominates(*s, *n)) {
+                continue;
+            }
+            loop = NULL;
+            darray_foreach(l, li->loops) {
+                if ((*l)->header == *s) {
+                    loop = *l;
+                    break;
+                }
+            }
+            if (!loop) {
+                if (!(loop = rir_loop_create(cfg, *s))) {
+                    rir_loopinfo_deinit(li);
+                    return false;
+                }
+                darray_append(li->loops, loop);
+            }
+            rir_loop_add_latch(loop, *n);
+        }
+    }
+    darray_foreach(l, li->loops) {
+        rir_loop_find_preheader(*l);
+        rir_loop_find_ivs(*l, cfg);
+    }
+    rir_loopinfo_nest(li);
+    return true;
+}
+
+void rir_loopinfo_deinit(struct rir_loopinfo *li)
+{
+    struct rir_loop **l;
+    darray_foreach(l, li->loops) {
+        rir_loop_destroy(*l);
+    }
+    darray_free(li->loops);
+}
+
+const struct rir_loop_iv *rir_loop_iv_from_value(const struct rir_loop *l,
+                                                 const struct rir_value *v)
+{
+    const struct rir_loop_iv *iv;
+    darray_foreach(iv, l->ivs) {
+        if (&iv->phi->val == v) {
+            return iv;
+        }
+    }
+    return NULL;
+}
+
+bool rir_loop_iv_bounded_in(const struct rir_loop *l,
+                            const struct rir_loop_iv *iv,
+                            const struct rir_cfg_node *n)
+{
+    return iv->bounded && l->contains[n->idx] && rir_cfg_dominates(iv->inside, n);
+}
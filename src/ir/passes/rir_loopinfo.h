@@ -0,0 +1,99 @@
+#ifndef LFR_IR_PASSES_RIR_LOOPINFO_H
+#define LFR_IR_PASSES_RIR_LOOPINFO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <rfbase/datastructs/darray.h>
+
+#include "rir_cfg.h"
+
+struct rir_expression;
+struct rir_value;
+
+/**
+ * A basic induction variable. A phi of the loop header that starts out as
+ * a constant and grows by a constant step on every back edge.
+ */
+struct rir_loop_iv {
+    //! The phi holding the variable's value during an iteration
+    struct rir_expression *phi;
+    //! Value of the variable when the loop is entered
+    int64_t init;
+    //! Amount added to the variable on every back edge. Always positive.
+    int64_t step;
+    //! True if the header leaves the loop once the variable reaches
+    //! @ref bound, so that it is below @ref bound in every block dominated
+    //! by @ref inside
+    bool bounded;
+    int64_t bound;
+    //! The header's successor that stays in the loop. NULL if not bounded.
+    struct rir_cfg_node *inside;
+};
+
+struct rir_loop;
+struct rir_loop_arr {darray(struct rir_loop*);};
+
+/**
+ * A natural loop, made of the blocks that can reach the back edges to its
+ * header without going through the header
+ */
+struct rir_loop {
+    struct rir_cfg_node *header;
+    //! The only block entering the loop from outside if it does nothing but
+    //! go to the header. NULL otherwise.
+    struct rir_cfg_node *preheader;
+    //! The blocks of the loop, header first
+    struct rir_cfg_node_arr blocks;
+    //! Blocks with a back edge to the header
+    struct rir_cfg_node_arr latches;
+    //! Membership of each node of the CFG, indexed by the node's idx
+    bool *contains;
+    //! The closest loop this one is nested in or NULL
+    struct rir_loop *parent;
+    //! 1 for loops not nested in any other loop
+    unsigned depth;
+    //! True if no other loop is nested in this one
+    bool innermost;
+    //! The basic induction variables of the loop
+    struct {darray(struct rir_loop_iv);} ivs;
+};
+
+/**
+ * The loops of a function
+ */
+struct rir_loopinfo {
+    struct rir_cfg *cfg;
+    //! All the loops of the function. Loops come before the loops they are
+    //! nested in.
+    struct rir_loop_arr loops;
+};
+
+/**
+ * Find the natural loops of a function and their induction variables
+ *
+ * Like the CFG it is built on, it has to be rebuilt if blocks or their exits
+ * change. Moving expressions between blocks keeps it valid.
+ *
+ * @param li           The loop information to initialize
+ * @param cfg          The control flow graph of the function, which has to
+ *                     outlive @a li
+ */
+bool rir_loopinfo_init(struct rir_loopinfo *li, struct rir_cfg *cfg);
+void rir_loopinfo_deinit(struct rir_loopinfo *li);
+
+/**
+ * @return The induction variable of @a l whose value is @a v or NULL
+ */
+const struct rir_loop_iv *rir_loop_iv_from_value(const struct rir_loop *l,
+                                                 const struct rir_value *v);
+
+/**
+ * @return true if control can only reach @a n through the edge from the
+ *         header of @a l to @a iv's inside successor, and so @a iv is known
+ *         to be below its bound in @a n
+ */
+bool rir_loop_iv_bounded_in(const struct rir_loop *l,
+                            const struct rir_loop_iv *iv,
+                            const struct rir_cfg_node *n);
+#endif
@@ -0,0 +1,233 @@
+#include "rir_pass.h"
+#include "rir_cfg.h"
+#include "rir_loopinfo.h"
+
+#include <rfbase/datastructs/darray.h>
+#include <rfbase/datastructs/intrusive_list.h>
+#include <rfbase/utils/memory.h>
+
+#include <ir/rir_block.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_type.h>
+#include <ir/rir_value.h>
+
+struct loopopt_ctx {
+    struct rir_cfg *cfg;
+    //! The block defining each value of the function, indexed by value id.
+    //! NULL for values not defined in a block, like the arguments.
+    struct rir_cfg_node **defs;
+    unsigned values_num;
+    //! Number of expressions hoisted and array accesses marked
+    unsigned changes;
+};
+
+struct loopopt_operand_ctx {
+    const struct loopopt_ctx *ctx;
+    const struct rir_loop *loop;
+    bool invariant;
+};
+
+static bool loopopt_ctx_init(struct loopopt_ctx *ctx, struct rir_cfg *cfg)
+{
+    struct rir_cfg_node *n;
+    struct rir_expression *e;
+    ctx->cfg = cfg;
+    ctx->changes = 0;
+    ctx->values_num = darray_size(cfg->fn->values);
+    RF_CALLOC(ctx->defs, ctx->values_num + 1, sizeof(*ctx->defs), return false);
+    darray_foreach(n, cfg->nodes) {
+        rf_ilist_for_each(&n->block->expressions, e, ln) {
+            if (e->val.category == RIR_VALUE_VARIABLE && e->val.id < ctx->values_num) {
+                ctx->defs[e->val.id] = n;
+            }
+        }
+    }
+    return true;
+}
+
+static void loopopt_check_operand_cb(const struct rir_value **operand,
+                                     struct loopopt_operand_ctx *opctx)
+{
+    const struct rir_cfg_node *def;
+    if ((*operand)->category != RIR_VALUE_VARIABLE) {
+        return;
+    }
+    def = (*operand)->id < opctx->ctx->values_num
+        ? opctx->ctx->defs[(*operand)->id] : NULL;
+    if (def && opctx->loop->contains[def->idx]) {
+        opctx->invariant = false;
+    }
+}
+
+/**
+ * @return true if @a e computes the same value on every iteration of the loop
+ *         and can be computed ahead of the loop, even if the loop would
+ *         not have computed it
+ */
+static bool loopopt_is_invariant(const struct loopopt_ctx *ctx,
+                                 const struct rir_loop *l,
+                                 struct rir_expression *e)
+{
+    struct loopopt_operand_ctx opctx;
+    switch (e->type) {
+    case RIR_EXPRESSION_FIXEDARRSIZE:
+    case RIR_EXPRESSION_CONVERT:
+    case RIR_EXPRESSION_ADD:
+    case RIR_EXPRESSION_SUB:
+    case RIR_EXPRESSION_MUL:
+    case RIR_EXPRESSION_CMP_EQ:
+    case RIR_EXPRESSION_CMP_NE:
+    case RIR_EXPRESSION_CMP_GE:
+    case RIR_EXPRESSION_CMP_GT:
+    case RIR_EXPRESSION_CMP_LE:
+    case RIR_EXPRESSION_CMP_LT:
+    case RIR_EXPRESSION_LOGIC_AND:
+    case RIR_EXPRESSION_LOGIC_OR:
+        break;
+    default:
+        // reads depend on the writes of the loop and division can trap
+        return false;
+    }
+    opctx.ctx = ctx;
+    opctx.loop = l;
+    opctx.invariant = true;
+    rir_expression_foreach_operand(e, (rir_operand_cb)loopopt_check_operand_cb, &opctx);
+    return opctx.invariant;
+}
+
+/**
+ * Move the expressions of the loop that compute the same value on every
+ * iteration to the preheader. Loops are visited innermost first, so what is
+ * hoisted out of an inner loop can be hoisted further out of the outer one.
+ */
+static void loopopt_hoist(struct loopopt_ctx *ctx, const struct rir_loop *l)
+{
+    struct rir_cfg_node **n;
+    struct rir_expression *e;
+    struct rir_expression *tmp;
+    if (!l->preheader) {
+        return;
+    }
+    // in reverse postorder operands are visited before their uses
+    darray_foreach(n, ctx->cfg->rpo) {
+        if (!l->contains[(*n)->idx]) {
+            continue;
+        }
+        rf_ilist_for_each_safe(&(*n)->block->expressions, e, tmp, ln) {
+            if (!loopopt_is_invariant(ctx, l, e)) {
+                continue;
+            }
+            rf_ilist_delete_from(&(*n)->block->expressions, &e->ln);
+            rir_block_add_expr(l->preheader->block, e);
+            if (e->val.category == RIR_VALUE_VARIABLE && e->val.id < ctx->values_num) {
+                ctx->defs[e->val.id] = l->preheader;
+            }
+            ++ctx->changes;
+        }
+    }
+}
+
+/**
+ * @return true if an array indexed by @a idx in block @a n is always
+ *         indexed inside its bounds
+ */
+static bool loopopt_idx_inbounds(const struct rir_loop *l,
+                                 const struct rir_cfg_node *n,
+                                 const struct rir_value *arr,
+                                 const struct rir_value *idx)
+{
+    const struct rir_loop_iv *iv;
+    int64_t size;
+    if (!rir_type_is_array(arr->type) ||
+        (size = rir_type_array_size(arr->type)) < 0 ||
+        !(iv = rir_loop_iv_from_value(l, idx)) ||
+        !rir_loop_iv_bounded_in(l, iv, n)) {
+        return false;
+    }
+    // the variable only grows from init and stays below its bound
+    return iv->init >= 0 && iv->bound <= size;
+}
+
+/**
+ * Mark indexing with induction variables that provably stays inside the
+ * indexed array. Indices of enclosing loops are checked as well.
+ */
+static void loopopt_mark_inbounds(struct loopopt_ctx *ctx, const struct rir_loop *l)
+{
+    struct rir_cfg_node **n;
+    struct rir_expression *e;
+    const struct rir_loop *outer;
+    darray_foreach(n, l->blocks) {
+        rf_ilist_for_each(&(*n)->block->expressions, e, ln) {
+            if (e->type != RIR_EXPRESSION_OBJIDX || e->objidx.inbounds) {
+                continue;
+            }
+            for (outer = l; outer; outer = outer->parent) {
+                if (loopopt_idx_inbounds(outer, *n, e->objidx.objmemory, e->objidx.idx)) {
+                    e->objidx.inbounds = true;
+                    ++ctx->changes;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Ask the backend to vectorize innermost loops that count iterations with
+ * an induction variable towards a constant bound
+ */
+static void loopopt_mark_vectorize(struct loopopt_ctx *ctx, const struct rir_loop *l)
+{
+    struct rir_block *latch;
+    const struct rir_loop_iv *iv;
+    bool counted = false;
+    if (!l->innermost || darray_size(l->latches) != 1) {
+        return;
+    }
+    darray_foreach(iv, l->ivs) {
+        counted = counted || iv->bounded;
+    }
+    latch = darray_item(l->latches, 0)->block;
+    if (counted && latch->exit.type == RIR_BLOCK_EXIT_BRANCH && !latch->exit.branch.vectorize) {
+        latch->exit.branch.vectorize = true;
+        ++ctx->changes;
+    }
+}
+
+bool rir_pass_loopopt(struct rir_fndef *fn, struct rir_pass_ctx *pctx)
+{
+    struct rir_cfg cfg;
+    struct rir_loopinfo li;
+    struct loopopt_ctx ctx;
+    struct rir_loop **l;
+    bool ret = false;
+    if (!rir_cfg_init(&cfg, fn)) {
+        return false;
+    }
+    if (!rir_loopinfo_init(&li, &cfg)) {
+        goto end_cfg;
+    }
+    if (darray_size(li.loops) == 0) {
+        ret = true;
+        goto end_li;
+    }
+    if (!loopopt_ctx_init(&ctx, &cfg)) {
+        goto end_li;
+    }
+    darray_foreach(l, li.loops) {
+        loopopt_hoist(&ctx, *l);
+        loopopt_mark_inbounds(&ctx, *l);
+        loopopt_mark_vectorize(&ctx, *l);
+    }
+    pctx->changes += ctx.changes;
+    free(ctx.defs);
+    ret = true;
+
+end_li:
+    rir_loopinfo_deinit(&li);
+end_cfg:
+    rir_cfg_deinit(&cfg);
+    return ret;
+}
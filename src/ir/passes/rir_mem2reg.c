@@ -0,0 +1,465 @@
+#include "rir_pass.h"
+#include "rir_pass_utils.h"
+#include "rir_cfg.h"
+
+#include <rfbase/datastructs/darray.h>
+#include <rfbase/datastructs/intrusive_list.h>
+#include <rfbase/utils/memory.h>
+
+#include <analyzer/symbol_table.h>
+#include <ast/constants.h>
+#include <types/type_elementary.h>
+#include <ir/parser/rirparser.h>
+#include <ir/rir.h>
+#include <ir/rir_block.h>
+#include <ir/rir_constant.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_object.h>
+#include <ir/rir_phi.h>
+#include <ir/rir_type.h>
+#include <ir/rir_value.h>
+
+/**
+ * A local variable that is a candidate for promotion to SSA values
+ */
+struct mem2reg_var {
+    //! The variable's allocation
+    struct rir_expression *alloca;
+    //! The block containing the allocation
+    struct rir_block *block;
+    //! True if the allocation is used for anything other than reads and writes
+    bool escapes;
+    //! Reachable blocks that write to the variable
+    struct rir_cfg_node_arr defs;
+    //! The values the variable holds along the current dominator tree path
+    struct {darray(const struct rir_value*);} stack;
+    //! Value given to the variable on paths that never wrote to it
+    const struct rir_value *undef;
+};
+
+struct mem2reg_phi {
+    struct mem2reg_var *var;
+    struct rir_expression *phi;
+};
+
+struct mem2reg_removal {
+    struct rir_block *block;
+    struct rir_expression *expr;
+};
+
+struct mem2reg_ctx {
+    struct rir *rir;
+    struct rir_fndef *fn;
+    struct rir_cfg cfg;
+    struct {darray(struct mem2reg_var);} vars;
+    //! Map from alloca values to candidate variables
+    struct rirvalue_idmap map;
+    //! For each cfg node, the phis inserted at its start
+    struct {darray(struct mem2reg_phi);} *phis;
+    //! Variables whose stack got pushed, to be popped when leaving a subtree
+    struct {darray(struct mem2reg_var*);} pushed;
+    //! Reads and writes of promoted variables, removed at the end
+    struct {darray(struct mem2reg_removal);} removals;
+    struct rir_replacements repl;
+    //! Used to create the phi values and give them new ids
+    struct rir_pctx pctx;
+    //! The expression whose operands are being checked
+    struct rir_expression *curr_expr;
+};
+
+static struct mem2reg_var *mem2reg_var_get(struct mem2reg_ctx *ctx,
+                                           const struct rir_value *memory)
+{
+    struct mem2reg_var *var;
+    var = rirvalue_idmap_get(&ctx->map, memory);
+    return var && &var->alloca->val == memory ? var : NULL;
+}
+
+static bool mem2reg_promotable_type(const struct rir_type *t)
+{
+    return rir_type_is_elementary(t) &&
+        !t->is_pointer &&
+        t->etype != ELEMENTARY_TYPE_STRING;
+}
+
+static bool mem2reg_collect_vars(struct mem2reg_ctx *ctx)
+{
+    struct rir_block **b;
+    struct rir_expression *e;
+    struct mem2reg_var *var;
+    struct mem2reg_var new_var;
+    darray_foreach(b, ctx->fn->blocks) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            if (e->type != RIR_EXPRESSION_ALLOCA ||
+                !mem2reg_promotable_type(e->alloca.type)) {
+                continue;
+            }
+            RF_STRUCT_ZERO(&new_var);
+            new_var.alloca = e;
+            new_var.block = *b;
+            darray_init(new_var.defs);
+            darray_init(new_var.stack);
+            darray_append(ctx->vars, new_var);
+        }
+    }
+    // the array does not grow anymore so pointers to its members are stable
+    darray_foreach(var, ctx->vars) {
+        if (!rirvalue_idmap_add(&ctx->map, &var->alloca->val, var)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void mem2reg_check_operand_cb(const struct rir_value **operand,
+                                     struct mem2reg_ctx *ctx)
+{
+    struct mem2reg_var *var = mem2reg_var_get(ctx, *operand);
+    struct rir_expression *e = ctx->curr_expr;
+    if (!var) {
+        return;
+    }
+    if (e && e->type == RIR_EXPRESSION_READ && operand == &e->read.memory) {
+        return;
+    }
+    if (e && e->type == RIR_EXPRESSION_WRITE && operand == &e->write.memory &&
+        mem2reg_promotable_type(e->write.writeval->type) &&
+        e->write.writeval->type->etype == var->alloca->alloca.type->etype) {
+        return;
+    }
+    var->escapes = true;
+}
+
+static void mem2reg_add_def(struct mem2reg_var *var, struct rir_cfg_node *n)
+{
+    // writes in the same block follow each other so checking the last is enough
+    if (darray_size(var->defs) != 0 &&
+        darray_item(var->defs, darray_size(var->defs) - 1) == n) {
+        return;
+    }
+    darray_append(var->defs, n);
+}
+
+/**
+ * Find out which candidates escape and in which blocks the rest are written
+ */
+static void mem2reg_analyze_uses(struct mem2reg_ctx *ctx)
+{
+    struct rir_cfg_node *n;
+    struct rir_expression *e;
+    struct mem2reg_var *var;
+    darray_foreach(n, ctx->cfg.nodes) {
+        rf_ilist_for_each(&n->block->expressions, e, ln) {
+            ctx->curr_expr = e;
+            rir_expression_foreach_operand(e, (rir_operand_cb)mem2reg_check_operand_cb, ctx);
+            if (e->type == RIR_EXPRESSION_WRITE &&
+                rir_cfg_node_reachable(n) &&
+                (var = mem2reg_var_get(ctx, e->write.memory))) {
+                mem2reg_add_def(var, n);
+            }
+        }
+        ctx->curr_expr = NULL;
+        rir_block_exit_foreach_operand(n->block, (rir_operand_cb)mem2reg_check_operand_cb, ctx);
+    }
+}
+
+static struct rir_expression *mem2reg_create_phi(struct mem2reg_ctx *ctx,
+                                                 struct mem2reg_var *var,
+                                                 struct rir_cfg_node *n)
+{
+    const struct RFstring *id;
+    struct rir_expression *phi;
+    struct mem2reg_phi entry;
+    RFS_PUSH();
+    // ids past the end of the function's values are always free
+    id = RFS("$%u", (unsigned)darray_size(ctx->fn->values));
+    rir_pctx_set_id(&ctx->pctx, id);
+    phi = rir_phi_create(var->alloca->alloca.type, RIRPOS_PARSE, &ctx->pctx);
+    rir_pctx_reset_id(&ctx->pctx);
+    RFS_POP();
+    if (!phi) {
+        return NULL;
+    }
+    // phis always go at the start of the block
+    rf_ilist_add(&n->block->expressions, &phi->ln);
+    entry.var = var;
+    entry.phi = phi;
+    darray_append(ctx->phis[n->idx], entry);
+    return phi;
+}
+
+/**
+ * Place phis for a variable at the iterated dominance frontier of the
+ * blocks that write to it
+ */
+static bool mem2reg_place_phis(struct mem2reg_ctx *ctx,
+                               struct mem2reg_var *var,
+                               unsigned *has_phi,
+                               unsigned *in_work,
+                               unsigned stamp)
+{
+    struct rir_cfg_node_arr work;
+    struct rir_cfg_node **it;
+    struct rir_cfg_node **f;
+    struct rir_cfg_node *n;
+    bool ret = false;
+    darray_init(work);
+    darray_foreach(it, var->defs) {
+        in_work[(*it)->idx] = stamp;
+        darray_append(work, *it);
+    }
+    while (darray_size(work) != 0) {
+        n = darray_pop(work);
+        darray_foreach(f, n->frontier) {
+            if (has_phi[(*f)->idx] == stamp) {
+                continue;
+            }
+            if (!mem2reg_create_phi(ctx, var, *f)) {
+                goto end;
+            }
+            has_phi[(*f)->idx] = stamp;
+            // a phi is a new definition of the variable
+            if (in_work[(*f)->idx] != stamp) {
+                in_work[(*f)->idx] = stamp;
+                darray_append(work, *f);
+            }
+        }
+    }
+    ret = true;
+end:
+    darray_free(work);
+    return ret;
+}
+
+static bool mem2reg_place_all_phis(struct mem2reg_ctx *ctx)
+{
+    struct mem2reg_var *var;
+    unsigned *has_phi;
+    unsigned *in_work;
+    unsigned stamp = 0;
+    bool ret = false;
+    RF_CALLOC(has_phi, rir_cfg_nodes_num(&ctx->cfg), sizeof(*has_phi), return false);
+    RF_CALLOC(in_work, rir_cfg_nodes_num(&ctx->cfg), sizeof(*in_work), goto free_has_phi);
+    darray_foreach(var, ctx->vars) {
+        // a different stamp per variable saves clearing the arrays
+        ++stamp;
+        if (!var->escapes && !mem2reg_place_phis(ctx, var, has_phi, in_work, stamp)) {
+            goto end;
+        }
+    }
+    ret = true;
+end:
+    free(in_work);
+free_has_phi:
+    free(has_phi);
+    return ret;
+}
+
+/**
+ * @return the value the variable currently holds. Locals that are read
+ * before being written hold an undefined value, so zero is as good as any.
+ */
+static const struct rir_value *mem2reg_var_top(struct mem2reg_ctx *ctx,
+                                               struct mem2reg_var *var)
+{
+    struct ast_constant c;
+    const struct rir_type *t = var->alloca->alloca.type;
+    if (darray_size(var->stack) != 0) {
+        return darray_item(var->stack, darray_size(var->stack) - 1);
+    }
+    if (!var->undef) {
+        if (elementary_type_is_float(t->etype)) {
+            ast_constant_init_float(&c, 0.0);
+        } else if (t->etype == ELEMENTARY_TYPE_BOOL) {
+            ast_constant_init_bool(&c, false);
+        } else {
+            ast_constant_init_int(&c, 0);
+        }
+        var->undef = rir_constantval_create_typed(
+            &c,
+            rir_type_get_or_create_from_other(t, ctx->rir, false),
+            ctx->rir
+        );
+    }
+    return var->undef;
+}
+
+static void mem2reg_push(struct mem2reg_ctx *ctx,
+                         struct mem2reg_var *var,
+                         const struct rir_value *val)
+{
+    darray_append(var->stack, val);
+    darray_append(ctx->pushed, var);
+}
+
+static void mem2reg_add_removal(struct mem2reg_ctx *ctx,
+                                struct rir_block *b,
+                                struct rir_expression *e)
+{
+    struct mem2reg_removal r;
+    r.block = b;
+    r.expr = e;
+    darray_append(ctx->removals, r);
+}
+
+static bool mem2reg_rename_block(struct mem2reg_ctx *ctx, struct rir_cfg_node *n)
+{
+    struct mem2reg_phi *p;
+    struct rir_expression *e;
+    struct mem2reg_var *var;
+    struct rir_cfg_node **s;
+    struct rir_cfg_node **child;
+    const struct rir_value *val;
+    unsigned pushed_mark = darray_size(ctx->pushed);
+
+    darray_foreach(p, ctx->phis[n->idx]) {
+        mem2reg_push(ctx, p->var, &p->phi->val);
+    }
+    rf_ilist_for_each(&n->block->expressions, e, ln) {
+        if (e->type == RIR_EXPRESSION_READ &&
+            (var = mem2reg_var_get(ctx, e->read.memory)) && !var->escapes) {
+            if (!(val = mem2reg_var_top(ctx, var)) ||
+                !rir_replacements_add(&ctx->repl, &e->val, val)) {
+                return false;
+            }
+            mem2reg_add_removal(ctx, n->block, e);
+        } else if (e->type == RIR_EXPRESSION_WRITE &&
+                   (var = mem2reg_var_get(ctx, e->write.memory)) && !var->escapes) {
+            mem2reg_push(ctx, var, e->write.writeval);
+            mem2reg_add_removal(ctx, n->block, e);
+        }
+    }
+    // give the phis of the successors the values flowing out of this block
+    darray_foreach(s, n->succs) {
+        darray_foreach(p, ctx->phis[(*s)->idx]) {
+            if (!(val = mem2reg_var_top(ctx, p->var))) {
+                return false;
+            }
+            rir_phi_add_incoming(&p->phi->phi, val, &n->block->label);
+        }
+    }
+    darray_foreach(child, n->children) {
+        if (!mem2reg_rename_block(ctx, *child)) {
+            return false;
+        }
+    }
+    while (darray_size(ctx->pushed) != pushed_mark) {
+        var = darray_pop(ctx->pushed);
+        darray_pop(var->stack);
+    }
+    return true;
+}
+
+static bool mem2reg_rename(struct mem2reg_ctx *ctx)
+{
+    struct rir_cfg_node *n;
+    if (!mem2reg_rename_block(ctx, darray_item(ctx->cfg.rpo, 0))) {
+        return false;
+    }
+    // Unreachable blocks never run but they still need their accesses
+    // rewritten, and they are still predecessors as far as phis care
+    darray_foreach(n, ctx->cfg.nodes) {
+        if (!rir_cfg_node_reachable(n) && !mem2reg_rename_block(ctx, n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Remove a promoted allocation, making sure the symbol table no longer
+ * points to it
+ */
+static void mem2reg_remove_alloca(struct mem2reg_ctx *ctx, struct mem2reg_var *var)
+{
+    struct rir_object *obj = rir_expression_to_obj(var->alloca);
+    struct symbol_table_record *rec;
+    if (var->block->st &&
+        (rec = symbol_table_lookup_rirobj(var->block->st, obj)) &&
+        rec->rirobj == obj) {
+        rec->rirobj = NULL;
+    }
+    rir_block_remove_expr(var->block, var->alloca, ctx->rir, ctx->fn);
+}
+
+static void mem2reg_finalize(struct mem2reg_ctx *ctx, unsigned *changes)
+{
+    struct mem2reg_removal *r;
+    struct mem2reg_var *var;
+    rir_replacements_apply(&ctx->repl, ctx->fn);
+    // the replacement keys belong to the reads removed below
+    rir_replacements_deinit(&ctx->repl);
+    darray_foreach(r, ctx->removals) {
+        rir_block_remove_expr(r->block, r->expr, ctx->rir, ctx->fn);
+    }
+    darray_foreach(var, ctx->vars) {
+        if (!var->escapes) {
+            mem2reg_remove_alloca(ctx, var);
+            ++*changes;
+        }
+    }
+}
+
+bool rir_pass_mem2reg(struct rir_fndef *fn, struct rir_pass_ctx *pctx)
+{
+    struct mem2reg_ctx ctx;
+    struct mem2reg_var *var;
+    bool repl_live = false;
+    bool ret = false;
+    unsigned i;
+    RF_STRUCT_ZERO(&ctx);
+    ctx.rir = pctx->rir;
+    ctx.fn = fn;
+    darray_init(ctx.vars);
+    darray_init(ctx.pushed);
+    darray_init(ctx.removals);
+    rirvalue_idmap_init(&ctx.map);
+    if (!mem2reg_collect_vars(&ctx)) {
+        goto free_vars;
+    }
+    if (darray_size(ctx.vars) == 0) {
+        ret = true;
+        goto free_vars;
+    }
+    if (!rir_cfg_init(&ctx.cfg, fn)) {
+        goto free_vars;
+    }
+    RF_CALLOC(ctx.phis, rir_cfg_nodes_num(&ctx.cfg), sizeof(*ctx.phis), goto free_cfg);
+    for (i = 0; i < rir_cfg_nodes_num(&ctx.cfg); ++i) {
+        darray_init(ctx.phis[i]);
+    }
+    rir_pctx_init(&ctx.pctx, ctx.rir);
+    ctx.pctx.common.current_fn = fn;
+    rir_replacements_init(&ctx.repl);
+    repl_live = true;
+
+    mem2reg_analyze_uses(&ctx);
+    if (!mem2reg_place_all_phis(&ctx) || !mem2reg_rename(&ctx)) {
+        goto end;
+    }
+    mem2reg_finalize(&ctx, &pctx->changes);
+    repl_live = false;
+    ret = true;
+
+end:
+    if (repl_live) {
+        rir_replacements_deinit(&ctx.repl);
+    }
+    for (i = 0; i < rir_cfg_nodes_num(&ctx.cfg); ++i) {
+        darray_free(ctx.phis[i]);
+    }
+    free(ctx.phis);
+free_cfg:
+    rir_cfg_deinit(&ctx.cfg);
+free_vars:
+    darray_foreach(var, ctx.vars) {
+        darray_free(var->defs);
+        darray_free(var->stack);
+    }
+    darray_free(ctx.vars);
+    darray_free(ctx.pushed);
+    darray_free(ctx.removals);
+    rirvalue_idmap_deinit(&ctx.map);
+    return ret;
+}
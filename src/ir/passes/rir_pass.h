@@ -0,0 +1,61 @@
+#ifndef LFR_IR_PASSES_RIR_PASS_H
+#define LFR_IR_PASSES_RIR_PASS_H
+
+#include <stdbool.h>
+
+struct rir;
+struct rir_fndef;
+struct rir_interp;
+
+/**
+ * State handed to every pass while it runs over a function
+ */
+struct rir_pass_ctx {
+    //! The module the function belongs to
+    struct rir *rir;
+    //! Interpreter of the module, used to evaluate calls at compile time
+    struct rir_interp *interp;
+    //! Number of changes the pass made. Summed over all functions.
+    unsigned changes;
+};
+
+typedef bool (*rir_pass_fn)(struct rir_fndef *fn, struct rir_pass_ctx *ctx);
+
+/**
+ * Replace calls to small functions with a copy of the callee's body. Only the
+ * parts of the callee that can run with the call's constant arguments and
+ * sum type index get copied.
+ */
+bool rir_pass_inline(struct rir_fndef *fn, struct rir_pass_ctx *ctx);
+
+/**
+ * Fold arithmetic, comparisons and conversions whose operands are constants
+ * and calls to pure functions with constant arguments
+ */
+bool rir_pass_constfold(struct rir_fndef *fn, struct rir_pass_ctx *ctx);
+
+/**
+ * Promote local variables of elementary types that are only ever read and
+ * written to SSA values, inserting phis where control flow merges
+ */
+bool rir_pass_mem2reg(struct rir_fndef *fn, struct rir_pass_ctx *ctx);
+
+/**
+ * Remove copies of a value onto itself and build the aggregate that every
+ * return of a function copies into the return slot directly in the slot
+ */
+bool rir_pass_copyelim(struct rir_fndef *fn, struct rir_pass_ctx *ctx);
+
+/**
+ * Remove expressions without side effects whose value is never used
+ */
+bool rir_pass_dce(struct rir_fndef *fn, struct rir_pass_ctx *ctx);
+
+/**
+ * Hoist loop invariant computations to the loop preheaders, mark array
+ * indexing with induction variables that can't go out of bounds and mark
+ * counted innermost loops for vectorization
+ */
+bool rir_pass_loopopt(struct rir_fndef *fn, struct rir_pass_ctx *ctx);
+
+#endif
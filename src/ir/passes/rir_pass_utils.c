@@ -0,0 +1,261 @@
+#include "rir_pass_utils.h"
+
+#include <rfbase/datastructs/intrusive_list.h>
+#include <rfbase/utils/sanity.h>
+
+#include <ir/rir.h>
+#include <ir/rir_object.h>
+#include <ir/rir_block.h>
+#include <ir/rir_function.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_value.h>
+
+static void rir_valuearr_foreach_operand(struct value_arr *arr,
+                                         rir_operand_cb cb,
+                                         void *user)
+{
+    struct rir_value **v;
+    darray_foreach(v, *arr) {
+        cb((const struct rir_value**)v, user);
+    }
+}
+
+void rir_expression_foreach_operand(struct rir_expression *e,
+                                    rir_operand_cb cb,
+                                    void *user)
+{
+    switch (e->type) {
+    case RIR_EXPRESSION_CALL:
+        rir_valuearr_foreach_operand(&e->call.args, cb, user);
+        break;
+    case RIR_EXPRESSION_CONVERT:
+        cb(&e->convert.val, user);
+        break;
+    case RIR_EXPRESSION_WRITE:
+        cb(&e->write.memory, user);
+        cb(&e->write.writeval, user);
+        break;
+    case RIR_EXPRESSION_READ:
+        cb(&e->read.memory, user);
+        break;
+    case RIR_EXPRESSION_OBJMEMBERAT:
+        cb(&e->objmemberat.objmemory, user);
+        break;
+    case RIR_EXPRESSION_SETUNIONIDX:
+        cb(&e->setunionidx.unimemory, user);
+        cb(&e->setunionidx.idx, user);
+        break;
+    case RIR_EXPRESSION_GETUNIONIDX:
+        cb(&e->getunionidx.unimemory, user);
+        break;
+    case RIR_EXPRESSION_UNIONMEMBERAT:
+        cb(&e->unionmemberat.unimemory, user);
+        break;
+    case RIR_EXPRESSION_OBJIDX:
+        cb(&e->objidx.objmemory, user);
+        cb(&e->objidx.idx, user);
+        break;
+    case RIR_EXPRESSION_FIXEDARR:
+        rir_valuearr_foreach_operand(&e->fixedarr.members, cb, user);
+        break;
+    case RIR_EXPRESSION_FIXEDARRSIZE:
+        cb(&e->fixedarrsize.array, user);
+        break;
+    case RIR_EXPRESSION_ADD:
+    case RIR_EXPRESSION_SUB:
+    case RIR_EXPRESSION_MUL:
+    case RIR_EXPRESSION_DIV:
+    case RIR_EXPRESSION_CMP_EQ:
+    case RIR_EXPRESSION_CMP_NE:
+    case RIR_EXPRESSION_CMP_GE:
+    case RIR_EXPRESSION_CMP_GT:
+    case RIR_EXPRESSION_CMP_LE:
+    case RIR_EXPRESSION_CMP_LT:
+    case RIR_EXPRESSION_LOGIC_AND:
+    case RIR_EXPRESSION_LOGIC_OR:
+        cb(&e->binaryop.a, user);
+        cb(&e->binaryop.b, user);
+        break;
+    case RIR_EXPRESSION_PHI:
+    {
+        // the incoming block labels are not operands
+        struct rir_phi_incoming *in;
+        darray_foreach(in, e->phi.incoming) {
+            cb(&in->val, user);
+        }
+    }
+        break;
+    case RIR_EXPRESSION_ALLOCA:
+    case RIR_EXPRESSION_CONSTANT:
+    case RIR_EXPRESSION_RETURN:
+        break;
+    case RIR_EXPRESSION_PLACEHOLDER:
+        RF_CRITICAL_FAIL("Placeholder expression should never make it into a block");
+        break;
+    }
+}
+
+void rir_block_exit_foreach_operand(struct rir_block *b,
+                                    rir_operand_cb cb,
+                                    void *user)
+{
+    switch (b->exit.type) {
+    case RIR_BLOCK_EXIT_RETURN:
+        if (b->exit.retstmt.val) {
+            cb(&b->exit.retstmt.val, user);
+        }
+        break;
+    case RIR_BLOCK_EXIT_CONDBRANCH:
+        cb(&b->exit.condbranch.cond, user);
+        break;
+    case RIR_BLOCK_EXIT_SWITCH:
+        // case values are constants, only the condition is computed
+        cb(&b->exit.switchbr.cond, user);
+        break;
+    case RIR_BLOCK_EXIT_BRANCH:
+    case RIR_BLOCK_EXIT_INVALID:
+        break;
+    }
+}
+
+bool rir_expression_is_pure(const struct rir_expression *e)
+{
+    switch (e->type) {
+    case RIR_EXPRESSION_CONVERT:
+    case RIR_EXPRESSION_READ:
+    case RIR_EXPRESSION_OBJMEMBERAT:
+    case RIR_EXPRESSION_GETUNIONIDX:
+    case RIR_EXPRESSION_UNIONMEMBERAT:
+    case RIR_EXPRESSION_OBJIDX:
+    case RIR_EXPRESSION_FIXEDARRSIZE:
+    case RIR_EXPRESSION_CONSTANT:
+    case RIR_EXPRESSION_ADD:
+    case RIR_EXPRESSION_SUB:
+    case RIR_EXPRESSION_MUL:
+    case RIR_EXPRESSION_DIV:
+    case RIR_EXPRESSION_CMP_EQ:
+    case RIR_EXPRESSION_CMP_NE:
+    case RIR_EXPRESSION_CMP_GE:
+    case RIR_EXPRESSION_CMP_GT:
+    case RIR_EXPRESSION_CMP_LE:
+    case RIR_EXPRESSION_CMP_LT:
+    case RIR_EXPRESSION_LOGIC_AND:
+    case RIR_EXPRESSION_LOGIC_OR:
+    case RIR_EXPRESSION_PHI:
+        return true;
+    default:
+        // allocations are also referenced from the symbol tables so they are
+        // never considered removable
+        return false;
+    }
+}
+
+void rirvalue_idmap_init(struct rirvalue_idmap *m)
+{
+    darray_init(*m);
+}
+
+void rirvalue_idmap_deinit(struct rirvalue_idmap *m)
+{
+    darray_free(*m);
+}
+
+bool rirvalue_idmap_add(struct rirvalue_idmap *m, const struct rir_value *key, void *data)
+{
+    RF_ASSERT(key->category == RIR_VALUE_VARIABLE, "Only variables can be keys");
+    while (darray_size(*m) <= key->id) {
+        darray_append(*m, NULL);
+    }
+    if (darray_item(*m, key->id)) {
+        return false;
+    }
+    darray_item(*m, key->id) = data;
+    return true;
+}
+
+void *rirvalue_idmap_get(const struct rirvalue_idmap *m, const struct rir_value *key)
+{
+    if (key->category != RIR_VALUE_VARIABLE || key->id >= darray_size(*m)) {
+        return NULL;
+    }
+    return darray_item(*m, key->id);
+}
+
+void rir_replacements_init(struct rir_replacements *r)
+{
+    rirvalue_idmap_init(&r->map);
+    r->num = 0;
+}
+
+void rir_replacements_deinit(struct rir_replacements *r)
+{
+    rirvalue_idmap_deinit(&r->map);
+}
+
+bool rir_replacements_add(struct rir_replacements *r,
+                          const struct rir_value *from,
+                          const struct rir_value *to)
+{
+    RF_ASSERT(from->category == RIR_VALUE_VARIABLE, "Only computed values can be replaced");
+    if (!rirvalue_idmap_add(&r->map, from, (struct rir_value*)to)) {
+        return false;
+    }
+    ++r->num;
+    return true;
+}
+
+const struct rir_value *rir_replacements_resolve(const struct rir_replacements *r,
+                                                 const struct rir_value *v)
+{
+    const struct rir_value *to;
+    if (r->num == 0) {
+        return v;
+    }
+    while ((to = rirvalue_idmap_get(&r->map, v))) {
+        v = to;
+    }
+    return v;
+}
+
+static void rir_replacements_apply_cb(const struct rir_value **operand,
+                                      struct rir_replacements *r)
+{
+    *operand = rir_replacements_resolve(r, *operand);
+}
+
+void rir_replacements_apply(struct rir_replacements *r, struct rir_fndef *fn)
+{
+    struct rir_block **b;
+    struct rir_expression *e;
+    if (r->num == 0) {
+        return;
+    }
+    darray_foreach(b, fn->blocks) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            rir_expression_foreach_operand(e, (rir_operand_cb)rir_replacements_apply_cb, r);
+        }
+        rir_block_exit_foreach_operand(*b, (rir_operand_cb)rir_replacements_apply_cb, r);
+    }
+}
+
+void rir_block_remove_expr(struct rir_block *b,
+                           struct rir_expression *e,
+                           struct rir *r,
+                           struct rir_fndef *fn)
+{
+    rf_ilist_delete_from(&b->expressions, &e->ln);
+    rir_object_listrem_destroy(rir_expression_to_obj(e), r, fn);
+}
+
+unsigned rir_fndef_expressions_num(const struct rir_fndef *fn)
+{
+    struct rir_block **b;
+    struct rir_expression *e;
+    unsigned num = 0;
+    darray_foreach(b, fn->blocks) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            ++num;
+        }
+    }
+    return num;
+}
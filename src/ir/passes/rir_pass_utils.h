@@ -0,0 +1,108 @@
+#ifndef LFR_IR_PASSES_RIR_PASS_UTILS_H
+#define LFR_IR_PASSES_RIR_PASS_UTILS_H
+
+#include <stdbool.h>
+
+#include <rfbase/datastructs/darray.h>
+
+struct rir;
+struct rir_value;
+struct rir_block;
+struct rir_expression;
+struct rir_fndef;
+
+/**
+ * Map from a rir variable value to a pointer
+ *
+ * Variable ids are unique and dense per function so the map is an array
+ * indexed by them. Only values of category RIR_VALUE_VARIABLE can be keys.
+ */
+struct rirvalue_idmap {
+    darray(void*);
+};
+
+void rirvalue_idmap_init(struct rirvalue_idmap *m);
+void rirvalue_idmap_deinit(struct rirvalue_idmap *m);
+/**
+ * Associate @a data with the variable @a key
+ *
+ * @return false if @a key already has a non-NULL association
+ */
+bool rirvalue_idmap_add(struct rirvalue_idmap *m, const struct rir_value *key, void *data);
+/**
+ * @return the data associated with @a key or NULL if there is none or if
+ *         @a key is not a variable
+ */
+void *rirvalue_idmap_get(const struct rirvalue_idmap *m, const struct rir_value *key);
+
+typedef void (*rir_operand_cb)(const struct rir_value **operand, void *user);
+
+/**
+ * Call @a cb for every value that is used as an operand by an expression
+ *
+ * Only values that are computed by the code are visited. Labels and the
+ * types of the expressions are not operands.
+ */
+void rir_expression_foreach_operand(struct rir_expression *e,
+                                    rir_operand_cb cb,
+                                    void *user);
+
+/**
+ * Call @a cb for every value that is used as an operand by the exit of a block
+ */
+void rir_block_exit_foreach_operand(struct rir_block *b,
+                                    rir_operand_cb cb,
+                                    void *user);
+
+/**
+ * @return true if the expression has no effect other than producing its value
+ */
+bool rir_expression_is_pure(const struct rir_expression *e);
+
+/**
+ * Records values that should be replaced by other values in a function and
+ * applies all replacements in a single walk over the function.
+ */
+struct rir_replacements {
+    struct rirvalue_idmap map;
+    unsigned num;
+};
+
+void rir_replacements_init(struct rir_replacements *r);
+void rir_replacements_deinit(struct rir_replacements *r);
+
+/**
+ * Note that all uses of @a from should become uses of @a to
+ */
+bool rir_replacements_add(struct rir_replacements *r,
+                          const struct rir_value *from,
+                          const struct rir_value *to);
+
+/**
+ * @return The value that @a v should be replaced with, following chains of
+ *         replacements, or @a v itself if it is not replaced
+ */
+const struct rir_value *rir_replacements_resolve(const struct rir_replacements *r,
+                                                 const struct rir_value *v);
+
+/**
+ * Rewrite all the operands of the expressions and block exits of @a fn
+ */
+void rir_replacements_apply(struct rir_replacements *r, struct rir_fndef *fn);
+
+/**
+ * Remove an expression from its block and destroy it
+ *
+ * The expression's value must not be used anywhere in the function.
+ */
+void rir_block_remove_expr(struct rir_block *b,
+                           struct rir_expression *e,
+                           struct rir *r,
+                           struct rir_fndef *fn);
+
+/**
+ * @return The number of expressions in all the blocks of @a fn
+ */
+unsigned rir_fndef_expressions_num(const struct rir_fndef *fn);
+
+#endif
@@ -0,0 +1,139 @@
+#include <ir/passes/rir_passes.h>
+
+#include <stdio.h>
+
+#include <rfbase/datastructs/intrusive_list.h>
+#include <rfbase/utils/memory.h>
+#include <rfbase/utils/log.h>
+
+#include <compiler.h>
+#include <compiler_args.h>
+#include <module.h>
+#include <ir/rir.h>
+#include <ir/rir_function.h>
+#include <ir/rir_interp.h>
+#include <utils/stats.h>
+
+#include "rir_pass.h"
+#include "rir_pass_utils.h"
+
+// pass statistics are only shown at this verbosity level or higher
+#define PASSES_VERBOSITY 2
+// maximum number of blocks a single call evaluated at compile time can run
+#define PASSES_INTERP_STEP_LIMIT 100000
+
+struct rir_pass {
+    const char *name;
+    rir_pass_fn fn;
+};
+
+static const struct rir_pass pipeline[RIR_PASSES_NUM] = {
+    {"inline", rir_pass_inline},
+    {"constfold", rir_pass_constfold},
+    {"mem2reg", rir_pass_mem2reg},
+    // promotion turns reads of variables holding constants into constants
+    {"constfold", rir_pass_constfold},
+    {"copyelim", rir_pass_copyelim},
+    {"dce", rir_pass_dce},
+    // induction variables are only recognizable once promoted to phis
+    {"loopopt", rir_pass_loopopt},
+};
+
+void rir_passes_stats_init(struct rir_passes_stats *stats)
+{
+    unsigned i;
+    RF_STRUCT_ZERO(stats);
+    for (i = 0; i < RIR_PASSES_NUM; ++i) {
+        stats->passes[i].name = pipeline[i].name;
+    }
+}
+
+static bool rir_passes_run_fndef(struct rir_fndef *fn,
+                                 struct rir *r,
+                                 struct rir_interp *interp,
+                                 struct rir_passes_stats *stats)
+{
+    struct rir_pass_ctx ctx;
+    struct rir_pass_stats *pstats;
+    unsigned i;
+    bool ok;
+    ctx.rir = r;
+    ctx.interp = interp;
+    for (i = 0; i < RIR_PASSES_NUM; ++i) {
+        pstats = &stats->passes[i];
+        ctx.changes = 0;
+        pstats->expressions_before += rir_fndef_expressions_num(fn);
+        // timed as a phase nested in "rir_passes", shown by --time-passes
+        stats_phase_begin(pipeline[i].name);
+        ok = pipeline[i].fn(fn, &ctx);
+        stats_phase_end();
+        if (!ok) {
+            RF_ERROR("RIR pass \"%s\" failed", pipeline[i].name);
+            return false;
+        }
+        pstats->expressions_after += rir_fndef_expressions_num(fn);
+        pstats->changes += ctx.changes;
+    }
+    return true;
+}
+
+bool rir_passes_run_module(struct rir *r, struct rir_passes_stats *stats)
+{
+    struct rir_fndecl *decl;
+    struct rir_interp *interp;
+    bool ret = false;
+    if (!(interp = rir_interp_create(r))) {
+        return false;
+    }
+    rir_interp_set_step_limit(interp, PASSES_INTERP_STEP_LIMIT);
+    rf_ilist_for_each(&r->functions, decl, ln) {
+        if (!decl->plain_decl &&
+            !rir_passes_run_fndef(rir_fndecl_to_fndef(decl), r, interp, stats)) {
+            goto end;
+        }
+    }
+    ret = true;
+end:
+    rir_interp_destroy(interp);
+    return ret;
+}
+
+bool rir_passes_run(struct compiler *c)
+{
+    struct module **mod;
+    struct rir_passes_stats stats;
+    if (compiler_args_no_rir_opt(c->args)) {
+        return true;
+    }
+    rir_passes_stats_init(&stats);
+    darray_foreach(mod, c->modules) {
+        // only for modules that got created from source, a parsed rir file
+        // is taken as is
+        if (module_rir_codepath(*mod) == RIRPOS_AST &&
+            !rir_passes_run_module((*mod)->rir, &stats)) {
+            return false;
+        }
+    }
+    rir_passes_print_stats(&stats, c->args);
+    return true;
+}
+
+void rir_passes_print_stats(const struct rir_passes_stats *stats,
+                            const struct compiler_args *args)
+{
+    unsigned i;
+    const struct rir_pass_stats *p;
+    if (compiler_args_get_verbosity(args) < PASSES_VERBOSITY) {
+        return;
+    }
+    for (i = 0; i < RIR_PASSES_NUM; ++i) {
+        p = &stats->passes[i];
+        printf(
+            "refu: [rir-pass] %-10s %u -> %u expressions, %u change/s\n",
+            p->name,
+            p->expressions_before,
+            p->expressions_after,
+            p->changes
+        );
+    }
+}
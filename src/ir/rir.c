@@ -13,13 +13,16 @@
 #include <ir/rir_utils.h>
 #include <types/type.h>
 #include <types/type_operators.h>
+#include <types/type_comparisons.h>
 #include <ast/ast.h>
 #include <ast/ast_utils.h>
 #include <ast/string_literal.h>
 #include <utils/common_strings.h>
+#include <utils/workers.h>
 #include <analyzer/type_set.h>
 #include <module.h>
 #include <compiler.h>
+#include <compiler_args.h>
 
 static inline void rir_ctx_init(struct rir_ctx *ctx, struct rir *r, struct module *m)
 {
@@ -180,9 +183,28 @@ static bool rir_init(struct rir *r)
     if (!r->rir_types_pool) {
         return false;
     }
+    r->objects_pool = rf_fixed_memorypool_create(sizeof(struct rir_object),
+                                                 RIR_OBJECTS_POOL_CHUNK_SIZE);
+    if (!r->objects_pool) {
+        goto fail_free_types_pool;
+    }
+    r->values_pool = rf_fixed_memorypool_create(sizeof(struct rir_value),
+                                                RIR_VALUES_POOL_CHUNK_SIZE);
+    if (!r->values_pool) {
+        goto fail_free_objects_pool;
+    }
     darray_init(r->dependencies);
-    darray_init(r->free_values);
+    darray_init(r->imported_typedefs);
+    pthread_mutex_init(&r->objects_lock, NULL);
+    pthread_mutex_init(&r->types_lock, NULL);
+    pthread_mutex_init(&r->globals_lock, NULL);
     return true;
+
+fail_free_objects_pool:
+    rf_fixed_memorypool_destroy(r->objects_pool);
+fail_free_types_pool:
+    rf_fixed_memorypool_destroy(r->rir_types_pool);
+    return false;
 }
 
 struct rir *rir_create()
@@ -201,6 +223,7 @@ static void rir_deinit(struct rir *r)
     struct rir_fndecl *fn;
     struct rir_fndecl *tmp;
     darray_free(r->dependencies);
+    darray_free(r->imported_typedefs);
     strmap_clear(&r->map);
     rirtype_strmap_free(&r->types_map);
     strmap_clear(&r->global_literals);
@@ -210,19 +233,15 @@ static void rir_deinit(struct rir *r)
     }
     rf_string_deinit(&r->name);
 
-    // free all free standing rir values
-    struct rir_value **val;
-    darray_foreach(val, r->free_values) {
-        rir_value_destroy(*val, RIR_VALUE_NORMAL);
-    }
-    darray_free(r->free_values);
-
-    // all other rir objects are in the global rir object list so destroy them
+    // all other rir objects are in the global rir object list. Their memory
+    // is released at once with the pool so only deinitialize them.
     struct rir_object *obj;
-    struct rir_object *tmpobj;
-    rf_ilist_for_each_safe(&r->objects, obj, tmpobj, ln) {
-        rir_object_destroy(obj);
+    rf_ilist_for_each(&r->objects, obj, ln) {
+        rir_object_deinit(obj);
     }
+    rf_fixed_memorypool_destroy(r->objects_pool);
+    // free standing values are constants which own no memory
+    rf_fixed_memorypool_destroy(r->values_pool);
 
     if (r->buff) {
         rf_stringx_destroy(r->buff);
@@ -235,6 +254,9 @@ static void rir_deinit(struct rir *r)
         rf_fixed_memorypool_destroy(r->types_pool);
     }
     rf_fixed_memorypool_destroy(r->rir_types_pool);
+    pthread_mutex_destroy(&r->objects_lock);
+    pthread_mutex_destroy(&r->types_lock);
+    pthread_mutex_destroy(&r->globals_lock);
 }
 
 void rir_destroy(struct rir *r)
@@ -257,7 +279,7 @@ static inline void rir_move_from_module(struct rir *r, struct module *m)
 
 static inline bool rir_create_typedefs(
     struct rf_objset_type *typeset,
-    struct RFilist_head *typedefs_list,
+    struct rir_typedef_registry *reg,
     struct rir_ctx *ctx)
 {
     struct type **t;
@@ -270,12 +292,10 @@ static inline bool rir_create_typedefs(
     }
     darray_foreach(t, tarr) {
         if (!type_is_elementary(*t) && !type_is_implop(*t)) {
-            struct rir_typedef *def = rir_typedef_create_from_type(*t, ctx);
-            if (!def) {
+            if (!rir_typedef_add_from_type(*t, reg, ctx)) {
                 RF_ERROR("Failed to create a RIR typedef");
                 goto end;
             }
-            rf_ilist_add_tail(typedefs_list,  &def->ln);
         }
     }
     ret = true;
@@ -284,20 +304,130 @@ end:
     return ret;
 }
 
-static bool rir_process_do(struct rir *r, struct module *m)
+//! A function definition whose body still has to be lowered
+struct rir_fnjob {
+    const struct ast_node *n;
+    struct rir_fndef *def;
+};
+
+/**
+ * Lowering of the function bodies of a module. Bodies are claimed one by one
+ * by the threads taking part so each one only ever touches its own function
+ * and the module's shared pools and maps, which are guarded by the locks
+ * of struct rir.
+ */
+struct rir_lowering {
+    struct rir *r;
+    struct module *m;
+    struct {darray(struct rir_fnjob);} jobs;
+    //! Index of the next job to claim. Guarded by @a lock
+    size_t next;
+    //! Set when lowering any of the bodies failed. Guarded by @a lock
+    bool failed;
+    pthread_mutex_t lock;
+};
+
+static void rir_lowering_init(struct rir_lowering *l, struct rir *r, struct module *m)
+{
+    RF_STRUCT_ZERO(l);
+    l->r = r;
+    l->m = m;
+    darray_init(l->jobs);
+    pthread_mutex_init(&l->lock, NULL);
+}
+
+static void rir_lowering_deinit(struct rir_lowering *l)
+{
+    darray_free(l->jobs);
+    pthread_mutex_destroy(&l->lock);
+}
+
+static void rir_lowering_fail(struct rir_lowering *l)
+{
+    pthread_mutex_lock(&l->lock);
+    l->failed = true;
+    pthread_mutex_unlock(&l->lock);
+}
+
+static void rir_lowering_run(struct rir_lowering *l, struct rir_ctx *ctx)
+{
+    struct rir_fnjob *job;
+    while (true) {
+        pthread_mutex_lock(&l->lock);
+        job = !l->failed && l->next < darray_size(l->jobs)
+            ? &darray_item(l->jobs, l->next++)
+            : NULL;
+        pthread_mutex_unlock(&l->lock);
+        if (!job) {
+            return;
+        }
+        if (!rir_fndef_body_from_ast(job->def, job->n, ctx)) {
+            RF_ERROR(
+                "Failed to create the RIR body of function \""RFS_PF"\"",
+                RFS_PA(&job->def->decl.name)
+            );
+            rir_lowering_fail(l);
+        }
+    }
+}
+
+static void *rir_lowering_thread_init(struct rir_lowering *l)
+{
+    struct rir_ctx *ctx;
+    // each thread needs its own type comparison context
+    RF_MALLOC(ctx, sizeof(*ctx), return NULL);
+    if (!typecmp_ctx_init()) {
+        free(ctx);
+        return NULL;
+    }
+    rir_ctx_init(ctx, l->r, l->m);
+    return ctx;
+}
+
+static void rir_lowering_thread_deinit(struct rir_lowering *l, struct rir_ctx *ctx)
+{
+    (void)l;
+    rir_ctx_deinit(ctx);
+    free(ctx);
+    typecmp_ctx_deinit();
+}
+
+static const struct workers rir_lowering_workers = {
+    .name = "RIR lowering",
+    .init = (void *(*)(void*))rir_lowering_thread_init,
+    .run = (void (*)(void*, void*))rir_lowering_run,
+    .deinit = (void (*)(void*, void*))rir_lowering_thread_deinit,
+};
+
+/**
+ * Lower all function bodies of @a l using up to @a jobs threads, including
+ * the calling one which uses @a ctx.
+ */
+static bool rir_lowering_do(struct rir_lowering *l, struct rir_ctx *ctx, unsigned jobs)
+{
+    return workers_run(&rir_lowering_workers, l, ctx, jobs, darray_size(l->jobs)) &&
+        !l->failed;
+}
+
+static bool rir_process_do(struct rir *r,
+                           struct module *m,
+                           struct rir_typedef_registry *reg,
+                           unsigned jobs)
 {
     RF_ASSERT(module_rir_codepath(m) == RIRPOS_AST,
               "Should not come here from a RIR parsing codepath");
     bool ret = false;
     struct rir_ctx ctx;
+    struct rir_lowering l;
 
     rir_move_from_module(r, m);
 
+    rir_lowering_init(&l, r, m);
     rir_ctx_init(&ctx, r, m);
     // assign the name to this rir
     if (!rf_string_copy_in(&r->name, module_name(m))) {
         RF_ERROR("Could not assign a name to a RIR module object");
-        return false;
+        goto end;
     }
     // for each of the module's dependencies, add equivalent rir dependencies
     struct module **dep;
@@ -323,14 +453,15 @@ static bool rir_process_do(struct rir *r, struct module *m)
         }
     }
 
-    // for each non elementary, non sum-type rir type in this module and its dependencies create a typedef
-    if (!rir_create_typedefs(r->types_set, &r->typedefs, &ctx)) {
+    // for each non elementary, non sum-type rir type in this module and its
+    // dependencies get a typedef. Those of the dependencies already exist.
+    if (!rir_create_typedefs(r->types_set, reg, &ctx)) {
         RF_ERROR("Failed to create a RIR typedef");
         goto end;
     }
     struct rir **rir_dep;
     darray_foreach(rir_dep, r->dependencies) {
-        if (!rir_create_typedefs((*rir_dep)->types_set, &r->typedefs, &ctx)) {
+        if (!rir_create_typedefs((*rir_dep)->types_set, reg, &ctx)) {
             RF_ERROR("Failed to create a RIR typedef");
             goto end;
         }
@@ -348,23 +479,30 @@ static bool rir_process_do(struct rir *r, struct module *m)
         rf_ilist_add_tail(&r->functions, &fndecl->ln);
     }
 
-    // for each function of the module, create a rir equivalent
+    // for each function of the module, create a rir equivalent. All
+    // declarations are created first and in source order so that the
+    // function list is the same no matter how the bodies get lowered.
     struct rir_fndef *fndef;
     struct ast_node **child;
     darray_foreach(child, m->node->children) {
         if ((*child)->type == AST_FUNCTION_IMPLEMENTATION) {
-            fndef = rir_fndef_create_from_ast(*child, &ctx);
+            fndef = rir_fndef_create_decl_from_ast(*child, &ctx);
             if (!fndef) {
                 RF_ERROR("Failed to create a RIR function definition");
                 goto end;
             }
             rf_ilist_add_tail(&r->functions, &fndef->decl.ln);
+            darray_append(l.jobs, ((struct rir_fnjob){*child, fndef}));
         }
     }
+    if (!rir_lowering_do(&l, &ctx, jobs)) {
+        goto end;
+    }
 
     // success
     ret = true;
 end:
+    rir_lowering_deinit(&l);
     rir_ctx_deinit(&ctx);
     return ret;
 }
@@ -376,20 +514,28 @@ bool compiler_create_rir()
     if (!rir_utils_create()) {
         return false;
     }
-    // for each module of the compiler that needs it, process and create the rir
+    struct rir_typedef_registry reg;
+    if (!rir_typedef_registry_init(&reg)) {
+        return false;
+    }
+    // for each module of the compiler that needs it, process and create the
+    // rir. Dependencies come first so their typedefs can be shared.
+    bool ret = true;
     struct module *mod;
     rf_ilist_for_each(&c->sorted_modules, mod, ln) {
         if (module_rir_codepath(mod) == RIRPOS_AST) {
-            if (!rir_process_do(mod->rir, mod)) {
+            if (!rir_process_do(mod->rir, mod, &reg, compiler_args_rir_jobs(c->args))) {
                 RF_ERROR(
                     "Failed to create the RIR for module \""RFS_PF"\"",
                     module_name(mod)
                 );
-                return false;
+                ret = false;
+                break;
             }
         }
     }
-    return true;
+    rir_typedef_registry_deinit(&reg);
+    return ret;
 }
 
 void rirtostr_ctx_reset(struct rirtostr_ctx *ctx)
@@ -461,6 +607,14 @@ struct RFstring *rir_tostring(struct rir *r)
             goto end;
         }
     }
+    // imported typedefs are also output so that the text is self-contained
+    struct rir_typedef **idef;
+    darray_foreach(idef, r->imported_typedefs) {
+        if (!rir_typedef_tostring(&ctx, *idef)) {
+            RF_ERROR("Failed to turn a rir typedef to a string");
+            goto end;
+        }
+    }
 
     // output functions
     struct rir_fndecl *decl;
@@ -520,7 +674,9 @@ struct rir_fndecl *rir_fndecl_byname(const struct rir *r, const struct RFstring
 
 struct rir_typedef *rir_typedef_frommap(const struct rir *r, const struct RFstring *name)
 {
+    pthread_mutex_lock((pthread_mutex_t*)&r->globals_lock);
     struct rir_object *obj = strmap_get(&r->map, name);
+    pthread_mutex_unlock((pthread_mutex_t*)&r->globals_lock);
     if (!obj) {
         return NULL;
     }
@@ -530,11 +686,17 @@ struct rir_typedef *rir_typedef_frommap(const struct rir *r, const struct RFstri
 struct rir_typedef *rir_typedef_byname(const struct rir *r, const struct RFstring *name)
 {
     struct rir_typedef *def;
+    struct rir_typedef **idef;
     rf_ilist_for_each(&r->typedefs, def, ln) {
         if (rf_string_equal(name, &def->name)) {
             return def;
         }
     }
+    darray_foreach(idef, r->imported_typedefs) {
+        if (rf_string_equal(name, &(*idef)->name)) {
+            return *idef;
+        }
+    }
     return NULL;
 }
 
@@ -554,10 +716,19 @@ struct rir_type *rir_type_byname(struct rir *r, const struct RFstring *name)
 
 struct rir_object *rir_strlit_obj(const struct rir *r, const struct ast_node *n)
 {
-    return strmap_get(&r->global_literals, ast_string_literal_get_str(n));
+    pthread_mutex_lock((pthread_mutex_t*)&r->globals_lock);
+    struct rir_object *ret = strmap_get(&r->global_literals, ast_string_literal_get_str(n));
+    pthread_mutex_unlock((pthread_mutex_t*)&r->globals_lock);
+    return ret;
 }
 
-void rir_freevalues_add(struct rir *r, struct rir_value *v)
+struct rir_value *rir_freevalue_alloc(struct rir *r)
 {
-    darray_append(r->free_values, v);
+    pthread_mutex_lock(&r->objects_lock);
+    struct rir_value *ret = rf_fixed_memorypool_alloc_element(r->values_pool);
+    pthread_mutex_unlock(&r->objects_lock);
+    if (ret) {
+        RF_STRUCT_ZERO(ret);
+    }
+    return ret;
 }
@@ -53,7 +53,7 @@ struct rir_object *rir_fixedarr_create_obj_from_ast(
     }
 
     if (!rir_object_expression_init(ret, RIR_EXPRESSION_FIXEDARR, RIRPOS_AST, ctx)) {
-        free(ret);
+        rir_object_free(ret, rir_ctx_rir(ctx));
         ret = NULL;
     }
     return ret;
@@ -121,7 +121,7 @@ struct rir_object *rir_fixedarrsize_create(struct rir_value *v, struct rir_ctx *
     ret->expr.type = RIR_EXPRESSION_FIXEDARRSIZE;
     int64_t size = rir_type_array_size(v->type);
     if (!rir_constantval_init_fromint64(&ret->expr.val, rir_ctx_rir(ctx), size)) {
-        free(ret);
+        rir_object_free(ret, rir_ctx_rir(ctx));
         ret = NULL;
     }
     return ret;
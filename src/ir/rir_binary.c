@@ -0,0 +1,2118 @@
+#include <ir/rir_binary.h>
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <rfbase/datastructs/htable.h>
+#include <rfbase/datastructs/strmap.h>
+#include <rfbase/string/core.h>
+#include <rfbase/utils/fixed_memory_pool.h>
+#include <rfbase/utils/hash.h>
+#include <rfbase/utils/log.h>
+#include <rfbase/utils/memory.h>
+
+#include <ir/rir.h>
+#include <ir/rir_block.h>
+#include <ir/rir_constant.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_global.h>
+#include <ir/rir_object.h>
+#include <ir/rir_phi.h>
+#include <ir/rir_type.h>
+#include <ir/rir_typedef.h>
+#include <ir/rir_value.h>
+#include <ir/parser/rirparser.h>
+#include <ast/constants_decls.h>
+#include "passes/rir_pass_utils.h"
+
+//! "RIRB" when read as bytes
+#define RIRB_MAGIC 0x42524952
+//! Reads differently if the binary was written on a host of other endianness
+#define RIRB_BYTE_ORDER 0x01020304
+//! Marks a missing string or value reference
+#define RIRB_NONE UINT32_MAX
+
+//! Value references keep their kind in the two top bits
+#define RIRB_REF_SHIFT 30
+#define RIRB_REF_MASK ((1u << RIRB_REF_SHIFT) - 1)
+enum rirb_ref_kind {
+    //! Dense index of a value of the current function
+    RIRB_REF_LOCAL = 0,
+    //! String index of the name of a global
+    RIRB_REF_GLOBAL,
+    //! Type index of a constant. The constant kind and value follow inline
+    RIRB_REF_CONSTANT,
+};
+
+//! category, is_pointer, etype/typedef/member type, array size (2 words)
+#define RIRB_TYPE_WORDS 5
+//! name, type, literal
+#define RIRB_GLOBAL_WORDS 3
+//! name, plain_decl, return type, argnum, arguments, body, body size
+#define RIRB_FUNCTION_WORDS 7
+
+//! Number of slots per chunk of the writer's memory pool
+#define RIRB_SLOTS_POOL_CHUNK_SIZE 1024
+
+struct rirb_section {
+    uint32_t offset;
+    uint32_t num;
+};
+
+struct rirb_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byte_order;
+    //! Size of the whole binary in words
+    uint32_t size;
+    //! String index of the module's name
+    uint32_t name;
+    //! The string offsets table. Has num + 1 entries
+    struct rirb_section strings;
+    //! The blob of all strings. num is in bytes
+    struct rirb_section blob;
+    struct rirb_section types;
+    struct rirb_section typedefs;
+    struct rirb_section globals;
+    struct rirb_section functions;
+    struct rirb_section deps;
+    //! Variable length records. num is in words
+    struct rirb_section data;
+};
+#define RIRB_HEADER_WORDS (sizeof(struct rirb_header) / sizeof(uint32_t))
+
+/* -- writing -- */
+
+struct rirb_slot {
+    const void *ptr;
+    uint32_t idx;
+};
+struct rirb_slot_strmap {STRMAP_MEMBERS(struct rirb_slot*);};
+
+/**
+ * A value of the function being written
+ */
+struct rirb_local {
+    //! Keep first, the locals table holds pointers to it
+    struct rirb_slot slot;
+    //! The expression defining the value. NULL for arguments, the return
+    //! slot and labels which are indexed up front
+    struct rir_expression *expr;
+    uint32_t block;
+    uint32_t pos;
+    bool visiting;
+    bool written;
+};
+
+/**
+ * A phi incoming value whose index is not known when the phi is written
+ */
+struct rirb_fixup {
+    //! Index of the word to patch in the data section
+    uint32_t word;
+    const struct rir_value *val;
+};
+
+struct rirb_writer {
+    struct rir *rir;
+    //! Pool for the slots of strings and types
+    struct rf_fixed_memorypool *pool;
+    struct rirb_slot_strmap strings_map;
+    //! All strings in the order of the string table
+    struct {darray(const struct RFstring*);} strings;
+    struct htable types_map;
+    struct rir_binary_buff types;
+    uint32_t types_num;
+    struct htable typedefs_map;
+    struct rirb_slot *typedef_slots;
+    struct rir_binary_buff typedefs;
+    struct rir_binary_buff globals;
+    uint32_t globals_num;
+    struct rir_binary_buff functions;
+    struct rir_binary_buff deps;
+    struct rir_binary_buff data;
+    //! Set if iterating the global literals failed
+    bool failed;
+    //! Values of the function being written
+    struct htable locals_map;
+    struct rirb_local *locals;
+    uint32_t locals_num;
+    //! Next dense value index of the function being written
+    uint32_t values_num;
+    struct {darray(struct rirb_fixup);} fixups;
+};
+
+static size_t rirb_slot_rehash(const void *e, void *priv)
+{
+    return hash_pointer(((const struct rirb_slot*)e)->ptr, 0);
+}
+
+static bool rirb_slot_cmp(const void *e, void *ptr)
+{
+    return ((const struct rirb_slot*)e)->ptr == ptr;
+}
+
+static struct rirb_slot *rirb_slot_get(const struct htable *t, const void *ptr)
+{
+    return htable_get(t, hash_pointer(ptr, 0), rirb_slot_cmp, ptr);
+}
+
+static inline void rirb_put(struct rir_binary_buff *b, uint32_t word)
+{
+    darray_append(*b, word);
+}
+
+static inline void rirb_put64(struct rir_binary_buff *b, uint64_t word)
+{
+    darray_append(*b, (uint32_t)word);
+    darray_append(*b, (uint32_t)(word >> 32));
+}
+
+static bool rirb_writer_init(struct rirb_writer *w, struct rir *r)
+{
+    RF_STRUCT_ZERO(w);
+    w->rir = r;
+    w->pool = rf_fixed_memorypool_create(sizeof(struct rirb_slot),
+                                         RIRB_SLOTS_POOL_CHUNK_SIZE);
+    if (!w->pool) {
+        return false;
+    }
+    strmap_init(&w->strings_map);
+    darray_init(w->strings);
+    htable_init(&w->types_map, rirb_slot_rehash, NULL);
+    htable_init(&w->typedefs_map, rirb_slot_rehash, NULL);
+    htable_init(&w->locals_map, rirb_slot_rehash, NULL);
+    darray_init(w->types);
+    darray_init(w->typedefs);
+    darray_init(w->globals);
+    darray_init(w->functions);
+    darray_init(w->deps);
+    darray_init(w->data);
+    darray_init(w->fixups);
+    return true;
+}
+
+static void rirb_writer_deinit(struct rirb_writer *w)
+{
+    strmap_clear(&w->strings_map);
+    darray_free(w->strings);
+    htable_clear(&w->types_map);
+    htable_clear(&w->typedefs_map);
+    htable_clear(&w->locals_map);
+    free(w->typedef_slots);
+    darray_free(w->types);
+    darray_free(w->typedefs);
+    darray_free(w->globals);
+    darray_free(w->functions);
+    darray_free(w->deps);
+    darray_free(w->data);
+    darray_free(w->fixups);
+    rf_fixed_memorypool_destroy(w->pool);
+}
+
+static bool rirb_string(struct rirb_writer *w, const struct RFstring *s, uint32_t *idx)
+{
+    struct rirb_slot *slot = strmap_get(&w->strings_map, s);
+    if (!slot) {
+        if (!(slot = rf_fixed_memorypool_alloc_element(w->pool))) {
+            return false;
+        }
+        slot->ptr = s;
+        slot->idx = darray_size(w->strings);
+        if (!strmap_add(&w->strings_map, (struct RFstring*)s, slot)) {
+            RF_ERROR("Failed to add a string to the binary rir string table");
+            return false;
+        }
+        darray_append(w->strings, s);
+    }
+    *idx = slot->idx;
+    return true;
+}
+
+static bool rirb_put_string(struct rirb_writer *w,
+                            struct rir_binary_buff *b,
+                            const struct RFstring *s)
+{
+    uint32_t idx;
+    if (!rirb_string(w, s, &idx)) {
+        return false;
+    }
+    rirb_put(b, idx);
+    return true;
+}
+
+static bool rirb_type(struct rirb_writer *w, const struct rir_type *t, uint32_t *idx)
+{
+    struct rirb_slot *slot = rirb_slot_get(&w->types_map, t);
+    uint32_t ref = 0;
+    if (slot) {
+        *idx = slot->idx;
+        return true;
+    }
+    switch (t->category) {
+    case RIR_TYPE_ELEMENTARY:
+        ref = t->etype;
+        break;
+    case RIR_TYPE_COMPOSITE:
+        if (!(slot = rirb_slot_get(&w->typedefs_map, t->tdef))) {
+            RF_ERROR(
+                "Rir type refers to typedef \""RFS_PF"\" of another module",
+                RFS_PA(&t->tdef->name)
+            );
+            return false;
+        }
+        ref = slot->idx;
+        break;
+    case RIR_TYPE_ARRAY:
+        // the member type always gets a smaller index than the array type
+        if (!rirb_type(w, t->array.type, &ref)) {
+            return false;
+        }
+        break;
+    }
+
+    if (!(slot = rf_fixed_memorypool_alloc_element(w->pool))) {
+        return false;
+    }
+    slot->ptr = t;
+    slot->idx = w->types_num++;
+    if (!htable_add(&w->types_map, hash_pointer(t, 0), slot)) {
+        RF_ERROR("Failed to add a type to the binary rir type table");
+        return false;
+    }
+    rirb_put(&w->types, t->category);
+    rirb_put(&w->types, t->is_pointer);
+    rirb_put(&w->types, ref);
+    rirb_put64(&w->types, t->category == RIR_TYPE_ARRAY ? (uint64_t)t->array.size : 0);
+    *idx = slot->idx;
+    return true;
+}
+
+static bool rirb_put_type(struct rirb_writer *w,
+                          struct rir_binary_buff *b,
+                          const struct rir_type *t)
+{
+    uint32_t idx;
+    if (!rirb_type(w, t, &idx)) {
+        return false;
+    }
+    rirb_put(b, idx);
+    return true;
+}
+
+static bool rirb_put_constant(struct rirb_writer *w, const struct rir_value *v)
+{
+    uint64_t bits = 0;
+    uint32_t type;
+    if (!rirb_type(w, v->type, &type)) {
+        return false;
+    }
+    switch (v->constant.type) {
+    case CONSTANT_NUMBER_INTEGER:
+        bits = (uint64_t)v->constant.value.integer;
+        break;
+    case CONSTANT_NUMBER_FLOAT:
+        memcpy(&bits, &v->constant.value.floating, sizeof(bits));
+        break;
+    case CONSTANT_BOOLEAN:
+        bits = v->constant.value.boolean;
+        break;
+    }
+    rirb_put(&w->data, ((uint32_t)RIRB_REF_CONSTANT << RIRB_REF_SHIFT) | type);
+    rirb_put(&w->data, v->constant.type);
+    rirb_put64(&w->data, bits);
+    return true;
+}
+
+static struct rirb_local *rirb_local_get(const struct rirb_writer *w, const struct rir_value *v)
+{
+    return (struct rirb_local*)rirb_slot_get(&w->locals_map, v);
+}
+
+static bool rirb_local_add(struct rirb_writer *w,
+                           const struct rir_value *v,
+                           struct rir_expression *expr,
+                           uint32_t block,
+                           uint32_t pos)
+{
+    struct rirb_local *l;
+    if (rirb_local_get(w, v)) {
+        RFS_PUSH();
+        RF_ERROR("Rir value \""RFS_PF"\" appears twice in a function", RFS_PA(rir_value_string(v)));
+        RFS_POP();
+        return false;
+    }
+    l = &w->locals[w->locals_num++];
+    l->slot.ptr = v;
+    l->slot.idx = expr ? RIRB_NONE : w->values_num++;
+    l->expr = expr;
+    l->block = block;
+    l->pos = pos;
+    l->visiting = false;
+    l->written = !expr;
+    if (!htable_add(&w->locals_map, hash_pointer(v, 0), l)) {
+        RF_ERROR("Failed to add a value to the binary rir locals table");
+        return false;
+    }
+    return true;
+}
+
+static bool rirb_put_value(struct rirb_writer *w, const struct rir_value *v)
+{
+    struct rirb_local *l;
+    uint32_t idx;
+    if (!v) {
+        rirb_put(&w->data, RIRB_NONE);
+        return true;
+    }
+    switch (v->category) {
+    case RIR_VALUE_CONSTANT:
+        return rirb_put_constant(w, v);
+    case RIR_VALUE_LITERAL:
+        if (!rirb_string(w, &v->name, &idx)) {
+            return false;
+        }
+        rirb_put(&w->data, ((uint32_t)RIRB_REF_GLOBAL << RIRB_REF_SHIFT) | idx);
+        return true;
+    case RIR_VALUE_VARIABLE:
+    case RIR_VALUE_LABEL:
+        l = rirb_local_get(w, v);
+        if (!l || !l->written) {
+            RFS_PUSH();
+            RF_ERROR(
+                "Rir value \""RFS_PF"\" is not defined in the function",
+                RFS_PA(rir_value_string(v))
+            );
+            RFS_POP();
+            return false;
+        }
+        rirb_put(&w->data, l->slot.idx);
+        return true;
+    case RIR_VALUE_NIL:
+        break;
+    }
+    RF_ERROR("Can't serialize a nil rir value");
+    return false;
+}
+
+/**
+ * Like rirb_put_value() but for values that may not have been written yet.
+ * Their index is filled in after the whole function has been written.
+ */
+static bool rirb_put_value_deferred(struct rirb_writer *w, const struct rir_value *v)
+{
+    struct rirb_fixup fixup;
+    if (v->category != RIR_VALUE_VARIABLE) {
+        return rirb_put_value(w, v);
+    }
+    fixup.word = darray_size(w->data);
+    fixup.val = v;
+    darray_append(w->fixups, fixup);
+    rirb_put(&w->data, RIRB_NONE);
+    return true;
+}
+
+static bool rirb_put_valuearr(struct rirb_writer *w, const struct value_arr *arr)
+{
+    struct rir_value **v;
+    rirb_put(&w->data, darray_size(*arr));
+    darray_foreach(v, *arr) {
+        if (!rirb_put_value(w, *v)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool rirb_write_expression_data(struct rirb_writer *w, const struct rir_expression *e)
+{
+    struct rir_phi_incoming *in;
+    switch (e->type) {
+    case RIR_EXPRESSION_CALL:
+        if (!rirb_put_string(w, &w->data, &e->call.name)) {
+            return false;
+        }
+        rirb_put(&w->data, e->call.foreign);
+        return rirb_put_valuearr(w, &e->call.args);
+    case RIR_EXPRESSION_ALLOCA:
+        if (!rirb_put_type(w, &w->data, e->alloca.type)) {
+            return false;
+        }
+        rirb_put(&w->data, e->alloca.alloc_location);
+        return true;
+    case RIR_EXPRESSION_RETURN:
+        return true;
+    case RIR_EXPRESSION_CONVERT:
+        return rirb_put_value(w, e->convert.val) &&
+            rirb_put_type(w, &w->data, e->convert.type);
+    case RIR_EXPRESSION_WRITE:
+        return rirb_put_value(w, e->write.memory) &&
+            rirb_put_value(w, e->write.writeval);
+    case RIR_EXPRESSION_READ:
+        return rirb_put_value(w, e->read.memory);
+    case RIR_EXPRESSION_OBJMEMBERAT:
+        if (!rirb_put_value(w, e->objmemberat.objmemory)) {
+            return false;
+        }
+        rirb_put(&w->data, e->objmemberat.idx);
+        return true;
+    case RIR_EXPRESSION_SETUNIONIDX:
+        return rirb_put_value(w, e->setunionidx.unimemory) &&
+            rirb_put_value(w, e->setunionidx.idx);
+    case RIR_EXPRESSION_GETUNIONIDX:
+        return rirb_put_value(w, e->getunionidx.unimemory);
+    case RIR_EXPRESSION_UNIONMEMBERAT:
+        if (!rirb_put_value(w, e->unionmemberat.unimemory)) {
+            return false;
+        }
+        rirb_put(&w->data, e->unionmemberat.idx);
+        return true;
+    case RIR_EXPRESSION_OBJIDX:
+        return rirb_put_value(w, e->objidx.objmemory) &&
+            rirb_put_value(w, e->objidx.idx);
+    case RIR_EXPRESSION_FIXEDARR:
+        if (!rirb_put_type(w, &w->data, e->fixedarr.member_type)) {
+            return false;
+        }
+        rirb_put64(&w->data, e->fixedarr.size);
+        return rirb_put_valuearr(w, &e->fixedarr.members);
+    case RIR_EXPRESSION_FIXEDARRSIZE:
+        return rirb_put_value(w, e->fixedarrsize.array);
+    case RIR_EXPRESSION_CONSTANT:
+        return rirb_put_constant(w, &e->val);
+    case RIR_EXPRESSION_ADD:
+    case RIR_EXPRESSION_SUB:
+    case RIR_EXPRESSION_MUL:
+    case RIR_EXPRESSION_DIV:
+    case RIR_EXPRESSION_CMP_EQ:
+    case RIR_EXPRESSION_CMP_NE:
+    case RIR_EXPRESSION_CMP_GE:
+    case RIR_EXPRESSION_CMP_GT:
+    case RIR_EXPRESSION_CMP_LE:
+    case RIR_EXPRESSION_CMP_LT:
+        return rirb_put_value(w, e->binaryop.a) &&
+            rirb_put_value(w, e->binaryop.b);
+    case RIR_EXPRESSION_PHI:
+        if (!rirb_put_type(w, &w->data, e->phi.type)) {
+            return false;
+        }
+        rirb_put(&w->data, rir_phi_incoming_num(&e->phi));
+        darray_foreach(in, e->phi.incoming) {
+            if (!rirb_put_value_deferred(w, in->val) ||
+                !rirb_put_value(w, in->block)) {
+                return false;
+            }
+        }
+        return true;
+    case RIR_EXPRESSION_LOGIC_AND:
+    case RIR_EXPRESSION_LOGIC_OR:
+        // they have no rir value type yet so can't be loaded back
+    case RIR_EXPRESSION_PLACEHOLDER:
+        break;
+    }
+    RF_ERROR("Can't serialize rir expression of type %d", e->type);
+    return false;
+}
+
+static bool rirb_write_expression(struct rirb_writer *w, struct rirb_local *l);
+
+struct rirb_operand_ctx {
+    struct rirb_writer *w;
+    bool ok;
+};
+
+static void rirb_write_operand_cb(const struct rir_value **op, void *user)
+{
+    struct rirb_operand_ctx *ctx = user;
+    struct rirb_local *l;
+    if (!ctx->ok || !*op || (*op)->category != RIR_VALUE_VARIABLE) {
+        return;
+    }
+    l = rirb_local_get(ctx->w, *op);
+    if (l && !l->written) {
+        ctx->ok = rirb_write_expression(ctx->w, l);
+    }
+}
+
+/**
+ * Write an expression after all the expressions defining its operands, so
+ * that the loader can create it right away. Phis are the exception since
+ * their incoming values can come from later in the function.
+ */
+static bool rirb_write_expression(struct rirb_writer *w, struct rirb_local *l)
+{
+    struct rir_expression *e = l->expr;
+    struct rirb_operand_ctx ctx;
+    if (l->visiting) {
+        RF_ERROR("Rir expression \"$%"PRIu32"\" depends on itself", e->val.id);
+        return false;
+    }
+    l->visiting = true;
+    if (e->type != RIR_EXPRESSION_PHI) {
+        ctx.w = w;
+        ctx.ok = true;
+        rir_expression_foreach_operand(e, rirb_write_operand_cb, &ctx);
+        if (!ctx.ok) {
+            return false;
+        }
+    }
+
+    rirb_put(&w->data, e->type);
+    rirb_put(&w->data, l->block);
+    rirb_put(&w->data, l->pos);
+    if (e->val.category == RIR_VALUE_VARIABLE) {
+        rirb_put(&w->data, e->val.id);
+        l->slot.idx = w->values_num++;
+    } else {
+        rirb_put(&w->data, RIRB_NONE);
+    }
+    if (!rirb_write_expression_data(w, e)) {
+        return false;
+    }
+    l->visiting = false;
+    l->written = true;
+    return true;
+}
+
+static bool rirb_write_exit(struct rirb_writer *w, const struct rir_block *b)
+{
+    const struct rir_block_exit *exit = &b->exit;
+    struct rir_switch_case *c;
+    rirb_put(&w->data, exit->type);
+    switch (exit->type) {
+    case RIR_BLOCK_EXIT_BRANCH:
+        return rirb_put_value(w, exit->branch.dst);
+    case RIR_BLOCK_EXIT_CONDBRANCH:
+        return rirb_put_value(w, exit->condbranch.cond) &&
+            rirb_put_value(w, exit->condbranch.taken) &&
+            rirb_put_value(w, exit->condbranch.fallthrough);
+    case RIR_BLOCK_EXIT_SWITCH:
+        if (!rirb_put_value(w, exit->switchbr.cond) ||
+            !rirb_put_value(w, exit->switchbr.fallthrough)) {
+            return false;
+        }
+        rirb_put(&w->data, rir_switch_cases_num(&exit->switchbr));
+        darray_foreach(c, exit->switchbr.cases) {
+            if (!rirb_put_value(w, c->val) || !rirb_put_value(w, c->dst)) {
+                return false;
+            }
+        }
+        return true;
+    case RIR_BLOCK_EXIT_RETURN:
+        return rirb_put_value(w, exit->retstmt.val);
+    case RIR_BLOCK_EXIT_INVALID:
+        return true;
+    }
+    RF_ERROR("Can't serialize rir block exit of type %d", exit->type);
+    return false;
+}
+
+/**
+ * Arguments and the return slot are recreated by the loader with the same
+ * ids as the rir parser gives them, so make sure they match
+ */
+static bool rirb_check_fndef_ids(const struct rir_fndef *fn)
+{
+    struct rir_object **var;
+    uint32_t idx = 0;
+    darray_foreach(var, fn->variables) {
+        if (rir_object_value(*var)->id != idx) {
+            RF_ERROR(
+                "Argument %"PRIu32" of \""RFS_PF"\" does not have the expected id",
+                idx, RFS_PA(&fn->decl.name)
+            );
+            return false;
+        }
+        ++idx;
+    }
+    if (idx != darray_size(fn->decl.argument_types)) {
+        RF_ERROR("Arguments of \""RFS_PF"\" do not match its declaration", RFS_PA(&fn->decl.name));
+        return false;
+    }
+    if (fn->retslot_val && fn->retslot_val->id != idx) {
+        RF_ERROR("Return slot of \""RFS_PF"\" does not have the expected id", RFS_PA(&fn->decl.name));
+        return false;
+    }
+    return true;
+}
+
+static bool rirb_write_fndef(struct rirb_writer *w, struct rir_fndef *fn)
+{
+    struct rir_object **var;
+    struct rir_block **b;
+    struct rir_expression *e;
+    struct rirb_local *l;
+    struct rirb_fixup *fixup;
+    uint32_t start = darray_size(w->data);
+    uint32_t block_idx;
+    uint32_t pos;
+    uint32_t i;
+    bool ret = false;
+    uint32_t exprs_num = rir_fndef_expressions_num(fn);
+    uint32_t max_locals = darray_size(fn->variables) + 1 + darray_size(fn->blocks) + exprs_num;
+
+    if (!rirb_check_fndef_ids(fn)) {
+        return false;
+    }
+    if (max_locals > RIRB_REF_MASK) {
+        RF_ERROR("Function \""RFS_PF"\" is too big for binary rir", RFS_PA(&fn->decl.name));
+        return false;
+    }
+    RF_CALLOC(w->locals, max_locals, sizeof(*w->locals), return false);
+    w->locals_num = 0;
+    w->values_num = 0;
+    darray_resize(w->fixups, 0);
+
+    // arguments, the return slot and the labels are indexed before any expression
+    darray_foreach(var, fn->variables) {
+        if (!rirb_local_add(w, rir_object_value(*var), NULL, 0, 0)) {
+            goto end;
+        }
+    }
+    if (fn->retslot_val && !rirb_local_add(w, fn->retslot_val, NULL, 0, 0)) {
+        goto end;
+    }
+    darray_foreach(b, fn->blocks) {
+        if (!rirb_local_add(w, &(*b)->label, NULL, 0, 0)) {
+            goto end;
+        }
+    }
+    block_idx = 0;
+    darray_foreach(b, fn->blocks) {
+        pos = 0;
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            if (!rirb_local_add(w, &e->val, e, block_idx, pos++)) {
+                goto end;
+            }
+        }
+        ++block_idx;
+    }
+
+    // the number of values is only known after the expressions are written
+    rirb_put(&w->data, 0);
+    rirb_put(&w->data, darray_size(fn->blocks));
+    rirb_put(&w->data, exprs_num);
+    darray_foreach(b, fn->blocks) {
+        if (!rirb_put_string(w, &w->data, &(*b)->label.name)) {
+            goto end;
+        }
+        pos = 0;
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            ++pos;
+        }
+        rirb_put(&w->data, pos);
+    }
+    for (i = 0; i < w->locals_num; ++i) {
+        l = &w->locals[i];
+        if (!l->written && !rirb_write_expression(w, l)) {
+            goto end;
+        }
+    }
+    darray_foreach(b, fn->blocks) {
+        if (!rirb_write_exit(w, *b)) {
+            goto end;
+        }
+    }
+    darray_foreach(fixup, w->fixups) {
+        l = rirb_local_get(w, fixup->val);
+        if (!l) {
+            RF_ERROR(
+                "Phi incoming value \"$%"PRIu32"\" is not defined in the function",
+                fixup->val->id
+            );
+            goto end;
+        }
+        darray_item(w->data, fixup->word) = l->slot.idx;
+    }
+    darray_item(w->data, start) = w->values_num;
+    ret = true;
+
+end:
+    htable_clear(&w->locals_map);
+    htable_init(&w->locals_map, rirb_slot_rehash, NULL);
+    free(w->locals);
+    w->locals = NULL;
+    return ret;
+}
+
+static bool rirb_write_function(struct rirb_writer *w, struct rir_fndecl *decl)
+{
+    struct rir_type **t;
+    uint32_t body;
+    if (!rirb_put_string(w, &w->functions, &decl->name)) {
+        return false;
+    }
+    rirb_put(&w->functions, decl->plain_decl);
+    if (!rirb_put_type(w, &w->functions, decl->return_type)) {
+        return false;
+    }
+    rirb_put(&w->functions, darray_size(decl->argument_types));
+    rirb_put(&w->functions, darray_size(w->data));
+    darray_foreach(t, decl->argument_types) {
+        if (!rirb_put_type(w, &w->data, *t)) {
+            return false;
+        }
+    }
+    if (decl->plain_decl) {
+        rirb_put(&w->functions, RIRB_NONE);
+        rirb_put(&w->functions, 0);
+        return true;
+    }
+    body = darray_size(w->data);
+    if (!rirb_write_fndef(w, rir_fndecl_to_fndef(decl))) {
+        return false;
+    }
+    rirb_put(&w->functions, body);
+    rirb_put(&w->functions, darray_size(w->data) - body);
+    return true;
+}
+
+static bool rirb_index_typedef(struct rirb_writer *w, struct rir_typedef *def, uint32_t num)
+{
+    w->typedef_slots[num].ptr = def;
+    w->typedef_slots[num].idx = num;
+    return htable_add(&w->typedefs_map, hash_pointer(def, 0), &w->typedef_slots[num]);
+}
+
+static bool rirb_write_typedef(struct rirb_writer *w, const struct rir_typedef *def)
+{
+    struct rir_type **t;
+    rirb_put(&w->typedefs, darray_size(w->data));
+    if (!rirb_put_string(w, &w->data, &def->name)) {
+        return false;
+    }
+    rirb_put(&w->data, def->is_union);
+    rirb_put(&w->data, darray_size(def->argument_types));
+    darray_foreach(t, def->argument_types) {
+        if (!rirb_put_type(w, &w->data, *t)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool rirb_write_typedefs(struct rirb_writer *w)
+{
+    struct rir_typedef *def;
+    struct rir_typedef **idef;
+    uint32_t num = darray_size(w->rir->imported_typedefs);
+    rf_ilist_for_each(&w->rir->typedefs, def, ln) {
+        ++num;
+    }
+    RF_CALLOC(w->typedef_slots, num + 1, sizeof(*w->typedef_slots), return false);
+    // index all typedefs first since member types may refer to any of them.
+    // Imported typedefs are written like owned ones, after them, so that
+    // the binary does not depend on the module that created them.
+    num = 0;
+    rf_ilist_for_each(&w->rir->typedefs, def, ln) {
+        if (!rirb_index_typedef(w, def, num++)) {
+            return false;
+        }
+    }
+    darray_foreach(idef, w->rir->imported_typedefs) {
+        if (!rirb_index_typedef(w, *idef, num++)) {
+            return false;
+        }
+    }
+    rf_ilist_for_each(&w->rir->typedefs, def, ln) {
+        if (!rirb_write_typedef(w, def)) {
+            return false;
+        }
+    }
+    darray_foreach(idef, w->rir->imported_typedefs) {
+        if (!rirb_write_typedef(w, *idef)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool rirb_write_global_cb(const struct RFstring *member,
+                                 struct rir_object *obj,
+                                 struct rirb_writer *w)
+{
+    const struct rir_value *v = &obj->global.val;
+    if (!rirb_put_string(w, &w->globals, &v->name) ||
+        !rirb_put_type(w, &w->globals, v->type) ||
+        !rirb_put_string(w, &w->globals, &v->literal)) {
+        w->failed = true;
+        return false;
+    }
+    ++w->globals_num;
+    return true;
+}
+
+static void rirb_append_section(struct rir_binary_buff *out,
+                                struct rirb_section *s,
+                                const struct rir_binary_buff *in,
+                                uint32_t num)
+{
+    s->offset = darray_size(*out);
+    s->num = num;
+    if (darray_size(*in) != 0) {
+        darray_resize(*out, s->offset + darray_size(*in));
+        memcpy(
+            &darray_item(*out, s->offset),
+            &darray_item(*in, 0),
+            darray_size(*in) * sizeof(uint32_t)
+        );
+    }
+}
+
+static void rirb_append_strings(struct rirb_writer *w,
+                                struct rir_binary_buff *out,
+                                struct rirb_header *hdr)
+{
+    const struct RFstring **s;
+    uint32_t bytes = 0;
+    uint32_t words;
+    char *blob;
+    hdr->strings.offset = darray_size(*out);
+    hdr->strings.num = darray_size(w->strings);
+    darray_foreach(s, w->strings) {
+        rirb_put(out, bytes);
+        bytes += rf_string_length_bytes(*s);
+    }
+    rirb_put(out, bytes);
+
+    hdr->blob.offset = darray_size(*out);
+    hdr->blob.num = bytes;
+    words = (bytes + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    if (words == 0) {
+        return;
+    }
+    darray_resize(*out, hdr->blob.offset + words);
+    blob = (char*)&darray_item(*out, hdr->blob.offset);
+    memset(blob, 0, words * sizeof(uint32_t));
+    darray_foreach(s, w->strings) {
+        memcpy(blob, rf_string_data(*s), rf_string_length_bytes(*s));
+        blob += rf_string_length_bytes(*s);
+    }
+}
+
+bool rir_binary_serialize(struct rir *r, struct rir_binary_buff *buff)
+{
+    struct rirb_writer w;
+    struct rirb_header hdr;
+    struct rir_fndecl *decl;
+    struct rir **dep;
+    uint32_t functions_num = 0;
+    bool ret = false;
+    if (!rirb_writer_init(&w, r)) {
+        return false;
+    }
+    RF_STRUCT_ZERO(&hdr);
+    hdr.magic = RIRB_MAGIC;
+    hdr.version = RIR_BINARY_VERSION;
+    hdr.byte_order = RIRB_BYTE_ORDER;
+
+    if (!rirb_string(&w, &r->name, &hdr.name)) {
+        goto end;
+    }
+    darray_foreach(dep, r->dependencies) {
+        if (!rirb_put_string(&w, &w.deps, &(*dep)->name)) {
+            goto end;
+        }
+    }
+    if (!rirb_write_typedefs(&w)) {
+        goto end;
+    }
+    strmap_iterate(&r->global_literals, (strmap_it_cb)rirb_write_global_cb, &w);
+    if (w.failed) {
+        goto end;
+    }
+    rf_ilist_for_each(&r->functions, decl, ln) {
+        if (!rirb_write_function(&w, decl)) {
+            RF_ERROR("Failed to serialize rir function \""RFS_PF"\"", RFS_PA(&decl->name));
+            goto end;
+        }
+        ++functions_num;
+    }
+
+    // assemble the sections after the header
+    darray_resize(*buff, RIRB_HEADER_WORDS);
+    rirb_append_strings(&w, buff, &hdr);
+    rirb_append_section(buff, &hdr.types, &w.types, w.types_num);
+    rirb_append_section(buff, &hdr.typedefs, &w.typedefs, darray_size(w.typedefs));
+    rirb_append_section(buff, &hdr.globals, &w.globals, w.globals_num);
+    rirb_append_section(buff, &hdr.functions, &w.functions, functions_num);
+    rirb_append_section(buff, &hdr.deps, &w.deps, darray_size(w.deps));
+    rirb_append_section(buff, &hdr.data, &w.data, darray_size(w.data));
+    hdr.size = darray_size(*buff);
+    memcpy(&darray_item(*buff, 0), &hdr, sizeof(hdr));
+    ret = true;
+
+end:
+    rirb_writer_deinit(&w);
+    return ret;
+}
+
+bool rir_binary_write(struct rir *r, const struct RFstring *path)
+{
+    struct rir_binary_buff buff;
+    FILE *f;
+    size_t bytes;
+    bool ret = false;
+    darray_init(buff);
+    if (!rir_binary_serialize(r, &buff)) {
+        goto free_buff;
+    }
+    RFS_PUSH();
+    f = fopen(rf_string_data(RFS_NT_OR_DIE(RFS_PF, RFS_PA(path))), "wb");
+    RFS_POP();
+    if (!f) {
+        RF_ERROR("Could not open \""RFS_PF"\" for writing", RFS_PA(path));
+        goto free_buff;
+    }
+    // the whole module is already in memory so it goes out in a single write
+    bytes = darray_size(buff) * sizeof(uint32_t);
+    ret = fwrite(&darray_item(buff, 0), 1, bytes, f) == bytes;
+    if (fclose(f) != 0) {
+        ret = false;
+    }
+    if (!ret) {
+        RF_ERROR("Failed to write binary rir to \""RFS_PF"\"", RFS_PA(path));
+    }
+
+free_buff:
+    darray_free(buff);
+    return ret;
+}
+
+/* -- loading -- */
+
+struct rir_binary {
+    const uint32_t *words;
+    //! Size of the binary in words
+    uint32_t size;
+    //! Size of the binary in bytes
+    size_t bytes;
+    //! True if @ref words is a file mapping
+    bool mapped;
+    struct rirb_header hdr;
+    struct rir *rir;
+    struct rir_pctx ctx;
+    //! Loaded types by type table index. NULL until first needed
+    struct rir_type **types;
+    //! Loaded typedefs by typedef table index
+    struct rir_typedef **typedefs;
+    //! Typedefs whose member types are being loaded
+    bool *typedefs_loading;
+    //! Definitions whose body is not loaded yet, by function table index
+    struct rir_fndef **pending;
+};
+
+struct rirb_cursor {
+    const uint32_t *pos;
+    const uint32_t *end;
+};
+
+static bool rirb_cursor_init(const struct rir_binary *rb,
+                             struct rirb_cursor *c,
+                             uint32_t offset,
+                             uint32_t size)
+{
+    if (offset > rb->hdr.data.num) {
+        RF_ERROR("Binary rir data offset out of bounds");
+        return false;
+    }
+    if (size == RIRB_NONE) {
+        size = rb->hdr.data.num - offset;
+    } else if (size > rb->hdr.data.num - offset) {
+        RF_ERROR("Binary rir data size out of bounds");
+        return false;
+    }
+    c->pos = rb->words + rb->hdr.data.offset + offset;
+    c->end = c->pos + size;
+    return true;
+}
+
+static bool rirb_read(struct rirb_cursor *c, uint32_t *word)
+{
+    if (c->pos == c->end) {
+        RF_ERROR("Unexpected end of binary rir data");
+        return false;
+    }
+    *word = *c->pos++;
+    return true;
+}
+
+static bool rirb_read64(struct rirb_cursor *c, uint64_t *word)
+{
+    uint32_t lo;
+    uint32_t hi;
+    if (!rirb_read(c, &lo) || !rirb_read(c, &hi)) {
+        return false;
+    }
+    *word = lo | ((uint64_t)hi << 32);
+    return true;
+}
+
+static bool rirb_string_get(const struct rir_binary *rb, uint32_t idx, struct RFstring *s)
+{
+    const uint32_t *offsets = rb->words + rb->hdr.strings.offset;
+    if (idx >= rb->hdr.strings.num) {
+        RF_ERROR("Invalid string index in binary rir");
+        return false;
+    }
+    // the loaded rir copies all strings so they can point into the binary
+    RF_STRING_SHALLOW_INIT(
+        s,
+        (char*)(rb->words + rb->hdr.blob.offset) + offsets[idx],
+        offsets[idx + 1] - offsets[idx]
+    );
+    return true;
+}
+
+static bool rirb_read_string(const struct rir_binary *rb,
+                             struct rirb_cursor *c,
+                             struct RFstring *s)
+{
+    uint32_t idx;
+    return rirb_read(c, &idx) && rirb_string_get(rb, idx, s);
+}
+
+static struct rir_typedef *rirb_typedef_get(struct rir_binary *rb, uint32_t idx);
+
+static struct rir_type *rirb_type_get(struct rir_binary *rb, uint32_t idx)
+{
+    const uint32_t *rec;
+    const struct rir_type *member;
+    struct rir_typedef *def;
+    struct rir_type *t = NULL;
+    if (idx >= rb->hdr.types.num) {
+        RF_ERROR("Invalid type index in binary rir");
+        return NULL;
+    }
+    if (rb->types[idx]) {
+        return rb->types[idx];
+    }
+    rec = rb->words + rb->hdr.types.offset + idx * RIRB_TYPE_WORDS;
+    switch (rec[0]) {
+    case RIR_TYPE_ELEMENTARY:
+        if (rec[2] >= ELEMENTARY_TYPE_TYPES_COUNT) {
+            RF_ERROR("Invalid elementary type in binary rir");
+            break;
+        }
+        t = rir_type_elem_get_or_create(rb->rir, rec[2], rec[1]);
+        break;
+    case RIR_TYPE_COMPOSITE:
+        if ((def = rirb_typedef_get(rb, rec[2]))) {
+            t = rir_type_comp_get_or_create(def, rb->rir, rec[1]);
+        }
+        break;
+    case RIR_TYPE_ARRAY:
+        // the writer puts member types first, which also rules out cycles
+        if (rec[2] >= idx) {
+            RF_ERROR("Invalid array member type in binary rir");
+            break;
+        }
+        if ((member = rirb_type_get(rb, rec[2]))) {
+            t = rir_type_arr_get_or_create(
+                rb->rir,
+                member,
+                (int64_t)(rec[3] | ((uint64_t)rec[4] << 32)),
+                rec[1]
+            );
+        }
+        break;
+    default:
+        RF_ERROR("Invalid type category in binary rir");
+        break;
+    }
+    rb->types[idx] = t;
+    return t;
+}
+
+static bool rirb_read_type(struct rir_binary *rb,
+                           struct rirb_cursor *c,
+                           const struct rir_type **t)
+{
+    uint32_t idx;
+    return rirb_read(c, &idx) && (*t = rirb_type_get(rb, idx));
+}
+
+static struct rir_typedef *rirb_typedef_get(struct rir_binary *rb, uint32_t idx)
+{
+    struct rirb_cursor c;
+    struct RFstring name;
+    struct rir_type_arr args;
+    struct rir_type *t;
+    struct rir_typedef *def = NULL;
+    uint32_t is_union;
+    uint32_t num;
+    uint32_t tidx;
+    uint32_t i;
+    if (idx >= rb->hdr.typedefs.num) {
+        RF_ERROR("Invalid typedef index in binary rir");
+        return NULL;
+    }
+    if (rb->typedefs[idx]) {
+        return rb->typedefs[idx];
+    }
+    if (rb->typedefs_loading[idx]) {
+        RF_ERROR("Typedef in binary rir contains itself");
+        return NULL;
+    }
+    rb->typedefs_loading[idx] = true;
+    darray_init(args);
+    if (!rirb_cursor_init(rb, &c, rb->words[rb->hdr.typedefs.offset + idx], RIRB_NONE) ||
+        !rirb_read_string(rb, &c, &name) ||
+        !rirb_read(&c, &is_union) ||
+        !rirb_read(&c, &num)) {
+        goto end;
+    }
+    for (i = 0; i < num; ++i) {
+        if (!rirb_read(&c, &tidx) || !(t = rirb_type_get(rb, tidx))) {
+            goto end;
+        }
+        darray_append(args, t);
+    }
+    def = rir_typedef_create(rb->rir, NULL, &name, is_union, &args);
+
+end:
+    if (!def) {
+        darray_free(args);
+    }
+    rb->typedefs_loading[idx] = false;
+    rb->typedefs[idx] = def;
+    return def;
+}
+
+static bool rirb_constant_init(struct ast_constant *c, uint32_t kind, uint64_t bits)
+{
+    switch (kind) {
+    case CONSTANT_NUMBER_INTEGER:
+        c->value.integer = (int64_t)bits;
+        break;
+    case CONSTANT_NUMBER_FLOAT:
+        memcpy(&c->value.floating, &bits, sizeof(bits));
+        break;
+    case CONSTANT_BOOLEAN:
+        c->value.boolean = bits != 0;
+        break;
+    default:
+        RF_ERROR("Invalid constant in binary rir");
+        return false;
+    }
+    c->type = kind;
+    return true;
+}
+
+/**
+ * Read the part of a constant following its first word, which holds the
+ * constant's type index
+ */
+static bool rirb_read_constant(struct rir_binary *rb,
+                               struct rirb_cursor *c,
+                               uint32_t type_idx,
+                               struct ast_constant *cst,
+                               struct rir_type **t)
+{
+    uint32_t kind;
+    uint64_t bits;
+    if (!rirb_read(c, &kind) ||
+        !rirb_read64(c, &bits) ||
+        !rirb_constant_init(cst, kind, bits) ||
+        !(*t = rirb_type_get(rb, type_idx))) {
+        return false;
+    }
+    if (!rir_type_is_elementary(*t)) {
+        RF_ERROR("Constant of non elementary type in binary rir");
+        return false;
+    }
+    return true;
+}
+
+struct rirb_phi_fixup {
+    struct rir_expression *phi;
+    //! Position of the incoming values in the data
+    struct rirb_cursor c;
+    uint32_t num;
+};
+
+/**
+ * State of loading a function body
+ */
+struct rirb_body {
+    struct rir_binary *rb;
+    struct rir_fndef *fn;
+    struct rirb_cursor c;
+    //! Values by dense index
+    struct rir_value **values;
+    uint32_t values_num;
+    //! Number of values loaded so far. Only those can be referred to.
+    uint32_t loaded;
+    uint32_t blocks_num;
+    //! Index in @ref exprs of the first expression of each block
+    uint32_t *block_start;
+    //! Number of expressions of each block
+    uint32_t *block_count;
+    //! Expressions in block order
+    struct rir_expression **exprs;
+    uint32_t exprs_num;
+    //! Phis whose incoming values are read after all expressions are loaded
+    struct {darray(struct rirb_phi_fixup);} fixups;
+};
+
+static bool rirb_read_value(struct rirb_body *b,
+                            struct rirb_cursor *c,
+                            const struct rir_value **v)
+{
+    struct ast_constant cst;
+    struct rir_type *t;
+    struct rir_object *obj;
+    struct RFstring name;
+    uint32_t ref;
+    uint32_t idx;
+    if (!rirb_read(c, &ref)) {
+        return false;
+    }
+    if (ref == RIRB_NONE) {
+        *v = NULL;
+        return true;
+    }
+    idx = ref & RIRB_REF_MASK;
+    switch (ref >> RIRB_REF_SHIFT) {
+    case RIRB_REF_LOCAL:
+        if (idx >= b->loaded) {
+            RF_ERROR("Binary rir value used before its definition");
+            return false;
+        }
+        *v = b->values[idx];
+        return true;
+    case RIRB_REF_GLOBAL:
+        if (!rirb_string_get(b->rb, idx, &name)) {
+            return false;
+        }
+        obj = strmap_get(&b->rb->rir->map, &name);
+        if (!obj || obj->category != RIR_OBJ_GLOBAL) {
+            RF_ERROR("Unknown global \""RFS_PF"\" in binary rir", RFS_PA(&name));
+            return false;
+        }
+        *v = rir_object_value(obj);
+        return true;
+    case RIRB_REF_CONSTANT:
+        if (!rirb_read_constant(b->rb, c, idx, &cst, &t)) {
+            return false;
+        }
+        *v = rir_constantval_create_typed(&cst, t, b->rb->rir);
+        return *v != NULL;
+    }
+    RF_ERROR("Invalid value reference in binary rir");
+    return false;
+}
+
+static bool rirb_read_label(struct rirb_body *b,
+                            struct rirb_cursor *c,
+                            struct rir_value **label)
+{
+    uint32_t ref;
+    if (!rirb_read(c, &ref)) {
+        return false;
+    }
+    if (ref >= b->loaded || b->values[ref]->category != RIR_VALUE_LABEL) {
+        RF_ERROR("Invalid label reference in binary rir");
+        return false;
+    }
+    *label = b->values[ref];
+    return true;
+}
+
+/**
+ * Read a value that has to be present, as expression operands do
+ */
+static bool rirb_read_operand(struct rirb_body *b,
+                              struct rirb_cursor *c,
+                              const struct rir_value **v)
+{
+    if (!rirb_read_value(b, c, v)) {
+        return false;
+    }
+    if (!*v) {
+        RF_ERROR("Missing rir expression operand in binary rir");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Check the member index of an objmemberat or unionmemberat
+ */
+static bool rirb_check_member(const struct rir_value *v, uint32_t idx)
+{
+    if (!rir_type_is_composite(v->type) ||
+        idx >= darray_size(v->type->tdef->argument_types)) {
+        RF_ERROR("Invalid member access in binary rir");
+        return false;
+    }
+    return true;
+}
+
+static bool rirb_skip_value(struct rirb_cursor *c)
+{
+    uint32_t ref;
+    if (!rirb_read(c, &ref)) {
+        return false;
+    }
+    if (ref != RIRB_NONE && (ref >> RIRB_REF_SHIFT) == RIRB_REF_CONSTANT) {
+        // constant kind and the 64 bit value
+        if (c->end - c->pos < 3) {
+            RF_ERROR("Unexpected end of binary rir data");
+            return false;
+        }
+        c->pos += 3;
+    }
+    return true;
+}
+
+static bool rirb_read_valuearr(struct rirb_body *b, struct value_arr *arr)
+{
+    const struct rir_value *v;
+    uint32_t num;
+    uint32_t i;
+    if (!rirb_read(&b->c, &num)) {
+        return false;
+    }
+    for (i = 0; i < num; ++i) {
+        if (!rirb_read_operand(b, &b->c, &v)) {
+            return false;
+        }
+        darray_append(*arr, (struct rir_value*)v);
+    }
+    return true;
+}
+
+static bool rirb_read_expression_data(struct rirb_body *b, struct rir_expression *e)
+{
+    struct rirb_cursor *c = &b->c;
+    struct rirb_phi_fixup fixup;
+    struct ast_constant cst;
+    struct rir_type *t;
+    struct RFstring name;
+    uint32_t word;
+    uint32_t i;
+    uint64_t size;
+    switch (e->type) {
+    case RIR_EXPRESSION_CALL:
+        darray_init(e->call.args);
+        if (!rirb_read_string(b->rb, c, &name) || !rirb_read(c, &word)) {
+            return false;
+        }
+        // the return type of the call comes from the declaration
+        if (!rir_fndecl_byname(b->rb->rir, &name)) {
+            RF_ERROR("Call to unknown function \""RFS_PF"\" in binary rir", RFS_PA(&name));
+            return false;
+        }
+        e->call.foreign = word;
+        return rf_string_copy_in(&e->call.name, &name) &&
+            rirb_read_valuearr(b, &e->call.args);
+    case RIR_EXPRESSION_ALLOCA:
+        if (!rirb_read_type(b->rb, c, &e->alloca.type) || !rirb_read(c, &word)) {
+            return false;
+        }
+        e->alloca.alloc_location = word;
+        e->alloca.ast_id = NULL;
+        return true;
+    case RIR_EXPRESSION_RETURN:
+        return true;
+    case RIR_EXPRESSION_CONVERT:
+        return rirb_read_operand(b, c, &e->convert.val) &&
+            rirb_read_type(b->rb, c, &e->convert.type);
+    case RIR_EXPRESSION_WRITE:
+        return rirb_read_operand(b, c, &e->write.memory) &&
+            rirb_read_operand(b, c, &e->write.writeval);
+    case RIR_EXPRESSION_READ:
+        if (!rirb_read_operand(b, c, &e->read.memory)) {
+            return false;
+        }
+        if (!e->read.memory->type->is_pointer) {
+            RF_ERROR("Rir read from a location not in memory in binary rir");
+            return false;
+        }
+        return true;
+    case RIR_EXPRESSION_OBJMEMBERAT:
+        return rirb_read_operand(b, c, &e->objmemberat.objmemory) &&
+            rirb_read(c, &e->objmemberat.idx) &&
+            rirb_check_member(e->objmemberat.objmemory, e->objmemberat.idx);
+    case RIR_EXPRESSION_SETUNIONIDX:
+        return rirb_read_operand(b, c, &e->setunionidx.unimemory) &&
+            rirb_read_operand(b, c, &e->setunionidx.idx);
+    case RIR_EXPRESSION_GETUNIONIDX:
+        return rirb_read_operand(b, c, &e->getunionidx.unimemory);
+    case RIR_EXPRESSION_UNIONMEMBERAT:
+        return rirb_read_operand(b, c, &e->unionmemberat.unimemory) &&
+            rirb_read(c, &e->unionmemberat.idx) &&
+            rirb_check_member(e->unionmemberat.unimemory, e->unionmemberat.idx);
+    case RIR_EXPRESSION_OBJIDX:
+        if (!rirb_read_operand(b, c, &e->objidx.objmemory) ||
+            !rirb_read_operand(b, c, &e->objidx.idx)) {
+            return false;
+        }
+        if (!rir_type_is_array(e->objidx.objmemory->type)) {
+            RF_ERROR("Rir objidx on a non array value in binary rir");
+            return false;
+        }
+        return true;
+    case RIR_EXPRESSION_FIXEDARR:
+        darray_init(e->fixedarr.members);
+        if (!rirb_read_type(b->rb, c, &e->fixedarr.member_type) ||
+            !rirb_read64(c, &size)) {
+            return false;
+        }
+        e->fixedarr.size = size;
+        return rirb_read_valuearr(b, &e->fixedarr.members);
+    case RIR_EXPRESSION_FIXEDARRSIZE:
+        if (!rirb_read_operand(b, c, &e->fixedarrsize.array)) {
+            return false;
+        }
+        if (!rir_type_is_array(e->fixedarrsize.array->type)) {
+            RF_ERROR("Fixedarrsize of a non array value in binary rir");
+            return false;
+        }
+        // just like rir_fixedarrsize_create() the value is the constant size
+        return rir_constantval_init_fromint64(
+            &e->val,
+            b->rb->rir,
+            rir_type_array_size(e->fixedarrsize.array->type)
+        );
+    case RIR_EXPRESSION_CONSTANT:
+        if (!rirb_read(c, &word) ||
+            (word >> RIRB_REF_SHIFT) != RIRB_REF_CONSTANT ||
+            !rirb_read_constant(b->rb, c, word & RIRB_REF_MASK, &cst, &t)) {
+            return false;
+        }
+        return rir_value_static_constant_init(&e->val, &cst, t);
+    case RIR_EXPRESSION_ADD:
+    case RIR_EXPRESSION_SUB:
+    case RIR_EXPRESSION_MUL:
+    case RIR_EXPRESSION_DIV:
+    case RIR_EXPRESSION_CMP_EQ:
+    case RIR_EXPRESSION_CMP_NE:
+    case RIR_EXPRESSION_CMP_GE:
+    case RIR_EXPRESSION_CMP_GT:
+    case RIR_EXPRESSION_CMP_LE:
+    case RIR_EXPRESSION_CMP_LT:
+        if (!rirb_read_operand(b, c, &e->binaryop.a) ||
+            !rirb_read_operand(b, c, &e->binaryop.b)) {
+            return false;
+        }
+        if (!rir_type_is_elementary(e->binaryop.a->type)) {
+            RF_ERROR("Rir binary operation on a non elementary value in binary rir");
+            return false;
+        }
+        return true;
+    case RIR_EXPRESSION_PHI:
+        darray_init(e->phi.incoming);
+        if (!rirb_read_type(b->rb, c, &e->phi.type) || !rirb_read(c, &fixup.num)) {
+            return false;
+        }
+        // incoming values may be defined later so only remember where they are
+        fixup.phi = e;
+        fixup.c = *c;
+        for (i = 0; i < fixup.num; ++i) {
+            if (!rirb_skip_value(c) || !rirb_read(c, &word)) {
+                return false;
+            }
+        }
+        darray_append(b->fixups, fixup);
+        return true;
+    default:
+        break;
+    }
+    RF_ERROR("Unsupported rir expression of type %d in binary rir", e->type);
+    return false;
+}
+
+static bool rirb_load_expression(struct rirb_body *b)
+{
+    struct rir_object *obj;
+    struct rir_expression *e;
+    uint32_t type;
+    uint32_t block;
+    uint32_t pos;
+    uint32_t id;
+    uint32_t slot;
+    bool has_id;
+    bool ok;
+    if (!rirb_read(&b->c, &type) ||
+        !rirb_read(&b->c, &block) ||
+        !rirb_read(&b->c, &pos) ||
+        !rirb_read(&b->c, &id)) {
+        return false;
+    }
+    if (block >= b->blocks_num || pos >= b->block_count[block]) {
+        RF_ERROR("Invalid expression position in binary rir");
+        return false;
+    }
+    slot = b->block_start[block] + pos;
+    if (b->exprs[slot]) {
+        RF_ERROR("Two expressions at the same position in binary rir");
+        return false;
+    }
+    if (type >= RIR_EXPRESSION_PLACEHOLDER) {
+        RF_ERROR("Invalid expression type in binary rir");
+        return false;
+    }
+    // expressions that don't give a variable value have no id
+    has_id = type != RIR_EXPRESSION_WRITE &&
+        type != RIR_EXPRESSION_RETURN &&
+        type != RIR_EXPRESSION_SETUNIONIDX &&
+        type != RIR_EXPRESSION_CONSTANT &&
+        type != RIR_EXPRESSION_FIXEDARRSIZE;
+    if (has_id != (id != RIRB_NONE)) {
+        RF_ERROR("Invalid expression id in binary rir");
+        return false;
+    }
+
+    if (!(obj = rir_object_create(RIR_OBJ_EXPRESSION, b->rb->rir))) {
+        return false;
+    }
+    // on failure the object stays in the module's object list and gets
+    // destroyed along with it, so the type is needed to deinit it properly
+    e = &obj->expr;
+    e->type = type;
+    if (!rirb_read_expression_data(b, e)) {
+        return false;
+    }
+    if (type != RIR_EXPRESSION_CONSTANT && type != RIR_EXPRESSION_FIXEDARRSIZE) {
+        RFS_PUSH();
+        if (has_id) {
+            rir_pctx_set_id(&b->rb->ctx, RFS("$%"PRIu32, id));
+        }
+        ok = rir_object_expression_init(obj, type, RIRPOS_PARSE, &b->rb->ctx);
+        if (has_id) {
+            rir_pctx_reset_id(&b->rb->ctx);
+        }
+        RFS_POP();
+        if (!ok) {
+            return false;
+        }
+    }
+    if (e->val.category == RIR_VALUE_VARIABLE) {
+        if (b->loaded == b->values_num) {
+            RF_ERROR("More values than expected in binary rir function");
+            return false;
+        }
+        b->values[b->loaded++] = &e->val;
+    }
+    b->exprs[slot] = e;
+    return true;
+}
+
+static bool rirb_load_phi_incoming(struct rirb_body *b, struct rirb_phi_fixup *fixup)
+{
+    const struct rir_value *val;
+    struct rir_value *label;
+    uint32_t i;
+    for (i = 0; i < fixup->num; ++i) {
+        if (!rirb_read_operand(b, &fixup->c, &val) ||
+            !rirb_read_label(b, &fixup->c, &label)) {
+            return false;
+        }
+        rir_phi_add_incoming(&fixup->phi->phi, val, label);
+    }
+    return true;
+}
+
+static bool rirb_load_exit(struct rirb_body *b, struct rir_block *block)
+{
+    const struct rir_value *cond;
+    const struct rir_value *val;
+    struct rir_value *taken;
+    struct rir_value *fallthrough;
+    uint32_t type;
+    uint32_t num;
+    uint32_t i;
+    if (!rirb_read(&b->c, &type)) {
+        return false;
+    }
+    switch (type) {
+    case RIR_BLOCK_EXIT_INVALID:
+        return true;
+    case RIR_BLOCK_EXIT_BRANCH:
+        return rirb_read_label(b, &b->c, &taken) &&
+            rir_block_exit_init_branch(&block->exit, taken);
+    case RIR_BLOCK_EXIT_CONDBRANCH:
+        return rirb_read_operand(b, &b->c, &cond) &&
+            rirb_read_label(b, &b->c, &taken) &&
+            rirb_read_label(b, &b->c, &fallthrough) &&
+            rir_block_exit_init_condbranch(&block->exit, cond, taken, fallthrough);
+    case RIR_BLOCK_EXIT_SWITCH:
+        if (!rirb_read_operand(b, &b->c, &cond) ||
+            !rirb_read_label(b, &b->c, &fallthrough) ||
+            !rirb_read(&b->c, &num) ||
+            !rir_block_exit_init_switch(&block->exit, cond, fallthrough)) {
+            return false;
+        }
+        for (i = 0; i < num; ++i) {
+            if (!rirb_read_operand(b, &b->c, &val) ||
+                !rirb_read_label(b, &b->c, &taken)) {
+                return false;
+            }
+            rir_switch_add_case(&block->exit.switchbr, val, taken);
+        }
+        return true;
+    case RIR_BLOCK_EXIT_RETURN:
+        if (!rirb_read_value(b, &b->c, &val)) {
+            return false;
+        }
+        rir_block_exit_return_init(&block->exit, val);
+        return true;
+    }
+    RF_ERROR("Invalid block exit in binary rir");
+    return false;
+}
+
+static bool rirb_load_blocks(struct rirb_body *b)
+{
+    struct RFstring label;
+    struct rir_block *block;
+    uint32_t start = 0;
+    uint32_t i;
+    for (i = 0; i < b->blocks_num; ++i) {
+        if (!rirb_read_string(b->rb, &b->c, &label) ||
+            !rirb_read(&b->c, &b->block_count[i])) {
+            return false;
+        }
+        if (b->block_count[i] > b->exprs_num - start) {
+            RF_ERROR("Invalid block size in binary rir");
+            return false;
+        }
+        b->block_start[i] = start;
+        start += b->block_count[i];
+        if (!(block = rir_block_create(&label, RIRPOS_PARSE, &b->rb->ctx))) {
+            return false;
+        }
+        rir_fndef_add_block(b->fn, block);
+        b->values[b->loaded++] = &block->label;
+    }
+    if (start != b->exprs_num) {
+        RF_ERROR("Block sizes don't add up in binary rir");
+        return false;
+    }
+    return true;
+}
+
+static bool rirb_load_body(struct rir_binary *rb, uint32_t fn_idx)
+{
+    const uint32_t *rec = rb->words + rb->hdr.functions.offset + fn_idx * RIRB_FUNCTION_WORDS;
+    struct rirb_body b;
+    struct rir_object **var;
+    struct rirb_phi_fixup *fixup;
+    uint32_t i;
+    uint32_t j;
+    bool ret = false;
+    RF_STRUCT_ZERO(&b);
+    b.rb = rb;
+    b.fn = rb->pending[fn_idx];
+    rb->pending[fn_idx] = NULL;
+    darray_init(b.fixups);
+    if (!rirb_cursor_init(rb, &b.c, rec[5], rec[6]) ||
+        !rirb_read(&b.c, &b.values_num) ||
+        !rirb_read(&b.c, &b.blocks_num) ||
+        !rirb_read(&b.c, &b.exprs_num)) {
+        return false;
+    }
+    // every block and expression takes up words so this bounds the allocations
+    if (b.blocks_num > rec[6] || b.exprs_num > rec[6] ||
+        b.values_num > darray_size(b.fn->variables) + 1 + b.blocks_num + b.exprs_num) {
+        RF_ERROR("Invalid function section in binary rir");
+        return false;
+    }
+    RF_CALLOC(b.values, b.values_num + 1, sizeof(*b.values), return false);
+    RF_CALLOC(b.block_start, b.blocks_num + 1, sizeof(*b.block_start), goto end);
+    RF_CALLOC(b.block_count, b.blocks_num + 1, sizeof(*b.block_count), goto end);
+    RF_CALLOC(b.exprs, b.exprs_num + 1, sizeof(*b.exprs), goto end);
+
+    rir_data_curr_fn(&rb->ctx) = b.fn;
+    darray_foreach(var, b.fn->variables) {
+        if (b.loaded < b.values_num) {
+            b.values[b.loaded++] = rir_object_value(*var);
+        }
+    }
+    if (b.fn->retslot_val && b.loaded < b.values_num) {
+        b.values[b.loaded++] = b.fn->retslot_val;
+    }
+    if (b.loaded + b.blocks_num > b.values_num) {
+        RF_ERROR("Invalid number of values in binary rir function");
+        goto end;
+    }
+    if (!rirb_load_blocks(&b)) {
+        goto end;
+    }
+    for (i = 0; i < b.exprs_num; ++i) {
+        if (!rirb_load_expression(&b)) {
+            goto end;
+        }
+    }
+    if (b.loaded != b.values_num) {
+        RF_ERROR("Fewer values than expected in binary rir function");
+        goto end;
+    }
+    // every slot is filled since positions are unique and as many as the slots
+    for (i = 0; i < b.blocks_num; ++i) {
+        for (j = 0; j < b.block_count[i]; ++j) {
+            rir_block_add_expr(
+                darray_item(b.fn->blocks, i),
+                b.exprs[b.block_start[i] + j]
+            );
+        }
+        if (!rirb_load_exit(&b, darray_item(b.fn->blocks, i))) {
+            goto end;
+        }
+    }
+    darray_foreach(fixup, b.fixups) {
+        if (!rirb_load_phi_incoming(&b, fixup)) {
+            goto end;
+        }
+    }
+    ret = true;
+
+end:
+    if (!ret) {
+        RF_ERROR("Failed to load function \""RFS_PF"\" from binary rir", RFS_PA(&b.fn->decl.name));
+    }
+    rir_data_curr_fn(&rb->ctx) = NULL;
+    rir_data_curr_block(&rb->ctx) = NULL;
+    darray_free(b.fixups);
+    free(b.values);
+    free(b.block_start);
+    free(b.block_count);
+    free(b.exprs);
+    return ret;
+}
+
+static bool rirb_load_function(struct rir_binary *rb, uint32_t idx)
+{
+    const uint32_t *rec = rb->words + rb->hdr.functions.offset + idx * RIRB_FUNCTION_WORDS;
+    struct RFstring name;
+    struct rir_type_arr args;
+    struct rir_type *return_type;
+    struct rir_type *t;
+    struct rir_fndecl *decl;
+    struct rir_fndef *def;
+    struct rirb_cursor c;
+    uint32_t tidx;
+    uint32_t i;
+    darray_init(args);
+    if (!rirb_string_get(rb, rec[0], &name) ||
+        !(return_type = rirb_type_get(rb, rec[2])) ||
+        !rirb_cursor_init(rb, &c, rec[4], rec[3])) {
+        goto fail;
+    }
+    for (i = 0; i < rec[3]; ++i) {
+        if (!rirb_read(&c, &tidx) || !(t = rirb_type_get(rb, tidx))) {
+            goto fail;
+        }
+        darray_append(args, t);
+    }
+    if (rec[1]) {
+        if (!(decl = rir_fndecl_create(&name, &args, return_type, true, RIRPOS_PARSE, &rb->ctx))) {
+            goto fail;
+        }
+        rf_ilist_add_tail(&rb->rir->functions, &decl->ln);
+        return true;
+    }
+
+    RF_MALLOC(def, sizeof(*def), goto fail);
+    RF_STRUCT_ZERO(def);
+    // set the function first so that its arguments go into its own map
+    rir_data_curr_fn(&rb->ctx) = def;
+    if (!rir_fndecl_init(&def->decl, &name, &args, return_type, false, RIRPOS_PARSE, &rb->ctx)) {
+        free(def);
+        goto fail;
+    }
+    if (!rir_fndef_init_no_decl(def, RIRPOS_PARSE, &rb->ctx)) {
+        rir_fndef_destroy(def);
+        return false;
+    }
+    rir_data_curr_fn(&rb->ctx) = NULL;
+    rf_ilist_add_tail(&rb->rir->functions, &def->decl.ln);
+    rb->pending[idx] = def;
+    return true;
+
+fail:
+    rir_data_curr_fn(&rb->ctx) = NULL;
+    darray_free(args);
+    return false;
+}
+
+static bool rirb_load_globals(struct rir_binary *rb)
+{
+    const uint32_t *rec;
+    struct RFstring name;
+    struct RFstring literal;
+    struct rir_type *t;
+    uint32_t i;
+    for (i = 0; i < rb->hdr.globals.num; ++i) {
+        rec = rb->words + rb->hdr.globals.offset + i * RIRB_GLOBAL_WORDS;
+        if (!rirb_string_get(rb, rec[0], &name) ||
+            !(t = rirb_type_get(rb, rec[1])) ||
+            !rirb_string_get(rb, rec[2], &literal) ||
+            !rir_global_create_string(t, &name, &literal, rb->rir)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool rirb_load_typedefs(struct rir_binary *rb)
+{
+    uint32_t i;
+    for (i = 0; i < rb->hdr.typedefs.num; ++i) {
+        if (!rirb_typedef_get(rb, i)) {
+            return false;
+        }
+    }
+    // typedefs got appended in the order they were needed so restore the
+    // order of the typedef table
+    for (i = 0; i < rb->hdr.typedefs.num; ++i) {
+        rf_ilist_delete_from(&rb->rir->typedefs, &rb->typedefs[i]->ln);
+        rf_ilist_add_tail(&rb->rir->typedefs, &rb->typedefs[i]->ln);
+    }
+    return true;
+}
+
+static bool rirb_load_deps(struct rir_binary *rb, const struct rir_arr *deps)
+{
+    struct RFstring name;
+    struct rir **dep;
+    struct rir *found;
+    uint32_t i;
+    for (i = 0; i < rb->hdr.deps.num; ++i) {
+        if (!rirb_string_get(rb, rb->words[rb->hdr.deps.offset + i], &name)) {
+            return false;
+        }
+        found = NULL;
+        if (deps) {
+            darray_foreach(dep, *deps) {
+                if (rf_string_equal(&(*dep)->name, &name)) {
+                    found = *dep;
+                    break;
+                }
+            }
+        }
+        if (!found) {
+            RF_ERROR("Binary rir depends on missing module \""RFS_PF"\"", RFS_PA(&name));
+            return false;
+        }
+        darray_append(rb->rir->dependencies, found);
+    }
+    return true;
+}
+
+static bool rirb_section_check(const struct rir_binary *rb,
+                               const struct rirb_section *s,
+                               uint64_t words)
+{
+    if (s->offset < RIRB_HEADER_WORDS || s->offset + words > rb->size) {
+        RF_ERROR("Binary rir section out of bounds");
+        return false;
+    }
+    return true;
+}
+
+static bool rirb_header_check(struct rir_binary *rb)
+{
+    const struct rirb_header *h = &rb->hdr;
+    const uint32_t *offsets;
+    uint32_t i;
+    if (rb->bytes % sizeof(uint32_t) != 0 ||
+        rb->bytes < sizeof(*h) ||
+        rb->bytes / sizeof(uint32_t) > UINT32_MAX) {
+        RF_ERROR("Invalid binary rir size");
+        return false;
+    }
+    memcpy(&rb->hdr, rb->words, sizeof(rb->hdr));
+    if (h->magic != RIRB_MAGIC) {
+        RF_ERROR("Not a binary rir file");
+        return false;
+    }
+    if (h->byte_order != RIRB_BYTE_ORDER) {
+        RF_ERROR("Binary rir was written on a host of different byte order");
+        return false;
+    }
+    if (h->version != RIR_BINARY_VERSION) {
+        RF_ERROR("Unsupported binary rir version %u", h->version);
+        return false;
+    }
+    if (h->size != rb->size) {
+        RF_ERROR("Binary rir size does not match its header");
+        return false;
+    }
+    if (!rirb_section_check(rb, &h->strings, (uint64_t)h->strings.num + 1) ||
+        !rirb_section_check(rb, &h->blob, ((uint64_t)h->blob.num + 3) / 4) ||
+        !rirb_section_check(rb, &h->types, (uint64_t)h->types.num * RIRB_TYPE_WORDS) ||
+        !rirb_section_check(rb, &h->typedefs, h->typedefs.num) ||
+        !rirb_section_check(rb, &h->globals, (uint64_t)h->globals.num * RIRB_GLOBAL_WORDS) ||
+        !rirb_section_check(rb, &h->functions, (uint64_t)h->functions.num * RIRB_FUNCTION_WORDS) ||
+        !rirb_section_check(rb, &h->deps, h->deps.num) ||
+        !rirb_section_check(rb, &h->data, h->data.num)) {
+        return false;
+    }
+    // validate the string table once so that strings can be read unchecked
+    offsets = rb->words + h->strings.offset;
+    if (offsets[0] != 0 || offsets[h->strings.num] != h->blob.num) {
+        RF_ERROR("Invalid binary rir string table");
+        return false;
+    }
+    for (i = 0; i < h->strings.num; ++i) {
+        if (offsets[i] > offsets[i + 1]) {
+            RF_ERROR("Invalid binary rir string table");
+            return false;
+        }
+    }
+    return true;
+}
+
+static void rirb_free(struct rir_binary *rb)
+{
+    if (rb->mapped) {
+        munmap((void*)rb->words, rb->bytes);
+    }
+    free(rb->types);
+    free(rb->typedefs);
+    free(rb->typedefs_loading);
+    free(rb->pending);
+    free(rb);
+}
+
+static struct rir_binary *rirb_open(const void *data,
+                                    size_t bytes,
+                                    bool mapped,
+                                    const struct rir_arr *deps)
+{
+    struct rir_binary *rb;
+    struct RFstring name;
+    uint32_t i;
+    RF_CALLOC(rb, 1, sizeof(*rb), return NULL);
+    rb->words = data;
+    rb->bytes = bytes;
+    rb->size = bytes / sizeof(uint32_t);
+    rb->mapped = mapped;
+    if (!rirb_header_check(rb)) {
+        goto fail;
+    }
+    RF_CALLOC(rb->types, rb->hdr.types.num + 1, sizeof(*rb->types), goto fail);
+    RF_CALLOC(rb->typedefs, rb->hdr.typedefs.num + 1, sizeof(*rb->typedefs), goto fail);
+    RF_CALLOC(rb->typedefs_loading, rb->hdr.typedefs.num + 1, sizeof(*rb->typedefs_loading), goto fail);
+    RF_CALLOC(rb->pending, rb->hdr.functions.num + 1, sizeof(*rb->pending), goto fail);
+    if (!(rb->rir = rir_create())) {
+        goto fail;
+    }
+    rir_pctx_init(&rb->ctx, rb->rir);
+    if (!rirb_string_get(rb, rb->hdr.name, &name) ||
+        !rf_string_copy_in(&rb->rir->name, &name) ||
+        !rirb_load_deps(rb, deps) ||
+        !rirb_load_typedefs(rb) ||
+        !rirb_load_globals(rb)) {
+        goto fail;
+    }
+    for (i = 0; i < rb->hdr.functions.num; ++i) {
+        if (!rirb_load_function(rb, i)) {
+            goto fail;
+        }
+    }
+    return rb;
+
+fail:
+    if (rb->rir) {
+        rir_destroy(rb->rir);
+    }
+    rirb_free(rb);
+    return NULL;
+}
+
+struct rir_binary *rir_binary_open_buffer(const void *data,
+                                          size_t size,
+                                          const struct rir_arr *deps)
+{
+    RF_ASSERT(((uintptr_t)data) % sizeof(uint32_t) == 0, "Binary rir buffer should be aligned");
+    return rirb_open(data, size, false, deps);
+}
+
+struct rir_binary *rir_binary_open(const struct RFstring *path, const struct rir_arr *deps)
+{
+    struct rir_binary *rb = NULL;
+    struct stat st;
+    void *addr;
+    int fd;
+    RFS_PUSH();
+    fd = open(rf_string_data(RFS_NT_OR_DIE(RFS_PF, RFS_PA(path))), O_RDONLY);
+    RFS_POP();
+    if (fd == -1) {
+        RF_ERROR("Could not open binary rir file \""RFS_PF"\"", RFS_PA(path));
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        RF_ERROR("Could not get the size of binary rir file \""RFS_PF"\"", RFS_PA(path));
+        goto end;
+    }
+    // the loaded rir copies everything it needs so the mapping can be private
+    // and read only. It stays around only until all bodies are materialized.
+    addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        RF_ERROR("Could not map binary rir file \""RFS_PF"\"", RFS_PA(path));
+        goto end;
+    }
+    rb = rirb_open(addr, st.st_size, true, deps);
+
+end:
+    close(fd);
+    return rb;
+}
+
+void rir_binary_close(struct rir_binary *rb)
+{
+    rirb_free(rb);
+}
+
+struct rir *rir_binary_rir(const struct rir_binary *rb)
+{
+    return rb->rir;
+}
+
+bool rir_binary_materialize(struct rir_binary *rb, struct rir_fndef *fn)
+{
+    uint32_t i;
+    for (i = 0; i < rb->hdr.functions.num; ++i) {
+        if (rb->pending[i] == fn) {
+            return rirb_load_body(rb, i);
+        }
+    }
+    return true;
+}
+
+bool rir_binary_materialize_all(struct rir_binary *rb)
+{
+    uint32_t i;
+    for (i = 0; i < rb->hdr.functions.num; ++i) {
+        if (rb->pending[i] && !rirb_load_body(rb, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct rir *rir_binary_load(const struct RFstring *path, const struct rir_arr *deps)
+{
+    struct rir *r;
+    struct rir_binary *rb = rir_binary_open(path, deps);
+    if (!rb) {
+        return NULL;
+    }
+    r = rir_binary_rir(rb);
+    if (!rir_binary_materialize_all(rb)) {
+        rir_destroy(r);
+        r = NULL;
+    }
+    rir_binary_close(rb);
+    return r;
+}
@@ -99,7 +99,7 @@ struct rir_object *rir_binaryop_create_nonast_obj(
 {
     struct rir_object *ret = rir_object_create(RIR_OBJ_EXPRESSION, rir_data_rir(data));
     if (!ret) {
-        goto fail;
+        return NULL;
     }
     if (!rir_binaryop_init(&ret->expr.binaryop, a, b, pos, data)) {
         goto fail;
@@ -110,7 +110,7 @@ struct rir_object *rir_binaryop_create_nonast_obj(
     return ret;
 
 fail:
-    free(ret);
+    rir_object_free(ret, rir_data_rir(data));
     return NULL;
 }
 
@@ -22,6 +22,7 @@ static const struct RFstring rir_blockexit_type_strings[] = {
     [RIR_BLOCK_EXIT_BRANCH] = RF_STRING_STATIC_INIT("branch"),
     [RIR_BLOCK_EXIT_CONDBRANCH] = RF_STRING_STATIC_INIT("condbranch"),
     [RIR_BLOCK_EXIT_RETURN] = RF_STRING_STATIC_INIT("return"),
+    [RIR_BLOCK_EXIT_SWITCH] = RF_STRING_STATIC_INIT("switch"),
 };
 const struct RFstring *rir_blockexit_type_str(enum rir_block_exit_type type)
 {
@@ -45,6 +46,14 @@ bool rir_block_exit_init_condbranch(struct rir_block_exit *exit,
     return rir_condbranch_init(&exit->condbranch, cond, taken, fallthrough);
 }
 
+bool rir_block_exit_init_switch(struct rir_block_exit *exit,
+                                const struct rir_value *cond,
+                                struct rir_value *fallthrough)
+{
+    exit->type = RIR_BLOCK_EXIT_SWITCH;
+    return rir_switch_init(&exit->switchbr, cond, fallthrough);
+}
+
 static inline void rir_block_exit_deinit(struct rir_block_exit *exit)
 {
     switch (exit->type) {
@@ -54,6 +63,9 @@ static inline void rir_block_exit_deinit(struct rir_block_exit *exit)
     case RIR_BLOCK_EXIT_CONDBRANCH:
         rir_condbranch_deinit(&exit->condbranch);
         break;
+    case RIR_BLOCK_EXIT_SWITCH:
+        rir_switch_deinit(&exit->switchbr);
+        break;
     case RIR_BLOCK_EXIT_INVALID:
         // if we come here during EXIT_INVALID, it means parsing failed
     case RIR_BLOCK_EXIT_RETURN:
@@ -88,6 +100,11 @@ static bool rir_blockexit_tostring(struct rirtostr_ctx *ctx, const struct rir_bl
             goto end;
         }
         break;
+    case RIR_BLOCK_EXIT_SWITCH:
+        if (!rir_switch_tostring(ctx, &exitb->switchbr)) {
+            goto end;
+        }
+        break;
     case RIR_BLOCK_EXIT_RETURN:
         if (exitb->retstmt.val) {
             if (!rf_stringx_append(
@@ -385,7 +402,7 @@ static struct rir_object *rir_block_matchcase_create_obj(const struct ast_node *
 {
     struct rir_object *ret = rir_object_create(RIR_OBJ_BLOCK, rir_ctx_rir(ctx));
     if (!ret) {
-        goto fail;
+        return NULL;
     }
     struct rir_block *b = &ret->block;
     if (!rir_block_init_from_ast_common(ret, BLOCK_POSITION_NORMAL, ctx)) {
@@ -410,7 +427,7 @@ static struct rir_object *rir_block_matchcase_create_obj(const struct ast_node *
     return ret;
 
 fail:
-    free(ret);
+    rir_object_free(ret, rir_ctx_rir(ctx));
     return NULL;
 }
 
@@ -501,7 +518,7 @@ i_INLINE_INS bool rir_block_exit_initialized(const struct rir_block *b);
 
 bool rir_block_is_first(const struct rir_block *b)
 {
-    return rf_string_equal(&b->label.id, &g_str_fnstart);
+    return rf_string_equal(&b->label.name, &g_str_fnstart);
 }
 
 i_INLINE_INS void rir_block_add_expr(struct rir_block *b, struct rir_expression *e);
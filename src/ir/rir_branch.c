@@ -10,6 +10,7 @@
 bool rir_branch_init(struct rir_branch *b, struct rir_value *dst)
 {
     b->dst = dst;
+    b->vectorize = false;
     return true;
 }
 
@@ -103,3 +104,57 @@ bool rir_condbranch_tostring(struct rirtostr_ctx *ctx, const struct rir_condbran
     RFS_POP();
     return ret;
 }
+
+bool rir_switch_init(struct rir_switch *sw,
+                     const struct rir_value *cond,
+                     struct rir_value *fallthrough)
+{
+    sw->cond = cond;
+    sw->fallthrough = fallthrough;
+    darray_init(sw->cases);
+    return true;
+}
+
+void rir_switch_add_case(struct rir_switch *sw,
+                         const struct rir_value *val,
+                         struct rir_value *dst)
+{
+    struct rir_switch_case c = {.val = val, .dst = dst};
+    darray_append(sw->cases, c);
+}
+
+void rir_switch_deinit(struct rir_switch *sw)
+{
+    darray_free(sw->cases);
+}
+
+i_INLINE_INS unsigned rir_switch_cases_num(const struct rir_switch *sw);
+
+bool rir_switch_tostring(struct rirtostr_ctx *ctx, const struct rir_switch *sw)
+{
+    struct rir_switch_case *c;
+    bool ret = false;
+    RFS_PUSH();
+    if (!rf_stringx_append(
+            ctx->rir->buff,
+            RFS(RIRTOSTR_INDENT"switch("RFS_PF", %%"RFS_PF,
+                RFS_PA(rir_value_string(sw->cond)),
+                RFS_PA(rir_value_string(sw->fallthrough)))
+        )) {
+        goto end;
+    }
+    darray_foreach(c, sw->cases) {
+        if (!rf_stringx_append(
+                ctx->rir->buff,
+                RFS(", "RFS_PF", %%"RFS_PF,
+                    RFS_PA(rir_value_string(c->val)),
+                    RFS_PA(rir_value_string(c->dst)))
+            )) {
+            goto end;
+        }
+    }
+    ret = rf_stringx_append_cstr(ctx->rir->buff, ")\n");
+end:
+    RFS_POP();
+    return ret;
+}
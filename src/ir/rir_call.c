@@ -214,7 +214,7 @@ struct rir_object *rir_call_create_obj(
     return ret;
 
 fail:
-    free(ret);
+    rir_object_free(ret, rir_data_rir(data));
     return NULL;
 }
 
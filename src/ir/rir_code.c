@@ -0,0 +1,250 @@
+#include <ir/rir_code.h>
+
+#include <rfbase/datastructs/intrusive_list.h>
+#include <rfbase/utils/sanity.h>
+
+#include <ir/rir.h>
+#include <ir/rir_block.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_object.h>
+#include <ir/rir_value.h>
+
+#include "passes/rir_pass_utils.h"
+
+i_INLINE_INS const struct rir_value *rir_code_value(const struct rir_code *c, uint32_t idx);
+i_INLINE_INS const uint32_t *rir_instr_ops(const struct rir_code *c,
+                                           const struct rir_instr *i);
+i_INLINE_INS const struct rir_value *rir_instr_operand(const struct rir_code *c,
+                                                       const struct rir_instr *i,
+                                                       unsigned n);
+i_INLINE_INS bool rir_instr_is_dead(const struct rir_instr *i);
+
+static bool rir_code_is_var(const struct rir_code *c, const struct rir_value *v)
+{
+    return v->category == RIR_VALUE_VARIABLE &&
+        v->id < c->vars_num &&
+        darray_item(c->values, v->id) == v;
+}
+
+/**
+ * @return The index of @a v in the value table, adding it if it's not a
+ *         variable of the function
+ */
+static uint32_t rir_code_value_idx(struct rir_code *c, const struct rir_value *v)
+{
+    if (rir_code_is_var(c, v)) {
+        return v->id;
+    }
+    darray_append(c->values, v);
+    return darray_size(c->values) - 1;
+}
+
+static void rir_code_count_cb(const struct rir_value **operand, unsigned *count)
+{
+    (void)operand;
+    ++*count;
+}
+
+struct rir_code_fill_ctx {
+    struct rir_code *c;
+    //! Where the next operand of the user goes in the dense form
+    uint32_t *slot;
+    uint32_t user;
+};
+
+static void rir_code_fill_cb(const struct rir_value **operand, struct rir_code_fill_ctx *fctx)
+{
+    struct rir_code *c = fctx->c;
+    struct rir_use use;
+    uint32_t idx = rir_code_value_idx(c, *operand);
+    *fctx->slot = idx;
+    if (idx < c->vars_num) {
+        use.operand = operand;
+        use.slot = fctx->slot;
+        use.user = fctx->user;
+        use.next = darray_item(c->first_use, idx);
+        darray_item(c->first_use, idx) = darray_size(c->uses);
+        ++darray_item(c->uses_num, idx);
+        darray_append(c->uses, use);
+    }
+    ++fctx->slot;
+}
+
+bool rir_code_init(struct rir_code *c, struct rir_fndef *fn)
+{
+    struct rir_block **b;
+    struct rir_expression *e;
+    struct rir_object **obj;
+    struct rir_instr *instr;
+    struct rir_code_block *cb;
+    struct rir_code_fill_ctx fctx;
+    uint32_t instrs_num = 0;
+    uint32_t extra_num = 0;
+    uint32_t i;
+    unsigned ops_num;
+    c->fn = fn;
+    c->vars_num = darray_size(fn->values);
+    darray_init(c->instrs);
+    darray_init(c->blocks);
+    darray_init(c->extra_ops);
+    darray_init(c->values);
+    darray_init(c->defs);
+    darray_init(c->first_use);
+    darray_init(c->uses_num);
+    darray_init(c->uses);
+
+    darray_foreach(obj, fn->values) {
+        darray_append(c->values, *obj ? rir_object_value(*obj) : NULL);
+        darray_append(c->defs, RIR_CODE_NONE);
+        darray_append(c->first_use, RIR_CODE_NONE);
+        darray_append(c->uses_num, 0);
+    }
+    // size the arrays up front since uses point into them
+    darray_foreach(b, fn->blocks) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            ops_num = 0;
+            rir_expression_foreach_operand(e, (rir_operand_cb)rir_code_count_cb, &ops_num);
+            if (ops_num > RIR_INSTR_INLINE_OPS) {
+                extra_num += ops_num;
+            }
+            ++instrs_num;
+        }
+    }
+    darray_resize(c->instrs, instrs_num);
+    darray_resize(c->extra_ops, extra_num);
+    darray_resize(c->blocks, darray_size(fn->blocks));
+
+    fctx.c = c;
+    instrs_num = 0;
+    extra_num = 0;
+    for (i = 0; i < darray_size(fn->blocks); ++i) {
+        cb = &darray_item(c->blocks, i);
+        cb->block = darray_item(fn->blocks, i);
+        cb->first = instrs_num;
+        cb->num = 0;
+        rf_ilist_for_each(&cb->block->expressions, e, ln) {
+            instr = &darray_item(c->instrs, instrs_num);
+            instr->op = e->type;
+            instr->block = i;
+            instr->expr = e;
+            ops_num = 0;
+            rir_expression_foreach_operand(e, (rir_operand_cb)rir_code_count_cb, &ops_num);
+            instr->ops_num = ops_num;
+            if (ops_num > RIR_INSTR_INLINE_OPS) {
+                instr->ops[0] = extra_num;
+                fctx.slot = &darray_item(c->extra_ops, extra_num);
+                extra_num += ops_num;
+            } else {
+                fctx.slot = instr->ops;
+            }
+            fctx.user = instrs_num;
+            rir_expression_foreach_operand(e, (rir_operand_cb)rir_code_fill_cb, &fctx);
+            if (rir_code_is_var(c, &e->val)) {
+                darray_item(c->defs, e->val.id) = instrs_num;
+            }
+            ++instrs_num;
+            ++cb->num;
+        }
+        // block exits have at most one operand
+        cb->exit_op = RIR_CODE_NONE;
+        fctx.slot = &cb->exit_op;
+        fctx.user = RIR_CODE_EXIT_USER | i;
+        rir_block_exit_foreach_operand(cb->block, (rir_operand_cb)rir_code_fill_cb, &fctx);
+    }
+    return true;
+}
+
+void rir_code_deinit(struct rir_code *c)
+{
+    darray_free(c->instrs);
+    darray_free(c->blocks);
+    darray_free(c->extra_ops);
+    darray_free(c->values);
+    darray_free(c->defs);
+    darray_free(c->first_use);
+    darray_free(c->uses_num);
+    darray_free(c->uses);
+}
+
+uint32_t rir_code_uses_num(const struct rir_code *c, const struct rir_value *v)
+{
+    return rir_code_is_var(c, v) ? darray_item(c->uses_num, v->id) : 0;
+}
+
+struct rir_instr *rir_code_def(const struct rir_code *c, const struct rir_value *v)
+{
+    uint32_t idx;
+    if (!rir_code_is_var(c, v) || (idx = darray_item(c->defs, v->id)) == RIR_CODE_NONE) {
+        return NULL;
+    }
+    return &darray_item(c->instrs, idx);
+}
+
+bool rir_code_replace_uses(struct rir_code *c,
+                           const struct rir_value *from,
+                           const struct rir_value *to)
+{
+    struct rir_use *use;
+    uint32_t u;
+    uint32_t next;
+    uint32_t to_idx;
+    if (!rir_code_is_var(c, from)) {
+        RF_ERROR("Only uses of variables of the function can be replaced");
+        return false;
+    }
+    if (from == to) {
+        return true;
+    }
+    to_idx = rir_code_value_idx(c, to);
+    for (u = darray_item(c->first_use, from->id); u != RIR_CODE_NONE; u = next) {
+        use = &darray_item(c->uses, u);
+        next = use->next;
+        if (!use->operand) {
+            // the user got killed
+            continue;
+        }
+        *use->operand = to;
+        *use->slot = to_idx;
+        if (to_idx < c->vars_num) {
+            use->next = darray_item(c->first_use, to_idx);
+            darray_item(c->first_use, to_idx) = u;
+            ++darray_item(c->uses_num, to_idx);
+        }
+    }
+    darray_item(c->first_use, from->id) = RIR_CODE_NONE;
+    darray_item(c->uses_num, from->id) = 0;
+    return true;
+}
+
+void rir_code_kill(struct rir_code *c, struct rir_instr *i, struct rir *r)
+{
+    const uint32_t *ops = rir_instr_ops(c, i);
+    uint32_t instr_idx = i - c->instrs.item;
+    struct rir_use *use;
+    struct rir_code_block *cb = &darray_item(c->blocks, i->block);
+    uint32_t u;
+    unsigned n;
+    RF_ASSERT(!rir_instr_is_dead(i), "Tried to kill an instruction twice");
+    RF_ASSERT(rir_code_uses_num(c, &i->expr->val) == 0, "Killed an instruction whose value is used");
+    // drop the uses of the instruction's operands
+    for (n = 0; n < i->ops_num; ++n) {
+        if (ops[n] >= c->vars_num) {
+            continue;
+        }
+        for (u = darray_item(c->first_use, ops[n]); u != RIR_CODE_NONE; u = use->next) {
+            use = &darray_item(c->uses, u);
+            if (use->operand && use->user == instr_idx) {
+                use->operand = NULL;
+                --darray_item(c->uses_num, ops[n]);
+                break;
+            }
+        }
+    }
+    if (rir_code_is_var(c, &i->expr->val)) {
+        darray_item(c->defs, i->expr->val.id) = RIR_CODE_NONE;
+        darray_item(c->values, i->expr->val.id) = NULL;
+    }
+    rir_block_remove_expr(cb->block, i->expr, r, c->fn);
+    i->expr = NULL;
+}
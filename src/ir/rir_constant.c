@@ -8,6 +8,7 @@
 #include <ir/rir_expression.h>
 #include <ast/ast.h>
 #include <ast/constants.h>
+#include <types/type_elementary.h>
 
 struct rir_object *rir_constant_create_obj(const struct ast_node *c, struct rir_ctx *ctx)
 {
@@ -32,14 +33,10 @@ struct rir_expression *rir_constant_create(const struct ast_node *c, struct rir_
 
 struct rir_value *rir_constantval_create_fromint64(int64_t n, struct rir *r)
 {
-    struct rir_value *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
-    if (!rir_constantval_init_fromint64(ret, r, n)) {
-        free(ret);
-        ret = NULL;
+    struct rir_value *ret = rir_freevalue_alloc(r);
+    if (!ret || !rir_constantval_init_fromint64(ret, r, n)) {
+        return NULL;
     }
-    // note that this value will need destruction
-    rir_freevalues_add(r, ret);
     return ret;
 }
 
@@ -53,14 +50,10 @@ bool rir_constantval_init_fromint64(struct rir_value *v, struct rir *r, int64_t
 
 struct rir_value *rir_constantval_create_fromint32(int32_t n, struct rir *r)
 {
-    struct rir_value *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
-    if (!rir_constantval_init_fromint32(ret, r, n)) {
-        free(ret);
-        ret = NULL;
+    struct rir_value *ret = rir_freevalue_alloc(r);
+    if (!ret || !rir_constantval_init_fromint32(ret, r, n)) {
+        return NULL;
     }
-    // note that this value will need destruction
-    rir_freevalues_add(r, ret);
     return ret;
 }
 
@@ -72,6 +65,42 @@ bool rir_constantval_init_fromint32(struct rir_value *v, struct rir *r, int32_t
     return rir_value_constant_init(v, &c, r, ELEMENTARY_TYPE_INT_32);
 }
 
+struct rir_value *rir_constantval_create_typed(const struct ast_constant *c,
+                                               struct rir_type *t,
+                                               struct rir *r)
+{
+    struct rir_value *ret = rir_freevalue_alloc(r);
+    if (!ret || !rir_value_static_constant_init(ret, c, t)) {
+        return NULL;
+    }
+    return ret;
+}
+
+int64_t rir_constant_int_to_width(int64_t v, enum elementary_type etype)
+{
+    int bits;
+    uint64_t mask;
+    if (etype == ELEMENTARY_TYPE_BOOL) {
+        return v & 1;
+    }
+    bits = elementary_type_to_bytesize(etype) * 8;
+    if (bits >= 64) {
+        return v;
+    }
+    mask = (UINT64_C(1) << bits) - 1;
+    if (etype % 2 != 0) { // unsigned
+        return (int64_t)((uint64_t)v & mask);
+    }
+    // signed, shift left and back to get the sign extension
+    return (int64_t)((uint64_t)v << (64 - bits)) >> (64 - bits);
+}
+
+int64_t rir_constant_int_to_signed_width(int64_t v, enum elementary_type etype)
+{
+    // signed integer types come right before their unsigned counterpart
+    return rir_constant_int_to_width(v, etype - etype % 2);
+}
+
 const struct RFstring *rir_constant_string(const struct rir_value *val)
 {
     RF_ASSERT(val->category == RIR_VALUE_CONSTANT, "Expected constant");
@@ -145,7 +145,7 @@ struct rir_object *rir_convert_create_obj(
         return ret;
     }
     if (!rir_object_expression_init(ret, RIR_EXPRESSION_CONVERT, pos, data)) {
-        free(ret);
+        rir_object_free(ret, rir_data_rir(data));
         ret = NULL;
     }
     return ret;
@@ -16,6 +16,7 @@
 #include <ir/rir_call.h>
 #include <ir/rir_type.h>
 #include <ir/rir_array.h>
+#include <ir/rir_phi.h>
 #include <ast/ast.h>
 
 void rir_expression_init_with_nilval(struct rir_expression *e,
@@ -64,6 +65,9 @@ void rir_expression_deinit(struct rir_expression *expr)
     case RIR_EXPRESSION_FIXEDARR:
         rir_fixedarr_deinit(&expr->fixedarr);
         break;
+    case RIR_EXPRESSION_PHI:
+        rir_phi_deinit(&expr->phi);
+        break;
     default:
         break;
     }
@@ -89,12 +93,11 @@ struct rir_object *rir_read_create_obj(
 {
     struct rir_object *ret = rir_object_create(RIR_OBJ_EXPRESSION, rir_data_rir(data));
     if (!ret) {
-        free(ret);
         return NULL;
     }
     ret->expr.read.memory = memory_to_read;
     if (!rir_object_expression_init(ret, RIR_EXPRESSION_READ, pos, data)) {
-        free(ret);
+        rir_object_free(ret, rir_data_rir(data));
         ret = NULL;
     }
     return ret;
@@ -162,7 +165,7 @@ struct rir_object *rir_write_create_obj(
     return ret;
 
 fail:
-    free(ret);
+    rir_object_free(ret, rir_data_rir(data));
     return NULL;
 }
 
@@ -190,7 +193,7 @@ struct rir_object *rir_alloca_create_obj(
     }
     rir_alloca_init(&ret->expr.alloca, type, id);
     if (!rir_object_expression_init(ret, RIR_EXPRESSION_ALLOCA, pos, data)) {
-        free(ret);
+        rir_object_free(ret, rir_data_rir(data));
         ret = NULL;
     }
     return ret;
@@ -220,7 +223,7 @@ static struct rir_object *rir_setunionidx_create_obj(
     ret->expr.setunionidx.unimemory = unimemory;
     ret->expr.setunionidx.idx = idx;
     if (!rir_object_expression_init(ret, RIR_EXPRESSION_SETUNIONIDX, pos, data)) {
-        free(ret);
+        rir_object_free(ret, rir_data_rir(data));
         ret = NULL;
     }
     return ret;
@@ -249,7 +252,7 @@ static struct rir_object *rir_getunionidx_create_obj(
     }
     ret->expr.getunionidx.unimemory = unimemory;
     if (!rir_object_expression_init(ret, RIR_EXPRESSION_GETUNIONIDX, pos, data)) {
-        free(ret);
+        rir_object_free(ret, rir_data_rir(data));
         ret = NULL;
     }
     return ret;
@@ -279,7 +282,7 @@ struct rir_object *rir_objmemberat_create_obj(
     ret->expr.objmemberat.objmemory = objmemory;
     ret->expr.objmemberat.idx = idx;
     if (!rir_object_expression_init(ret, RIR_EXPRESSION_OBJMEMBERAT, pos, data)) {
-        free(ret);
+        rir_object_free(ret, rir_data_rir(data));
         ret = NULL;
     }
     return ret;
@@ -310,7 +313,7 @@ static struct rir_object *rir_unionmemberat_create_obj(
     ret->expr.unionmemberat.unimemory = unimemory;
     ret->expr.unionmemberat.idx = idx;
     if (!rir_object_expression_init(ret, RIR_EXPRESSION_UNIONMEMBERAT, pos, data)) {
-        free(ret);
+        rir_object_free(ret, rir_data_rir(data));
         ret = NULL;
     }
     return ret;
@@ -329,7 +332,7 @@ struct rir_object *rir_objidx_create_obj(
     ret->expr.objidx.objmemory = objmemory;
     ret->expr.objidx.idx = idx;
     if (!rir_object_expression_init(ret, RIR_EXPRESSION_OBJIDX, pos, data)) {
-        free(ret);
+        rir_object_free(ret, rir_data_rir(data));
         ret = NULL;
     }
     return ret;
@@ -381,6 +384,11 @@ bool rir_expression_tostring(struct rirtostr_ctx *ctx, const struct rir_expressi
             goto end;
         }
         break;
+    case RIR_EXPRESSION_PHI:
+        if (!rir_phi_tostring(ctx, e)) {
+            goto end;
+        }
+        break;
     case RIR_EXPRESSION_SETUNIONIDX:
         if (!rf_stringx_append(
                 ctx->rir->buff,
@@ -541,6 +549,7 @@ static const struct RFstring rir_expression_type_strings[] = {
     [RIR_EXPRESSION_CMP_LT] = RF_STRING_STATIC_INIT("cmplt"),
     [RIR_EXPRESSION_LOGIC_AND] = RF_STRING_STATIC_INIT("logicand"),
     [RIR_EXPRESSION_LOGIC_OR] = RF_STRING_STATIC_INIT("logicor"),
+    [RIR_EXPRESSION_PHI] = RF_STRING_STATIC_INIT("phi"),
 };
 
 const struct RFstring *rir_expression_type_string(const struct rir_expression *expr)
@@ -320,12 +320,14 @@ static inline void rir_fndef_init_common_intro(
 {
     // only if coming from AST->RIR reset some attributes to zero. When coming 
     // from rir parsing the initialization to zero happens in rir_parse_fndef()
+    // and the map already holds the arguments added by rir_fndecl_init()
     if (pos == RIRPOS_AST) {
         RF_STRUCT_ZERO(ret);
         rir_ctx_reset(data);
         darray_init(ret->variables);
+        darray_init(ret->values);
+        strmap_init(&ret->map);
     }
-    strmap_init(&ret->map);
     rir_data_curr_fn(data) = ret;
 }
 
@@ -381,7 +383,7 @@ struct rir_fndef *rir_fndef_create_no_decl(enum rir_pos pos, rir_data data)
     return ret;
 }
 
-static bool rir_fndef_init_from_ast(
+static bool rir_fndef_init_decl_from_ast(
     struct rir_fndef *ret,
     const struct ast_node *n,
     struct rir_ctx *ctx)
@@ -405,6 +407,36 @@ static bool rir_fndef_init_from_ast(
         )) {
         goto end;
     }
+    success = true;
+end:
+    rir_ctx_pop_st(ctx);
+    return success;
+}
+
+struct rir_fndef *rir_fndef_create_decl_from_ast(const struct ast_node *n, struct rir_ctx *ctx)
+{
+    struct rir_fndef *ret;
+    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    if (!rir_fndef_init_decl_from_ast(ret, n, ctx)) {
+        free(ret);
+        ret = NULL;
+    }
+    return ret;
+}
+
+bool rir_fndef_body_from_ast(
+    struct rir_fndef *ret,
+    const struct ast_node *n,
+    struct rir_ctx *ctx)
+{
+    bool success = false;
+    struct ast_node *ast_returns = ast_fndecl_return_get(ast_fnimpl_fndecl_get(n));
+    // continue numbering values after the ones the declaration created
+    rir_ctx_reset(ctx);
+    ctx->expression_idx = darray_size(ret->values);
+    ctx->next_block = NULL;
+    rir_data_curr_fn(ctx) = ret;
+    rir_ctx_push_st(ctx, ret->st);
 
     // create the end block
     struct rir_block *end_block;
@@ -450,10 +482,9 @@ end:
 
 struct rir_fndef *rir_fndef_create_from_ast(const struct ast_node *n, struct rir_ctx *ctx)
 {
-    struct rir_fndef *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
-    if (!rir_fndef_init_from_ast(ret, n, ctx)) {
-        free(ret);
+    struct rir_fndef *ret = rir_fndef_create_decl_from_ast(n, ctx);
+    if (ret && !rir_fndef_body_from_ast(ret, n, ctx)) {
+        rir_fndef_destroy(ret);
         ret = NULL;
     }
     return ret;
@@ -463,6 +494,7 @@ static void rir_fndef_deinit(struct rir_fndef *f)
 {
     // not clearing the members of the maps. They should be cleared from the global list
     strmap_clear(&f->map);
+    darray_free(f->values);
     darray_free(f->blocks);
     darray_free(f->variables);
     rir_fndecl_deinit(&f->decl);
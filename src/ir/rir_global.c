@@ -62,7 +62,7 @@ struct rir_object *rir_global_create_string(const struct rir_type *type,
     return ret;
 
 fail_free_ret:
-    free(ret);
+    rir_object_free(ret, rir);
     return NULL;
 }
 
@@ -134,6 +134,7 @@ i_INLINE_INS struct rir_type *rir_global_type(const struct rir_global *g);
 
 struct rir_object *rir_global_addorget_string(struct rir *rir, const struct RFstring *s)
 {
+    pthread_mutex_lock(&rir->globals_lock);
     struct rir_object *gstring = strmap_get(&rir->global_literals, s);
     if (!gstring) {
         RFS_PUSH();
@@ -145,5 +146,6 @@ struct rir_object *rir_global_addorget_string(struct rir *rir, const struct RFst
         );
         RFS_POP();
     }
+    pthread_mutex_unlock(&rir->globals_lock);
     return gstring;
 }
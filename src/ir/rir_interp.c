@@ -0,0 +1,1493 @@
+#include <ir/rir_interp.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <rfbase/datastructs/darray.h>
+#include <rfbase/datastructs/htable.h>
+#include <rfbase/datastructs/intrusive_list.h>
+#include <rfbase/string/core.h>
+#include <rfbase/utils/fixed_memory_pool.h>
+#include <rfbase/utils/hash.h>
+#include <rfbase/utils/log.h>
+#include <rfbase/utils/memory.h>
+
+#include <ast/constants.h>
+#include <types/type_elementary.h>
+#include <ir/rir.h>
+#include <ir/rir_block.h>
+#include <ir/rir_constant.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_object.h>
+#include <ir/rir_type.h>
+#include <ir/rir_typedef.h>
+#include <ir/rir_value.h>
+
+//! Marks a missing register or block
+#define INTERP_NONE UINT32_MAX
+//! Number of cells of the interpreter's stack
+#define INTERP_STACK_CELLS (1 << 18)
+//! Maximum depth of nested calls
+#define INTERP_MAX_DEPTH 1024
+//! Maximum number of arguments of a foreign function binding
+#define INTERP_BINDING_MAX_ARGS 4
+//! Number of slots per chunk of the memory pool used while preparing a function
+#define INTERP_SLOTS_POOL_CHUNK_SIZE 256
+
+// The foreign functions imported by stdlib/io.rf. Just like for the JIT they
+// live in rfbase which is linked into the compiler.
+bool rf_stdlib_print_int64(int64_t i);
+bool rf_stdlib_print_uint64(uint64_t i);
+bool rf_stdlib_print_string(struct RFstring *s);
+
+typedef bool (*interp_binding_fn)(const union rir_interp_cell *args,
+                                  union rir_interp_cell *ret);
+
+struct interp_binding {
+    struct RFstring name;
+    interp_binding_fn fn;
+    unsigned args_num;
+};
+
+static bool interp_print_int64(const union rir_interp_cell *args,
+                               union rir_interp_cell *ret)
+{
+    ret->i = rf_stdlib_print_int64(args[0].i);
+    return true;
+}
+
+static bool interp_print_uint64(const union rir_interp_cell *args,
+                                union rir_interp_cell *ret)
+{
+    ret->i = rf_stdlib_print_uint64(args[0].u);
+    return true;
+}
+
+static bool interp_print_string(const union rir_interp_cell *args,
+                                union rir_interp_cell *ret)
+{
+    ret->i = rf_stdlib_print_string(&args[0].ptr->s);
+    return true;
+}
+
+static const struct interp_binding interp_bindings[] = {
+    {RF_STRING_STATIC_INIT("rf_stdlib_print_int64"), interp_print_int64, 1},
+    {RF_STRING_STATIC_INIT("rf_stdlib_print_uint64"), interp_print_uint64, 1},
+    {RF_STRING_STATIC_INIT("rf_stdlib_print_string"), interp_print_string, 1},
+};
+
+enum interp_purity {
+    INTERP_PURITY_UNKNOWN = 0,
+    //! Being determined. Recursive calls are conservatively taken as impure
+    INTERP_PURITY_CHECKING,
+    INTERP_PURITY_PURE,
+    INTERP_PURITY_IMPURE,
+};
+
+struct interp_fn;
+
+/**
+ * A rir expression translated for execution
+ */
+struct interp_instr {
+    enum rir_expression_type type;
+    //! Register receiving the expression's value or INTERP_NONE
+    uint32_t dst;
+    //! Operand registers
+    uint32_t a;
+    uint32_t b;
+    //! Member offset in cells, index of a member or size of an array
+    uint32_t imm;
+    //! Number of cells copied by the expression. 0 for elementary values
+    //! that are not handled by reference.
+    uint32_t cells;
+    //! Offset of the memory the expression owns, after the frame's registers
+    uint32_t slot;
+    //! The elementary type the expression operates on
+    enum elementary_type etype;
+    //! The elementary type conversions convert to
+    enum elementary_type to_etype;
+    //! True for allocas on the heap
+    bool heap;
+    //! True if the array members the expression copies are handled by reference
+    bool byref;
+    //! True for array indexing whose index was proven to be inside the array
+    bool inbounds;
+    //! Operand registers of calls and fixed arrays in the function's operands
+    uint32_t ops;
+    uint32_t ops_num;
+    //! The called function, if defined in rir
+    const struct rir_fndef *callee;
+    //! The called function, if it is bound to a foreign function
+    const struct interp_binding *binding;
+};
+
+struct interp_incoming {
+    //! Index of the predecessor block
+    uint32_t pred;
+    uint32_t src;
+};
+
+struct interp_phi {
+    uint32_t dst;
+    uint32_t incoming;
+    uint32_t incoming_num;
+};
+
+struct interp_case {
+    int64_t val;
+    uint32_t dst;
+};
+
+struct interp_block {
+    uint32_t instrs;
+    uint32_t instrs_num;
+    uint32_t phis;
+    uint32_t phis_num;
+    enum rir_block_exit_type exit;
+    //! Condition or return value register
+    uint32_t val;
+    //! Destination of branches, taken block of condbranches
+    uint32_t dst;
+    //! Fallthrough block of condbranches and switches
+    uint32_t other;
+    //! Elementary type of the switch condition
+    enum elementary_type etype;
+    uint32_t cases;
+    uint32_t cases_num;
+};
+
+/**
+ * A rir function definition translated for execution
+ */
+struct interp_fn {
+    const struct rir_fndef *def;
+    struct {darray(struct interp_instr);} instrs;
+    struct {darray(struct interp_block);} blocks;
+    struct {darray(uint32_t);} operands;
+    struct {darray(struct interp_phi);} phis;
+    struct {darray(struct interp_incoming);} incoming;
+    struct {darray(struct interp_case);} cases;
+    //! Initial contents of the registers. Holds the constants.
+    struct {darray(union rir_interp_cell);} regs;
+    //! The cells of the string literals the function uses
+    union rir_interp_cell *literals;
+    //! Scratch space for the parallel assignment of phis
+    union rir_interp_cell *phi_values;
+    uint32_t args_num;
+    //! Register of the return slot or INTERP_NONE
+    uint32_t retslot;
+    //! Offset of the return slot's memory after the registers
+    uint32_t retslot_cells;
+    //! Number of cells of memory after the registers
+    uint32_t cells_num;
+    enum interp_purity purity;
+};
+
+struct rir_interp {
+    struct rir *rir;
+    //! Map from rir function definitions to their translations
+    struct htable fns_map;
+    struct {darray(struct interp_fn*);} fns;
+    union rir_interp_cell *stack;
+    size_t sp;
+    unsigned depth;
+    uint64_t steps;
+    uint64_t step_limit;
+    //! Memory of the heap allocas, freed with the interpreter
+    struct {darray(union rir_interp_cell*);} heap;
+    const char *error;
+};
+
+/* -- types and values -- */
+
+/**
+ * @return true if values of type @a t are handled through a pointer to
+ *         their cells, whether @a t is a pointer or not
+ */
+static bool interp_type_byref(const struct rir_type *t)
+{
+    return rir_type_is_specific_elementary(t, ELEMENTARY_TYPE_STRING) ||
+        rir_type_is_composite(t) ||
+        rir_type_is_array(t);
+}
+
+/**
+ * @return The number of cells the memory of a value of type @a t occupies.
+ *         Whether @a t is a pointer is not taken into account.
+ */
+static uint32_t interp_type_cells(const struct rir_type *t)
+{
+    struct rir_type **member;
+    uint32_t cells = 0;
+    uint32_t mcells;
+    switch (t->category) {
+    case RIR_TYPE_ELEMENTARY:
+        return 1;
+    case RIR_TYPE_COMPOSITE:
+        darray_foreach(member, t->tdef->argument_types) {
+            mcells = interp_type_cells(*member);
+            if (!t->tdef->is_union) {
+                cells += mcells;
+            } else if (mcells > cells) {
+                cells = mcells;
+            }
+        }
+        // the selector of a union comes first
+        return t->tdef->is_union ? cells + 1 : cells;
+    case RIR_TYPE_ARRAY:
+        if (t->array.size < 0) {
+            return 0;
+        }
+        return (uint32_t)t->array.size * interp_type_cells(t->array.type);
+    }
+    return 0;
+}
+
+/**
+ * @return The number of cells a value of type @a t copies on reads and
+ *         writes or 0 if it fits in a register
+ */
+static uint32_t interp_type_copy_cells(const struct rir_type *t)
+{
+    return interp_type_byref(t) ? interp_type_cells(t) : 0;
+}
+
+void rir_interp_cell_from_constant(union rir_interp_cell *c, const struct rir_value *v)
+{
+    RF_ASSERT(v->category == RIR_VALUE_CONSTANT, "Expected a constant value");
+    switch (v->constant.type) {
+    case CONSTANT_NUMBER_INTEGER:
+        c->i = rir_type_is_elementary(v->type)
+            ? rir_constant_int_to_width(v->constant.value.integer, v->type->etype)
+            : v->constant.value.integer;
+        break;
+    case CONSTANT_NUMBER_FLOAT:
+        c->f = rir_type_is_specific_elementary(v->type, ELEMENTARY_TYPE_FLOAT_32)
+            ? (double)(float)v->constant.value.floating
+            : v->constant.value.floating;
+        break;
+    case CONSTANT_BOOLEAN:
+        c->i = v->constant.value.boolean;
+        break;
+    }
+}
+
+void rir_interp_cell_to_constant(const union rir_interp_cell *c,
+                                 const struct rir_type *t,
+                                 struct ast_constant *out)
+{
+    RF_ASSERT(rir_type_is_elementary(t), "Expected an elementary type");
+    if (t->etype == ELEMENTARY_TYPE_BOOL) {
+        ast_constant_init_bool(out, c->i != 0);
+    } else if (elementary_type_is_float(t->etype)) {
+        ast_constant_init_float(out, c->f);
+    } else {
+        ast_constant_init_int(out, c->i);
+    }
+}
+
+/* -- function lookup -- */
+
+static const struct rir_fndef *interp_fndef_in(const struct rir *r,
+                                               const struct RFstring *name)
+{
+    struct rir_fndecl *decl;
+    struct rir **dep;
+    const struct rir_fndef *ret;
+    rf_ilist_for_each(&r->functions, decl, ln) {
+        if (!decl->plain_decl && rf_string_equal(&decl->name, name)) {
+            return rir_fndecl_to_fndef(decl);
+        }
+    }
+    darray_foreach(dep, r->dependencies) {
+        if ((ret = interp_fndef_in(*dep, name))) {
+            return ret;
+        }
+    }
+    return NULL;
+}
+
+const struct rir_fndef *rir_interp_fndef(const struct rir_interp *in,
+                                         const struct RFstring *name)
+{
+    return interp_fndef_in(in->rir, name);
+}
+
+static const struct interp_binding *interp_binding_get(const struct RFstring *name)
+{
+    unsigned i;
+    for (i = 0; i < sizeof(interp_bindings) / sizeof(interp_bindings[0]); ++i) {
+        if (rf_string_equal(name, &interp_bindings[i].name)) {
+            return &interp_bindings[i];
+        }
+    }
+    return NULL;
+}
+
+/* -- preparation of functions -- */
+
+struct interp_slot {
+    const void *ptr;
+    uint32_t idx;
+};
+
+struct interp_literal {
+    uint32_t reg;
+    const struct RFstring *s;
+};
+
+struct interp_prep {
+    struct interp_fn *fn;
+    //! The module calls are resolved from
+    const struct rir *rir;
+    //! Why the preparation failed. NULL if it did not.
+    const char *error;
+    //! Pool for the slots of the map
+    struct rf_fixed_memorypool *pool;
+    //! Map from rir values to registers and from rir blocks to block indices
+    struct htable map;
+    struct {darray(struct interp_literal);} literals;
+};
+
+static size_t interp_slot_rehash(const void *e, void *priv)
+{
+    return hash_pointer(((const struct interp_slot*)e)->ptr, 0);
+}
+
+static bool interp_slot_cmp(const void *e, void *ptr)
+{
+    return ((const struct interp_slot*)e)->ptr == ptr;
+}
+
+/**
+ * Note why a function can't be prepared. Preparation also happens when
+ * checking whether calls can be folded so it does not log errors.
+ */
+static bool interp_prep_fail(struct interp_prep *p, const char *error)
+{
+    if (!p->error) {
+        p->error = error;
+    }
+    return false;
+}
+
+static bool interp_prep_map(struct interp_prep *p, const void *ptr, uint32_t idx)
+{
+    struct interp_slot *slot;
+    if (!(slot = rf_fixed_memorypool_alloc_element(p->pool))) {
+        return false;
+    }
+    slot->ptr = ptr;
+    slot->idx = idx;
+    return htable_add(&p->map, hash_pointer(ptr, 0), slot);
+}
+
+static uint32_t interp_prep_lookup(const struct interp_prep *p, const void *ptr)
+{
+    struct interp_slot *slot = htable_get(&p->map, hash_pointer(ptr, 0), interp_slot_cmp, ptr);
+    return slot ? slot->idx : INTERP_NONE;
+}
+
+static uint32_t interp_prep_newreg(struct interp_prep *p)
+{
+    union rir_interp_cell zero;
+    RF_STRUCT_ZERO(&zero);
+    darray_append(p->fn->regs, zero);
+    return darray_size(p->fn->regs) - 1;
+}
+
+static bool interp_prep_value(struct interp_prep *p, const struct rir_value *v)
+{
+    return interp_prep_map(p, v, interp_prep_newreg(p));
+}
+
+/**
+ * @return The register of an operand. Constants and string literals get
+ *         their register the first time they are used.
+ */
+static uint32_t interp_prep_operand(struct interp_prep *p, const struct rir_value *v)
+{
+    struct interp_literal lit;
+    uint32_t reg = interp_prep_lookup(p, v);
+    if (reg != INTERP_NONE) {
+        return reg;
+    }
+    switch (v->category) {
+    case RIR_VALUE_CONSTANT:
+        reg = interp_prep_newreg(p);
+        rir_interp_cell_from_constant(&darray_item(p->fn->regs, reg), v);
+        break;
+    case RIR_VALUE_LITERAL:
+        reg = interp_prep_newreg(p);
+        lit.reg = reg;
+        lit.s = &v->literal;
+        darray_append(p->literals, lit);
+        break;
+    default:
+        interp_prep_fail(p, "use of an unknown rir value");
+        return INTERP_NONE;
+    }
+    if (!interp_prep_map(p, v, reg)) {
+        interp_prep_fail(p, "out of memory");
+        return INTERP_NONE;
+    }
+    return reg;
+}
+
+static uint32_t interp_prep_block(const struct interp_prep *p, const struct rir_value *label)
+{
+    return interp_prep_lookup(p, rir_value_label_dst(label));
+}
+
+/**
+ * Reserve @a cells cells of memory in the frame of the function
+ */
+static uint32_t interp_prep_slot(struct interp_prep *p, uint32_t cells)
+{
+    uint32_t ret = p->fn->cells_num;
+    p->fn->cells_num += cells;
+    return ret;
+}
+
+static bool interp_prep_operands(struct interp_prep *p,
+                                 struct interp_instr *instr,
+                                 const struct value_arr *arr)
+{
+    struct rir_value **v;
+    uint32_t reg;
+    instr->ops = darray_size(p->fn->operands);
+    instr->ops_num = darray_size(*arr);
+    darray_foreach(v, *arr) {
+        if ((reg = interp_prep_operand(p, *v)) == INTERP_NONE) {
+            return false;
+        }
+        darray_append(p->fn->operands, reg);
+    }
+    return true;
+}
+
+static bool interp_prep_call(struct interp_prep *p,
+                             struct interp_instr *instr,
+                             const struct rir_expression *e)
+{
+    if (!interp_prep_operands(p, instr, &e->call.args)) {
+        return false;
+    }
+    if (!e->call.foreign &&
+        (instr->callee = interp_fndef_in(p->rir, &e->call.name))) {
+        if (darray_size(instr->callee->decl.argument_types) != instr->ops_num) {
+            return interp_prep_fail(p, "call with the wrong number of arguments");
+        }
+    } else if (!(instr->binding = interp_binding_get(&e->call.name))) {
+        return interp_prep_fail(p, "call to a function with neither a definition nor a foreign binding");
+    } else if (instr->binding->args_num != instr->ops_num) {
+        return interp_prep_fail(p, "foreign call with the wrong number of arguments");
+    }
+    // values returned by reference are copied out of the callee's frame
+    if (e->val.category != RIR_VALUE_NIL &&
+        (instr->cells = interp_type_copy_cells(e->val.type))) {
+        instr->slot = interp_prep_slot(p, instr->cells);
+    }
+    return true;
+}
+
+static bool interp_prep_convert(struct interp_prep *p,
+                                struct interp_instr *instr,
+                                const struct rir_expression *e)
+{
+    const struct rir_type *from = e->convert.val->type;
+    const struct rir_type *to = e->convert.type;
+    if (rir_type_is_array(from) && rir_type_is_array(to) &&
+        rir_type_is_elementary(from->array.type) &&
+        rir_type_is_elementary(to->array.type) &&
+        from->array.size == to->array.size && from->array.size >= 0) {
+        instr->etype = from->array.type->etype;
+        instr->to_etype = to->array.type->etype;
+        instr->imm = (uint32_t)from->array.size;
+        instr->slot = interp_prep_slot(p, instr->imm);
+        return true;
+    }
+    // like in the backend floats only convert to floats and integers to integers
+    if (rir_type_is_elementary(from) && rir_type_is_elementary(to) &&
+        !interp_type_byref(from) && !interp_type_byref(to) &&
+        !from->is_pointer && !to->is_pointer &&
+        elementary_type_is_float(from->etype) == elementary_type_is_float(to->etype)) {
+        instr->etype = from->etype;
+        instr->to_etype = to->etype;
+        return true;
+    }
+    return interp_prep_fail(p, "unsupported conversion");
+}
+
+static bool interp_prep_expression(struct interp_prep *p,
+                                   struct interp_instr *instr,
+                                   const struct rir_expression *e)
+{
+    const struct rir_type *t;
+    RF_STRUCT_ZERO(instr);
+    instr->type = e->type;
+    instr->dst = e->val.category == RIR_VALUE_VARIABLE
+        ? interp_prep_lookup(p, &e->val)
+        : INTERP_NONE;
+    instr->a = INTERP_NONE;
+    instr->b = INTERP_NONE;
+
+    switch (e->type) {
+    case RIR_EXPRESSION_ALLOCA:
+        if (rir_type_is_array(e->alloca.type) && e->alloca.type->array.size < 0) {
+            return interp_prep_fail(p, "allocation of an array without a fixed size");
+        }
+        instr->cells = interp_type_cells(e->alloca.type);
+        instr->heap = e->alloca.alloc_location == RIR_ALLOC_HEAP;
+        if (!instr->heap) {
+            instr->slot = interp_prep_slot(p, instr->cells);
+        }
+        break;
+    case RIR_EXPRESSION_WRITE:
+        instr->a = interp_prep_operand(p, e->write.memory);
+        instr->b = interp_prep_operand(p, e->write.writeval);
+        instr->cells = interp_type_copy_cells(e->write.memory->type);
+        break;
+    case RIR_EXPRESSION_READ:
+        instr->a = interp_prep_operand(p, e->read.memory);
+        if ((instr->cells = interp_type_copy_cells(e->read.memory->type))) {
+            instr->slot = interp_prep_slot(p, instr->cells);
+        }
+        break;
+    case RIR_EXPRESSION_OBJMEMBERAT:
+    {
+        uint32_t i;
+        t = e->objmemberat.objmemory->type;
+        if (!rir_type_is_composite(t) ||
+            e->objmemberat.idx >= darray_size(t->tdef->argument_types)) {
+            return interp_prep_fail(p, "invalid objmemberat");
+        }
+        instr->a = interp_prep_operand(p, e->objmemberat.objmemory);
+        for (i = 0; i < e->objmemberat.idx; ++i) {
+            instr->imm += interp_type_cells(darray_item(t->tdef->argument_types, i));
+        }
+        break;
+    }
+    case RIR_EXPRESSION_UNIONMEMBERAT:
+        instr->a = interp_prep_operand(p, e->unionmemberat.unimemory);
+        break;
+    case RIR_EXPRESSION_SETUNIONIDX:
+        instr->a = interp_prep_operand(p, e->setunionidx.unimemory);
+        instr->b = interp_prep_operand(p, e->setunionidx.idx);
+        break;
+    case RIR_EXPRESSION_GETUNIONIDX:
+        instr->a = interp_prep_operand(p, e->getunionidx.unimemory);
+        break;
+    case RIR_EXPRESSION_OBJIDX:
+        t = e->objidx.objmemory->type;
+        if (!rir_type_is_array(t) || t->array.size < 0) {
+            return interp_prep_fail(p, "objidx of a non fixed size array");
+        }
+        instr->a = interp_prep_operand(p, e->objidx.objmemory);
+        instr->b = interp_prep_operand(p, e->objidx.idx);
+        instr->imm = (uint32_t)t->array.size;
+        instr->inbounds = e->objidx.inbounds;
+        instr->byref = interp_type_byref(t->array.type);
+        instr->cells = interp_type_cells(t->array.type);
+        if (instr->byref) {
+            instr->slot = interp_prep_slot(p, instr->cells);
+        }
+        break;
+    case RIR_EXPRESSION_FIXEDARR:
+        if (!interp_prep_operands(p, instr, &e->fixedarr.members)) {
+            return false;
+        }
+        instr->imm = (uint32_t)e->fixedarr.size;
+        instr->byref = interp_type_byref(e->fixedarr.member_type);
+        instr->cells = interp_type_cells(e->fixedarr.member_type);
+        instr->slot = interp_prep_slot(p, instr->imm * instr->cells);
+        break;
+    case RIR_EXPRESSION_CONVERT:
+        instr->a = interp_prep_operand(p, e->convert.val);
+        if (!interp_prep_convert(p, instr, e)) {
+            return false;
+        }
+        break;
+    case RIR_EXPRESSION_ADD:
+    case RIR_EXPRESSION_SUB:
+    case RIR_EXPRESSION_MUL:
+    case RIR_EXPRESSION_DIV:
+    case RIR_EXPRESSION_CMP_EQ:
+    case RIR_EXPRESSION_CMP_NE:
+    case RIR_EXPRESSION_CMP_GE:
+    case RIR_EXPRESSION_CMP_GT:
+    case RIR_EXPRESSION_CMP_LE:
+    case RIR_EXPRESSION_CMP_LT:
+        t = e->binaryop.a->type;
+        if (!rir_type_is_elementary(t) || t->is_pointer || interp_type_byref(t)) {
+            return interp_prep_fail(p, "binary operation on non elementary values");
+        }
+        instr->a = interp_prep_operand(p, e->binaryop.a);
+        instr->b = interp_prep_operand(p, e->binaryop.b);
+        instr->etype = t->etype;
+        break;
+    case RIR_EXPRESSION_CALL:
+        if (!interp_prep_call(p, instr, e)) {
+            return false;
+        }
+        break;
+    default:
+        return interp_prep_fail(p, "expression the interpreter can't execute");
+    }
+    // operands that could not be resolved have already noted the error
+    return !p->error;
+}
+
+static bool interp_prep_phi(struct interp_prep *p, const struct rir_expression *e)
+{
+    struct rir_phi_incoming *rin;
+    struct interp_incoming in;
+    struct interp_phi phi;
+    phi.dst = interp_prep_lookup(p, &e->val);
+    phi.incoming = darray_size(p->fn->incoming);
+    phi.incoming_num = rir_phi_incoming_num(&e->phi);
+    darray_foreach(rin, e->phi.incoming) {
+        in.pred = interp_prep_block(p, rin->block);
+        in.src = interp_prep_operand(p, rin->val);
+        if (in.pred == INTERP_NONE) {
+            return interp_prep_fail(p, "phi incoming value from an unknown block");
+        }
+        if (in.src == INTERP_NONE) {
+            return false;
+        }
+        darray_append(p->fn->incoming, in);
+    }
+    darray_append(p->fn->phis, phi);
+    return true;
+}
+
+static bool interp_prep_exit(struct interp_prep *p,
+                             struct interp_block *ib,
+                             const struct rir_block_exit *exit)
+{
+    struct rir_switch_case *c;
+    struct interp_case ic;
+    union rir_interp_cell cell;
+    ib->exit = exit->type;
+    ib->val = INTERP_NONE;
+    ib->dst = INTERP_NONE;
+    ib->other = INTERP_NONE;
+    switch (exit->type) {
+    case RIR_BLOCK_EXIT_BRANCH:
+        ib->dst = interp_prep_block(p, exit->branch.dst);
+        break;
+    case RIR_BLOCK_EXIT_CONDBRANCH:
+        ib->val = interp_prep_operand(p, exit->condbranch.cond);
+        ib->dst = interp_prep_block(p, exit->condbranch.taken);
+        ib->other = interp_prep_block(p, exit->condbranch.fallthrough);
+        if (ib->other == INTERP_NONE) {
+            return interp_prep_fail(p, "branch to an unknown block");
+        }
+        break;
+    case RIR_BLOCK_EXIT_SWITCH:
+        if (!rir_type_is_elementary(exit->switchbr.cond->type)) {
+            return interp_prep_fail(p, "switch on a non elementary value");
+        }
+        ib->val = interp_prep_operand(p, exit->switchbr.cond);
+        ib->other = interp_prep_block(p, exit->switchbr.fallthrough);
+        ib->dst = ib->other;
+        ib->etype = exit->switchbr.cond->type->etype;
+        ib->cases = darray_size(p->fn->cases);
+        ib->cases_num = rir_switch_cases_num(&exit->switchbr);
+        darray_foreach(c, exit->switchbr.cases) {
+            if (c->val->category != RIR_VALUE_CONSTANT) {
+                return interp_prep_fail(p, "switch case that is not a constant");
+            }
+            // case constants are compared at the width of the condition
+            rir_interp_cell_from_constant(&cell, c->val);
+            ic.val = rir_constant_int_to_width(cell.i, ib->etype);
+            if ((ic.dst = interp_prep_block(p, c->dst)) == INTERP_NONE) {
+                return interp_prep_fail(p, "branch to an unknown block");
+            }
+            darray_append(p->fn->cases, ic);
+        }
+        break;
+    case RIR_BLOCK_EXIT_RETURN:
+        if (exit->retstmt.val) {
+            ib->val = interp_prep_operand(p, exit->retstmt.val);
+        }
+        return !p->error;
+    default:
+        return interp_prep_fail(p, "block without an exit");
+    }
+    if (ib->dst == INTERP_NONE) {
+        return interp_prep_fail(p, "branch to an unknown block");
+    }
+    return !p->error;
+}
+
+/**
+ * Number the values of a function. Arguments come first so that a call can
+ * place them directly in the registers of the callee's frame.
+ */
+static bool interp_prep_registers(struct interp_prep *p, const struct rir_fndef *def)
+{
+    struct rir_object **var;
+    struct rir_block **b;
+    struct rir_expression *e;
+    uint32_t idx = 0;
+    darray_foreach(var, def->variables) {
+        if (!interp_prep_value(p, rir_object_value(*var))) {
+            return false;
+        }
+    }
+    p->fn->args_num = darray_size(def->variables);
+    if (def->retslot_val) {
+        p->fn->retslot = darray_size(p->fn->regs);
+        p->fn->retslot_cells = interp_prep_slot(p, interp_type_cells(def->retslot_val->type));
+        if (!interp_prep_value(p, def->retslot_val)) {
+            return false;
+        }
+    }
+    darray_foreach(b, def->blocks) {
+        if (!interp_prep_map(p, *b, idx++)) {
+            return false;
+        }
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            if (e->val.category == RIR_VALUE_VARIABLE && !interp_prep_value(p, &e->val)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool interp_prep_body(struct interp_prep *p, const struct rir_fndef *def)
+{
+    struct rir_block **b;
+    struct rir_expression *e;
+    struct interp_block ib;
+    struct interp_instr instr;
+    uint32_t max_phis = 0;
+    darray_foreach(b, def->blocks) {
+        RF_STRUCT_ZERO(&ib);
+        ib.instrs = darray_size(p->fn->instrs);
+        ib.phis = darray_size(p->fn->phis);
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            if (e->type == RIR_EXPRESSION_PHI) {
+                if (!interp_prep_phi(p, e)) {
+                    return false;
+                }
+                continue;
+            }
+            // constants need no execution, their registers are preloaded
+            if (e->val.category == RIR_VALUE_CONSTANT) {
+                continue;
+            }
+            if (!interp_prep_expression(p, &instr, e)) {
+                return false;
+            }
+            darray_append(p->fn->instrs, instr);
+        }
+        ib.instrs_num = darray_size(p->fn->instrs) - ib.instrs;
+        ib.phis_num = darray_size(p->fn->phis) - ib.phis;
+        if (ib.phis_num > max_phis) {
+            max_phis = ib.phis_num;
+        }
+        if (!interp_prep_exit(p, &ib, &(*b)->exit)) {
+            return false;
+        }
+        darray_append(p->fn->blocks, ib);
+    }
+    if (max_phis) {
+        RF_CALLOC(p->fn->phi_values, max_phis, sizeof(*p->fn->phi_values), return false);
+    }
+    return true;
+}
+
+/**
+ * Give the string literals their cells. Done last since the cells are
+ * pointed to by the registers' initial contents.
+ */
+static bool interp_prep_literals(struct interp_prep *p)
+{
+    struct interp_literal *lit;
+    unsigned i = 0;
+    if (darray_size(p->literals) == 0) {
+        return true;
+    }
+    RF_CALLOC(p->fn->literals, darray_size(p->literals), sizeof(*p->fn->literals), return false);
+    darray_foreach(lit, p->literals) {
+        p->fn->literals[i].s = *lit->s;
+        darray_item(p->fn->regs, lit->reg).ptr = &p->fn->literals[i];
+        ++i;
+    }
+    return true;
+}
+
+static void interp_fn_destroy(struct interp_fn *fn)
+{
+    darray_free(fn->instrs);
+    darray_free(fn->blocks);
+    darray_free(fn->operands);
+    darray_free(fn->phis);
+    darray_free(fn->incoming);
+    darray_free(fn->cases);
+    darray_free(fn->regs);
+    free(fn->literals);
+    free(fn->phi_values);
+    free(fn);
+}
+
+/**
+ * Translate a function for execution
+ *
+ * @param in           The interpreter. Its error is set on failure.
+ * @param def          The function to translate
+ * @return             The translated function or NULL for failure
+ */
+static struct interp_fn *interp_fn_create(struct rir_interp *in, const struct rir_fndef *def)
+{
+    struct interp_prep p;
+    struct interp_fn *fn;
+    bool ok = false;
+    RF_CALLOC(fn, 1, sizeof(*fn), return NULL);
+    fn->def = def;
+    fn->retslot = INTERP_NONE;
+    darray_init(fn->instrs);
+    darray_init(fn->blocks);
+    darray_init(fn->operands);
+    darray_init(fn->phis);
+    darray_init(fn->incoming);
+    darray_init(fn->cases);
+    darray_init(fn->regs);
+
+    RF_STRUCT_ZERO(&p);
+    p.fn = fn;
+    // calls are resolved from the interpreter's module, which also sees the
+    // functions of all the modules it depends on
+    p.rir = in->rir;
+    if (!(p.pool = rf_fixed_memorypool_create(sizeof(struct interp_slot),
+                                              INTERP_SLOTS_POOL_CHUNK_SIZE))) {
+        interp_fn_destroy(fn);
+        return NULL;
+    }
+    htable_init(&p.map, interp_slot_rehash, NULL);
+    darray_init(p.literals);
+
+    if (darray_size(def->blocks) == 0) {
+        interp_prep_fail(&p, "call to a function without a body");
+        goto end;
+    }
+    ok = interp_prep_registers(&p, def) &&
+        interp_prep_body(&p, def) &&
+        interp_prep_literals(&p);
+
+end:
+    darray_free(p.literals);
+    htable_clear(&p.map);
+    rf_fixed_memorypool_destroy(p.pool);
+    if (!ok) {
+        in->error = p.error ? p.error : "out of memory";
+        interp_fn_destroy(fn);
+        return NULL;
+    }
+    return fn;
+}
+
+static size_t interp_fn_rehash(const void *e, void *priv)
+{
+    return hash_pointer(((const struct interp_fn*)e)->def, 0);
+}
+
+static bool interp_fn_cmp(const void *e, void *def)
+{
+    return ((const struct interp_fn*)e)->def == def;
+}
+
+/**
+ * @return The translation of a function, translating it the first time
+ */
+static struct interp_fn *interp_fn_get(struct rir_interp *in, const struct rir_fndef *def)
+{
+    struct interp_fn *fn = htable_get(&in->fns_map, hash_pointer(def, 0), interp_fn_cmp, def);
+    if (fn) {
+        return fn;
+    }
+    if (!(fn = interp_fn_create(in, def))) {
+        return NULL;
+    }
+    if (!htable_add(&in->fns_map, hash_pointer(def, 0), fn)) {
+        in->error = "out of memory";
+        interp_fn_destroy(fn);
+        return NULL;
+    }
+    darray_append(in->fns, fn);
+    return fn;
+}
+
+/* -- execution -- */
+
+static bool interp_fail(struct rir_interp *in, const char *error)
+{
+    in->error = error;
+    return false;
+}
+
+static int64_t interp_binop_int(enum rir_expression_type type,
+                                int64_t a,
+                                int64_t b,
+                                enum elementary_type etype)
+{
+    int64_t sa;
+    int64_t sb;
+    switch (type) {
+    case RIR_EXPRESSION_ADD:
+        return rir_constant_int_to_width((int64_t)((uint64_t)a + (uint64_t)b), etype);
+    case RIR_EXPRESSION_SUB:
+        return rir_constant_int_to_width((int64_t)((uint64_t)a - (uint64_t)b), etype);
+    case RIR_EXPRESSION_MUL:
+        return rir_constant_int_to_width((int64_t)((uint64_t)a * (uint64_t)b), etype);
+    case RIR_EXPRESSION_CMP_EQ:
+        return a == b;
+    case RIR_EXPRESSION_CMP_NE:
+        return a != b;
+    default:
+        break;
+    }
+    // like the backend, integers are compared as signed at their width
+    if (etype != ELEMENTARY_TYPE_BOOL) {
+        sa = rir_constant_int_to_signed_width(a, etype);
+        sb = rir_constant_int_to_signed_width(b, etype);
+    } else {
+        sa = a;
+        sb = b;
+    }
+    switch (type) {
+    case RIR_EXPRESSION_CMP_GE:
+        return sa >= sb;
+    case RIR_EXPRESSION_CMP_GT:
+        return sa > sb;
+    case RIR_EXPRESSION_CMP_LE:
+        return sa <= sb;
+    case RIR_EXPRESSION_CMP_LT:
+        return sa < sb;
+    default:
+        RF_CRITICAL_FAIL("Unexpected binary operation");
+        return 0;
+    }
+}
+
+static void interp_binop_float(enum rir_expression_type type,
+                               double a,
+                               double b,
+                               enum elementary_type etype,
+                               union rir_interp_cell *out)
+{
+    bool ordered = !isnan(a) && !isnan(b);
+    switch (type) {
+    case RIR_EXPRESSION_ADD:
+        out->f = a + b;
+        break;
+    case RIR_EXPRESSION_SUB:
+        out->f = a - b;
+        break;
+    case RIR_EXPRESSION_MUL:
+        out->f = a * b;
+        break;
+    case RIR_EXPRESSION_DIV:
+        out->f = a / b;
+        break;
+    case RIR_EXPRESSION_CMP_EQ:
+        out->i = ordered && a == b;
+        return;
+    case RIR_EXPRESSION_CMP_NE:
+        out->i = ordered && a != b;
+        return;
+    case RIR_EXPRESSION_CMP_GE:
+        out->i = ordered && a >= b;
+        return;
+    case RIR_EXPRESSION_CMP_GT:
+        out->i = ordered && a > b;
+        return;
+    case RIR_EXPRESSION_CMP_LE:
+        out->i = ordered && a <= b;
+        return;
+    case RIR_EXPRESSION_CMP_LT:
+        out->i = ordered && a < b;
+        return;
+    default:
+        RF_CRITICAL_FAIL("Unexpected binary operation");
+        return;
+    }
+    if (etype == ELEMENTARY_TYPE_FLOAT_32) {
+        out->f = (double)(float)out->f;
+    }
+}
+
+static bool interp_binop(struct rir_interp *in,
+                         const struct interp_instr *instr,
+                         const union rir_interp_cell *a,
+                         const union rir_interp_cell *b,
+                         union rir_interp_cell *out)
+{
+    int bits;
+    uint64_t mask;
+    if (elementary_type_is_float(instr->etype)) {
+        interp_binop_float(instr->type, a->f, b->f, instr->etype, out);
+        return true;
+    }
+    if (instr->type != RIR_EXPRESSION_DIV) {
+        out->i = interp_binop_int(instr->type, a->i, b->i, instr->etype);
+        return true;
+    }
+    // division is unsigned, just like in the backend
+    bits = elementary_type_to_bytesize(instr->etype) * 8;
+    mask = bits >= 64 ? UINT64_MAX : (UINT64_C(1) << bits) - 1;
+    if ((b->u & mask) == 0) {
+        return interp_fail(in, "division by zero");
+    }
+    out->i = rir_constant_int_to_width((int64_t)((a->u & mask) / (b->u & mask)), instr->etype);
+    return true;
+}
+
+static void interp_convert_elementary(const union rir_interp_cell *from,
+                                      enum elementary_type from_etype,
+                                      enum elementary_type to_etype,
+                                      union rir_interp_cell *to)
+{
+    if (elementary_type_is_float(from_etype)) {
+        to->f = to_etype == ELEMENTARY_TYPE_FLOAT_32 ? (double)(float)from->f : from->f;
+        return;
+    }
+    // zero extend from the source width, then truncate to the target width
+    to->i = rir_constant_int_to_width(
+        from_etype == ELEMENTARY_TYPE_BOOL ? from->i : rir_constant_int_to_width(from->i, from_etype | 1),
+        to_etype
+    );
+}
+
+static bool interp_exec(struct rir_interp *in,
+                        struct interp_fn *fn,
+                        union rir_interp_cell *regs,
+                        union rir_interp_cell *ret);
+
+/**
+ * Push the frame of a function on the stack and initialize its registers
+ *
+ * @return The registers of the frame or NULL if the stack is exhausted
+ */
+static union rir_interp_cell *interp_frame_push(struct rir_interp *in, struct interp_fn *fn)
+{
+    union rir_interp_cell *regs = in->stack + in->sp;
+    size_t regs_num = darray_size(fn->regs);
+    if (in->sp + regs_num + fn->cells_num > INTERP_STACK_CELLS) {
+        in->error = "stack overflow";
+        return NULL;
+    }
+    if (regs_num) {
+        memcpy(regs, &darray_item(fn->regs, 0), regs_num * sizeof(*regs));
+    }
+    memset(regs + regs_num, 0, fn->cells_num * sizeof(*regs));
+    if (fn->retslot != INTERP_NONE) {
+        regs[fn->retslot].ptr = regs + regs_num + fn->retslot_cells;
+    }
+    in->sp += regs_num + fn->cells_num;
+    return regs;
+}
+
+static inline void interp_frame_pop(struct rir_interp *in, union rir_interp_cell *regs)
+{
+    in->sp = regs - in->stack;
+}
+
+static bool interp_call(struct rir_interp *in,
+                        struct interp_fn *fn,
+                        const struct interp_instr *instr,
+                        union rir_interp_cell *regs,
+                        union rir_interp_cell *cells)
+{
+    union rir_interp_cell args[INTERP_BINDING_MAX_ARGS];
+    union rir_interp_cell ret;
+    union rir_interp_cell *callee_regs;
+    struct interp_fn *callee;
+    const uint32_t *ops = &darray_item(fn->operands, instr->ops);
+    uint32_t i;
+    bool ok;
+
+    if (instr->binding) {
+        for (i = 0; i < instr->ops_num; ++i) {
+            args[i] = regs[ops[i]];
+        }
+        ok = instr->binding->fn(args, &ret);
+    } else {
+        if (!(callee = interp_fn_get(in, instr->callee))) {
+            return false;
+        }
+        if (!(callee_regs = interp_frame_push(in, callee))) {
+            return false;
+        }
+        for (i = 0; i < instr->ops_num; ++i) {
+            callee_regs[i] = regs[ops[i]];
+        }
+        ok = interp_exec(in, callee, callee_regs, &ret);
+        interp_frame_pop(in, callee_regs);
+    }
+    if (!ok) {
+        return false;
+    }
+    if (instr->dst == INTERP_NONE) {
+        return true;
+    }
+    // the callee's frame is gone so values returned by reference are copied
+    if (instr->cells) {
+        memcpy(cells + instr->slot, ret.ptr, instr->cells * sizeof(*cells));
+        regs[instr->dst].ptr = cells + instr->slot;
+    } else {
+        regs[instr->dst] = ret;
+    }
+    return true;
+}
+
+static bool interp_exec_instr(struct rir_interp *in,
+                              struct interp_fn *fn,
+                              const struct interp_instr *instr,
+                              union rir_interp_cell *regs,
+                              union rir_interp_cell *cells)
+{
+    union rir_interp_cell *dst = instr->dst != INTERP_NONE ? &regs[instr->dst] : NULL;
+    union rir_interp_cell *mem;
+    const uint32_t *ops;
+    uint64_t idx;
+    uint32_t i;
+    switch (instr->type) {
+    case RIR_EXPRESSION_ALLOCA:
+        if (!instr->heap) {
+            dst->ptr = cells + instr->slot;
+            break;
+        }
+        RF_CALLOC(mem, instr->cells ? instr->cells : 1, sizeof(*mem), return interp_fail(in, "out of memory"));
+        darray_append(in->heap, mem);
+        dst->ptr = mem;
+        break;
+    case RIR_EXPRESSION_WRITE:
+        if (instr->cells) {
+            memmove(regs[instr->a].ptr, regs[instr->b].ptr, instr->cells * sizeof(*cells));
+        } else {
+            *regs[instr->a].ptr = regs[instr->b];
+        }
+        break;
+    case RIR_EXPRESSION_READ:
+        if (instr->cells) {
+            memmove(cells + instr->slot, regs[instr->a].ptr, instr->cells * sizeof(*cells));
+            dst->ptr = cells + instr->slot;
+        } else {
+            *dst = *regs[instr->a].ptr;
+        }
+        break;
+    case RIR_EXPRESSION_OBJMEMBERAT:
+        dst->ptr = regs[instr->a].ptr + instr->imm;
+        break;
+    case RIR_EXPRESSION_UNIONMEMBERAT:
+        // all members share the payload which comes right after the selector
+        dst->ptr = regs[instr->a].ptr + 1;
+        break;
+    case RIR_EXPRESSION_SETUNIONIDX:
+        regs[instr->a].ptr->i = regs[instr->b].i;
+        break;
+    case RIR_EXPRESSION_GETUNIONIDX:
+        dst->i = regs[instr->a].ptr->i;
+        break;
+    case RIR_EXPRESSION_OBJIDX:
+        idx = regs[instr->b].u;
+        if (!instr->inbounds && idx >= instr->imm) {
+            return interp_fail(in, "array index out of bounds");
+        }
+        mem = regs[instr->a].ptr + idx * instr->cells;
+        if (instr->byref) {
+            memmove(cells + instr->slot, mem, instr->cells * sizeof(*cells));
+            dst->ptr = cells + instr->slot;
+        } else {
+            *dst = *mem;
+        }
+        break;
+    case RIR_EXPRESSION_FIXEDARR:
+        ops = &darray_item(fn->operands, instr->ops);
+        mem = cells + instr->slot;
+        memset(mem, 0, instr->imm * instr->cells * sizeof(*mem));
+        for (i = 0; i < instr->ops_num && i < instr->imm; ++i) {
+            if (instr->byref) {
+                memcpy(mem + i * instr->cells, regs[ops[i]].ptr, instr->cells * sizeof(*mem));
+            } else {
+                mem[i] = regs[ops[i]];
+            }
+        }
+        dst->ptr = mem;
+        break;
+    case RIR_EXPRESSION_CONVERT:
+        if (instr->imm) {
+            mem = cells + instr->slot;
+            for (i = 0; i < instr->imm; ++i) {
+                interp_convert_elementary(regs[instr->a].ptr + i, instr->etype, instr->to_etype, mem + i);
+            }
+            dst->ptr = mem;
+        } else {
+            interp_convert_elementary(&regs[instr->a], instr->etype, instr->to_etype, dst);
+        }
+        break;
+    case RIR_EXPRESSION_ADD:
+    case RIR_EXPRESSION_SUB:
+    case RIR_EXPRESSION_MUL:
+    case RIR_EXPRESSION_DIV:
+    case RIR_EXPRESSION_CMP_EQ:
+    case RIR_EXPRESSION_CMP_NE:
+    case RIR_EXPRESSION_CMP_GE:
+    case RIR_EXPRESSION_CMP_GT:
+    case RIR_EXPRESSION_CMP_LE:
+    case RIR_EXPRESSION_CMP_LT:
+        return interp_binop(in, instr, &regs[instr->a], &regs[instr->b], dst);
+    case RIR_EXPRESSION_CALL:
+        return interp_call(in, fn, instr, regs, cells);
+    default:
+        RF_CRITICAL_FAIL("Unexpected expression in prepared interpreter code");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Assign the phis of a block the values coming from @a pred. All phis read
+ * their incoming values before any of them is assigned.
+ */
+static void interp_enter_block(struct interp_fn *fn,
+                               const struct interp_block *b,
+                               uint32_t pred,
+                               union rir_interp_cell *regs)
+{
+    const struct interp_phi *phi;
+    const struct interp_incoming *inc;
+    uint32_t i;
+    uint32_t j;
+    for (i = 0; i < b->phis_num; ++i) {
+        phi = &darray_item(fn->phis, b->phis + i);
+        fn->phi_values[i] = regs[phi->dst];
+        for (j = 0; j < phi->incoming_num; ++j) {
+            inc = &darray_item(fn->incoming, phi->incoming + j);
+            if (inc->pred == pred) {
+                fn->phi_values[i] = regs[inc->src];
+                break;
+            }
+        }
+    }
+    for (i = 0; i < b->phis_num; ++i) {
+        regs[darray_item(fn->phis, b->phis + i).dst] = fn->phi_values[i];
+    }
+}
+
+static uint32_t interp_switch_dst(const struct interp_fn *fn,
+                                  const struct interp_block *b,
+                                  const union rir_interp_cell *cond)
+{
+    int64_t v = rir_constant_int_to_width(cond->i, b->etype);
+    uint32_t i;
+    for (i = 0; i < b->cases_num; ++i) {
+        if (darray_item(fn->cases, b->cases + i).val == v) {
+            return darray_item(fn->cases, b->cases + i).dst;
+        }
+    }
+    return b->other;
+}
+
+static bool interp_exec(struct rir_interp *in,
+                        struct interp_fn *fn,
+                        union rir_interp_cell *regs,
+                        union rir_interp_cell *ret)
+{
+    union rir_interp_cell *cells = regs + darray_size(fn->regs);
+    const struct interp_block *b;
+    uint32_t curr = 0;
+    uint32_t pred = INTERP_NONE;
+    uint32_t next;
+    uint32_t i;
+    bool ok = false;
+
+    if (++in->depth > INTERP_MAX_DEPTH) {
+        in->error = "maximum call depth exceeded";
+        goto end;
+    }
+    while (true) {
+        if (in->step_limit && ++in->steps > in->step_limit) {
+            in->error = "step limit exceeded";
+            goto end;
+        }
+        b = &darray_item(fn->blocks, curr);
+        if (pred != INTERP_NONE) {
+            interp_enter_block(fn, b, pred, regs);
+        }
+        for (i = 0; i < b->instrs_num; ++i) {
+            if (!interp_exec_instr(in, fn, &darray_item(fn->instrs, b->instrs + i), regs, cells)) {
+                goto end;
+            }
+        }
+        switch (b->exit) {
+        case RIR_BLOCK_EXIT_BRANCH:
+            next = b->dst;
+            break;
+        case RIR_BLOCK_EXIT_CONDBRANCH:
+            next = regs[b->val].i ? b->dst : b->other;
+            break;
+        case RIR_BLOCK_EXIT_SWITCH:
+            next = interp_switch_dst(fn, b, &regs[b->val]);
+            break;
+        case RIR_BLOCK_EXIT_RETURN:
+            if (b->val != INTERP_NONE) {
+                *ret = regs[b->val];
+            } else {
+                ret->i = 0;
+            }
+            ok = true;
+            goto end;
+        default:
+            RF_CRITICAL_FAIL("Unexpected block exit in prepared interpreter code");
+            goto end;
+        }
+        pred = curr;
+        curr = next;
+    }
+
+end:
+    --in->depth;
+    return ok;
+}
+
+/* -- purity -- */
+
+static bool interp_type_foldable(const struct rir_type *t)
+{
+    return rir_type_is_elementary(t) && !t->is_pointer &&
+        t->etype != ELEMENTARY_TYPE_STRING && t->etype != ELEMENTARY_TYPE_NIL;
+}
+
+/**
+ * @return true if executing @a fn has no effect outside of its frame
+ */
+static bool interp_fn_effect_free(struct rir_interp *in, const struct rir_fndef *def)
+{
+    struct interp_fn *fn;
+    struct interp_instr *instr;
+    bool pure = true;
+    if (!(fn = interp_fn_get(in, def))) {
+        return false;
+    }
+    if (fn->purity != INTERP_PURITY_UNKNOWN) {
+        return fn->purity == INTERP_PURITY_PURE;
+    }
+    fn->purity = INTERP_PURITY_CHECKING;
+    darray_foreach(instr, fn->instrs) {
+        if ((instr->type == RIR_EXPRESSION_ALLOCA && instr->heap) ||
+            (instr->type == RIR_EXPRESSION_CALL &&
+             (instr->binding || !interp_fn_effect_free(in, instr->callee)))) {
+            pure = false;
+            break;
+        }
+    }
+    fn->purity = pure ? INTERP_PURITY_PURE : INTERP_PURITY_IMPURE;
+    return pure;
+}
+
+bool rir_interp_fn_is_pure(struct rir_interp *in, const struct rir_fndef *fn)
+{
+    struct rir_type **t;
+    if (!interp_type_foldable(fn->decl.return_type)) {
+        return false;
+    }
+    darray_foreach(t, fn->decl.argument_types) {
+        if (!interp_type_foldable(*t)) {
+            return false;
+        }
+    }
+    return interp_fn_effect_free(in, fn);
+}
+
+/* -- public interface -- */
+
+struct rir_interp *rir_interp_create(struct rir *r)
+{
+    struct rir_interp *in;
+    RF_CALLOC(in, 1, sizeof(*in), return NULL);
+    in->rir = r;
+    RF_MALLOC(in->stack, INTERP_STACK_CELLS * sizeof(*in->stack), free(in); return NULL);
+    htable_init(&in->fns_map, interp_fn_rehash, NULL);
+    darray_init(in->fns);
+    darray_init(in->heap);
+    return in;
+}
+
+void rir_interp_destroy(struct rir_interp *in)
+{
+    struct interp_fn **fn;
+    union rir_interp_cell **mem;
+    darray_foreach(fn, in->fns) {
+        interp_fn_destroy(*fn);
+    }
+    darray_free(in->fns);
+    htable_clear(&in->fns_map);
+    darray_foreach(mem, in->heap) {
+        free(*mem);
+    }
+    darray_free(in->heap);
+    free(in->stack);
+    free(in);
+}
+
+void rir_interp_set_step_limit(struct rir_interp *in, uint64_t steps)
+{
+    in->step_limit = steps;
+}
+
+const char *rir_interp_error(const struct rir_interp *in)
+{
+    return in->error ? in->error : "no error";
+}
+
+bool rir_interp_call(struct rir_interp *in,
+                     const struct rir_fndef *def,
+                     const union rir_interp_cell *args,
+                     union rir_interp_cell *ret)
+{
+    struct interp_fn *fn;
+    union rir_interp_cell *regs;
+    bool ok;
+    in->error = NULL;
+    in->steps = 0;
+    if (!(fn = interp_fn_get(in, def))) {
+        return false;
+    }
+    if (!(regs = interp_frame_push(in, fn))) {
+        return false;
+    }
+    if (fn->args_num) {
+        memcpy(regs, args, fn->args_num * sizeof(*regs));
+    }
+    ok = interp_exec(in, fn, regs, ret);
+    interp_frame_pop(in, regs);
+    return ok;
+}
+
+bool rir_interp_run_main(struct rir_interp *in, int *retcode)
+{
+    static const struct RFstring main_str = RF_STRING_STATIC_INIT("main");
+    const struct rir_fndef *main_fn;
+    union rir_interp_cell ret;
+    if (!(main_fn = rir_interp_fndef(in, &main_str))) {
+        RF_ERROR("Interpreter could not find a main() function");
+        return false;
+    }
+    if (darray_size(main_fn->decl.argument_types) != 0) {
+        RF_ERROR("Interpreter can only run a main() function without arguments");
+        return false;
+    }
+    if (!rir_interp_call(in, main_fn, NULL, &ret)) {
+        RF_ERROR("Interpreting main() failed: %s", rir_interp_error(in));
+        return false;
+    }
+    *retcode = (int)ret.i;
+    return true;
+}
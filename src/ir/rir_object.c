@@ -1,22 +1,32 @@
 #include <ir/rir_object.h>
 
 #include <rfbase/utils/memory.h>
+#include <rfbase/utils/fixed_memory_pool.h>
 #include <rfbase/string/core.h>
 
 #include <ir/rir.h>
 #include <ir/rir_function.h>
+#include <utils/stats.h>
 
 struct rir_object *rir_object_create(enum rir_obj_category category, struct rir *r)
 {
-    struct rir_object *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
-    RF_STRUCT_ZERO(ret);
+    pthread_mutex_lock(&r->objects_lock);
+    struct rir_object *ret = rf_fixed_memorypool_alloc_element(r->objects_pool);
+    if (ret) {
+        RF_STRUCT_ZERO(ret);
+        rf_ilist_add(&r->objects,  &ret->ln);
+    }
+    pthread_mutex_unlock(&r->objects_lock);
+    if (!ret) {
+        RF_ERROR("Failed to allocate a rir object");
+        return NULL;
+    }
+    stats_add(STATS_RIR_OBJECTS, 1);
     ret->category = category;
-    rf_ilist_add(&r->objects,  &ret->ln);
     return ret;
 }
 
-void rir_object_destroy(struct rir_object *obj)
+void rir_object_deinit(struct rir_object *obj)
 {
     switch(obj->category) {
     case RIR_OBJ_EXPRESSION:
@@ -35,7 +45,22 @@ void rir_object_destroy(struct rir_object *obj)
         rir_variable_deinit(&obj->variable);
         break;
     }
-    free(obj);
+}
+
+void rir_object_destroy(struct rir_object *obj, struct rir *r)
+{
+    rir_object_deinit(obj);
+    pthread_mutex_lock(&r->objects_lock);
+    rf_fixed_memorypool_free_element(r->objects_pool, obj);
+    pthread_mutex_unlock(&r->objects_lock);
+}
+
+void rir_object_free(struct rir_object *obj, struct rir *r)
+{
+    pthread_mutex_lock(&r->objects_lock);
+    rf_ilist_delete_from(&r->objects, &obj->ln);
+    rf_fixed_memorypool_free_element(r->objects_pool, obj);
+    pthread_mutex_unlock(&r->objects_lock);
 }
 
 struct rir_value *rir_object_value(struct rir_object *obj)
@@ -58,13 +83,26 @@ struct rir_value *rir_object_value(struct rir_object *obj)
 
 void rir_object_listrem(struct rir_object *obj, struct rir *r, struct rir_fndef *current_fn)
 {
+    pthread_mutex_lock(&r->objects_lock);
     rf_ilist_delete_from(&r->objects, &obj->ln);
-    // also remove it from any string maps it can be found in
+    pthread_mutex_unlock(&r->objects_lock);
+    // also remove it from any maps it can be found in
     struct rir_value *val = rir_object_value(obj);
-    struct rirobj_strmap *map = current_fn ? &current_fn->map : &r->map;
-    struct RFstring *str = strmap_del(map, &val->id, NULL);
+    if (val->category == RIR_VALUE_VARIABLE) {
+        RF_ASSERT(current_fn, "Variables can only be removed from inside a function");
+        if (current_fn && val->id < darray_size(current_fn->values)) {
+            darray_item(current_fn->values, val->id) = NULL;
+        }
+        return;
+    }
+    if (val->category != RIR_VALUE_LABEL && val->category != RIR_VALUE_LITERAL) {
+        return;
+    }
+    struct RFstring *str = current_fn ? strmap_del(&current_fn->map, &val->name, NULL) : NULL;
     if (!str) {
-        str = strmap_del(&r->map, &val->id, NULL);
+        pthread_mutex_lock(&r->globals_lock);
+        str = strmap_del(&r->map, &val->name, NULL);
+        pthread_mutex_unlock(&r->globals_lock);
     }
     RF_ASSERT(str, "Could not find object for removal in the current function or in the global rir string map");
 }
@@ -72,7 +110,7 @@ void rir_object_listrem(struct rir_object *obj, struct rir *r, struct rir_fndef
 void rir_object_listrem_destroy(struct rir_object *obj, struct rir *r, struct rir_fndef *current_fn)
 {
     rir_object_listrem(obj, r, current_fn);
-    rir_object_destroy(obj);
+    rir_object_destroy(obj, r);
 }
 
 struct rir_typedef *rir_object_get_typedef(struct rir_object *obj)
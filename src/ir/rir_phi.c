@@ -0,0 +1,86 @@
+#include <ir/rir_phi.h>
+
+#include <rfbase/utils/memory.h>
+#include <rfbase/string/manipulationx.h>
+
+#include <ir/rir.h>
+#include <ir/rir_object.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_type.h>
+#include <ir/rir_value.h>
+
+struct rir_object *rir_phi_create_obj(
+    const struct rir_type *type,
+    enum rir_pos pos,
+    rir_data data
+)
+{
+    struct rir_object *ret = rir_object_create(RIR_OBJ_EXPRESSION, rir_data_rir(data));
+    if (!ret) {
+        return NULL;
+    }
+    ret->expr.phi.type = type;
+    darray_init(ret->expr.phi.incoming);
+    if (!rir_object_expression_init(ret, RIR_EXPRESSION_PHI, pos, data)) {
+        darray_free(ret->expr.phi.incoming);
+        rir_object_free(ret, rir_data_rir(data));
+        ret = NULL;
+    }
+    return ret;
+}
+
+struct rir_expression *rir_phi_create(
+    const struct rir_type *type,
+    enum rir_pos pos,
+    rir_data data
+)
+{
+    struct rir_object *obj = rir_phi_create_obj(type, pos, data);
+    return obj ? &obj->expr : NULL;
+}
+
+void rir_phi_add_incoming(struct rir_phi *phi,
+                          const struct rir_value *val,
+                          const struct rir_value *block)
+{
+    struct rir_phi_incoming in;
+    in.val = val;
+    in.block = block;
+    darray_append(phi->incoming, in);
+}
+
+void rir_phi_deinit(struct rir_phi *phi)
+{
+    darray_free(phi->incoming);
+}
+
+i_INLINE_INS unsigned rir_phi_incoming_num(const struct rir_phi *phi);
+
+bool rir_phi_tostring(struct rirtostr_ctx *ctx, const struct rir_expression *e)
+{
+    struct rir_phi_incoming *in;
+    bool ret = false;
+    RFS_PUSH();
+    if (!rf_stringx_append(
+            ctx->rir->buff,
+            RFS(RIRTOSTR_INDENT RFS_PF" = phi("RFS_PF,
+                RFS_PA(rir_value_string(&e->val)),
+                RFS_PA(rir_type_string(e->phi.type)))
+        )) {
+        goto end;
+    }
+    darray_foreach(in, e->phi.incoming) {
+        if (!rf_stringx_append(
+                ctx->rir->buff,
+                RFS(", "RFS_PF", %%"RFS_PF,
+                    RFS_PA(rir_value_string(in->val)),
+                    RFS_PA(rir_value_string(in->block)))
+            )) {
+            goto end;
+        }
+    }
+    ret = rf_stringx_append_cstr(ctx->rir->buff, ")\n");
+end:
+    RFS_POP();
+    return ret;
+}
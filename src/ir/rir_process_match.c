@@ -95,36 +95,11 @@ bool rir_match_st_populate_allocas(const struct ast_node *mcase, struct rir_obje
 }
 
 static struct rir_block *rir_process_matchcase(
-    const struct ast_node *mexpr,
     struct rir_object *matched_rir_obj,
-    struct rir_value *uni_idx,
-    struct ast_matchexpr_it *it,
-    struct rir_block *before_block,
     struct rir_block *after_block,
     struct ast_node *mcase,
     struct rir_ctx *ctx)
 {
-    struct rir_expression *cmp = NULL;
-    struct rir_block *this_block = rir_ctx_curr_block(ctx);
-    struct rir_value *case_rir_idx = rir_constantval_create_fromint32(ast_matchcase_index_get(mcase), rir_ctx_rir(ctx));
-    bool need_case_cmp = !ast_match_expr_next_case_is_last(mexpr, it) || this_block == before_block;
-    if (need_case_cmp) {
-        if (this_block != before_block) {
-            //create new empty block for the comparisons
-            this_block = rir_block_create_from_ast(NULL, BLOCK_POSITION_NORMAL, ctx);
-            rir_fndef_add_block(rir_ctx_curr_fn(ctx), this_block);
-        }
-        // Create index comparison for match case
-        cmp = rir_binaryop_create_nonast(
-            RIR_EXPRESSION_CMP_EQ,
-            uni_idx,
-            case_rir_idx,
-            RIRPOS_AST,
-            ctx
-        );
-        rir_common_block_add(&ctx->common, cmp);
-    }
-
     // use this match case symbol table now
     rir_ctx_push_st(ctx, ast_matchcase_symbol_table_get(mcase));
 
@@ -154,25 +129,6 @@ static struct rir_block *rir_process_matchcase(
     if (!rir_block_exit_init_branch(&taken->exit, &after_block->label)) {
         return NULL;
     }
-
-    //try to get next case
-    struct ast_node *next_case = ast_matchexpr_next_case(mexpr, it);
-    if (next_case) {
-        struct rir_block *next_case_block = rir_process_matchcase(mexpr, matched_rir_obj, uni_idx, it, before_block, after_block, next_case, ctx);
-        if (need_case_cmp) {
-            if (!rir_block_exit_init_condbranch(&this_block->exit, &cmp->val, &taken->label, &next_case_block->label)) {
-                return NULL;
-            }
-            return this_block;
-        }
-    } else {
-        // last taken needs to also connect to the after
-        // TODO: Last taken should also have a conditional. Maybe only with a specific compiler argument
-        // we should check if the sum type actually matched anything and if not terminate the program
-        if (!rir_block_exit_init_branch(&taken->exit, &after_block->label)) {
-            return NULL;
-        }
-    }
     return taken;
 }
 
@@ -208,23 +164,34 @@ bool rir_process_matchexpr(struct ast_node *n, struct rir_ctx *ctx)
         after_block = rir_value_label_dst(rir_ctx_curr_fn(ctx)->end_label);
     }
 
+    struct rir_block *switch_block = rir_ctx_curr_block(ctx);
     struct rir_expression *uni_idx = rir_getunionidx_create(rir_object_value(matched_obj), RIRPOS_AST, ctx);
     rir_common_block_add(&ctx->common, uni_idx);
+    // dispatch to the cases with a single switch on the union index. The
+    // fallthrough is set to the last case below so that, as with an exhaustive
+    // match, it needs no comparison of its own.
+    if (!rir_block_exit_init_switch(&switch_block->exit, &uni_idx->val, NULL)) {
+        goto fail;
+    }
+
     struct ast_matchexpr_it it;
+    struct ast_node *next_case;
+    struct rir_block *case_block;
     struct ast_node *mcase = ast_matchexpr_first_case(n, &it);
-    struct rir_block *first_case_block = rir_process_matchcase(
-        n,
-        matched_obj,
-        &uni_idx->val,
-        &it,
-        rir_ctx_curr_block(ctx),
-        after_block,
-        mcase,
-        ctx
-    );
-
-    if (!first_case_block) {
-        goto fail;
+    while (mcase) {
+        if (!(case_block = rir_process_matchcase(matched_obj, after_block, mcase, ctx))) {
+            goto fail;
+        }
+        if ((next_case = ast_matchexpr_next_case(n, &it))) {
+            rir_switch_add_case(
+                &switch_block->exit.switchbr,
+                rir_constantval_create_fromint32(ast_matchcase_index_get(mcase), rir_ctx_rir(ctx)),
+                &case_block->label
+            );
+        } else {
+            switch_block->exit.switchbr.fallthrough = &case_block->label;
+        }
+        mcase = next_case;
     }
 
     // for normal matchexpr, after_block was an empty block so let's add it to the function now
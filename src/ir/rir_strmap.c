@@ -71,12 +71,37 @@ bool rir_map_addobj(
 }
 
 
+bool rir_map_addvar(struct rir_common *c, uint32_t id, struct rir_object *obj)
+{
+    struct rir_fndef *fn = c->current_fn;
+    if (!fn) {
+        return false;
+    }
+    while (darray_size(fn->values) <= id) {
+        darray_append(fn->values, NULL);
+    }
+    if (darray_item(fn->values, id)) {
+        return false;
+    }
+    darray_item(fn->values, id) = obj;
+    return true;
+}
+
 struct rir_object *rir_map_getobj(struct rir_common *c,
                                   const struct RFstring *id)
 {
-    struct rir_object *ret = strmap_get(rir_common_curr_map(c), id);
+    uint32_t varid;
+    if (rir_value_id_from_string(id, &varid)) {
+        if (!c->current_fn || varid >= darray_size(c->current_fn->values)) {
+            return NULL;
+        }
+        return darray_item(c->current_fn->values, varid);
+    }
+    struct rir_object *ret = c->current_fn ? strmap_get(&c->current_fn->map, id) : NULL;
     if (!ret) {
+        pthread_mutex_lock(&c->rir->globals_lock);
         ret = strmap_get(&c->rir->map, id);
+        pthread_mutex_unlock(&c->rir->globals_lock);
     }
     return ret;
 }
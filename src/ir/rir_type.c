@@ -40,7 +40,9 @@ struct rir_type *rir_type_alloc(struct rir *r)
 void rir_type_destroy(struct rir_type *t, struct rir *r)
 {
     if (t->category != RIR_TYPE_ELEMENTARY) {
+        pthread_mutex_lock(&r->types_lock);
         rf_fixed_memorypool_free_element(r->rir_types_pool, t);
+        pthread_mutex_unlock(&r->types_lock);
     }
 }
 
@@ -90,6 +92,7 @@ struct rir_type *rir_type_elem_get_or_create(
 {
     RFS_PUSH();
     const struct RFstring *id = rir_form_elemtype_string(etype, is_pointer);
+    pthread_mutex_lock(&r->types_lock);
     struct rir_type *ret = rirtype_strmap_get(&r->types_map, id);
     if (ret) {
         goto end;
@@ -103,6 +106,7 @@ struct rir_type *rir_type_elem_get_or_create(
     rirtype_strmap_add(&r->types_map, id, ret);
 
 end:
+    pthread_mutex_unlock(&r->types_lock);
     RFS_POP();
     return ret;
 }
@@ -121,6 +125,7 @@ struct rir_type *rir_type_comp_get_or_create(
 {
     RFS_PUSH();
     const struct RFstring *id = rir_form_comptype_string(def, is_pointer);
+    pthread_mutex_lock(&r->types_lock);
     struct rir_type *ret = rirtype_strmap_get(&r->types_map, id);
     if (ret) {
         RF_ASSERT(ret->is_pointer == is_pointer, "Should never happen.");
@@ -134,6 +139,7 @@ struct rir_type *rir_type_comp_get_or_create(
     rir_type_comp_init(ret, def, is_pointer);
     rirtype_strmap_add(&r->types_map, id, ret);
 end:
+    pthread_mutex_unlock(&r->types_lock);
     RFS_POP();
     return ret;
 }
@@ -162,6 +168,7 @@ struct rir_type *rir_type_arr_get_or_create(
         size,
         is_pointer
     );
+    pthread_mutex_lock(&r->types_lock);
     struct rir_type *ret = rirtype_strmap_get(&r->types_map, id);
     if (ret) {
         RF_ASSERT(ret->is_pointer == is_pointer, "Should never happen.");
@@ -175,6 +182,7 @@ struct rir_type *rir_type_arr_get_or_create(
     rir_type_arr_init(ret, pointing_type, size, is_pointer);
     rirtype_strmap_add(&r->types_map, id, ret);
 end:
+    pthread_mutex_unlock(&r->types_lock);
     RFS_POP();
     return ret;
 }
@@ -1,6 +1,9 @@
 #include <ir/rir_typedef.h>
 
 #include <rfbase/utils/memory.h>
+#include <rfbase/utils/hash.h>
+#include <rfbase/utils/fixed_memory_pool.h>
+#include <rfbase/utils/container_of.h>
 #include <rfbase/string/manipulationx.h>
 #include <rfbase/string/core.h>
 #include <rfbase/math/math.h>
@@ -11,6 +14,29 @@
 #include <types/type.h>
 #include <types/type_operators.h>
 
+/**
+ * Make the typedef @a obj of type @a t visible in the symbol table of @a ctx
+ */
+static bool rir_typedef_st_add(struct rir_object *obj,
+                               const struct type *t,
+                               struct rir_ctx *ctx)
+{
+    if (type_is_defined(t)) {
+        // set the typedef rir object in the symbol table
+        if (!rir_ctx_st_setobj(ctx, &obj->tdef.name, obj)) {
+            RF_ERROR("Failed to set the typedef rir object in the symbol table");
+            return false;
+        }
+        return true;
+    }
+    // since this is a new, "internally created" type create a new symbol table record
+    if (!rir_ctx_st_newobj(ctx, &obj->tdef.name, (struct type*)t, obj)) {
+        RF_ERROR("Failed to create new symbol table record for a rir created type");
+        return false;
+    }
+    return true;
+}
+
 static bool rir_typedef_init_from_type(
     struct rir_object *obj,
     struct type *t,
@@ -29,12 +55,6 @@ static bool rir_typedef_init_from_type(
             RF_ERROR("Failed to set copy a string to a typedef");
             return false;
         }
-        t = type_defined_get_type(t);
-        // set the typedef rir object in the symbol table
-        if (!rir_ctx_st_setobj(ctx, &def->name, obj)) {
-            RF_ERROR("Failed to set the typedef rir object in the symbol table");
-            return false;
-        }
     } else {
         RFS_PUSH();
         if (!rf_string_copy_in(&def->name, type_get_unique_type_str(t))) {
@@ -43,11 +63,12 @@ static bool rir_typedef_init_from_type(
             return false;
         }
         RFS_POP();
-        // since this is a new, "internally created" type create a new symbol table record
-        if (!rir_ctx_st_newobj(ctx, &def->name, t, obj)) {
-            RF_ERROR("Failed to create new symbol table record for a rir created type");
-            return false;
-        }
+    }
+    if (!rir_typedef_st_add(obj, t, ctx)) {
+        return false;
+    }
+    if (type_is_defined(t)) {
+        t = type_defined_get_type(t);
     }
     if (!rir_typearr_from_type(&def->argument_types, t, RIR_LOC_TYPEDESC, ctx)) {
         RF_ERROR("Failed to turn a type to an arg array");
@@ -70,7 +91,7 @@ static struct rir_object *rir_typedef_create_obj_from_type(struct type *t, struc
         return NULL;
     }
     if (!rir_typedef_init_from_type(ret, t, ctx)) {
-        free(ret);
+        rir_object_free(ret, ctx->common.rir);
         ret = NULL;
     }
     return ret;
@@ -82,6 +103,91 @@ struct rir_typedef *rir_typedef_create_from_type(struct type *t, struct rir_ctx
     return obj ? &obj->tdef : NULL;
 }
 
+struct rir_typedef_regentry {
+    const struct type *type;
+    struct rir_typedef *def;
+};
+
+static size_t rir_typedef_regentry_hash(const void *e, void *priv)
+{
+    return hash_pointer(((const struct rir_typedef_regentry*)e)->type, 0);
+}
+
+static bool rir_typedef_regentry_cmp(const void *e, void *type)
+{
+    return ((const struct rir_typedef_regentry*)e)->type == type;
+}
+
+bool rir_typedef_registry_init(struct rir_typedef_registry *reg)
+{
+    reg->pool = rf_fixed_memorypool_create(sizeof(struct rir_typedef_regentry),
+                                           RIR_TYPEDEF_REGISTRY_CHUNK_SIZE);
+    if (!reg->pool) {
+        return false;
+    }
+    htable_init(&reg->table, rir_typedef_regentry_hash, NULL);
+    return true;
+}
+
+void rir_typedef_registry_deinit(struct rir_typedef_registry *reg)
+{
+    htable_clear(&reg->table);
+    rf_fixed_memorypool_destroy(reg->pool);
+}
+
+static bool rir_typedef_import(struct rir_typedef *def,
+                               const struct type *t,
+                               struct rir_ctx *ctx)
+{
+    struct rir *r = rir_ctx_rir(ctx);
+    struct rir_object *obj = container_of(def, struct rir_object, tdef);
+    if (rir_typedef_frommap(r, &def->name) == def) {
+        // reachable through more than one dependency
+        return true;
+    }
+    if (!rir_typedef_st_add(obj, t, ctx)) {
+        return false;
+    }
+    if (!rir_map_addobj(&ctx->common, &def->name, obj)) {
+        RF_ERROR("Failed to add a typedef to the rir strmap");
+        return false;
+    }
+    darray_append(r->imported_typedefs, def);
+    return true;
+}
+
+bool rir_typedef_add_from_type(struct type *t,
+                               struct rir_typedef_registry *reg,
+                               struct rir_ctx *ctx)
+{
+    struct rir_typedef_regentry *entry = htable_get(
+        &reg->table,
+        hash_pointer(t, 0),
+        rir_typedef_regentry_cmp,
+        t
+    );
+    if (entry) {
+        return rir_typedef_import(entry->def, t, ctx);
+    }
+
+    struct rir_typedef *def = rir_typedef_create_from_type(t, ctx);
+    if (!def) {
+        return false;
+    }
+    rf_ilist_add_tail(&rir_ctx_rir(ctx)->typedefs, &def->ln);
+    if (!(entry = rf_fixed_memorypool_alloc_element(reg->pool))) {
+        RF_ERROR("Failed to allocate a typedef registry entry");
+        return false;
+    }
+    entry->type = t;
+    entry->def = def;
+    if (!htable_add(&reg->table, hash_pointer(t, 0), entry)) {
+        RF_ERROR("Failed to add a typedef to the registry");
+        return false;
+    }
+    return true;
+}
+
 struct rir_object *rir_typedef_create_obj(
     struct rir *r,
     struct rir_fndef *curr_fn,
@@ -1,5 +1,7 @@
 #include <ir/rir_value.h>
 
+#include <inttypes.h>
+
 #include <rfbase/string/core.h>
 #include <rfbase/string/manipulationx.h>
 #include <rfbase/utils/memory.h>
@@ -14,15 +16,6 @@
 #include <types/type_elementary.h>
 #include <utils/common_strings.h>
 
-void rir_valuearr_deinit(struct value_arr *arr, enum rvalue_pos pos)
-{
-    struct rir_value **v;
-    darray_foreach(v, *arr) {
-        rir_value_destroy(*v, pos);
-    }
-    darray_free(*arr);
-}
-
 bool rir_valuearr_tostring_close(struct rirtostr_ctx *ctx, const struct value_arr *arr)
 {
     RFS_PUSH();
@@ -56,10 +49,10 @@ bool rir_value_label_init_string(
     RF_ASSERT(obj->category == RIR_OBJ_BLOCK, "Expected rir block object");
     v->category = RIR_VALUE_LABEL;
     v->label_dst = &obj->block;
-    if (!rf_string_copy_in(&v->id, s)) {
+    if (!rf_string_copy_in(&v->name, s)) {
         return false;
     }
-    return rir_map_addobj(common, &v->id, obj);
+    return rir_map_addobj(common, &v->name, obj);
 }
 
 bool rir_value_constant_init(
@@ -68,7 +61,6 @@ bool rir_value_constant_init(
     struct rir *r,
     enum elementary_type type)
 {
-    bool ret;
     v->category = RIR_VALUE_CONSTANT;
     v->constant = *c;
     switch (v->constant.type) {
@@ -79,7 +71,6 @@ bool rir_value_constant_init(
             type != ELEMENTARY_TYPE_TYPES_COUNT ? type : ELEMENTARY_TYPE_INT_64,
             false
         );
-        ret = rf_string_initv(&v->id, "%"PRId64, v->constant.value.integer);
         break;
     case CONSTANT_NUMBER_FLOAT:
         RF_ASSERT(type == ELEMENTARY_TYPE_TYPES_COUNT || elementary_type_is_float(type), "Should have gotten a floating type here");
@@ -88,7 +79,6 @@ bool rir_value_constant_init(
             type != ELEMENTARY_TYPE_TYPES_COUNT ? type : ELEMENTARY_TYPE_FLOAT_64,
             false
         );
-        ret = rf_string_initv(&v->id, "%f", v->constant.value.floating);
         break;
     case CONSTANT_BOOLEAN:
         v->type = rir_type_elem_get_or_create(
@@ -96,10 +86,9 @@ bool rir_value_constant_init(
             ELEMENTARY_TYPE_BOOL,
             false
         );
-        ret = rf_string_initv(&v->id, "%s", v->constant.value.boolean ? "true" : "false");
         break;
     }
-    return ret;
+    return v->type != NULL;
 }
 
 bool rir_value_static_constant_init(
@@ -107,25 +96,11 @@ bool rir_value_static_constant_init(
     const struct ast_constant *c,
     struct rir_type *t)
 {
-    bool ret;
     v->category = RIR_VALUE_CONSTANT;
     v->constant = *c;
     RF_ASSERT(t && t->category == RIR_TYPE_ELEMENTARY, "rir type should be elementary here");
-    switch (v->constant.type) {
-    case CONSTANT_NUMBER_INTEGER:
-        v->type = t;
-        ret = rf_string_initv(&v->id, "%"PRId64, v->constant.value.integer);
-        break;
-    case CONSTANT_NUMBER_FLOAT:
-        v->type = t;
-        ret = rf_string_initv(&v->id, "%f", v->constant.value.floating);
-        break;
-    case CONSTANT_BOOLEAN:
-        v->type = t;
-        ret = rf_string_initv(&v->id, "%s", v->constant.value.boolean ? "true" : "false");
-        break;
-    }
-    return ret;
+    v->type = t;
+    return true;
 }
 
 bool rir_value_literal_init(
@@ -137,13 +112,13 @@ bool rir_value_literal_init(
 {
     v->category = RIR_VALUE_LITERAL;
     v->type = rir_type_elem_get_or_create(r, ELEMENTARY_TYPE_STRING, false);
-    if (!rf_string_copy_in(&v->id, name)) {
+    if (!rf_string_copy_in(&v->name, name)) {
         return false;
     }
     if (!rf_string_copy_in(&v->literal, value)) {
         return false;
     }
-    return rirobj_strmap_add(&r->map, &v->id, obj);
+    return rirobj_strmap_add(&r->map, &v->name, obj);
 }
 
 bool rir_value_variable_init(
@@ -160,14 +135,13 @@ bool rir_value_variable_init(
     // interpret data
     if (pos == RIRPOS_AST) {
         struct rir_ctx *ctx = data;
-        if (!rf_string_initv(&v->id, "$%d", ctx->expression_idx++)) {
-            return false;
-        }
+        v->id = ctx->expression_idx++;
         c = &ctx->common;
     } else {
         struct rir_pctx *ctx = data;
         RF_ASSERT(ctx->id, "Expected a string in the context");
-        if (!rf_string_copy_in(&v->id, ctx->id)) {
+        if (!rir_value_id_from_string(ctx->id, &v->id)) {
+            RF_ERROR("\""RFS_PF"\" is not a valid rir variable identifier", RFS_PA(ctx->id));
             return false;
         }
         c = data;
@@ -193,6 +167,9 @@ bool rir_value_variable_init(
         case RIR_EXPRESSION_GETUNIONIDX:
             v->type = rir_type_elem_get_or_create(c->rir, ELEMENTARY_TYPE_INT_64, false);
             break;
+        case RIR_EXPRESSION_PHI:
+            v->type = rir_type_get_or_create_from_other(expr->phi.type, c->rir, false);
+            break;
         case RIR_EXPRESSION_READ:
             if (!expr->read.memory->type->is_pointer) {
                 RF_ERROR("Tried to rir read from a location not in memory");
@@ -279,11 +256,11 @@ bool rir_value_variable_init(
     } else {
         RF_CRITICAL_FAIL("TODO ... should this even ever happen?");
     }
-    // finally add it to the rir strmap
-    ret = rir_map_addobj(c, &v->id, obj);
+    // finally add it to the function's variables
+    ret = rir_map_addvar(c, v->id, obj);
     if (!ret) {
         // already exists? (should not happen)
-        RF_ERROR("Could not add rir value \""RFS_PF"\" to map.", RFS_PA(&v->id));
+        RF_ERROR("Could not add rir value \"$%"PRIu32"\" to map.", v->id);
     }
 
 end:
@@ -298,51 +275,73 @@ void rir_value_nil_init(struct rir_value *v)
 
 void rir_value_deinit(struct rir_value *v)
 {
-    if (v->category != RIR_VALUE_NIL) {
-        rf_string_deinit(&v->id);
+    if (v->category == RIR_VALUE_LABEL || v->category == RIR_VALUE_LITERAL) {
+        rf_string_deinit(&v->name);
     }
     if (v->category == RIR_VALUE_LITERAL) {
         rf_string_deinit(&v->literal);
     }
 }
 
-void rir_value_destroy(struct rir_value *v, enum rvalue_pos pos)
+bool rir_value_id_from_string(const struct RFstring *s, uint32_t *id)
 {
-    if (pos == RIR_VALUE_PARSING && v->category == RIR_VALUE_VARIABLE) {
-        return; // rir_parse_value() does not create new values there so don't destroy now
+    const char *p = rf_string_data(s);
+    const char *end = p + rf_string_length_bytes(s);
+    uint64_t n = 0;
+    if (p == end || *p != '$' || ++p == end) {
+        return false;
     }
-    rir_value_deinit(v);
-    free(v);
+    for (; p != end; ++p) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        n = n * 10 + (*p - '0');
+        if (n > UINT32_MAX) {
+            return false;
+        }
+    }
+    *id = (uint32_t)n;
+    return true;
 }
 
 bool rir_value_tostring(struct rir *r, const struct rir_value *v)
 {
+    bool ret = true;
+    RFS_PUSH();
     switch (v->category) {
     case RIR_VALUE_LABEL:
-        if (!rf_stringx_append(r->buff, RFS("%%"RFS_PF, RFS_PA(&v->id)))) {
-            return false;
-        }
+        ret = rf_stringx_append(r->buff, RFS("%%"RFS_PF, RFS_PA(&v->name)));
         break;
     case RIR_VALUE_CONSTANT:
     case RIR_VALUE_VARIABLE:
     case RIR_VALUE_LITERAL:
-        if (!rf_stringx_append(r->buff, &v->id)) {
-            return false;
-        }
+        ret = rf_stringx_append(r->buff, rir_value_string(v));
+        break;
     case RIR_VALUE_NIL:
         break;
     }
-    return true;
+    RFS_POP();
+    return ret;
 }
 
 const struct RFstring *rir_value_string(const struct rir_value *v)
 {
     switch (v->category) {
     case RIR_VALUE_CONSTANT:
+        switch (v->constant.type) {
+        case CONSTANT_NUMBER_INTEGER:
+            return RFS("%"PRId64, v->constant.value.integer);
+        case CONSTANT_NUMBER_FLOAT:
+            return RFS("%f", v->constant.value.floating);
+        case CONSTANT_BOOLEAN:
+            return RFS("%s", v->constant.value.boolean ? "true" : "false");
+        }
+        break;
     case RIR_VALUE_VARIABLE:
+        return RFS("$%"PRIu32, v->id);
     case RIR_VALUE_LABEL:
     case RIR_VALUE_LITERAL:
-        return &v->id;
+        return &v->name;
     case RIR_VALUE_NIL:
         break;
     }
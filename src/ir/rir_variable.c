@@ -22,7 +22,7 @@ struct rir_object *rir_variable_create(
         return NULL;
     }
     if (!rir_variable_init(ret, type, pos, data)) {
-        free(ret);
+        rir_object_free(ret, rir_data_rir(data));
         ret = NULL;
     }
     return ret;
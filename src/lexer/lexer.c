@@ -4,6 +4,7 @@
 #include <rfbase/string/conversion.h>
 
 #include <inpfile.h>
+#include <utils/stats.h>
 #include <ast/constants.h>
 #include <ast/string_literal.h>
 
@@ -636,6 +637,7 @@ bool lexer_scan(struct lexer *l)
         }
         inpfile_move(l->file, p - sp, p - sp);
     }
+    stats_add(STATS_TOKENS, darray_size(l->tokens));
     return true;
 }
 
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <rfbase/refu.h>
 #include <compiler.h>
+#include <compiler_args.h>
 
 int main(int argc, char **argv)
 {
@@ -25,6 +26,10 @@ int main(int argc, char **argv)
         return 1; // don't bother freeing stuff, just exit with error
     }
 
+    // if the program was run in process exit with its return value
+    int rc = compiler_args_jit_run(compiler->args) || compiler_args_interpret(compiler->args)
+        ? compiler->run_retcode
+        : 0;
     compiler_destroy(compiler);
-    return 0;
+    return rc;
 }
@@ -5,6 +5,7 @@
 #include <utils/common_strings.h>
 #include <compiler.h>
 #include <utils/common_strings.h>
+#include <utils/stats.h>
 #include <parser/parser_common.h>
 #include <front_ctx.h>
 #include <ast/ast.h>
@@ -243,23 +244,33 @@ bool module_analyze(struct module *m)
     bool ret = false;
     // since analyze pass is always going to be one per thread initializing
     // thread local type creation context here should be okay
+    bool ok;
     type_creation_ctx_init();
     // create symbol tables and change ast nodes ownership
-    if (!analyzer_first_pass(m)) {
+    stats_phase_begin("pass1");
+    ok = analyzer_first_pass(m);
+    stats_phase_end();
+    if (!ok) {
         if (!module_have_errors(m)) {
             RF_ERROR("Failure at module analysis first pass");
         }
         goto end;
     }
 
-    if (!analyzer_typecheck(m, m->node)) {
+    stats_phase_begin("typecheck");
+    ok = analyzer_typecheck(m, m->node);
+    stats_phase_end();
+    if (!ok) {
         if (!module_have_errors(m)) {
             RF_ERROR("Failure at module's typechecking");
         }
         goto end;
     }
 
-    if (!analyzer_finalize(m)) {
+    stats_phase_begin("finalize");
+    ok = analyzer_finalize(m);
+    stats_phase_end();
+    if (!ok) {
         RF_ERROR("Failure at module's finalization");
         goto end;
     }
@@ -0,0 +1,32 @@
+#ifndef LFR_OWNERSHIP_CTX_H
+#define LFR_OWNERSHIP_CTX_H
+
+#include <stdbool.h>
+
+struct rir;
+struct ow_graph;
+
+/**
+ * Ownership analysis one module at a time. ownership_pass() does this for
+ * every module of the compiler. Done separately the graphs of a module can
+ * be looked at before the next module replaces them.
+ *
+ * @param jobs           Number of threads to analyze the functions of each
+ *                       module with
+ */
+void ow_ctx_begin(unsigned int jobs);
+void ow_ctx_end();
+
+/**
+ * Analyze a module. Its dependencies should have been analyzed before so
+ * that calls into them can use their summaries.
+ */
+bool ow_ctx_module_pass(struct rir *r);
+
+/**
+ * @return The graphs of the module analyzed last, in the order they were
+ *         created. Their number is returned in @a num.
+ */
+struct ow_graph **ow_ctx_graphs(unsigned int *num);
+
+#endif
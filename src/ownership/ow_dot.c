@@ -0,0 +1,116 @@
+#include "ow_dot.h"
+
+#include <stdio.h>
+
+#include <rfbase/string/core.h>
+#include <rfbase/string/corex.h>
+#include <rfbase/utils/log.h>
+
+#include <ir/rir_expression.h>
+
+#include "ow_edge.h"
+#include "ow_graph.h"
+
+static bool ow_dot_node(struct RFstringx *out, const struct ow_node *n)
+{
+    bool ret;
+    RFS_PUSH();
+    ret = rf_stringx_append(out, RFS("    \""RFS_PF"\";\n", RFS_PA(ow_node_id(n))));
+    RFS_POP();
+    return ret;
+}
+
+static bool ow_dot_edges(struct RFstringx *out, const struct ow_node *n)
+{
+    struct ow_edge *edge;
+    bool ret = true;
+    RFS_PUSH();
+    ow_node_foreach_edge(n, edge) {
+        ret = rf_stringx_append(out, RFS(
+            "  \""RFS_PF"\" -> \""RFS_PF"\" [label=\"%u - "RFS_PF"\"];\n",
+            RFS_PA(ow_node_id(n)),
+            RFS_PA(ow_node_id(edge->to)),
+            edge->counter,
+            RFS_PA(edge->edgeexpr
+                   ? rir_expression_type_string(edge->edgeexpr)
+                   : ow_node_end_type_str(OW_END_RETURN))
+        ));
+        if (!ret) {
+            break;
+        }
+    }
+    RFS_POP();
+    return ret;
+}
+
+bool ow_graphs_to_dot(struct RFstringx *out,
+                      const struct RFstring *name,
+                      struct ow_graph * const *graphs,
+                      unsigned int graphs_num)
+{
+    struct rf_objset_iter it;
+    struct ow_node *n;
+    const struct RFstring *fn_name = NULL;
+    unsigned int i;
+    bool ret = false;
+    RFS_PUSH();
+    if (!rf_stringx_append(out, RFS("digraph \""RFS_PF"\" {\n", RFS_PA(name)))) {
+        goto end;
+    }
+    // every node goes in the cluster of its function, before any edge
+    // mentions it and places it outside
+    for (i = 0; i < graphs_num; ++i) {
+        if (!fn_name || !rf_string_equal(fn_name, graphs[i]->fn_name)) {
+            if (fn_name && !rf_stringx_append_cstr(out, "  }\n")) {
+                goto end;
+            }
+            fn_name = graphs[i]->fn_name;
+            if (!rf_stringx_append(out, RFS(
+                    "  subgraph \"cluster_"RFS_PF"\" {\n    label=\""RFS_PF"\";\n",
+                    RFS_PA(fn_name), RFS_PA(fn_name)))) {
+                goto end;
+            }
+        }
+        rf_objset_foreach(&graphs[i]->set, &it, n) {
+            if (!ow_dot_node(out, n)) {
+                goto end;
+            }
+        }
+    }
+    if (fn_name && !rf_stringx_append_cstr(out, "  }\n")) {
+        goto end;
+    }
+    for (i = 0; i < graphs_num; ++i) {
+        rf_objset_foreach(&graphs[i]->set, &it, n) {
+            if (!ow_dot_edges(out, n)) {
+                goto end;
+            }
+        }
+    }
+    ret = rf_stringx_append_cstr(out, "}\n");
+end:
+    RFS_POP();
+    return ret;
+}
+
+bool ow_dot_write(const struct RFstring *dot, const struct RFstring *path)
+{
+    FILE *f;
+    bool ret;
+    RFS_PUSH();
+    f = fopen(rf_string_data(RFS_NT_OR_DIE(RFS_PF, RFS_PA(path))), "w");
+    RFS_POP();
+    if (!f) {
+        RF_ERROR("Could not open \""RFS_PF"\" for writing", RFS_PA(path));
+        return false;
+    }
+    ret = fwrite(rf_string_data(dot), 1, rf_string_length_bytes(dot), f) ==
+        rf_string_length_bytes(dot);
+    if (fclose(f) != 0) {
+        ret = false;
+    }
+    if (!ret) {
+        RF_ERROR("Failed to write the ownership graph to \""RFS_PF"\"", RFS_PA(path));
+    }
+    return ret;
+}
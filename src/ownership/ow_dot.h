@@ -0,0 +1,31 @@
+#ifndef LFR_OWNERSHIP_DOT_H
+#define LFR_OWNERSHIP_DOT_H
+
+#include <stdbool.h>
+
+struct ow_graph;
+struct RFstring;
+struct RFstringx;
+
+/**
+ * Write ownership graphs as a single graph in the DOT language. The graphs
+ * of each function are grouped in a cluster of their own.
+ *
+ * @param out            The string to append the DOT text to
+ * @param name           The name to give to the whole graph
+ * @param graphs         The graphs to write. Graphs of the same function
+ *                       should be consecutive.
+ * @param graphs_num     The number of graphs in @a graphs
+ * @return               false in failure
+ */
+bool ow_graphs_to_dot(struct RFstringx *out,
+                      const struct RFstring *name,
+                      struct ow_graph * const *graphs,
+                      unsigned int graphs_num);
+
+/**
+ * Write DOT text to the file at @a path
+ */
+bool ow_dot_write(const struct RFstring *dot, const struct RFstring *path);
+
+#endif
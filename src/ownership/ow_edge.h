@@ -14,21 +14,27 @@ struct ow_edge {
     //! Can be NULL. Example: for returns
     const struct rir_expression *edgeexpr;
     struct ow_node *to;
+    //! The next edge going out of the same node
+    struct ow_edge *next;
     unsigned int counter;
 };
 
+/**
+ * Iterate the edges going out of node @a n_
+ */
+#define ow_node_foreach_edge(n_, e_)                            \
+    for ((e_) = (n_)->edges; (e_); (e_) = (e_)->next)
+
 /**
  * Create an edge to a new node by specifying a value to create a node for
  */
-struct ow_edge *ow_edge_create(const struct rir_expression *expr, const struct RFstring *name, const struct rir_value *nodev, unsigned int counter);
+struct ow_edge *ow_edge_create(struct ow_pools *pools, const struct rir_expression *expr, const struct RFstring *name, const struct rir_value *nodev, unsigned int counter);
 /**
  * Create an edge to an end node
  */
-struct ow_edge *ow_endedge_create(const struct rir_expression *expr, const struct RFstring *fnname, enum ow_end_type end_type, unsigned int counter);
+struct ow_edge *ow_endedge_create(struct ow_pools *pools, const struct rir_expression *expr, const struct RFstring *fnname, enum ow_end_type end_type, unsigned int counter);
 /**
  * Create an edge without allocating a new node but just pointing to it
  */
-struct ow_edge *ow_edge_create_from_node(const struct rir_expression *expr, struct ow_node *tonode, unsigned int counter);
-
-void ow_edge_destroy(struct ow_edge *e);
+struct ow_edge *ow_edge_create_from_node(struct ow_pools *pools, const struct rir_expression *expr, struct ow_node *tonode, unsigned int counter);
 #endif
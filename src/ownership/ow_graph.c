@@ -1,15 +1,50 @@
 #include "ow_graph.h"
 
 #include <rfbase/string/core.h>
+#include <rfbase/utils/fixed_memory_pool.h>
 
 #include "ow_debug.h"
+#include "ow_edge.h"
 #include <ownership/ownership.h>
 #include <ir/rir_object.h>
 
-struct ow_passed_loc *ow_passed_loc_create(const struct rir_call *c, struct ow_node *n, unsigned int idx)
+struct ow_pools *ow_pools_create()
+{
+    struct ow_pools *p;
+    RF_MALLOC(p, sizeof(*p), return NULL);
+    RF_STRUCT_ZERO(p);
+    if (!(p->nodes = rf_fixed_memorypool_create(sizeof(struct ow_node), OW_NODES_POOL_CHUNK_SIZE)) ||
+        !(p->edges = rf_fixed_memorypool_create(sizeof(struct ow_edge), OW_EDGES_POOL_CHUNK_SIZE)) ||
+        !(p->plocs = rf_fixed_memorypool_create(sizeof(struct ow_passed_loc), OW_PLOCS_POOL_CHUNK_SIZE))) {
+        ow_pools_destroy(p);
+        return NULL;
+    }
+    return p;
+}
+
+void ow_pools_destroy(struct ow_pools *p)
+{
+    if (p->nodes) {
+        rf_fixed_memorypool_destroy(p->nodes);
+    }
+    if (p->edges) {
+        rf_fixed_memorypool_destroy(p->edges);
+    }
+    if (p->plocs) {
+        rf_fixed_memorypool_destroy(p->plocs);
+    }
+    free(p);
+}
+
+struct ow_passed_loc *ow_passed_loc_create(struct ow_pools *pools,
+                                           const struct rir_call *c,
+                                           struct ow_node *n,
+                                           unsigned int idx)
 {
     struct ow_passed_loc *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    if (!(ret = rf_fixed_memorypool_alloc_element(pools->plocs))) {
+        return NULL;
+    }
     RF_STRUCT_ZERO(ret);
     ret->call = c;
     ret->from_node = n;
@@ -18,25 +53,23 @@ struct ow_passed_loc *ow_passed_loc_create(const struct rir_call *c, struct ow_n
     return ret;
 }
 
-void ow_passed_loc_destroy(struct ow_passed_loc *ploc)
-{
-    free(ploc);
-}
-
 struct ow_graph *ow_graph_create(struct rir_object *obj,
                                  const struct RFstring *name,
-                                 struct symbol_table_record *rec)
+                                 struct symbol_table_record *rec,
+                                 struct ow_pools *pools)
 {
     struct ow_graph *ret;
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     RF_STRUCT_ZERO(ret);
     ret->fn_name = name;
     ret->obj = obj;
-    ret->root = ow_node_create(name, rir_object_value(obj));
+    ret->pools = pools;
+    ret->root = ow_node_create(pools, name, rir_object_value(obj));
     ret->graph_attrs = 0;
     ret->rec = rec;
     if (!ret->root) {
-        return false;
+        free(ret);
+        return NULL;
     }
     darray_init(ret->passed_locations);
     rf_objset_init(&ret->set, ownode);
@@ -47,64 +80,36 @@ struct ow_graph *ow_graph_create(struct rir_object *obj,
 
 void ow_graph_destroy(struct ow_graph *g)
 {
-    struct ow_passed_loc **ploc;
-    darray_foreach(ploc, g->passed_locations) {
-        ow_passed_loc_destroy(*ploc);
-    }
+    // the nodes, edges and passed locations go with the pools
     darray_free(g->passed_locations);
-    ow_node_destroy(g->root);
     rf_objset_clear(&g->set);
     free(g);
 }
 
-bool ow_graph_check_or_add_val(struct ow_graph *g,
-                               const struct rir_value *v,
-                               const struct rir_value *dependentv,
-                               const struct rir_expression *edgexpr)
+struct ow_node *ow_graph_add_val(struct ow_graph *g,
+                                 struct ow_node *n,
+                                 const struct rir_value *dependentv,
+                                 const struct rir_expression *edgexpr)
 {
-    struct ow_node *n;
-    OWDD(
-        "Normal Checking in \""RFS_PF"()\" if value "RFS_PF" can go to graph for value "RFS_PF"\n",
-        RFS_PA(ow_curr_fnname()),
-        RFS_PA(rir_value_string(v)),
-        RFS_PA(ow_node_id(g->root))
-    );
-    if (!(n = ownode_objset_has_value(&g->set, ow_curr_fnname(), v))) {
-        OWDD("No it can't!\n");
-        return false;
-    }
-    OWDD("Yes it can.\n");
-    if (!(n = ow_node_add_val_edge(n, dependentv, edgexpr))) {
+    if (!(n = ow_node_add_val_edge(g->pools, n, dependentv, edgexpr))) {
         OWDD("Failed to add a new node as an edge");
-        return false;
+        return NULL;
     }
     OWDD("Adding node with id \""RFS_PF"\" to the graph for value "RFS_PF"\n",
        RFS_PA(ow_node_id(n)),
        RFS_PA(ow_node_id(g->root))
     );
     rf_objset_add(&g->set, ownode, n);
-    return true;
+    return n;
 }
 
-bool ow_graph_check_or_add_end(struct ow_graph *g,
-                               const struct rir_value *v,
-                               enum ow_end_type end_type,
-                               const struct rir_expression *edgexpr,
-                               unsigned int idx)
+bool ow_graph_add_end(struct ow_graph *g,
+                      struct ow_node *n,
+                      enum ow_end_type end_type,
+                      const struct rir_expression *edgexpr,
+                      unsigned int idx)
 {
-    struct ow_node *n;
-    OWDD(
-        "End Checking in \""RFS_PF"()\" if value "RFS_PF" can go to graph for value "RFS_PF"\n",
-        RFS_PA(ow_curr_fnname()),
-        RFS_PA(rir_value_string(v)),
-        RFS_PA(ow_node_id(g->root))
-    );
-    if (!(n = ownode_objset_has_value(&g->set, ow_curr_fnname(), v))) {
-        OWDD("No it can't!\n");
-        return false;
-    }
-    OWDD("Yes it can.\n");
-    if (!(n = ow_node_add_end_edge(n, end_type, edgexpr))) {
+    if (!(n = ow_node_add_end_edge(g->pools, n, end_type, edgexpr))) {
         OWDD("Failed to add a new node as an edge");
         return false;
     }
@@ -118,7 +123,10 @@ bool ow_graph_check_or_add_end(struct ow_graph *g,
         OWDD("End Checking was for CALL\n");
         ow_graph_set_attr(g, OW_ATTR_PASSED);
         RF_ASSERT(edgexpr->type == RIR_EXPRESSION_CALL, "A rir call should be here");
-        struct ow_passed_loc *ploc = ow_passed_loc_create(&edgexpr->call, n, idx);
+        struct ow_passed_loc *ploc = ow_passed_loc_create(g->pools, &edgexpr->call, n, idx);
+        if (!ploc) {
+            return false;
+        }
         darray_append(g->passed_locations, ploc);
     }
     break;
@@ -130,15 +138,25 @@ void ow_graph_set_attr(struct ow_graph *g, enum graph_attrs attr)
 {
     switch(attr)  {
     case OW_ATTR_RETURNED:
-        if (g->obj->category == RIR_OBJ_EXPRESSION && g->obj->expr.type == RIR_EXPRESSION_ALLOCA) {
-            // since the graph states the value is returned, allocation needs to be in the heap
-            g->obj->expr.alloca.alloc_location = RIR_ALLOC_HEAP;
-        }
-    break;
     case OW_ATTR_PASSED:
+    case OW_ATTR_STORED:
+    case OW_ATTR_ESCAPED:
         break;
     }
     RF_BITFLAG_SET(g->graph_attrs, attr);
 }
 
+void ow_graph_place(struct ow_graph *g)
+{
+    if (g->obj->category != RIR_OBJ_EXPRESSION || g->obj->expr.type != RIR_EXPRESSION_ALLOCA) {
+        return;
+    }
+    // a value that is returned or may be kept by a callee outlives the
+    // function so it needs to be in the heap
+    g->obj->expr.alloca.alloc_location =
+        ow_graph_has_attr(g, OW_ATTR_RETURNED) || ow_graph_has_attr(g, OW_ATTR_ESCAPED)
+        ? RIR_ALLOC_HEAP
+        : RIR_ALLOC_STACK;
+}
+
 i_INLINE_INS bool ow_graph_has_attr(const struct ow_graph *g, enum graph_attrs attr);
@@ -8,11 +8,34 @@
 
 struct rir_expression;
 struct rir_object;
+struct rf_fixed_memorypool;
+
+#define OW_NODES_POOL_CHUNK_SIZE 1024
+#define OW_EDGES_POOL_CHUNK_SIZE 1024
+#define OW_PLOCS_POOL_CHUNK_SIZE 256
+
+/**
+ * Memory for the nodes, edges and passed locations of ownership graphs.
+ * Nothing is freed on its own. Everything goes at once when the pools are
+ * destroyed, after all graphs using them.
+ */
+struct ow_pools {
+    struct rf_fixed_memorypool *nodes;
+    struct rf_fixed_memorypool *edges;
+    struct rf_fixed_memorypool *plocs;
+};
+
+struct ow_pools *ow_pools_create();
+void ow_pools_destroy(struct ow_pools *p);
 
 //! Graph attributes
 enum graph_attrs {
     OW_ATTR_RETURNED = 1,
     OW_ATTR_PASSED = 2,
+    //! The value is written into memory
+    OW_ATTR_STORED = 4,
+    //! The value is passed to a function that may keep it
+    OW_ATTR_ESCAPED = 8,
 };
 
 struct ow_passed_loc {
@@ -22,10 +45,10 @@ struct ow_passed_loc {
     unsigned int idx;
 };
 
-struct ow_passed_loc *ow_passed_loc_create(const struct rir_call *c,
+struct ow_passed_loc *ow_passed_loc_create(struct ow_pools *pools,
+                                           const struct rir_call *c,
                                            struct ow_node *n,
                                            unsigned int idx);
-void ow_passed_loc_destroy(struct ow_passed_loc *ploc);
 
 struct ow_graph {
     //! Name of the function this graph's value starts from
@@ -44,36 +67,58 @@ struct ow_graph {
     struct {darray(struct ow_passed_loc*);} passed_locations;
     //! The symbol table record of the rir object the graph is for
     struct symbol_table_record *rec;
+    //! Position of the graph in the list of graphs of the module
+    unsigned int idx;
+    //! Where the nodes, edges and passed locations of the graph come from
+    struct ow_pools *pools;
 };
 
 struct ow_graph *ow_graph_create(struct rir_object *expr,
                                  const struct RFstring *name,
-                                 struct symbol_table_record *rec);
+                                 struct symbol_table_record *rec,
+                                 struct ow_pools *pools);
 void ow_graph_destroy(struct ow_graph *g);
 
-bool ow_graph_check_or_add_val(struct ow_graph *g,
-                               const struct rir_value *v,
-                               const struct rir_value *dependentv,
-                               const struct rir_expression *edgexpr);
+/**
+ * Add a node for @a dependentv to the graph, depending on node @a n
+ *
+ * @param g              The graph @a n belongs to
+ * @param n              The node of the graph the new node depends on
+ * @param dependentv     The value of the new node
+ * @param edgexpr        The rir expression that should go at the connecting edge
+ * @return The new node or NULL in failure
+ */
+struct ow_node *ow_graph_add_val(struct ow_graph *g,
+                                 struct ow_node *n,
+                                 const struct rir_value *dependentv,
+                                 const struct rir_expression *edgexpr);
 
-bool ow_graph_check_or_add_end(struct ow_graph *g,
-                               const struct rir_value *v,
-                               enum ow_end_type end_type,
-                               const struct rir_expression *edgexpr,
-                               unsigned int idx);
+/**
+ * Add an end node to the graph, depending on node @a n
+ *
+ * @param g              The graph @a n belongs to
+ * @param n              The node of the graph the end node depends on
+ * @param end_type       The end node type
+ * @param edgexpr        The rir expression that should go at the connecting edge
+ * @param idx            If this concerns parameter passing this is the parameter index. Else zero.
+ */
+bool ow_graph_add_end(struct ow_graph *g,
+                      struct ow_node *n,
+                      enum ow_end_type end_type,
+                      const struct rir_expression *edgexpr,
+                      unsigned int idx);
 
 void ow_graph_set_attr(struct ow_graph *g, enum graph_attrs attr);
 
+/**
+ * Decide where the allocation the graph is for goes, from what happens
+ * to its value
+ */
+void ow_graph_place(struct ow_graph *g);
+
 i_INLINE_DECL bool ow_graph_has_attr(const struct ow_graph *g, enum graph_attrs attr)
 {
     return RF_BITFLAG_ON(g->graph_attrs, attr);
 }
 
-#if RF_OPTION_WITH_GRAPHVIZ
-/**
- * Turn a graph to a graphviz dot graph
- */
-bool ow_graph_to_graphviz(struct ow_graph *g);
-#endif
-
 #endif
@@ -3,7 +3,18 @@
 
 #include <stdbool.h>
 
+struct RFstring;
+
 bool ow_graphviz_init();
 void ow_graphviz_deinit();
 
+/**
+ * Lay out a graph given in the DOT language and render it as SVG
+ *
+ * @param dot            The DOT text of the graph
+ * @param path           The file to write the SVG to
+ * @return               false in failure
+ */
+bool ow_graphviz_render(const struct RFstring *dot, const struct RFstring *path);
+
 #endif
@@ -1,18 +1,31 @@
 #include "ow_node.h"
 
 #include <rfbase/string/core.h>
+#include <rfbase/utils/fixed_memory_pool.h>
 
 #include "ow_edge.h"
+#include "ow_graph.h"
 #include "ow_debug.h"
 #include <ownership/ownership.h>
 #include <ir/rir_object.h>
 
 static void ow_node_init_common(struct ow_node *n, const struct RFstring *fnname)
 {
-    darray_init(n->edges);
+    n->edges = NULL;
+    n->last_edge = NULL;
     n->fnname = fnname;
 }
 
+static void ow_node_append_edge(struct ow_node *n, struct ow_edge *e)
+{
+    if (n->last_edge) {
+        n->last_edge->next = e;
+    } else {
+        n->edges = e;
+    }
+    n->last_edge = e;
+}
+
 void ow_node_init(struct ow_node *n, const struct rir_value *nodeval)
 {
     n->type = OW_NTYPE_FULL;
@@ -26,35 +39,39 @@ static void ow_node_init_end(struct ow_node *n, enum ow_end_type end_type, const
     n->end.other_fn_name = other_fn_name;
 }
 
-struct ow_node *ow_node_create(const struct RFstring *fnname, const struct rir_value *nodeval)
+struct ow_node *ow_node_create(struct ow_pools *pools, const struct RFstring *fnname, const struct rir_value *nodeval)
 {
     struct ow_node *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    if (!(ret = rf_fixed_memorypool_alloc_element(pools->nodes))) {
+        return NULL;
+    }
     ow_node_init_common(ret, fnname);
     ow_node_init(ret, nodeval);
     return ret;
 }
 
-struct ow_node *ow_node_end_create(const struct RFstring *fnname, enum ow_end_type end_type, const struct RFstring *other_fn_name)
+struct ow_node *ow_node_end_create(struct ow_pools *pools, const struct RFstring *fnname, enum ow_end_type end_type, const struct RFstring *other_fn_name)
 {
     struct ow_node *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    if (!(ret = rf_fixed_memorypool_alloc_element(pools->nodes))) {
+        return NULL;
+    }
     ow_node_init_common(ret, fnname);
     ow_node_init_end(ret, end_type, other_fn_name);
     return ret;
 }
 
-bool ow_node_connect_node(struct ow_node *n, const struct rir_expression *expr, struct ow_node *other)
+bool ow_node_connect_node(struct ow_pools *pools, struct ow_node *n, const struct rir_expression *expr, struct ow_node *other)
 {
-    struct ow_edge *e = ow_edge_create_from_node(expr, other, ow_expr_idx_inc());
+    struct ow_edge *e = ow_edge_create_from_node(pools, expr, other, ow_expr_idx_inc());
     if (!e) {
         return false;
     }
-    darray_append(n->edges, e);
+    ow_node_append_edge(n, e);
     return true;
 }
 
-bool ow_node_connect_end_node(struct ow_node *n, const struct rir_expression *expr, struct ow_node *other)
+bool ow_node_connect_end_node(struct ow_pools *pools, struct ow_node *n, const struct rir_expression *expr, struct ow_node *other)
 {
     OWDD(
         "Connect node \""RFS_PF"\" with \""RFS_PF"\" with counter: %u\n",
@@ -62,26 +79,10 @@ bool ow_node_connect_end_node(struct ow_node *n, const struct rir_expression *ex
         RFS_PA(ow_node_id(other)),
         ow_expr_idx()
     );
-    return ow_node_connect_node(n, expr, other);
-}
-
-void ow_node_deinit(struct ow_node *n)
-{
-    struct ow_edge **e;
-    darray_foreach(e, n->edges) {
-        ow_edge_destroy(*e);
-    }
-    darray_free(n->edges);
-}
-
-
-void ow_node_destroy(struct ow_node *n)
-{
-    ow_node_deinit(n);
-    free(n);
+    return ow_node_connect_node(pools, n, expr, other);
 }
 
-struct ow_node *ow_node_add_val_edge(struct ow_node *n, const struct rir_value *otherval, const struct rir_expression *expr)
+struct ow_node *ow_node_add_val_edge(struct ow_pools *pools, struct ow_node *n, const struct rir_value *otherval, const struct rir_expression *expr)
 {
     RF_ASSERT(n->type != OW_NTYPE_END, "No end node should appear here");
     OWDD(
@@ -89,15 +90,15 @@ struct ow_node *ow_node_add_val_edge(struct ow_node *n, const struct rir_value *
         RFS_PA(ow_node_id(n)),
         ow_expr_idx()
     );
-    struct ow_edge *e = ow_edge_create(expr, n->fnname, otherval, ow_expr_idx_inc());
+    struct ow_edge *e = ow_edge_create(pools, expr, n->fnname, otherval, ow_expr_idx_inc());
     if (!e) {
         return NULL;
     }
-    darray_append(n->edges, e);
+    ow_node_append_edge(n, e);
     return e->to;
 }
 
-struct ow_node *ow_node_add_end_edge(struct ow_node *n, enum ow_end_type end_type, const struct rir_expression *expr)
+struct ow_node *ow_node_add_end_edge(struct ow_pools *pools, struct ow_node *n, enum ow_end_type end_type, const struct rir_expression *expr)
 {
     RF_ASSERT(n->type != OW_NTYPE_END, "No end node should appear here");
     OWDD(
@@ -105,11 +106,11 @@ struct ow_node *ow_node_add_end_edge(struct ow_node *n, enum ow_end_type end_typ
         RFS_PA(ow_node_id(n)),
         ow_expr_idx()
     );
-    struct ow_edge *e = ow_endedge_create(expr, n->fnname, end_type, ow_expr_idx_inc());
+    struct ow_edge *e = ow_endedge_create(pools, expr, n->fnname, end_type, ow_expr_idx_inc());
     if (!e) {
         return NULL;
     }
-    darray_append(n->edges, e);
+    ow_node_append_edge(n, e);
     return e->to;
 }
 
@@ -136,7 +137,7 @@ const struct RFstring *ow_node_id(const struct ow_node *n)
             return RFS(RFS_PF, RFS_PA(ow_node_end_type_str(n->end.type)));
         }
     }
-    return RFS(RFS_PF"_"RFS_PF, RFS_PA(&n->full.val->id), RFS_PA(n->fnname));
+    return RFS(RFS_PF"_"RFS_PF, RFS_PA(rir_value_string(n->full.val)), RFS_PA(n->fnname));
 }
 
 
@@ -175,7 +176,7 @@ static bool id_cmp_fn(struct ow_node *n, size_t *id)
 struct ow_node *ownode_objset_has_value(const struct rf_objset_ownode *set, const struct RFstring *fnname, const struct rir_value *v)
 {
     RFS_PUSH();
-    const struct RFstring *s = RFS(RFS_PF"_"RFS_PF, RFS_PA(&v->id), RFS_PA(fnname));
+    const struct RFstring *s = RFS(RFS_PF"_"RFS_PF, RFS_PA(rir_value_string(v)), RFS_PA(fnname));
     size_t id = rf_hash_str_stable(s, 0);
     OWDD("has_value: Checking for \""RFS_PF"\"\n", RFS_PA(s));
     RFS_POP();
@@ -9,6 +9,7 @@
 struct rir_value;
 struct rir_expression;
 struct ow_edge;
+struct ow_pools;
 
 struct ow_node_full {
     const struct rir_value *val;
@@ -31,7 +32,10 @@ enum ow_node_type {
 struct ow_node {
     enum ow_node_type type;
     const struct RFstring *fnname;
-    struct {darray(struct ow_edge*);} edges;
+    //! First of the edges going out of the node, linked through their @a next
+    struct ow_edge *edges;
+    //! Last of the edges going out of the node, where new ones get appended
+    struct ow_edge *last_edge;
     union {
         struct ow_node_full full;
         struct ow_node_end end;
@@ -39,14 +43,11 @@ struct ow_node {
 };
 
 void ow_node_init(struct ow_node *n, const struct rir_value *nodeval);
-struct ow_node *ow_node_create(const struct RFstring *fnname, const struct rir_value *nodeval);
-struct ow_node *ow_node_end_create(const struct RFstring *fnname, enum ow_end_type end_type, const struct RFstring *other_fn_name);
+struct ow_node *ow_node_create(struct ow_pools *pools, const struct RFstring *fnname, const struct rir_value *nodeval);
+struct ow_node *ow_node_end_create(struct ow_pools *pools, const struct RFstring *fnname, enum ow_end_type end_type, const struct RFstring *other_fn_name);
 
-bool ow_node_connect_node(struct ow_node *n, const struct rir_expression *expr, struct ow_node *other);
-bool ow_node_connect_end_node(struct ow_node *n, const struct rir_expression *expr, struct ow_node *other);
-
-void ow_node_deinit(struct ow_node *n);
-void ow_node_destroy(struct ow_node *n);
+bool ow_node_connect_node(struct ow_pools *pools, struct ow_node *n, const struct rir_expression *expr, struct ow_node *other);
+bool ow_node_connect_end_node(struct ow_pools *pools, struct ow_node *n, const struct rir_expression *expr, struct ow_node *other);
 
 /**
  * Given a unique ID for this ow node graph
@@ -54,8 +55,8 @@ void ow_node_destroy(struct ow_node *n);
  */
 const struct RFstring *ow_node_id(const struct ow_node *n);
 
-struct ow_node *ow_node_add_val_edge(struct ow_node *n, const struct rir_value *otherval, const struct rir_expression *expr);
-struct ow_node *ow_node_add_end_edge(struct ow_node *n, enum ow_end_type end_type, const struct rir_expression *expr);
+struct ow_node *ow_node_add_val_edge(struct ow_pools *pools, struct ow_node *n, const struct rir_value *otherval, const struct rir_expression *expr);
+struct ow_node *ow_node_add_end_edge(struct ow_pools *pools, struct ow_node *n, enum ow_end_type end_type, const struct rir_expression *expr);
 
 const struct RFstring *ow_node_end_type_str(enum ow_end_type type);
 
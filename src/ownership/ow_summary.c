@@ -0,0 +1,244 @@
+#include "ow_summary.h"
+
+#include <rfbase/datastructs/intrusive_list.h>
+#include <rfbase/utils/memory.h>
+
+#include <ir/rir.h>
+#include <ir/rir_block.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+
+struct ow_module_summaries *ow_module_summaries_create(const struct rir *r)
+{
+    struct ow_module_summaries *ms;
+    RF_MALLOC(ms, sizeof(*ms), return NULL);
+    ms->rir = r;
+    strmap_init(&ms->fns);
+    return ms;
+}
+
+static bool itfree_summary(const struct RFstring *s, struct ow_summary *sum, void *u)
+{
+    (void)s;
+    (void)u;
+    darray_free(sum->params);
+    free(sum);
+    return true;
+}
+
+void ow_module_summaries_destroy(struct ow_module_summaries *ms)
+{
+    strmap_iterate(&ms->fns, (strmap_it_cb)itfree_summary, NULL);
+    strmap_clear(&ms->fns);
+    free(ms);
+}
+
+struct ow_summary *ow_module_summaries_add(struct ow_module_summaries *ms,
+                                           const struct rir_fndef *fn)
+{
+    struct ow_summary *s;
+    int *flags;
+    RF_MALLOC(s, sizeof(*s), return NULL);
+    darray_init(s->params);
+    darray_resize(s->params, darray_size(fn->variables));
+    darray_foreach(flags, s->params) {
+        *flags = 0;
+    }
+    s->done = false;
+    if (!strmap_add(&ms->fns, (struct RFstring*)&fn->decl.name, s)) {
+        darray_free(s->params);
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+struct ow_summary *ow_module_summaries_get(const struct ow_module_summaries *ms,
+                                           const struct RFstring *fn_name)
+{
+    return strmap_get(&ms->fns, fn_name);
+}
+
+int ow_summary_param(const struct ow_summary *s, unsigned int idx)
+{
+    if (!s || !s->done || idx >= darray_size(s->params)) {
+        return OW_PARAM_UNKNOWN;
+    }
+    return darray_item(s->params, idx);
+}
+
+struct ow_cg_node {
+    struct rir_fndef *fn;
+    //! Indices of the called functions of the module. May repeat.
+    struct {darray(unsigned int);} callees;
+    //! Order of the visit, starting from 1. 0 for not visited yet.
+    unsigned int index;
+    //! Smallest index reachable from the node that is still on the stack
+    unsigned int lowlink;
+    //! The component of the node once it's complete
+    unsigned int scc;
+    bool on_stack;
+};
+
+struct ow_cg_nodemap {
+    STRMAP_MEMBERS(struct ow_cg_node*);
+};
+
+struct ow_cg {
+    struct {darray(struct ow_cg_node);} nodes;
+    //! Function name to its node
+    struct ow_cg_nodemap map;
+    struct {darray(unsigned int);} stack;
+    unsigned int next_index;
+    struct ow_callgraph_order *order;
+};
+
+static bool ow_cg_init(struct ow_cg *cg, const struct rir *r, struct ow_callgraph_order *o)
+{
+    struct rir_fndecl *decl;
+    struct ow_cg_node *n;
+    struct ow_cg_node *callee;
+    struct rir_block **b;
+    struct rir_expression *e;
+    unsigned int fns_num = 0;
+    darray_init(cg->nodes);
+    darray_init(cg->stack);
+    strmap_init(&cg->map);
+    cg->next_index = 0;
+    cg->order = o;
+    rf_ilist_for_each(&r->functions, decl, ln) {
+        if (!decl->plain_decl) {
+            ++fns_num;
+        }
+    }
+    // sized up front since the map points into the array
+    darray_resize(cg->nodes, fns_num);
+    n = cg->nodes.item;
+    rf_ilist_for_each(&r->functions, decl, ln) {
+        if (decl->plain_decl) {
+            continue;
+        }
+        n->fn = rir_fndecl_to_fndef(decl);
+        darray_init(n->callees);
+        n->index = 0;
+        n->lowlink = 0;
+        n->scc = 0;
+        n->on_stack = false;
+        ++n;
+    }
+    darray_foreach(n, cg->nodes) {
+        if (!strmap_add(&cg->map, &n->fn->decl.name, n)) {
+            RF_ERROR("Failed to add a function to the call graph");
+            return false;
+        }
+    }
+    darray_foreach(n, cg->nodes) {
+        darray_foreach(b, n->fn->blocks) {
+            rf_ilist_for_each(&(*b)->expressions, e, ln) {
+                if (e->type == RIR_EXPRESSION_CALL && !e->call.foreign &&
+                    (callee = strmap_get(&cg->map, &e->call.name))) {
+                    darray_append(n->callees, callee - cg->nodes.item);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static void ow_cg_deinit(struct ow_cg *cg)
+{
+    struct ow_cg_node *n;
+    darray_foreach(n, cg->nodes) {
+        darray_free(n->callees);
+    }
+    darray_free(cg->nodes);
+    darray_free(cg->stack);
+    strmap_clear(&cg->map);
+}
+
+/**
+ * Tarjan's algorithm. Components are completed only after all the
+ * components they call, so they come out with callees first.
+ */
+static void ow_cg_strongconnect(struct ow_cg *cg, unsigned int v)
+{
+    struct ow_cg_node *n = &darray_item(cg->nodes, v);
+    struct ow_cg_node *w;
+    struct ow_cg_node *m;
+    unsigned int *c;
+    unsigned int top;
+    unsigned int i;
+    unsigned int level = 0;
+    n->index = n->lowlink = ++cg->next_index;
+    n->on_stack = true;
+    darray_append(cg->stack, v);
+    darray_foreach(c, n->callees) {
+        w = &darray_item(cg->nodes, *c);
+        if (w->index == 0) {
+            ow_cg_strongconnect(cg, *c);
+            if (w->lowlink < n->lowlink) {
+                n->lowlink = w->lowlink;
+            }
+        } else if (w->on_stack && w->index < n->lowlink) {
+            n->lowlink = w->index;
+        }
+    }
+    if (n->lowlink != n->index) {
+        return;
+    }
+    // the component is everything above the node in the stack. Its callees
+    // that are not on the stack belong to components that are complete.
+    for (i = darray_size(cg->stack); i-- > 0;) {
+        m = &darray_item(cg->nodes, darray_item(cg->stack, i));
+        darray_foreach(c, m->callees) {
+            w = &darray_item(cg->nodes, *c);
+            if (!w->on_stack && darray_item(cg->order->scc_levels, w->scc) >= level) {
+                level = darray_item(cg->order->scc_levels, w->scc) + 1;
+            }
+        }
+        if (m == n) {
+            break;
+        }
+    }
+    do {
+        top = darray_pop(cg->stack);
+        m = &darray_item(cg->nodes, top);
+        m->on_stack = false;
+        m->scc = darray_size(cg->order->scc_ends);
+        darray_append(cg->order->fns, m->fn);
+    } while (top != v);
+    darray_append(cg->order->scc_ends, darray_size(cg->order->fns));
+    darray_append(cg->order->scc_levels, level);
+}
+
+bool ow_callgraph_order_init(struct ow_callgraph_order *o, const struct rir *r)
+{
+    struct ow_cg cg;
+    unsigned int i;
+    bool ret = false;
+    darray_init(o->fns);
+    darray_init(o->scc_ends);
+    darray_init(o->scc_levels);
+    if (!ow_cg_init(&cg, r, o)) {
+        goto end;
+    }
+    for (i = 0; i < darray_size(cg.nodes); ++i) {
+        if (darray_item(cg.nodes, i).index == 0) {
+            ow_cg_strongconnect(&cg, i);
+        }
+    }
+    ret = true;
+end:
+    ow_cg_deinit(&cg);
+    if (!ret) {
+        ow_callgraph_order_deinit(o);
+    }
+    return ret;
+}
+
+void ow_callgraph_order_deinit(struct ow_callgraph_order *o)
+{
+    darray_free(o->fns);
+    darray_free(o->scc_ends);
+    darray_free(o->scc_levels);
+}
@@ -0,0 +1,87 @@
+#ifndef LFR_OWNERSHIP_SUMMARY_H
+#define LFR_OWNERSHIP_SUMMARY_H
+
+#include <stdbool.h>
+
+#include <rfbase/datastructs/darray.h>
+#include <rfbase/datastructs/strmap.h>
+
+struct rir;
+struct rir_fndef;
+struct RFstring;
+
+//! What a function may do with the value given for one of its parameters
+enum ow_param_flags {
+    //! The value, or something depending on it, is returned
+    OW_PARAM_RETURNED = 1,
+    //! The value is written into memory
+    OW_PARAM_STORED = 2,
+    //! The value is handed to code whose effect is unknown, like a foreign
+    //! function
+    OW_PARAM_ESCAPES = 4,
+};
+//! What has to be assumed for a parameter of a function without a summary
+#define OW_PARAM_UNKNOWN (OW_PARAM_RETURNED | OW_PARAM_STORED | OW_PARAM_ESCAPES)
+
+/**
+ * The effect of a function on the ownership of its arguments, so that
+ * callers don't need to look at the function's graphs
+ */
+struct ow_summary {
+    //! Flags of each parameter by parameter index
+    struct {darray(int);} params;
+    //! False until the summary is computed. Calls between the functions of a
+    //! cycle see summaries that are not done yet.
+    bool done;
+};
+
+struct owsum_strmap {
+    STRMAP_MEMBERS(struct ow_summary*);
+};
+
+//! The summaries of all function definitions of a module
+struct ow_module_summaries {
+    const struct rir *rir;
+    //! Function name to its summary
+    struct owsum_strmap fns;
+};
+
+struct ow_module_summaries *ow_module_summaries_create(const struct rir *r);
+void ow_module_summaries_destroy(struct ow_module_summaries *ms);
+
+/**
+ * Add an empty summary for a function of the module
+ *
+ * @return The summary to fill in or NULL in failure
+ */
+struct ow_summary *ow_module_summaries_add(struct ow_module_summaries *ms,
+                                           const struct rir_fndef *fn);
+
+struct ow_summary *ow_module_summaries_get(const struct ow_module_summaries *ms,
+                                           const struct RFstring *fn_name);
+
+/**
+ * @return The flags of parameter @a idx, or OW_PARAM_UNKNOWN if there is no
+ *         finished summary
+ */
+int ow_summary_param(const struct ow_summary *s, unsigned int idx);
+
+/**
+ * The function definitions of a module in an order where callees come before
+ * their callers. The functions of each strongly connected component of the
+ * call graph are consecutive.
+ */
+struct ow_callgraph_order {
+    struct {darray(struct rir_fndef*);} fns;
+    //! For each strongly connected component, the index in @a fns after its
+    //! last function
+    struct {darray(unsigned int);} scc_ends;
+    //! For each strongly connected component, the longest chain of calls into
+    //! other components. Components of the same level never call each other.
+    struct {darray(unsigned int);} scc_levels;
+};
+
+bool ow_callgraph_order_init(struct ow_callgraph_order *o, const struct rir *r);
+void ow_callgraph_order_deinit(struct ow_callgraph_order *o);
+
+#endif
@@ -1,17 +1,30 @@
 #include <ownership/ownership.h>
 
+#include <pthread.h>
+
 #include <rfbase/datastructs/objset.h>
+#include <rfbase/datastructs/strmap.h>
+#include <rfbase/string/corex.h>
+#include <rfbase/utils/memory.h>
 
 #include <compiler.h>
+#include <compiler_args.h>
 #include <ir/rir.h>
 #include <ir/rir_object.h>
 #include <ir/rir_function.h>
 #include <ir/rir_block.h>
 #include <ir/rir_call.h>
+#include <ir/rir_code.h>
+#include <ir/rir_value.h>
 #include <analyzer/symbol_table.h>
+#include <info/info.h>
+#include <utils/workers.h>
 
+#include "ow_ctx.h"
 #include "ow_graph.h"
+#include "ow_summary.h"
 #include "ow_debug.h"
+#include "ow_dot.h"
 #if RF_OPTION_WITH_GRAPHVIZ
 #include "ow_graphviz.h"
 #endif
@@ -19,9 +32,50 @@
 struct objset_st { OBJSET_MEMBERS(struct symbol_table*); };
 
 
+//! The node of a graph standing for a value of the current function
+struct ow_value_node {
+    struct ow_graph *graph;
+    //! NULL if the value is in no graph
+    struct ow_node *node;
+};
+
+//! The graphs of the arguments of a function, indexed by the value id of the
+//! argument which is its index. NULL for arguments that got no graph.
+struct ow_fn_graphs {
+    struct {darray(struct ow_graph*);} args;
+};
+
+struct owfn_strmap {
+    STRMAP_MEMBERS(struct ow_fn_graphs*);
+};
+
 struct ow_ctx {
+    //! The context of the module if this is the context of a thread
+    //! analyzing some of its functions. NULL otherwise.
+    struct ow_ctx *parent;
+    //! Number of threads to analyze the functions of a module with
+    unsigned int jobs;
     struct {darray(struct ow_graph*);} graphs;
+    //! Where the graphs built in this context get their nodes from. Created
+    //! with the first graph.
+    struct ow_pools *pools;
+    //! Pools of other contexts whose graphs got merged into this one
+    struct {darray(struct ow_pools*);} merged_pools;
+    //! Function name to the graphs of its arguments. Used to link the graph
+    //! of a value passed to a function to the graph of the argument.
+    struct owfn_strmap fn_graphs;
+    //! Summaries of the functions of every module analyzed so far. Unlike
+    //! the graphs they are kept across modules so that calls into
+    //! dependencies can use them.
+    struct {darray(struct ow_module_summaries*);} summaries;
+    //! Summaries of the module being analyzed
+    struct ow_module_summaries *curr_summaries;
     const struct RFstring *curr_fn_name;
+    const struct rir_fndef *curr_fn;
+    //! Indexed by the id of the values of the current function. Kept up to
+    //! date as nodes get added so that finding the graph of an operand does
+    //! not need to search every graph of the module.
+    struct {darray(struct ow_value_node);} value_nodes;
     unsigned int rir_expr_idx;
 };
 i_THREAD__ struct ow_ctx *g_ow_ctx = NULL;
@@ -50,36 +104,187 @@ unsigned int ow_expr_idx()
     return g_ow_ctx->rir_expr_idx;
 }
 
-static void ow_ctx_init()
+static void ow_ctx_init(struct ow_ctx *parent)
 {
     RF_ASSERT_OR_EXIT(!g_ow_ctx, "Global Ownership context was already initialized.");
     g_ow_ctx = malloc(sizeof(struct ow_ctx));
     RF_ASSERT_OR_EXIT(g_ow_ctx, "Could not allocate a global ownership context");
     RF_STRUCT_ZERO(g_ow_ctx);
+    g_ow_ctx->parent = parent;
+    if (parent) {
+        g_ow_ctx->curr_summaries = parent->curr_summaries;
+    }
     darray_init(g_ow_ctx->graphs);
+    darray_init(g_ow_ctx->merged_pools);
+    darray_init(g_ow_ctx->value_nodes);
+    strmap_init(&g_ow_ctx->fn_graphs);
+    darray_init(g_ow_ctx->summaries);
+}
+
+static bool itfree_fngraphs(const struct RFstring *s, struct ow_fn_graphs *fg, void *u)
+{
+    (void)s;
+    (void)u;
+    darray_free(fg->args);
+    free(fg);
+    return true;
 }
 
 static void ow_ctx_reset()
 {
     RF_ASSERT(g_ow_ctx, "No global ownership context exists");
     struct ow_graph **g;
+    struct ow_pools **p;
     darray_foreach(g, g_ow_ctx->graphs) {
         ow_graph_destroy(*g);
     }
     darray_clear(g_ow_ctx->graphs);
+    // only after the graphs since they point into the pools
+    if (g_ow_ctx->pools) {
+        ow_pools_destroy(g_ow_ctx->pools);
+        g_ow_ctx->pools = NULL;
+    }
+    darray_foreach(p, g_ow_ctx->merged_pools) {
+        ow_pools_destroy(*p);
+    }
+    darray_clear(g_ow_ctx->merged_pools);
+    strmap_iterate(&g_ow_ctx->fn_graphs, (strmap_it_cb)itfree_fngraphs, NULL);
+    strmap_clear(&g_ow_ctx->fn_graphs);
 }
 
 static void ow_ctx_deinit()
 {
+    struct ow_module_summaries **ms;
     ow_ctx_reset();
+    darray_foreach(ms, g_ow_ctx->summaries) {
+        ow_module_summaries_destroy(*ms);
+    }
+    darray_free(g_ow_ctx->summaries);
     darray_free(g_ow_ctx->graphs);
+    darray_free(g_ow_ctx->merged_pools);
+    darray_free(g_ow_ctx->value_nodes);
     free(g_ow_ctx);
     g_ow_ctx = NULL;
 }
 
-static inline bool ow_ctx_add_new(struct rir_object *obj, const struct RFstring *fn_name, struct symbol_table *st)
+struct ow_merge {
+    struct ow_ctx *into;
+    bool ok;
+};
+
+static bool itmove_fngraphs(const struct RFstring *s, struct ow_fn_graphs *fg, struct ow_merge *m)
+{
+    if (!strmap_add(&m->into->fn_graphs, (struct RFstring*)s, fg)) {
+        RF_ERROR("Failed to remember the argument graphs of a function");
+        itfree_fngraphs(s, fg, NULL);
+        m->ok = false;
+    }
+    return true;
+}
+
+/**
+ * Move the graphs of the current context into @a into
+ */
+static bool ow_ctx_merge(struct ow_ctx *into)
+{
+    struct ow_merge m = {into, true};
+    struct ow_graph **g;
+    darray_foreach(g, g_ow_ctx->graphs) {
+        (*g)->idx = darray_size(into->graphs);
+        darray_append(into->graphs, *g);
+    }
+    darray_clear(g_ow_ctx->graphs);
+    strmap_iterate(&g_ow_ctx->fn_graphs, (strmap_it_cb)itmove_fngraphs, &m);
+    strmap_clear(&g_ow_ctx->fn_graphs);
+    return m.ok;
+}
+
+static void ow_ctx_set_fn(const struct rir_fndef *f)
+{
+    struct ow_value_node *vn;
+    g_ow_ctx->curr_fn_name = &f->decl.name;
+    g_ow_ctx->curr_fn = f;
+    darray_resize(g_ow_ctx->value_nodes, darray_size(f->values));
+    darray_foreach(vn, g_ow_ctx->value_nodes) {
+        vn->graph = NULL;
+        vn->node = NULL;
+    }
+}
+
+/**
+ * @return The map entry of @a v or NULL if it's not a variable of the
+ *         current function
+ */
+static struct ow_value_node *ow_ctx_value_node(const struct rir_value *v)
+{
+    struct rir_object *obj;
+    if (v->category != RIR_VALUE_VARIABLE || v->id >= darray_size(g_ow_ctx->value_nodes)) {
+        return NULL;
+    }
+    obj = darray_item(g_ow_ctx->curr_fn->values, v->id);
+    return obj && rir_object_value(obj) == v
+        ? &darray_item(g_ow_ctx->value_nodes, v->id)
+        : NULL;
+}
+
+/**
+ * Remember that @a n of graph @a g stands for @a v. If the value is already
+ * in a graph the graph created first keeps it, as searching the graphs in
+ * order would find.
+ */
+static void ow_ctx_set_value_node(const struct rir_value *v,
+                                  struct ow_graph *g,
+                                  struct ow_node *n)
+{
+    struct ow_value_node *vn = ow_ctx_value_node(v);
+    if (vn && (!vn->node || vn->graph->idx > g->idx)) {
+        vn->graph = g;
+        vn->node = n;
+    }
+}
+
+/**
+ * @return The node standing for @a v in the current function or NULL if it's
+ *         in no graph. The graph of the node is returned in @a g.
+ */
+static struct ow_node *ow_ctx_find_node(const struct rir_value *v, struct ow_graph **g)
+{
+    struct ow_value_node *vn;
+    struct ow_graph **graph;
+    struct ow_node *n;
+    if ((vn = ow_ctx_value_node(v))) {
+        *g = vn->graph;
+        return vn->node;
+    }
+    // values that don't belong to the function are rare so just search
+    darray_foreach(graph, g_ow_ctx->graphs) {
+        if ((n = ownode_objset_has_value(&(*graph)->set, ow_curr_fnname(), v))) {
+            *g = *graph;
+            return n;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Add a new graph for @a obj if it has a symbol table record
+ *
+ * @param obj            The rir object to create the graph for
+ * @param fn_name        The name of the function the object is in
+ * @param st             The symbol table to look for the object's record in
+ * @param created        If not NULL returns the new graph or NULL if none
+ *                       was needed
+ * @return               false in failure
+ */
+static inline bool ow_ctx_add_new(struct rir_object *obj,
+                                  const struct RFstring *fn_name,
+                                  struct symbol_table *st,
+                                  struct ow_graph **created)
 {
     RF_ASSERT(g_ow_ctx, "No global ownership context exists");
+    if (created) {
+        *created = NULL;
+    }
     // find the symbol table record for this rir object
     struct symbol_table_record *rec = symbol_table_lookup_rirobj(st, obj);
     if (!rec) {
@@ -87,63 +292,177 @@ static inline bool ow_ctx_add_new(struct rir_object *obj, const struct RFstring
         // creating a graph for this alloca
         return true;
     }
-    struct ow_graph *g = ow_graph_create(obj, fn_name, rec);
+    if (!g_ow_ctx->pools && !(g_ow_ctx->pools = ow_pools_create())) {
+        return false;
+    }
+    struct ow_graph *g = ow_graph_create(obj, fn_name, rec, g_ow_ctx->pools);
     if (!g) {
         return false;
     }
+    if (created) {
+        *created = g;
+    }
+    g->idx = darray_size(g_ow_ctx->graphs);
     darray_append(g_ow_ctx->graphs, g);
+    ow_ctx_set_value_node(rir_object_value(obj), g, g->root);
     return true;
 }
 
-static struct ow_graph *ow_ctx_graph_from_ploc(struct ow_passed_loc *ploc, struct ow_graph *from_graph)
+/**
+ * Create the argument graphs of the current function, remembering them by
+ * function name and argument index
+ */
+static bool ow_ctx_add_args(struct rir_fndef *f)
 {
-    RF_ASSERT(!ploc->call->foreign, "Foreign function calls should not come here");
-    RF_ASSERT(g_ow_ctx, "No global ownership context exists");
-    struct ow_graph **g;
-    OWDD("Trying to find ploc \""RFS_PF"\" in the following graphs:\n", RFS_PA(&ploc->call->name)); 
-    darray_foreach(g, g_ow_ctx->graphs) {
-        OWDD("Graph "RFS_PF"\n", RFS_PA(ow_node_id((*g)->root)));
+    struct rir_object **var;
+    struct ow_graph *g;
+    struct ow_fn_graphs *fg;
+    uint32_t id;
+    RF_MALLOC(fg, sizeof(*fg), return false);
+    darray_init(fg->args);
+    if (!strmap_add(&g_ow_ctx->fn_graphs, (struct RFstring*)&f->decl.name, fg)) {
+        darray_free(fg->args);
+        free(fg);
+        RF_ERROR("Failed to remember the argument graphs of a function");
+        return false;
     }
-    darray_foreach(g, g_ow_ctx->graphs) {
-        RFS_PUSH();
-        if (rf_string_equal(&ploc->call->name, (*g)->fn_name) &&
-            (*g)->obj->category == RIR_OBJ_VARIABLE &&
-            rf_string_equal(rir_value_string(rir_object_value((*g)->obj)),
-                            RFS("$%u", ploc->idx))
-        ) {
-            RFS_POP();
-            // change ploc node to the actual node it should point to
-            ploc->node = (*g)->root;
-            return *g;
+    darray_foreach(var, f->variables) {
+        if (!ow_ctx_add_new(*var, &f->decl.name, f->st, &g)) {
+            RF_ERROR("Error at adding a new ownership graph");
+            return false;
         }
-        RFS_POP();
+        id = rir_object_value(*var)->id;
+        while (darray_size(fg->args) <= id) {
+            darray_append(fg->args, NULL);
+        }
+        darray_item(fg->args, id) = g;
     }
-    // else fail
-    return NULL;
+    return true;
 }
 
-#if RF_OPTION_WITH_GRAPHVIZ
-bool ow_ctx_create_graphviz()
+static struct ow_graph *ow_ctx_graph_from_ploc(struct ow_passed_loc *ploc)
+{
+    RF_ASSERT(!ploc->call->foreign, "Foreign function calls should not come here");
+    RF_ASSERT(g_ow_ctx, "No global ownership context exists");
+    struct ow_fn_graphs *fg;
+    struct ow_graph *g;
+    OWDD("Trying to find ploc \""RFS_PF"\" %u\n", RFS_PA(&ploc->call->name), ploc->idx);
+    if (!(fg = strmap_get(&g_ow_ctx->fn_graphs, &ploc->call->name)) ||
+        ploc->idx >= darray_size(fg->args) ||
+        !(g = darray_item(fg->args, ploc->idx))) {
+        return NULL;
+    }
+    // change ploc node to the actual node it should point to
+    ploc->node = g->root;
+    return g;
+}
+
+#if RF_OPTION_OWNERSHIP_DOT || RF_OPTION_WITH_GRAPHVIZ
+/**
+ * Export all ownership graphs of a module in one go, as a DOT file and/or an
+ * SVG rendering depending on the build options
+ */
+static bool ow_ctx_export(const struct rir *r)
 {
+    struct RFstringx dot;
     bool ret = false;
-    if (!ow_graphviz_init()) {
-        RF_ERROR("Failed to initialize graphviz data");
+    if (!rf_stringx_init_buff(&dot, 4096, "")) {
         return false;
     }
-    struct ow_graph **graph;
-    darray_foreach(graph, g_ow_ctx->graphs) {
-        if (!ow_graph_to_graphviz(*graph)) {
-            goto end;
-        }
+    if (!ow_graphs_to_dot(&dot, &r->name, g_ow_ctx->graphs.item, darray_size(g_ow_ctx->graphs))) {
+        RF_ERROR("Failed to create the ownership graph of a module");
+        goto end;
     }
-    //success
+    RFS_PUSH();
+#if RF_OPTION_OWNERSHIP_DOT
+    if (!ow_dot_write(RF_STRX2STR(&dot), RFS("ownership_"RFS_PF".dot", RFS_PA(&r->name)))) {
+        goto pop;
+    }
+#endif
+#if RF_OPTION_WITH_GRAPHVIZ
+    if (!ow_graphviz_init()) {
+        RF_ERROR("Failed to initialize graphviz data");
+        goto pop;
+    }
+    ret = ow_graphviz_render(RF_STRX2STR(&dot), RFS("ownership_"RFS_PF".svg", RFS_PA(&r->name)));
+    ow_graphviz_deinit();
+#else
     ret = true;
+#endif
+pop:
+    RFS_POP();
 end:
-    ow_graphviz_deinit();
+    rf_stringx_deinit(&dot);
     return ret;
 }
 #endif
 
+static struct ow_module_summaries *ow_ctx_module_summaries(const struct rir *r)
+{
+    struct ow_ctx *ctx = g_ow_ctx->parent ? g_ow_ctx->parent : g_ow_ctx;
+    struct ow_module_summaries **ms;
+    darray_foreach(ms, ctx->summaries) {
+        if ((*ms)->rir == r) {
+            return *ms;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @return The summary of the function called @a name as seen from the current
+ *         module, or NULL if it has none. Like rir_fndecl_byname() the
+ *         module's own functions are looked at before its dependencies.
+ */
+static const struct ow_summary *ow_ctx_summary(const struct RFstring *name)
+{
+    struct ow_module_summaries *curr = g_ow_ctx->curr_summaries;
+    struct ow_module_summaries *ms;
+    struct ow_summary *s;
+    struct rir **dep;
+    if ((s = ow_module_summaries_get(curr, name))) {
+        return s;
+    }
+    darray_foreach(dep, curr->rir->dependencies) {
+        if ((ms = ow_ctx_module_summaries(*dep)) &&
+            (s = ow_module_summaries_get(ms, name))) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Compute the summary of a function from the graphs of its arguments
+ */
+static void ow_ctx_summarize(const struct rir_fndef *f)
+{
+    struct ow_summary *s = ow_module_summaries_get(g_ow_ctx->curr_summaries, &f->decl.name);
+    struct ow_fn_graphs *fg = strmap_get(&g_ow_ctx->fn_graphs, &f->decl.name);
+    struct ow_graph *g;
+    unsigned int i;
+    int flags;
+    RF_ASSERT(s && fg, "The function should have been analyzed");
+    for (i = 0; i < darray_size(s->params) && i < darray_size(fg->args); ++i) {
+        if (!(g = darray_item(fg->args, i))) {
+            // arguments without a graph are not owned values
+            continue;
+        }
+        flags = 0;
+        if (ow_graph_has_attr(g, OW_ATTR_RETURNED)) {
+            flags |= OW_PARAM_RETURNED;
+        }
+        if (ow_graph_has_attr(g, OW_ATTR_STORED)) {
+            flags |= OW_PARAM_STORED;
+        }
+        if (ow_graph_has_attr(g, OW_ATTR_ESCAPED)) {
+            flags |= OW_PARAM_ESCAPES;
+        }
+        darray_item(s->params, i) = flags;
+    }
+    s->done = true;
+}
+
 /**
  * Check if a value should go to a graph
  *
@@ -151,15 +470,23 @@ end:
  * @param dv             The value to put into the graph as a dependency
  * @param expr           The rir expression that should go at the connecting edge
  */
-static void ow_ctx_check_value(const struct rir_value *v, const struct rir_value *dv, struct rir_expression *expr)
+static struct ow_graph *ow_ctx_check_value(const struct rir_value *v,
+                                           const struct rir_value *dv,
+                                           struct rir_expression *expr)
 {
     RF_ASSERT(g_ow_ctx, "No global ownership context exists");
-    struct ow_graph **graph;
-    darray_foreach(graph, g_ow_ctx->graphs) {
-        if (ow_graph_check_or_add_val(*graph, v, dv, expr)) {
-            return; // stop searching if it gets added to any graph
-        }
+    struct ow_graph *g;
+    struct ow_node *n;
+    OWDD("Checking in \""RFS_PF"()\" if value "RFS_PF" goes to a graph\n",
+         RFS_PA(ow_curr_fnname()), RFS_PA(rir_value_string(v)));
+    if (!(n = ow_ctx_find_node(v, &g))) {
+        return NULL;
+    }
+    if (!(n = ow_graph_add_val(g, n, dv, expr))) {
+        return NULL;
     }
+    ow_ctx_set_value_node(dv, g, n);
+    return g;
 }
 
 /**
@@ -178,19 +505,22 @@ static inline void ow_ctx_check_value_from_expr(const struct rir_value *v, struc
  * @param end_type       The end node type
  * @param expr           The rir expression that should go at the connecting edge
  * @param idx            If this concerns parameter passing this is the parameter index. Else zero.
+ * @return               The graph the end node got added to or NULL
  */
-static void ow_ctx_check_value_as_end(const struct rir_value *v,
-                                      enum ow_end_type end_type,
-                                      const struct rir_expression *expr,
-                                      unsigned int idx)
+static struct ow_graph *ow_ctx_check_value_as_end(const struct rir_value *v,
+                                                  enum ow_end_type end_type,
+                                                  const struct rir_expression *expr,
+                                                  unsigned int idx)
 {
     RF_ASSERT(g_ow_ctx, "No global ownership context exists");
-    struct ow_graph **graph;
-    darray_foreach(graph, g_ow_ctx->graphs) {
-        if (ow_graph_check_or_add_end(*graph, v, end_type, expr, idx)) {
-            return; // stop searching if it gets added to any graph
-        }
+    struct ow_graph *g;
+    struct ow_node *n;
+    OWDD("End checking in \""RFS_PF"()\" if value "RFS_PF" goes to a graph\n",
+         RFS_PA(ow_curr_fnname()), RFS_PA(rir_value_string(v)));
+    if (!(n = ow_ctx_find_node(v, &g)) || !ow_graph_add_end(g, n, end_type, expr, idx)) {
+        return NULL;
     }
+    return g;
 }
 
 void ow_ctx_check_expr(struct rir_expression *expr)
@@ -201,10 +531,23 @@ void ow_ctx_check_expr(struct rir_expression *expr)
         // check if any of the call's arguments should be in the graph
     {
         struct rir_value **val;
+        struct ow_graph *g;
         unsigned int idx = 0;
+        int flags;
+        const struct ow_summary *sum = expr->call.foreign
+            ? NULL
+            : ow_ctx_summary(&expr->call.name);
         darray_foreach(val, expr->call.args) {
-            ow_ctx_check_value_from_expr(*val, expr);
-            ow_ctx_check_value_as_end(*val, OW_END_PASSED, expr, idx++);
+            // foreign functions only use their arguments during the call
+            flags = expr->call.foreign ? OW_PARAM_RETURNED : ow_summary_param(sum, idx);
+            // only an argument the callee may return flows into the call's value
+            if (flags & OW_PARAM_RETURNED) {
+                ow_ctx_check_value_from_expr(*val, expr);
+            }
+            g = ow_ctx_check_value_as_end(*val, OW_END_PASSED, expr, idx++);
+            if (g && (flags & (OW_PARAM_STORED | OW_PARAM_ESCAPES))) {
+                ow_graph_set_attr(g, OW_ATTR_ESCAPED);
+            }
         }
     }
         break;
@@ -230,7 +573,12 @@ void ow_ctx_check_expr(struct rir_expression *expr)
         ow_ctx_check_value_from_expr(expr->read.memory, expr);
         break;
     case RIR_EXPRESSION_WRITE:
-        ow_ctx_check_value(expr->write.writeval, expr->write.memory, expr);
+    {
+        struct ow_graph *g = ow_ctx_check_value(expr->write.writeval, expr->write.memory, expr);
+        if (g) {
+            ow_graph_set_attr(g, OW_ATTR_STORED);
+        }
+    }
         break;
     case RIR_EXPRESSION_CONVERT:
         ow_ctx_check_value_from_expr(expr->convert.val, expr);
@@ -258,6 +606,8 @@ void ow_ctx_check_expr(struct rir_expression *expr)
 
     case RIR_EXPRESSION_LOGIC_AND:
     case RIR_EXPRESSION_LOGIC_OR:
+    // phis only ever merge elementary values which are not owned
+    case RIR_EXPRESSION_PHI:
     case RIR_EXPRESSION_PLACEHOLDER:
         // no need to do anything
         break;
@@ -269,47 +619,267 @@ void ow_ctx_check_expr(struct rir_expression *expr)
 
 bool ow_function_pass(struct rir_fndef *f)
 {
-    struct rir_object **var;
     ow_reset_expr_idx();
-    g_ow_ctx->curr_fn_name = &f->decl.name;
-    darray_foreach(var, f->variables) {
-        if (!ow_ctx_add_new(*var, &f->decl.name, f->st)) {
-            RF_ERROR("Error at adding a new ownership graph");
-            return false;
-        }
+    ow_ctx_set_fn(f);
+    if (!ow_ctx_add_args(f)) {
+        return false;
     }
 
-    struct rir_block **b;
-    darray_foreach(b, f->blocks) {
-        struct rir_expression *expr;
-        rf_ilist_for_each(&(*b)->expressions, expr, ln) {
+    struct rir_code code;
+    struct rir_code_block *cb;
+    struct rir_instr *instr;
+    bool ret = false;
+    if (!rir_code_init(&code, f)) {
+        return false;
+    }
+    darray_foreach(cb, code.blocks) {
+        rir_code_foreach_block_instr(&code, cb, instr) {
             // if it's an alloca add a new graph
-            if (expr->type == RIR_EXPRESSION_ALLOCA) {
-                if (!ow_ctx_add_new(rir_expression_to_obj(expr), &f->decl.name, (*b)->st)) {
+            if (instr->op == RIR_EXPRESSION_ALLOCA) {
+                if (!ow_ctx_add_new(rir_expression_to_obj(instr->expr), &f->decl.name, cb->block->st, NULL)) {
                     RF_ERROR("Error at adding a new ownership graph");
-                    return false;
+                    goto end;
                 }
             } else { // in other cases see if it needs to go in a graph
-                ow_ctx_check_expr(expr);
+                ow_ctx_check_expr(instr->expr);
             }
         }
         // also check if this is the return block
-        struct rir_return *rexp = &(*b)->exit.retstmt;
-        if ((*b)->exit.type == RIR_BLOCK_EXIT_RETURN && rexp->val) {
+        struct rir_return *rexp = &cb->block->exit.retstmt;
+        if (cb->block->exit.type == RIR_BLOCK_EXIT_RETURN && rexp->val) {
             ow_ctx_check_value_as_end(rexp->val, OW_END_RETURN, NULL, 0);
         }
     }
-    return true;
+    ret = true;
+end:
+    rir_code_deinit(&code);
+    return ret;
 }
 
-bool ow_module_pass(struct rir *r)
+/**
+ * Analysis of the functions of a module by a pool of threads. The strongly
+ * connected components of the call graph go in waves, one per level, so that
+ * every call sees the finished summary of its callee unless both are in the
+ * same cycle of calls. Each thread builds graphs in its own context and moves
+ * them to the module's context once a component is done.
+ */
+struct ow_analysis {
+    struct ow_ctx *module_ctx;
+    const struct ow_callgraph_order *order;
+    //! Indices of the components ordered by level
+    struct {darray(unsigned int);} sccs;
+    //! For each level, the index in @a sccs after its last component
+    struct {darray(unsigned int);} wave_ends;
+    //! Index in @a sccs of the next component to claim. Guarded by @a lock
+    size_t next;
+    //! The level being analyzed. Guarded by @a lock
+    unsigned int wave;
+    //! Components of the wave that are claimed but not done. Guarded by @a lock
+    unsigned int busy;
+    //! Set when analyzing any of the functions failed. Guarded by @a lock
+    bool failed;
+    pthread_mutex_t lock;
+    //! Signalled when the last component of a wave is done or on failure
+    pthread_cond_t wave_done;
+};
+
+static void ow_analysis_init(struct ow_analysis *a,
+                             struct ow_ctx *module_ctx,
+                             const struct ow_callgraph_order *order)
 {
-    // output functions
-    struct rir_fndecl *decl;
-    rf_ilist_for_each(&r->functions, decl, ln) {
-        if (!decl->plain_decl && !ow_function_pass(rir_fndecl_to_fndef(decl))) {
-            return false;
+    unsigned int *level;
+    unsigned int *end;
+    unsigned int levels = 0;
+    unsigned int count;
+    unsigned int i;
+    RF_STRUCT_ZERO(a);
+    a->module_ctx = module_ctx;
+    a->order = order;
+    darray_init(a->sccs);
+    darray_init(a->wave_ends);
+    pthread_mutex_init(&a->lock, NULL);
+    pthread_cond_init(&a->wave_done, NULL);
+    darray_foreach(level, order->scc_levels) {
+        if (*level >= levels) {
+            levels = *level + 1;
+        }
+    }
+    // count the components of each level and turn the counts into the
+    // index of the first component of each level
+    darray_resize(a->wave_ends, levels);
+    darray_foreach(end, a->wave_ends) {
+        *end = 0;
+    }
+    darray_foreach(level, order->scc_levels) {
+        ++darray_item(a->wave_ends, *level);
+    }
+    i = 0;
+    darray_foreach(end, a->wave_ends) {
+        count = *end;
+        *end = i;
+        i += count;
+    }
+    // placing each component moves the start of its level forward, until it
+    // is the end of the level
+    darray_resize(a->sccs, darray_size(order->scc_levels));
+    for (i = 0; i < darray_size(order->scc_levels); ++i) {
+        end = &darray_item(a->wave_ends, darray_item(order->scc_levels, i));
+        darray_item(a->sccs, (*end)++) = i;
+    }
+}
+
+static void ow_analysis_deinit(struct ow_analysis *a)
+{
+    darray_free(a->sccs);
+    darray_free(a->wave_ends);
+    pthread_mutex_destroy(&a->lock);
+    pthread_cond_destroy(&a->wave_done);
+}
+
+/**
+ * Claim the next component to analyze, waiting for the current wave to
+ * finish if all of its components are claimed
+ *
+ * @return false if there is nothing left to claim
+ */
+static bool ow_analysis_claim(struct ow_analysis *a, unsigned int *scc)
+{
+    bool ret = false;
+    pthread_mutex_lock(&a->lock);
+    while (!a->failed && a->next < darray_size(a->sccs)) {
+        if (a->next < darray_item(a->wave_ends, a->wave)) {
+            *scc = darray_item(a->sccs, a->next++);
+            ++a->busy;
+            ret = true;
+            break;
+        }
+        if (a->busy == 0) {
+            ++a->wave;
+            continue;
         }
+        pthread_cond_wait(&a->wave_done, &a->lock);
+    }
+    pthread_mutex_unlock(&a->lock);
+    return ret;
+}
+
+static void ow_analysis_finish(struct ow_analysis *a, bool ok)
+{
+    pthread_mutex_lock(&a->lock);
+    if (!ok || !ow_ctx_merge(a->module_ctx)) {
+        a->failed = true;
+    }
+    if (--a->busy == 0 || a->failed) {
+        pthread_cond_broadcast(&a->wave_done);
+    }
+    pthread_mutex_unlock(&a->lock);
+}
+
+static void ow_analysis_run(struct ow_analysis *a)
+{
+    const struct ow_callgraph_order *order = a->order;
+    unsigned int scc;
+    unsigned int first;
+    unsigned int end;
+    unsigned int i;
+    bool ok;
+    while (ow_analysis_claim(a, &scc)) {
+        first = scc == 0 ? 0 : darray_item(order->scc_ends, scc - 1);
+        end = darray_item(order->scc_ends, scc);
+        ok = true;
+        for (i = first; ok && i < end; ++i) {
+            ok = ow_function_pass(darray_item(order->fns, i));
+        }
+        // summaries of a cycle are only done once all of its functions are
+        for (i = first; ok && i < end; ++i) {
+            ow_ctx_summarize(darray_item(order->fns, i));
+        }
+        ow_analysis_finish(a, ok);
+    }
+    // the merged graphs point into the pools of this context so the module
+    // keeps them
+    if (g_ow_ctx->pools) {
+        pthread_mutex_lock(&a->lock);
+        darray_append(a->module_ctx->merged_pools, g_ow_ctx->pools);
+        pthread_mutex_unlock(&a->lock);
+        g_ow_ctx->pools = NULL;
+    }
+}
+
+static void *ow_analysis_thread_init(struct ow_analysis *a)
+{
+    // every thread, this one included, works in a context of its own since
+    // the module's context only gets touched when merging
+    g_ow_ctx = NULL;
+    ow_ctx_init(a->module_ctx);
+    return g_ow_ctx;
+}
+
+static void ow_analysis_thread_run(struct ow_analysis *a, struct ow_ctx *ctx)
+{
+    (void)ctx;
+    ow_analysis_run(a);
+}
+
+static void ow_analysis_thread_deinit(struct ow_analysis *a, struct ow_ctx *ctx)
+{
+    (void)a;
+    (void)ctx;
+    ow_ctx_deinit();
+}
+
+static const struct workers ow_analysis_workers = {
+    .name = "ownership analysis",
+    .init = (void *(*)(void*))ow_analysis_thread_init,
+    .run = (void (*)(void*, void*))ow_analysis_thread_run,
+    .deinit = (void (*)(void*, void*))ow_analysis_thread_deinit,
+};
+
+/**
+ * Analyze all functions of @a a using up to @a jobs threads, including the
+ * calling one
+ */
+static bool ow_analysis_do(struct ow_analysis *a, unsigned int jobs)
+{
+    bool ret = workers_run(&ow_analysis_workers, a, NULL, jobs, darray_size(a->sccs));
+    g_ow_ctx = a->module_ctx;
+    return ret && !a->failed;
+}
+
+/**
+ * Analyze the functions of a module bottom-up over its call graph
+ */
+static bool ow_module_functions_pass(struct rir *r)
+{
+    struct ow_callgraph_order order;
+    struct ow_analysis a;
+    struct rir_fndef **fn;
+    bool ret = false;
+    if (!(g_ow_ctx->curr_summaries = ow_module_summaries_create(r))) {
+        return false;
+    }
+    darray_append(g_ow_ctx->summaries, g_ow_ctx->curr_summaries);
+    if (!ow_callgraph_order_init(&order, r)) {
+        return false;
+    }
+    darray_foreach(fn, order.fns) {
+        if (!ow_module_summaries_add(g_ow_ctx->curr_summaries, *fn)) {
+            RF_ERROR("Failed to add an ownership summary");
+            goto end;
+        }
+    }
+    ow_analysis_init(&a, g_ow_ctx, &order);
+    ret = ow_analysis_do(&a, g_ow_ctx->jobs);
+    ow_analysis_deinit(&a);
+end:
+    ow_callgraph_order_deinit(&order);
+    return ret;
+}
+
+bool ow_module_pass(struct rir *r)
+{
+    if (!ow_module_functions_pass(r)) {
+        return false;
     }
 
     struct ow_graph **graph;
@@ -321,39 +891,74 @@ bool ow_module_pass(struct rir *r)
                 continue;
             }
             // find the graph of the passed function
-            struct ow_graph *pgraph = ow_ctx_graph_from_ploc(*ploc, *graph);
+            struct ow_graph *pgraph = ow_ctx_graph_from_ploc(*ploc);
+            if (!pgraph && !ow_module_summaries_get(g_ow_ctx->curr_summaries, &(*ploc)->call->name)) {
+                // a function of another module. Its summary got applied at the call.
+                continue;
+            }
             if (!pgraph) {
                 RF_ERROR("Failed to find the graph from a passed location");
                 return false;
             }
             // connect them
             /* if (!ow_node_connect_end_node((*graph)->root, rir_call_to_expr((*ploc)->call), (*ploc)->node)) { */
-            if (!ow_node_connect_end_node((*ploc)->from_node, rir_call_to_expr((*ploc)->call), (*ploc)->node)) {
+            if (!ow_node_connect_end_node((*graph)->pools, (*ploc)->from_node, rir_call_to_expr((*ploc)->call), (*ploc)->node)) {
                 RF_ERROR("Failed to connect nodes of two different graphs");
                 return false;
             }
         }
     }
-    
-#if RF_OPTION_WITH_GRAPHVIZ
-    rf_ilist_for_each(&r->functions, decl, ln) {
-        // for now just always create the SVG graphs per function
-        ow_ctx_create_graphviz();
+
+    // all uses of the values are known now so annotate the allocations
+    darray_foreach(graph, g_ow_ctx->graphs) {
+        ow_graph_place(*graph);
+    }
+
+#if RF_OPTION_OWNERSHIP_DOT || RF_OPTION_WITH_GRAPHVIZ
+    // the graphs are only debug output, not being able to write them should
+    // not fail the compilation
+    if (!ow_ctx_export(r)) {
+        WARN("Could not export the ownership graphs of module \""RFS_PF"\"",
+             RFS_PA(&r->name));
     }
 #endif
     return true;
 }
 
+void ow_ctx_begin(unsigned int jobs)
+{
+    ow_ctx_init(NULL);
+    g_ow_ctx->jobs = jobs;
+}
+
+void ow_ctx_end()
+{
+    ow_ctx_deinit();
+}
+
+bool ow_ctx_module_pass(struct rir *r)
+{
+    // graphs are per module, the summaries are kept for the dependents
+    ow_ctx_reset();
+    return ow_module_pass(r);
+}
+
+struct ow_graph **ow_ctx_graphs(unsigned int *num)
+{
+    RF_ASSERT(g_ow_ctx, "No global ownership context exists");
+    *num = darray_size(g_ow_ctx->graphs);
+    return g_ow_ctx->graphs.item;
+}
+
 bool ownership_pass(struct compiler *c)
 {
     struct module **mod;
     bool ret = false;
-    ow_ctx_init();
+    ow_ctx_begin(compiler_args_rir_jobs(c->args));
     darray_foreach(mod, c->modules) {
         // only for modules that got parsed from normal source, at least for now
         if (module_rir_codepath(*mod) == RIRPOS_AST) {
-            ow_ctx_reset(); // for now the graph is per module
-            if (!ow_module_pass((*mod)->rir)) {
+            if (!ow_ctx_module_pass((*mod)->rir)) {
                 goto end;
             }
         }
@@ -362,6 +967,6 @@ bool ownership_pass(struct compiler *c)
     ret = true;
 
 end:
-    ow_ctx_deinit();
+    ow_ctx_end();
     return ret;
 }
@@ -18,6 +18,8 @@
 #include <types/type_arr.h>
 #include <types/type_elementary.h>
 
+#include <utils/stats.h>
+
 /* -- typecmp_ctx functions -- */
 
 struct typecmp_ctx {
@@ -520,6 +522,7 @@ bool type_compare(const struct type *from,
                   const struct type *to,
                   enum comparison_reason reason)
 {
+    stats_add(STATS_TYPE_COMPARISONS, 1);
     typecmp_ctx_reset();
     // first check if we refer to the same type (elementary or composite)
     if (from == to) {
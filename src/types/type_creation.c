@@ -14,6 +14,7 @@
 #include <analyzer/type_set.h>
 #include <analyzer/analyzer.h>
 #include <module.h>
+#include <utils/stats.h>
 
 struct type_creation_ctx {
     //! A queue of type operators during creation
@@ -200,6 +201,7 @@ struct type *type_alloc(struct module *m)
 {
     struct type *ret = rf_fixed_memorypool_alloc_element(m->types_pool);
     RF_STRUCT_ZERO(ret);
+    stats_add(STATS_TYPES, 1);
     return ret;
 }
 
@@ -207,6 +209,7 @@ struct type *type_alloc_copy(struct module *m, const struct type *source)
 {
     struct type *ret = rf_fixed_memorypool_alloc_element(m->types_pool);
     memcpy(ret, source, sizeof(*source));
+    stats_add(STATS_TYPES, 1);
     return ret;
 }
 
@@ -0,0 +1,263 @@
+#include <utils/stats.h>
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include <rfbase/datastructs/darray.h>
+#include <rfbase/utils/log.h>
+#include <rfbase/utils/sanity.h>
+
+i_THREAD__ uint64_t g_stats_counts[STATS_COUNTERS_NUM];
+
+//! Marks a phase without a parent
+#define STATS_NO_PARENT ((unsigned int)-1)
+
+static const char *stats_counter_names[STATS_COUNTERS_NUM] = {
+    "tokens",
+    "ast_nodes",
+    "types",
+    "type_comparisons",
+    "symbol_lookups",
+    "rir_objects",
+    "llvm_instructions",
+};
+
+struct stats_phase {
+    const char *name;
+    unsigned int parent;
+    unsigned int depth;
+    unsigned int calls;
+    uint64_t time_ns;
+    //! Peak resident set size of the process in KB when the phase last ended
+    long peak_rss_kb;
+    //! What got counted while the phase was running, including its children
+    uint64_t counts[STATS_COUNTERS_NUM];
+};
+
+//! A phase that is running
+struct stats_running {
+    unsigned int phase;
+    uint64_t start_ns;
+    uint64_t start_counts[STATS_COUNTERS_NUM];
+};
+
+struct stats {
+    bool enabled;
+    struct {darray(struct stats_phase);} phases;
+    struct {darray(struct stats_running);} stack;
+    //! Counters flushed by threads that are done
+    uint64_t flushed[STATS_COUNTERS_NUM];
+    pthread_mutex_t lock;
+};
+
+static struct stats g_stats = {
+    .enabled = false,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+i_INLINE_INS void stats_add(enum stats_counter c, uint64_t n);
+
+static uint64_t stats_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static long stats_peak_rss_kb()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    // given in bytes instead of KB
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * Get the counters of the main thread together with those flushed by other
+ * threads
+ */
+static void stats_totals(uint64_t *counts)
+{
+    unsigned int i;
+    pthread_mutex_lock(&g_stats.lock);
+    for (i = 0; i < STATS_COUNTERS_NUM; ++i) {
+        counts[i] = g_stats_counts[i] + g_stats.flushed[i];
+    }
+    pthread_mutex_unlock(&g_stats.lock);
+}
+
+void stats_enable()
+{
+    g_stats.enabled = true;
+    darray_init(g_stats.phases);
+    darray_init(g_stats.stack);
+}
+
+bool stats_enabled()
+{
+    return g_stats.enabled;
+}
+
+void stats_deinit()
+{
+    if (!g_stats.enabled) {
+        return;
+    }
+    darray_free(g_stats.phases);
+    darray_free(g_stats.stack);
+    g_stats.enabled = false;
+}
+
+void stats_phase_begin(const char *name)
+{
+    struct stats_running run;
+    struct stats_phase *p;
+    struct stats_phase phase;
+    unsigned int parent;
+    if (!g_stats.enabled) {
+        return;
+    }
+    parent = darray_empty(g_stats.stack)
+        ? STATS_NO_PARENT
+        : darray_top(g_stats.stack).phase;
+    run.phase = STATS_NO_PARENT;
+    darray_foreach(p, g_stats.phases) {
+        if (p->parent == parent && strcmp(p->name, name) == 0) {
+            run.phase = p - g_stats.phases.item;
+            break;
+        }
+    }
+    if (run.phase == STATS_NO_PARENT) {
+        memset(&phase, 0, sizeof(phase));
+        phase.name = name;
+        phase.parent = parent;
+        phase.depth = darray_size(g_stats.stack);
+        darray_append(g_stats.phases, phase);
+        run.phase = darray_size(g_stats.phases) - 1;
+    }
+    stats_totals(run.start_counts);
+    run.start_ns = stats_now_ns();
+    darray_append(g_stats.stack, run);
+}
+
+void stats_phase_end()
+{
+    struct stats_running run;
+    struct stats_phase *p;
+    uint64_t end_ns;
+    uint64_t counts[STATS_COUNTERS_NUM];
+    unsigned int i;
+    if (!g_stats.enabled) {
+        return;
+    }
+    end_ns = stats_now_ns();
+    RF_ASSERT(!darray_empty(g_stats.stack), "stats_phase_end() without a running phase");
+    run = darray_pop(g_stats.stack);
+    stats_totals(counts);
+    p = &darray_item(g_stats.phases, run.phase);
+    p->time_ns += end_ns - run.start_ns;
+    ++p->calls;
+    p->peak_rss_kb = stats_peak_rss_kb();
+    for (i = 0; i < STATS_COUNTERS_NUM; ++i) {
+        p->counts[i] += counts[i] - run.start_counts[i];
+    }
+}
+
+void stats_thread_flush()
+{
+    unsigned int i;
+    pthread_mutex_lock(&g_stats.lock);
+    for (i = 0; i < STATS_COUNTERS_NUM; ++i) {
+        g_stats.flushed[i] += g_stats_counts[i];
+        g_stats_counts[i] = 0;
+    }
+    pthread_mutex_unlock(&g_stats.lock);
+}
+
+static void stats_print_table_phase(FILE *f, unsigned int idx)
+{
+    const struct stats_phase *p = &darray_item(g_stats.phases, idx);
+    unsigned int i;
+    fprintf(f, "%*s%-*s %10.3f %6u %10ld",
+            (int)p->depth * 2, "", 24 - (int)p->depth * 2, p->name,
+            p->time_ns / 1e6, p->calls, p->peak_rss_kb);
+    for (i = 0; i < STATS_COUNTERS_NUM; ++i) {
+        fprintf(f, " %17" PRIu64, p->counts[i]);
+    }
+    fputc('\n', f);
+    // children come after their parent since they are added when they first
+    // run, but not necessarily right after it
+    for (i = idx + 1; i < darray_size(g_stats.phases); ++i) {
+        if (darray_item(g_stats.phases, i).parent == idx) {
+            stats_print_table_phase(f, i);
+        }
+    }
+}
+
+static void stats_print_json_phase(FILE *f, unsigned int idx)
+{
+    const struct stats_phase *p = &darray_item(g_stats.phases, idx);
+    unsigned int i;
+    bool first = true;
+    fprintf(f, "{\"name\":\"%s\",\"time_ms\":%.3f,\"calls\":%u,\"peak_rss_kb\":%ld,\"counters\":{",
+            p->name, p->time_ns / 1e6, p->calls, p->peak_rss_kb);
+    for (i = 0; i < STATS_COUNTERS_NUM; ++i) {
+        fprintf(f, "%s\"%s\":%" PRIu64, i == 0 ? "" : ",", stats_counter_names[i], p->counts[i]);
+    }
+    fputs("},\"children\":[", f);
+    for (i = idx + 1; i < darray_size(g_stats.phases); ++i) {
+        if (darray_item(g_stats.phases, i).parent == idx) {
+            if (!first) {
+                fputc(',', f);
+            }
+            stats_print_json_phase(f, i);
+            first = false;
+        }
+    }
+    fputs("]}", f);
+}
+
+void stats_print(FILE *f, enum stats_format format)
+{
+    unsigned int i;
+    bool first = true;
+    if (!g_stats.enabled) {
+        return;
+    }
+    if (format == STATS_FORMAT_JSON) {
+        fputs("{\"phases\":[", f);
+    } else {
+        fprintf(f, "%-24s %10s %6s %10s", "phase", "time(ms)", "calls", "rss(KB)");
+        for (i = 0; i < STATS_COUNTERS_NUM; ++i) {
+            fprintf(f, " %17s", stats_counter_names[i]);
+        }
+        fputc('\n', f);
+    }
+    for (i = 0; i < darray_size(g_stats.phases); ++i) {
+        if (darray_item(g_stats.phases, i).parent != STATS_NO_PARENT) {
+            continue;
+        }
+        if (format == STATS_FORMAT_JSON) {
+            if (!first) {
+                fputc(',', f);
+            }
+            stats_print_json_phase(f, i);
+        } else {
+            stats_print_table_phase(f, i);
+        }
+        first = false;
+    }
+    if (format == STATS_FORMAT_JSON) {
+        fputs("]}\n", f);
+    }
+    fflush(f);
+}
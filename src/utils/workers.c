@@ -0,0 +1,80 @@
+#include <utils/workers.h>
+
+#include <pthread.h>
+
+#include <rfbase/refu.h>
+#include <rfbase/persistent/buffers.h>
+#include <rfbase/utils/log.h>
+#include <rfbase/utils/memory.h>
+
+#include <utils/stats.h>
+
+//! What a thread of the pool needs to start working
+struct workers_thread {
+    const struct workers *w;
+    void *data;
+};
+
+static void *workers_thread(struct workers_thread *t)
+{
+    void *state;
+    // each thread needs its own string buffers
+    if (!rf_persistent_data_ts_init(RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+                                    RF_DEFAULT_TS_SBUFF_INITIAL_SIZE)) {
+        RF_ERROR("Could not set up the buffers of a %s thread", t->w->name);
+        return NULL;
+    }
+    if ((state = t->w->init(t->data))) {
+        t->w->run(t->data, state);
+        t->w->deinit(t->data, state);
+    }
+    stats_thread_flush();
+    rf_persistent_data_ts_deinit();
+    return NULL;
+}
+
+bool workers_run(const struct workers *w,
+                 void *data,
+                 void *state,
+                 unsigned int jobs,
+                 unsigned int work)
+{
+    struct workers_thread t = {.w = w, .data = data};
+    pthread_t *threads = NULL;
+    unsigned int i;
+    unsigned int created = 0;
+    bool own_state = !state;
+    bool ret = false;
+    if (jobs > work) {
+        jobs = work;
+    }
+    if (jobs > 1) {
+        RF_MALLOC(threads, sizeof(*threads) * (jobs - 1), return false);
+        for (i = 0; i < jobs - 1; ++i) {
+            if (pthread_create(
+                    &threads[i],
+                    NULL,
+                    (void *(*)(void*))workers_thread,
+                    &t) != 0) {
+                // the threads we got, and this one, can still do all the work
+                RF_ERROR("Could not create a %s thread", w->name);
+                break;
+            }
+            ++created;
+        }
+    }
+    if (own_state && !(state = w->init(data))) {
+        RF_ERROR("Could not set up the %s of the calling thread", w->name);
+    } else {
+        w->run(data, state);
+        if (own_state) {
+            w->deinit(data, state);
+        }
+        ret = true;
+    }
+    for (i = 0; i < created; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    return ret;
+}
@@ -69,6 +69,7 @@ function print_help {
     echo "    --help                  Print this help message."
     echo "    --rfbase                If given then also rfbase submodule tests are ran"
     echo "    --coverage              If given then generate coverage report"
+    echo "    --benchmarks            If given then also run the benchmark tests"
     echo "    --in-travis             We are running tests in a travis instance"
     echo "    --travis-job-id NUMBER   If running inside a travis instance this should contain the job ID"
 }
@@ -163,6 +164,9 @@ do
     if [[ $arg == "--rfbase" ]]; then
         TEST_RFBASE=1
         continue
+    elif [[ $arg == "--benchmarks" ]]; then
+        export REFU_TEST_BENCHMARKS=1
+        continue
     elif [[ $arg == "--coverage" ]]; then
         COVERAGE=1
         continue
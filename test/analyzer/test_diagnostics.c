@@ -0,0 +1,160 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rfbase/string/core.h>
+
+#include <compiler.h>
+#include <compiler_args.h>
+#include <info/diagnostics.h>
+
+#include "../testsupport_front.h"
+#include "../testsupport.h"
+#include "testsupport_analyzer.h"
+
+#include CLIB_TEST_HELPERS
+
+#define i_eval(_def) #_def
+#define i_str(_def) i_eval(_def)
+#define TEST_DIAG_VERSION_STR                           \
+    i_str(RF_LANG_MAJOR_VERSION) "."                    \
+    i_str(RF_LANG_MINOR_VERSION) "."                    \
+    i_str(RF_LANG_PATCH_VERSION)
+
+// two errors for the same span, columns 12 to 17 of the second line
+static const struct RFstring s_invalid_uop = RF_STRING_STATIC_INIT(
+    "{\n"
+    "b:string = -\"foo\"\n"
+    "}"
+);
+
+/**
+ * Typecheck @a source writing its messages in @a format
+ *
+ * @return The whole output. Free it with free().
+ */
+static char *test_diagnostics_output(const struct RFstring *source,
+                                     enum info_diag_format format)
+{
+    struct compiler *c = compiler_instance_get();
+    FILE *f = tmpfile();
+    char *ret;
+    long size;
+    ck_assert(f);
+    // set before the front is created, as the compiler does for its inputs
+    c->diag = info_diag_create(format, f);
+    ck_assert(c->diag);
+    front_testdriver_new_ast_main_source(source);
+    testsupport_scan_and_parse();
+    ck_assert(!compiler_analyze());
+    // the compiler frees the writer but nothing more gets written to f
+    info_diag_end(c->diag);
+
+    ck_assert(fseek(f, 0, SEEK_END) == 0);
+    size = ftell(f);
+    ck_assert(size >= 0);
+    rewind(f);
+    ret = malloc(size + 1);
+    ck_assert(ret);
+    ck_assert_uint_eq(fread(ret, 1, size, f), size);
+    ret[size] = '\0';
+    fclose(f);
+    return ret;
+}
+
+#define ck_assert_diagnostics_output(source_, format_, expected_)       \
+    do {                                                                \
+        char *got_ = test_diagnostics_output(source_, format_);         \
+        ck_assert_msg(                                                  \
+            strcmp(got_, expected_) == 0,                               \
+            "Diagnostics output mismatch.\nExpected:\n%s\nGot:\n%s",    \
+            expected_, got_                                             \
+        );                                                              \
+        free(got_);                                                     \
+    } while (0)
+
+START_TEST (test_diagnostics_json_lines) {
+    static const char *expected =
+        "{\"file\":\"test_filename\",\"line\":2,\"column\":12,"
+        "\"end_line\":2,\"end_column\":18,\"severity\":\"error\","
+        "\"type\":\"semantic error\","
+        "\"message\":\"Can't apply \\\"-\\\" to \\\"string\\\"\"}\n"
+        "{\"file\":\"test_filename\",\"line\":2,\"column\":12,"
+        "\"end_line\":2,\"end_column\":18,\"severity\":\"error\","
+        "\"type\":\"semantic error\","
+        "\"message\":\"Type of right side of \\\"=\\\" can not be determined\"}\n";
+    ck_assert_diagnostics_output(&s_invalid_uop, INFO_DIAG_FORMAT_JSON, expected);
+} END_TEST
+
+START_TEST (test_diagnostics_sarif) {
+    static const char *expected =
+        "{\"version\":\"2.1.0\","
+        "\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\","
+        "\"runs\":[{\"tool\":{\"driver\":{\"name\":\"refu\","
+        "\"version\":\"" TEST_DIAG_VERSION_STR "\"}},"
+        "\"results\":[\n"
+        "{\"level\":\"error\","
+        "\"message\":{\"text\":\"Can't apply \\\"-\\\" to \\\"string\\\"\"},"
+        "\"locations\":[{\"physicalLocation\":{"
+        "\"artifactLocation\":{\"uri\":\"test_filename\"},"
+        "\"region\":{\"startLine\":2,\"startColumn\":12,\"endLine\":2,\"endColumn\":18}}}]},\n"
+        "{\"level\":\"error\","
+        "\"message\":{\"text\":\"Type of right side of \\\"=\\\" can not be determined\"},"
+        "\"locations\":[{\"physicalLocation\":{"
+        "\"artifactLocation\":{\"uri\":\"test_filename\"},"
+        "\"region\":{\"startLine\":2,\"startColumn\":12,\"endLine\":2,\"endColumn\":18}}}]}"
+        "\n]}]}\n";
+    ck_assert_diagnostics_output(&s_invalid_uop, INFO_DIAG_FORMAT_SARIF, expected);
+} END_TEST
+
+START_TEST (test_diagnostics_format_unknown) {
+    struct compiler_args *args = compiler_args_create();
+    enum info_diag_format format;
+    ck_assert(args);
+    ck_assert(compiler_args_diagnostics_format(args, &format));
+    ck_assert_int_eq(format, INFO_DIAG_FORMAT_TEXT);
+    args->diagnostics_format->count = 1;
+    args->diagnostics_format->sval[0] = "sarif";
+    ck_assert(compiler_args_diagnostics_format(args, &format));
+    ck_assert_int_eq(format, INFO_DIAG_FORMAT_SARIF);
+    // no falling back to text
+    args->diagnostics_format->sval[0] = "xml";
+    ck_assert(!compiler_args_diagnostics_format(args, &format));
+    args->diagnostics_format->count = 0;
+    compiler_args_destroy(args);
+} END_TEST
+
+START_TEST (test_diagnostics_format_arg_unanchored) {
+    struct compiler_args *args = compiler_args_create();
+    char *argv[] = {"refu", "--diagnostics-format", "xjson", "test_input_file.rf"};
+    ck_assert(args);
+    // a value that only contains a format fails parsing, which exits
+    compiler_args_parse(args, 4, argv);
+    compiler_args_destroy(args);
+} END_TEST
+
+Suite *analyzer_diagnostics_suite_create(void)
+{
+    Suite *s = suite_create("analyzer_diagnostics");
+
+    TCase *tc1 = tcase_create("analyzer_diagnostics_output");
+    tcase_add_checked_fixture(tc1,
+                              setup_analyzer_tests_no_stdlib,
+                              teardown_analyzer_tests);
+    tcase_add_test(tc1, test_diagnostics_json_lines);
+    tcase_add_test(tc1, test_diagnostics_sarif);
+
+    TCase *tc2 = tcase_create("analyzer_diagnostics_args");
+    tcase_add_checked_fixture(tc2,
+                              setup_base_tests,
+                              teardown_base_tests);
+    tcase_add_test(tc2, test_diagnostics_format_unknown);
+    tcase_add_exit_test(tc2, test_diagnostics_format_arg_unanchored, 1);
+
+    suite_add_tcase(s, tc1);
+    suite_add_tcase(s, tc2);
+
+    return s;
+}
@@ -209,18 +209,18 @@ bool ck_assert_analyzer_errors_impl(struct info_msg *exp_errors,
                     "Got more analyzer errors than the expected %u. The extra "
                     "error we got is:\n\""RFS_PF"\".",
                     num,
-                    RFS_PA(&msg->s)
+                    RFS_PA(info_msg_str(msg))
                 );
                 return false;
             }
 
             // check for error message string
-            if (!rf_string_equal(&msg->s, &exp_errors[i].s)) {
+            if (!rf_string_equal(info_msg_str(msg), &exp_errors[i].s)) {
                 ck_analyzer_check_abort(
                     filename, line,
                     "For analyzer error number %u: Got:\n\""RFS_PF"\"\n"
                     "but expected:\n\""RFS_PF"\"", i,
-                    RFS_PA(&msg->s),
+                    RFS_PA(info_msg_str(msg)),
                     RFS_PA(&exp_errors[i].s)
                 );
                 return false;
@@ -0,0 +1,285 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Analysis.h>
+#include <llvm-c/Target.h>
+
+#include <rfbase/string/core.h>
+
+#include <ir/rir.h>
+#include <ir/rir_type.h>
+#include <ir/rir_typedef.h>
+
+#include "../../src/backend/llvm_ast.h"
+#include "../../src/backend/llvm_globals.h"
+#include "../../src/backend/llvm_jit.h"
+#include "../../src/backend/llvm_types.h"
+#include "../../src/backend/llvm_utils.h"
+#include "../rir/testsupport_rir.h"
+
+#include CLIB_TEST_HELPERS
+
+static struct llvm_traversal_ctx g_ctx;
+
+/**
+ * Set up a traversal context with a module laid out for the native target,
+ * the way blvm_create_module() does before lowering any type
+ */
+static void setup_llvm_types_tests()
+{
+    setup_rir_tests_no_source();
+    testsupport_rir_add_module();
+    LLVMInitializeNativeTarget();
+
+    RF_STRUCT_ZERO(&g_ctx);
+    g_ctx.llvm_context = LLVMContextCreate();
+    g_ctx.builder = LLVMCreateBuilderInContext(g_ctx.llvm_context);
+    g_ctx.llvm_mod = LLVMModuleCreateWithNameInContext("test_module", g_ctx.llvm_context);
+    ck_assert_msg(bllvm_set_native_target(g_ctx.llvm_mod), "Could not set the native target");
+    g_ctx.target_data = LLVMCreateTargetData(LLVMGetDataLayout(g_ctx.llvm_mod));
+    darray_init(g_ctx.params);
+    darray_init(g_ctx.values);
+    darray_init(g_ctx.valmap);
+    rir_types_map_init(&g_ctx.types_map);
+    strmap_init(&g_ctx.blockmap);
+    ck_assert(bllvm_create_global_functions(&g_ctx));
+}
+
+static void teardown_llvm_types_tests()
+{
+    darray_free(g_ctx.params);
+    darray_free(g_ctx.values);
+    darray_free(g_ctx.valmap);
+    rir_types_map_deinit(&g_ctx.types_map);
+    strmap_clear(&g_ctx.blockmap);
+    LLVMDisposeTargetData(g_ctx.target_data);
+    LLVMDisposeBuilder(g_ctx.builder);
+    // the JIT disposes of the module it runs
+    if (g_ctx.llvm_mod) {
+        LLVMDisposeModule(g_ctx.llvm_mod);
+    }
+    LLVMContextDispose(g_ctx.llvm_context);
+    teardown_rir_tests();
+}
+
+static struct rir_typedef *testsupport_llvm_typedef(const char *name,
+                                                    bool is_union,
+                                                    const char **members,
+                                                    unsigned members_num)
+{
+    unsigned i;
+    struct rir_typedef *def = testsupport_rir_add_typedef(name, is_union);
+    for (i = 0; i < members_num; ++i) {
+        testsupport_rir_typearr(def, members[i]);
+    }
+    return def;
+}
+
+static void testsupport_llvm_add_main()
+{
+    g_ctx.current_function = LLVMAddFunction(
+        g_ctx.llvm_mod,
+        "main",
+        LLVMFunctionType(LLVMInt32TypeInContext(g_ctx.llvm_context), NULL, 0, false)
+    );
+    bllvm_enter_block(
+        &g_ctx,
+        LLVMAppendBasicBlockInContext(g_ctx.llvm_context, g_ctx.current_function, "entry")
+    );
+}
+
+static int testsupport_llvm_run_main()
+{
+    int retcode = -1;
+    char *error = NULL;
+    ck_assert_msg(
+        !LLVMVerifyModule(g_ctx.llvm_mod, LLVMReturnStatusAction, &error),
+        "Invalid LLVM module: %s", error
+    );
+    bllvm_error_dispose(&error);
+    ck_assert_msg(bllvm_jit_run(g_ctx.llvm_mod, &retcode), "Could not run main()");
+    g_ctx.llvm_mod = NULL;
+    return retcode;
+}
+
+static unsigned testsupport_llvm_calls_num(LLVMBasicBlockRef block)
+{
+    LLVMValueRef instr;
+    unsigned num = 0;
+    for (instr = LLVMGetFirstInstruction(block); instr; instr = LLVMGetNextInstruction(instr)) {
+        if (LLVMIsACallInst(instr)) {
+            ++num;
+        }
+    }
+    return num;
+}
+
+START_TEST (test_union_layout_of_elementary_members) {
+    static const char *members[] = {"u8", "u64", "u16"};
+    LLVMTypeRef elems[3];
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(g_ctx.llvm_context);
+    unsigned long long align = LLVMABIAlignmentOfType(g_ctx.target_data, i64);
+    LLVMTypeRef t = bllvm_compile_typedef(
+        testsupport_llvm_typedef("elem_union", true, members, 3),
+        &g_ctx
+    );
+
+    // {i8 selector, i64 payload} since the strictest aligned member is also
+    // the biggest one
+    ck_assert_uint_eq(LLVMCountStructElementTypes(t), 2);
+    LLVMGetStructElementTypes(t, elems);
+    ck_assert_uint_eq(LLVMGetIntTypeWidth(elems[0]), 8);
+    ck_assert(elems[1] == i64);
+    ck_assert_uint_eq(LLVMOffsetOfElement(g_ctx.target_data, t, 1), align);
+    ck_assert_uint_eq(LLVMABISizeOfType(g_ctx.target_data, t), align + 8);
+    ck_assert_uint_eq(LLVMABIAlignmentOfType(g_ctx.target_data, t), align);
+} END_TEST
+
+START_TEST (test_union_layout_pads_payload_to_biggest_member) {
+    static const char *members[] = {"u32"};
+    LLVMTypeRef elems[3];
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(g_ctx.llvm_context);
+    unsigned long long align = LLVMABIAlignmentOfType(g_ctx.target_data, i32);
+    unsigned long long payload_size;
+    struct rir *r = testsupport_rir_curr_module();
+    struct rir_typedef *def = testsupport_llvm_typedef("padded_union", true, members, 1);
+    // a byte array is bigger than the u32 but less strictly aligned
+    darray_append(
+        def->argument_types,
+        rir_type_arr_get_or_create(
+            r,
+            rir_type_elem_get_or_create(r, ELEMENTARY_TYPE_UINT_8, false),
+            10,
+            false
+        )
+    );
+    LLVMTypeRef t = bllvm_compile_typedef(def, &g_ctx);
+
+    // {i8 selector, i32 payload, [6 x i8] padding}
+    ck_assert_uint_eq(LLVMCountStructElementTypes(t), 3);
+    LLVMGetStructElementTypes(t, elems);
+    ck_assert(elems[1] == i32);
+    ck_assert_uint_eq(LLVMGetArrayLength(elems[2]), 6);
+    ck_assert_uint_eq(LLVMOffsetOfElement(g_ctx.target_data, t, 1), align);
+    payload_size = LLVMABISizeOfType(g_ctx.target_data, t) - align;
+    ck_assert_uint_ge(payload_size, 10);
+    ck_assert_uint_lt(payload_size, 10 + align);
+    ck_assert_uint_eq(LLVMABIAlignmentOfType(g_ctx.target_data, t), align);
+} END_TEST
+
+START_TEST (test_union_selector_width) {
+    ck_assert_uint_eq(LLVMGetIntTypeWidth(bllvm_union_selector_type(2, &g_ctx)), 8);
+    ck_assert_uint_eq(LLVMGetIntTypeWidth(bllvm_union_selector_type(256, &g_ctx)), 8);
+    ck_assert_uint_eq(LLVMGetIntTypeWidth(bllvm_union_selector_type(257, &g_ctx)), 16);
+    ck_assert_uint_eq(LLVMGetIntTypeWidth(bllvm_union_selector_type(65536, &g_ctx)), 16);
+    ck_assert_uint_eq(LLVMGetIntTypeWidth(bllvm_union_selector_type(65537, &g_ctx)), 32);
+} END_TEST
+
+START_TEST (test_union_selector_of_many_members) {
+    unsigned i;
+    LLVMTypeRef elems[2];
+    LLVMValueRef u;
+    struct rir_typedef *def = testsupport_rir_add_typedef("big_union", true);
+    for (i = 0; i < 300; ++i) {
+        testsupport_rir_typearr(def, "u8");
+    }
+    LLVMTypeRef t = bllvm_compile_typedef(def, &g_ctx);
+    LLVMGetStructElementTypes(t, elems);
+    ck_assert_uint_eq(LLVMGetIntTypeWidth(elems[0]), 16);
+
+    // an index above 255 must survive being stored and read back
+    testsupport_llvm_add_main();
+    u = LLVMBuildAlloca(g_ctx.builder, t, "");
+    bllvm_union_set_selector(
+        u,
+        LLVMConstInt(LLVMInt32TypeInContext(g_ctx.llvm_context), 299, 0),
+        &g_ctx
+    );
+    LLVMBuildRet(g_ctx.builder, bllvm_union_get_selector(u, &g_ctx));
+    ck_assert_int_eq(testsupport_llvm_run_main(), 299);
+} END_TEST
+
+/**
+ * Copy a {u32, u64...} aggregate with bllvm_memcpy() and return the sum of
+ * the first two members of the copy
+ */
+static LLVMBasicBlockRef testsupport_llvm_copy_aggregate(const char *name,
+                                                         const char **members,
+                                                         unsigned members_num)
+{
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(g_ctx.llvm_context);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(g_ctx.llvm_context);
+    LLVMTypeRef t = bllvm_compile_typedef(
+        testsupport_llvm_typedef(name, false, members, members_num),
+        &g_ctx
+    );
+    LLVMValueRef from;
+    LLVMValueRef to;
+    LLVMValueRef a;
+    LLVMValueRef b;
+
+    testsupport_llvm_add_main();
+    from = LLVMBuildAlloca(g_ctx.builder, t, "");
+    to = LLVMBuildAlloca(g_ctx.builder, t, "");
+    LLVMBuildStore(g_ctx.builder, LLVMConstInt(i32, 7, 0), bllvm_gep_to_struct(from, 0, &g_ctx));
+    LLVMBuildStore(g_ctx.builder, LLVMConstInt(i64, 35, 0), bllvm_gep_to_struct(from, 1, &g_ctx));
+    bllvm_memcpy(from, to, &g_ctx);
+    a = LLVMBuildLoad(g_ctx.builder, bllvm_gep_to_struct(to, 0, &g_ctx), "");
+    b = LLVMBuildLoad(g_ctx.builder, bllvm_gep_to_struct(to, 1, &g_ctx), "");
+    LLVMBuildRet(
+        g_ctx.builder,
+        LLVMBuildAdd(g_ctx.builder, a, LLVMBuildTrunc(g_ctx.builder, b, i32, ""), "")
+    );
+    return g_ctx.current_block;
+}
+
+START_TEST (test_small_aggregate_copy_round_trip) {
+    static const char *members[] = {"u32", "u64"};
+    LLVMBasicBlockRef block = testsupport_llvm_copy_aggregate("small_aggr", members, 2);
+    ck_assert_uint_le(
+        LLVMStoreSizeOfType(g_ctx.target_data, LLVMGetTypeByName(g_ctx.llvm_mod, "small_aggr")),
+        16
+    );
+    // copied with a load and a store instead of a call to memcpy
+    ck_assert_uint_eq(testsupport_llvm_calls_num(block), 0);
+    ck_assert_int_eq(testsupport_llvm_run_main(), 42);
+} END_TEST
+
+START_TEST (test_big_aggregate_copy_round_trip) {
+    static const char *members[] = {"u32", "u64", "u64"};
+    LLVMBasicBlockRef block = testsupport_llvm_copy_aggregate("big_aggr", members, 3);
+    ck_assert_uint_gt(
+        LLVMStoreSizeOfType(g_ctx.target_data, LLVMGetTypeByName(g_ctx.llvm_mod, "big_aggr")),
+        16
+    );
+    ck_assert_uint_eq(testsupport_llvm_calls_num(block), 1);
+    ck_assert_int_eq(testsupport_llvm_run_main(), 42);
+} END_TEST
+
+Suite *backend_llvm_types_suite_create(void)
+{
+    Suite *s = suite_create("backend_llvm_types");
+
+    TCase *tc_unions = tcase_create("backend_llvm_unions");
+    tcase_add_checked_fixture(tc_unions,
+                              setup_llvm_types_tests,
+                              teardown_llvm_types_tests);
+    tcase_add_test(tc_unions, test_union_layout_of_elementary_members);
+    tcase_add_test(tc_unions, test_union_layout_pads_payload_to_biggest_member);
+    tcase_add_test(tc_unions, test_union_selector_width);
+    tcase_add_test(tc_unions, test_union_selector_of_many_members);
+
+    TCase *tc_copies = tcase_create("backend_llvm_aggregate_copies");
+    tcase_add_checked_fixture(tc_copies,
+                              setup_llvm_types_tests,
+                              teardown_llvm_types_tests);
+    tcase_add_test(tc_copies, test_small_aggregate_copy_round_trip);
+    tcase_add_test(tc_copies, test_big_aggregate_copy_round_trip);
+
+    suite_add_tcase(s, tc_unions);
+    suite_add_tcase(s, tc_copies);
+    return s;
+}
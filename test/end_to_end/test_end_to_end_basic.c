@@ -54,6 +54,39 @@ START_TEST (test_negative_integer_constants) {
     ck_end_to_end_run(inputs, 10);
 } END_TEST
 
+START_TEST (test_optimized_locals) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+
+            "fn main()->u32{\n"
+            "a:u32 = 12 * 3\n"
+            "b:u32 = a - 6\n"
+            "a = b / 5\n"
+            "if a >= 6 { return a + b }\n"
+            "return 0\n"
+            "}")
+    };
+    ck_end_to_end_run(inputs, 36);
+} END_TEST
+
+START_TEST (test_unoptimized_locals) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+
+            "fn main()->u32{\n"
+            "a:u32 = 12 * 3\n"
+            "b:u32 = a - 6\n"
+            "a = b / 5\n"
+            "if a >= 6 { return a + b }\n"
+            "return 0\n"
+            "}")
+    };
+    // the same program without the rir passes must give the same result
+    ck_end_to_end_run(inputs, 36, NULL, "--no-rir-opt test_input_file.rf");
+} END_TEST
+
 START_TEST (test_print_string) {
     struct test_input_pair inputs[] = {
         TEST_DECL_SRC(
@@ -872,6 +905,61 @@ START_TEST (test_forexpr_4) {
     ck_end_to_end_run(inputs, 20, &output, "test_input_file.rf");
 } END_TEST
 
+START_TEST (test_jit_run_smoke) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn main()->u32{return 42}")
+    };
+    ck_end_to_end_jit_run(inputs, 42, "--run test_input_file.rf");
+} END_TEST
+
+START_TEST (test_jit_run_function_calls) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn add(a:u32, b:u32) -> u32 {\n"
+            "    return a + b\n"
+            "}\n"
+            "fn main()->u32{\n"
+            "    print(\"jit\")\n"
+            "    return add(12, 22)\n"
+            "}")
+    };
+    ck_end_to_end_jit_run(inputs, 34, "--run test_input_file.rf");
+} END_TEST
+
+START_TEST (test_interpret_smoke) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn main()->u32{return 42}")
+    };
+    ck_end_to_end_jit_run(inputs, 42, "--interpret test_input_file.rf");
+} END_TEST
+
+START_TEST (test_interpret_loops_and_calls) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "type pair {a:u32, b:u32}\n"
+            "fn add(a:u32, b:u32) -> u32 {\n"
+            "    return a + b\n"
+            "}\n"
+            "fn main()->u32{\n"
+            "    arr:u32[4] = [1, 2, 3, 4]\n"
+            "    sum:u32 = 0\n"
+            "    for a in arr {\n"
+            "        sum = sum + a\n"
+            "    }\n"
+            "    print(\"interpreted\")\n"
+            "    p:pair = pair(sum, 24)\n"
+            "    return add(p.a, p.b)\n"
+            "}")
+    };
+    ck_end_to_end_jit_run(inputs, 34, "--interpret test_input_file.rf");
+} END_TEST
+
 Suite *end_to_end_basic_suite_create(void)
 {
     Suite *s = suite_create("end_to_end_basic");
@@ -884,6 +972,8 @@ Suite *end_to_end_basic_suite_create(void)
     tcase_add_test(st_basic, test_addition);
     tcase_add_test(st_basic, test_multiple_real_arithmetic);
     tcase_add_test(st_basic, test_negative_integer_constants);
+    tcase_add_test(st_basic, test_optimized_locals);
+    tcase_add_test(st_basic, test_unoptimized_locals);
 
     TCase *st_print = tcase_create("end_to_end_print");
     tcase_add_checked_fixture(st_print,
@@ -976,6 +1066,15 @@ Suite *end_to_end_basic_suite_create(void)
     tcase_add_test(st_forexpr, test_forexpr_2);
     tcase_add_test(st_forexpr, test_forexpr_3);
 
+    TCase *st_jit = tcase_create("end_to_end_jit");
+    tcase_add_checked_fixture(st_jit,
+                              setup_end_to_end_tests,
+                              teardown_end_to_end_tests);
+    tcase_add_test(st_jit, test_jit_run_smoke);
+    tcase_add_test(st_jit, test_jit_run_function_calls);
+    tcase_add_test(st_jit, test_interpret_smoke);
+    tcase_add_test(st_jit, test_interpret_loops_and_calls);
+
     suite_add_tcase(s, st_basic);
     suite_add_tcase(s, st_print);
     suite_add_tcase(s, st_basic_types);
@@ -987,6 +1086,7 @@ Suite *end_to_end_basic_suite_create(void)
     suite_add_tcase(s, st_match_expr);
     suite_add_tcase(s, st_arrays);
     suite_add_tcase(s, st_forexpr);
+    suite_add_tcase(s, st_jit);
 
     return s;
 }
@@ -0,0 +1,236 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rfbase/string/core.h>
+
+#include "testsupport_end_to_end.h"
+
+#include CLIB_TEST_HELPERS
+
+/**
+ * Compile the inputs, which must already exist as files, and run the
+ * resulting executable
+ */
+#define ck_end_to_end_cached_run(i_inputs_, i_expected_ret_, i_arguments_) \
+    do {                                                                \
+        int actual_ret;                                                 \
+        ck_assert_msg(end_to_end_compile(PASS_SRC_ARR(i_inputs_), i_arguments_), \
+                      "Could not compile the input file/s");            \
+        ck_assert_msg(end_to_end_run(&actual_ret, NULL),                \
+                      "Failed to execute driver's compiled result");    \
+        ck_assert_int_eq(i_expected_ret_, actual_ret);                  \
+    } while (0)
+
+#define ck_assert_cache_stats(i_hits_, i_misses_)                       \
+    do {                                                                \
+        struct compiler_cache *cache_ = &get_end_to_end_driver()->compiler->cache; \
+        ck_assert_msg(cache_->enabled, "The cache should be enabled");  \
+        ck_assert_uint_eq(cache_->hits, i_hits_);                       \
+        ck_assert_uint_eq(cache_->misses, i_misses_);                   \
+    } while (0)
+
+START_TEST (test_cache_miss_then_hit) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn main()->u32{return 42}")
+    };
+    ck_assert(end_to_end_create_files(PASS_SRC_ARR(inputs)));
+    ck_end_to_end_cached_run(inputs, 42, NULL);
+    ck_assert_cache_stats(0, 1);
+
+    ck_assert(end_to_end_restart_compiler());
+    ck_end_to_end_cached_run(inputs, 42, NULL);
+    ck_assert_cache_stats(1, 0);
+} END_TEST
+
+START_TEST (test_cache_invalidated_by_source) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn main()->u32{return 42}")
+    };
+    struct test_input_pair changed_inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn main()->u32{return 24}")
+    };
+    ck_assert(end_to_end_create_files(PASS_SRC_ARR(inputs)));
+    ck_end_to_end_cached_run(inputs, 42, NULL);
+    ck_assert_cache_stats(0, 1);
+
+    ck_assert(end_to_end_restart_compiler());
+    ck_assert(end_to_end_create_files(PASS_SRC_ARR(changed_inputs)));
+    ck_end_to_end_cached_run(changed_inputs, 24, NULL);
+    ck_assert_cache_stats(0, 1);
+} END_TEST
+
+START_TEST (test_cache_invalidated_by_dependency) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "main.rf",
+            "import other\n"
+            "fn main()->u32{return 42}"
+        ),
+        TEST_DECL_SRC(
+            "other.rf",
+            "module other {\n"
+            "}"
+        )
+    };
+    struct test_input_pair changed_inputs[] = {
+        TEST_DECL_SRC(
+            "main.rf",
+            "import other\n"
+            "fn main()->u32{return 42}"
+        ),
+        TEST_DECL_SRC(
+            "other.rf",
+            "module other {\n"
+            "import base\n"
+            "}"
+        ),
+        TEST_DECL_SRC(
+            "base.rf",
+            "module base {\n"
+            "}"
+        )
+    };
+    ck_assert(end_to_end_create_files(PASS_SRC_ARR(inputs)));
+    ck_end_to_end_cached_run(inputs, 42, NULL);
+    ck_assert_cache_stats(0, 1);
+
+    // only the dependency of main changed
+    ck_assert(end_to_end_restart_compiler());
+    ck_assert(end_to_end_create_files(PASS_SRC_ARR(changed_inputs)));
+    ck_end_to_end_cached_run(changed_inputs, 42, NULL);
+    ck_assert_cache_stats(0, 1);
+} END_TEST
+
+START_TEST (test_cache_invalidated_by_arguments) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn main()->u32{return 42}")
+    };
+    uint64_t key;
+    ck_assert(end_to_end_create_files(PASS_SRC_ARR(inputs)));
+    ck_end_to_end_cached_run(inputs, 42, NULL);
+    ck_assert_cache_stats(0, 1);
+    key = get_end_to_end_driver()->compiler->cache.key;
+
+    // an argument that changes the generated code needs a new executable
+    ck_assert(end_to_end_restart_compiler());
+    ck_end_to_end_cached_run(inputs, 42, "--no-rir-opt test_input_file.rf");
+    ck_assert_cache_stats(0, 1);
+    ck_assert_uint_ne(get_end_to_end_driver()->compiler->cache.key, key);
+
+    // one that only changes where the messages go does not
+    ck_assert(end_to_end_restart_compiler());
+    ck_end_to_end_cached_run(inputs, 42, "-v 1 test_input_file.rf");
+    ck_assert_cache_stats(1, 0);
+    ck_assert_uint_eq(get_end_to_end_driver()->compiler->cache.key, key);
+} END_TEST
+
+START_TEST (test_cache_not_used_with_no_cache) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn main()->u32{return 42}")
+    };
+    ck_assert(end_to_end_create_files(PASS_SRC_ARR(inputs)));
+    ck_end_to_end_cached_run(inputs, 42, NULL);
+
+    ck_assert(end_to_end_restart_compiler());
+    ck_end_to_end_cached_run(inputs, 42, "--no-cache test_input_file.rf");
+    ck_assert(!get_end_to_end_driver()->compiler->cache.enabled);
+    ck_assert_uint_eq(get_end_to_end_driver()->compiler->cache.hits, 0);
+} END_TEST
+
+#define ck_assert_cache_stdlib_stats(i_hits_, i_misses_)                \
+    do {                                                                \
+        struct compiler_cache *cache_ = &get_end_to_end_driver()->compiler->cache; \
+        ck_assert_uint_eq(cache_->stdlib_hits, i_hits_);                \
+        ck_assert_uint_eq(cache_->stdlib_misses, i_misses_);            \
+    } while (0)
+
+START_TEST (test_cache_stdlib_miss_then_hit) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn main()->u32{return 42}")
+    };
+    struct test_input_pair other_inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn main()->u32{return 12 + 22}")
+    };
+    ck_assert(end_to_end_create_files(PASS_SRC_ARR(inputs)));
+    ck_end_to_end_cached_run(inputs, 42, NULL);
+    ck_assert_cache_stdlib_stats(0, 1);
+
+    // a different program still reuses the standard library
+    ck_assert(end_to_end_restart_compiler());
+    ck_assert(end_to_end_create_files(PASS_SRC_ARR(other_inputs)));
+    ck_end_to_end_cached_run(other_inputs, 34, NULL);
+    ck_assert_cache_stats(0, 1);
+    ck_assert_cache_stdlib_stats(1, 0);
+
+    // and so does running it in process
+    ck_assert(end_to_end_restart_compiler());
+    ck_end_to_end_jit_run(other_inputs, 34, "--run test_input_file.rf");
+    ck_assert_cache_stdlib_stats(1, 0);
+} END_TEST
+
+START_TEST (test_cache_stdlib_invalidated_by_arguments) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+            "fn main()->u32{return 42}")
+    };
+    uint64_t key;
+    ck_assert(end_to_end_create_files(PASS_SRC_ARR(inputs)));
+    ck_end_to_end_cached_run(inputs, 42, NULL);
+    ck_assert_cache_stdlib_stats(0, 1);
+    key = get_end_to_end_driver()->compiler->cache.stdlib_key;
+
+    ck_assert(end_to_end_restart_compiler());
+    ck_end_to_end_cached_run(inputs, 42, "--no-rir-opt test_input_file.rf");
+    ck_assert_cache_stdlib_stats(0, 1);
+    ck_assert_uint_ne(get_end_to_end_driver()->compiler->cache.stdlib_key, key);
+
+    // the standard library of the first compilation is still there
+    ck_assert(end_to_end_restart_compiler());
+    ck_end_to_end_jit_run(inputs, 42, "--run test_input_file.rf");
+    ck_assert_cache_stdlib_stats(1, 0);
+    ck_assert_uint_eq(get_end_to_end_driver()->compiler->cache.stdlib_key, key);
+} END_TEST
+
+Suite *end_to_end_cache_suite_create(void)
+{
+    Suite *s = suite_create("end_to_end_cache");
+
+    TCase *st_exe = tcase_create("end_to_end_cache_executables");
+    tcase_add_checked_fixture(st_exe,
+                              setup_end_to_end_tests,
+                              teardown_end_to_end_tests);
+    tcase_add_test(st_exe, test_cache_miss_then_hit);
+    tcase_add_test(st_exe, test_cache_invalidated_by_source);
+    tcase_add_test(st_exe, test_cache_invalidated_by_dependency);
+    tcase_add_test(st_exe, test_cache_invalidated_by_arguments);
+    tcase_add_test(st_exe, test_cache_not_used_with_no_cache);
+
+    TCase *st_stdlib = tcase_create("end_to_end_cache_stdlib");
+    tcase_add_checked_fixture(st_stdlib,
+                              setup_end_to_end_tests,
+                              teardown_end_to_end_tests);
+    tcase_add_test(st_stdlib, test_cache_stdlib_miss_then_hit);
+    tcase_add_test(st_stdlib, test_cache_stdlib_invalidated_by_arguments);
+
+    suite_add_tcase(s, st_exe);
+    suite_add_tcase(s, st_stdlib);
+
+    return s;
+}
@@ -1,5 +1,10 @@
 #include "testsupport_end_to_end.h"
 
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
 #include <check.h>
 #include CLIB_TEST_HELPERS
 
@@ -18,25 +23,70 @@ struct end_to_end_driver *get_end_to_end_driver()
     return &_driver;
 }
 
+/**
+ * Remove a directory created by the tests along with all the files and
+ * directories under it
+ */
+static void end_to_end_remove_dir(const char *name)
+{
+    char path[256];
+    struct dirent *entry;
+    DIR *dir = opendir(name);
+    if (!dir) {
+        return;
+    }
+    while ((entry = readdir(dir))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", name, entry->d_name);
+        if (remove(path) != 0) {
+            end_to_end_remove_dir(path);
+        }
+    }
+    closedir(dir);
+    rmdir(name);
+}
+
 void setup_end_to_end_tests()
 {
     RF_STRUCT_ZERO(&_driver);
+    // each test gets its own empty compilation cache
+    strcpy(_driver.cache_home, "/tmp/refu_test_cache_XXXXXX");
+    ck_assert_msg(mkdtemp(_driver.cache_home), "failed to create a cache directory");
+    setenv("XDG_CACHE_HOME", _driver.cache_home, 1);
     // initialize the compiler instance here (since we need rf_init())
     _driver.compiler = compiler_create(LOG_TARGET_STDOUT, true);
     ck_assert_msg(_driver.compiler, "failed to create the compiler instance");
 }
 
-void teardown_end_to_end_tests()
+static void end_to_end_driver_delete_files(struct end_to_end_driver *d)
 {
-    if (_driver.file_names) {
-        unsigned i;
-        for (i = 0; i < _driver.files_num; ++i) {
-            rf_system_delete_file(&_driver.file_names[i]);
-            rf_string_deinit(&_driver.file_names[i]);
-        }
-        free(_driver.file_names);
+    unsigned i;
+    if (!d->file_names) {
+        return;
+    }
+    for (i = 0; i < d->files_num; ++i) {
+        rf_system_delete_file(&d->file_names[i]);
+        rf_string_deinit(&d->file_names[i]);
     }
+    free(d->file_names);
+    d->file_names = NULL;
+    d->files_num = 0;
+}
+
+void teardown_end_to_end_tests()
+{
+    end_to_end_driver_delete_files(&_driver);
     compiler_destroy(_driver.compiler);
+    end_to_end_remove_dir(_driver.cache_home);
+}
+
+bool end_to_end_driver_restart_compiler(struct end_to_end_driver *d)
+{
+    compiler_destroy(d->compiler);
+    d->compiler = compiler_create(LOG_TARGET_STDOUT, true);
+    return d->compiler != NULL;
 }
 
 bool end_to_end_driver_create_files(struct end_to_end_driver *d,
@@ -45,6 +95,8 @@ bool end_to_end_driver_create_files(struct end_to_end_driver *d,
 {
     FILE *f;
     unsigned i;
+    // a test can replace its input files between compilations
+    end_to_end_driver_delete_files(d);
     d->files_num = num;
 
     // create file names
@@ -52,6 +104,7 @@ bool end_to_end_driver_create_files(struct end_to_end_driver *d,
     for (i = 0; i < num; ++i) {
         if (!rf_string_copy_in(&d->file_names[i], &inputs[i].filename)) {
             free(d->file_names);
+            d->file_names = NULL;
             return false;
         }
     }
@@ -209,6 +262,7 @@ bool end_to_end_driver_run(
     return true;
 }
 
+i_INLINE_INS bool end_to_end_restart_compiler();
 i_INLINE_INS bool end_to_end_create_files(struct test_input_pair *inputs, unsigned num);
 i_INLINE_INS bool end_to_end_compile(const struct test_input_pair *inputs,
                                      unsigned inputsn,
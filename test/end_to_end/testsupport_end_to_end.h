@@ -14,6 +14,8 @@ struct end_to_end_driver {
     struct compiler *compiler;
     struct RFstring *file_names;
     unsigned files_num;
+    //! Temporary $XDG_CACHE_HOME so tests never touch the user's cache
+    char cache_home[32];
 };
 
 struct end_to_end_driver *get_end_to_end_driver();
@@ -21,6 +23,16 @@ struct end_to_end_driver *get_end_to_end_driver();
 void setup_end_to_end_tests();
 void teardown_end_to_end_tests();
 
+/**
+ * Destroy the compiler instance and create a new one, as if the compiler
+ * was invoked again. The input files and the cache are kept.
+ */
+bool end_to_end_driver_restart_compiler(struct end_to_end_driver *d);
+i_INLINE_DECL bool end_to_end_restart_compiler()
+{
+    return end_to_end_driver_restart_compiler(get_end_to_end_driver());
+}
+
 bool end_to_end_driver_create_files(struct end_to_end_driver *d,
                                     struct test_input_pair *inputs,
                                     unsigned num);
@@ -96,4 +108,26 @@ i_INLINE_DECL bool end_to_end_run(int *ret_value,
 #define ck_end_to_end_run(...)                                      \
     RF_SELECT_FUNC_IF_NARGGT(i_ck_end_to_end_run_with_stdout, 2, __VA_ARGS__)
 
+/**
+ * Runs an end to end test for the given input files in process, using the
+ * compiler's --run JIT mode or its --interpret mode instead of creating and
+ * executing a binary
+ *
+ * @param i_inputs_              Array of filename/content pair for sources
+ * @param i_expected_ret_        The program's expected return value
+ * @param i_arguments_           The arguments to provide to the compiler as a
+ *                               cstring. Must contain --run or --interpret.
+ */
+#define ck_end_to_end_jit_run(i_inputs_, i_expected_ret_, i_arguments_) \
+    do {                                                                \
+        int actual_ret;                                                 \
+        ck_assert_msg(end_to_end_create_files(PASS_SRC_ARR(i_inputs_)), \
+                      "Could not create input file/s");                 \
+        ck_assert_msg(end_to_end_compile(PASS_SRC_ARR(i_inputs_), i_arguments_), \
+                      "Could not run the input file/s in process");   \
+        actual_ret = get_end_to_end_driver()->compiler->run_retcode;    \
+        ck_assert_msg(i_expected_ret_ == actual_ret, "Program return values do not match." \
+                      "Expected %u but got %u", i_expected_ret_, actual_ret); \
+    }while (0)
+
 #endif
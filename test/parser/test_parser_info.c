@@ -0,0 +1,191 @@
+/**
+ * Tests for the messages the parser and the analyzer keep in an info context,
+ * their deferred formatting and the rolling back of speculative parsing
+ */
+#include <check.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <rfbase/string/core.h>
+
+#include <info/arena.h>
+#include <info/info.h>
+#include <info/msg.h>
+
+#include "../testsupport.h"
+
+#include CLIB_TEST_HELPERS
+
+static struct info_msg *test_info_last_msg(struct info_ctx *ctx)
+{
+    struct info_msg *m = rf_ilist_tail(&ctx->msg_list, struct info_msg, ln);
+    ck_assert(m);
+    return m;
+}
+
+START_TEST (test_info_msg_temporary_string_args) {
+    struct info_ctx *ctx = info_ctx_create(NULL);
+    struct info_msg *m;
+    struct RFstring *tmp;
+    ck_assert(ctx);
+    RFS_PUSH();
+    ck_assert((tmp = RFS("type_%d", 42)));
+    ck_assert(i_info_ctx_add_msg(ctx, MESSAGE_SEMANTIC_ERROR, NULL, NULL,
+                                 "unknown type \""RFS_PF"\"", RFS_PA(tmp)));
+    RFS_POP();
+    // overwrite the temporary buffer the argument was in
+    RFS_PUSH();
+    ck_assert(RFS("xxxx_%d", 99));
+    RFS_POP();
+
+    m = test_info_last_msg(ctx);
+    ck_assert_msg(!m->formatted, "The message should not be formatted yet");
+    ck_assert_rf_str_eq_cstr(info_msg_str(m), "unknown type \"type_42\"");
+    info_ctx_destroy(ctx);
+} END_TEST
+
+// the arguments given to the message and to snprintf() for the expected text
+#define TEST_INFO_CONV_FMT                                              \
+    "[%*d] [%*d] [%-*.*s] [%.*s] 100%% [%c] [%.*f] [%5.2s] [%lu] [%hhd]"
+#define TEST_INFO_CONV_ARGS                                     \
+    6, 42, -6, 42, 8, 3, "abcdef", -1, "whole", 'z', 2, 3.14159, \
+        "xyz", 123456789UL, 300
+
+START_TEST (test_info_msg_format_conversions) {
+    struct info_ctx *ctx = info_ctx_create(NULL);
+    struct info_msg *m;
+    char expected[128];
+    ck_assert(ctx);
+    ck_assert(i_info_ctx_add_msg(ctx, MESSAGE_SYNTAX_WARNING, NULL, NULL,
+                                 TEST_INFO_CONV_FMT, TEST_INFO_CONV_ARGS));
+    snprintf(expected, sizeof(expected), TEST_INFO_CONV_FMT, TEST_INFO_CONV_ARGS);
+
+    m = test_info_last_msg(ctx);
+    ck_assert(!m->formatted);
+    ck_assert_rf_str_eq_cstr(info_msg_str(m), expected);
+    ck_assert(m->formatted);
+    info_ctx_destroy(ctx);
+} END_TEST
+
+START_TEST (test_info_msg_eager_fallback) {
+    struct info_ctx *ctx = info_ctx_create(NULL);
+    struct info_ctx *plain = info_ctx_create(NULL);
+    struct info_msg *m;
+    ck_assert(ctx);
+    ck_assert(plain);
+    // wide strings can't be kept for later so the message is formatted now
+    ck_assert(i_info_ctx_add_msg(ctx, MESSAGE_SEMANTIC_ERROR, NULL, NULL,
+                                 "%ls and %d", L"wide", 3));
+    m = test_info_last_msg(ctx);
+    ck_assert_msg(m->formatted, "The message should have been formatted eagerly");
+    ck_assert_rf_str_eq_cstr(info_msg_str(m), "wide and 3");
+
+    // the arguments captured before giving up are given back to the arena,
+    // leaving it as if a message without arguments had been added
+    ck_assert(i_info_ctx_add_msg(plain, MESSAGE_SEMANTIC_ERROR, NULL, NULL, "plain"));
+    ck_assert_uint_eq(ctx->arena.curr, plain->arena.curr);
+    ck_assert_uint_eq(ctx->arena.used, plain->arena.used);
+    info_ctx_destroy(plain);
+    info_ctx_destroy(ctx);
+} END_TEST
+
+START_TEST (test_info_ctx_nested_rollback) {
+    struct info_ctx *ctx = info_ctx_create(NULL);
+    struct info_arena_mark mark;
+    // does not fit in the chunk of the smaller messages
+    char big[INFO_ARENA_CHUNK_SIZE + 1];
+    unsigned int chunks;
+    ck_assert(ctx);
+    memset(big, 'a', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+
+    ck_assert(i_info_ctx_add_msg(ctx, MESSAGE_SEMANTIC_ERROR, NULL, NULL, "first"));
+    info_ctx_push(ctx);
+    ck_assert(i_info_ctx_add_msg(ctx, MESSAGE_SYNTAX_WARNING, NULL, NULL, "outer %d", 1));
+    info_ctx_push(ctx);
+    info_arena_get_mark(&ctx->arena, &mark);
+    ck_assert(i_info_ctx_add_msg(ctx, MESSAGE_SYNTAX_ERROR, NULL, NULL, "inner %s", big));
+    chunks = darray_size(ctx->arena.chunks);
+    ck_assert_uint_gt(chunks, mark.chunk + 1);
+    ck_assert_uint_eq(ctx->msg_num, 3);
+    ck_assert(info_ctx_has(ctx, MESSAGE_SYNTAX_ERROR));
+
+    info_ctx_rollback(ctx);
+    ck_assert_uint_eq(ctx->msg_num, 2);
+    ck_assert_uint_eq(ctx->type_counts[info_msg_type_index(MESSAGE_SYNTAX_ERROR)], 0);
+    ck_assert_uint_eq(ctx->type_counts[info_msg_type_index(MESSAGE_SYNTAX_WARNING)], 1);
+    ck_assert_uint_eq(ctx->type_counts[info_msg_type_index(MESSAGE_SEMANTIC_ERROR)], 1);
+    ck_assert(!info_ctx_has(ctx, MESSAGE_SYNTAX_ERROR));
+    ck_assert_uint_eq(ctx->arena.curr, mark.chunk);
+    ck_assert_uint_eq(ctx->arena.used, mark.used);
+
+    // the chunk of the rolled back message gets reused
+    info_ctx_push(ctx);
+    ck_assert(i_info_ctx_add_msg(ctx, MESSAGE_SYNTAX_ERROR, NULL, NULL, "again %s", big));
+    ck_assert_uint_eq(darray_size(ctx->arena.chunks), chunks);
+    info_ctx_rollback(ctx);
+
+    // popping keeps what was added since the outer push
+    info_ctx_pop(ctx);
+    ck_assert(darray_empty(ctx->last_msgs_arr));
+    ck_assert_uint_eq(ctx->msg_num, 2);
+    ck_assert(info_ctx_has(ctx, MESSAGE_SYNTAX_WARNING));
+    ck_assert(info_ctx_has(ctx, MESSAGE_SEMANTIC_ERROR));
+    ck_assert_rf_str_eq_cstr(info_msg_str(test_info_last_msg(ctx)), "outer 1");
+    info_ctx_destroy(ctx);
+} END_TEST
+
+START_TEST (test_info_ctx_has_after_removal) {
+    struct info_ctx *ctx = info_ctx_create(NULL);
+    FILE *f = tmpfile();
+    unsigned int i;
+    ck_assert(ctx);
+    ck_assert(f);
+    ck_assert(i_info_ctx_add_msg(ctx, MESSAGE_SEMANTIC_WARNING, NULL, NULL, "warning"));
+    ck_assert(i_info_ctx_add_msg(ctx, MESSAGE_SYNTAX_ERROR, NULL, NULL, "error %d", 1));
+    ck_assert(info_ctx_has(ctx, MESSAGE_SEMANTIC_WARNING | MESSAGE_SYNTAX_ERROR));
+
+    info_ctx_rem_messages(ctx, 1);
+    ck_assert(!info_ctx_has(ctx, MESSAGE_SYNTAX_ERROR));
+    ck_assert(!info_ctx_has(ctx, MESSAGE_SEMANTIC_ERROR | MESSAGE_SYNTAX_ERROR));
+    ck_assert(info_ctx_has(ctx, MESSAGE_SEMANTIC_WARNING));
+    ck_assert(info_ctx_has(ctx, MESSAGE_ANY));
+
+    ck_assert(i_info_ctx_add_msg(ctx, MESSAGE_SEMANTIC_ERROR, NULL, NULL, "error %d", 2));
+    info_ctx_flush(ctx, f, MESSAGE_ANY);
+    ck_assert_uint_eq(ctx->msg_num, 0);
+    for (i = 0; i < INFO_MESSAGE_TYPES_NUM; ++i) {
+        ck_assert_uint_eq(ctx->type_counts[i], 0);
+    }
+    ck_assert(!info_ctx_has(ctx, MESSAGE_ANY));
+    ck_assert(!info_ctx_has(ctx, MESSAGE_SEMANTIC_WARNING));
+    ck_assert(!info_ctx_has(ctx, MESSAGE_SEMANTIC_ERROR));
+    fclose(f);
+    info_ctx_destroy(ctx);
+} END_TEST
+
+Suite *parser_info_suite_create(void)
+{
+    Suite *s = suite_create("parser_info");
+
+    TCase *tc1 = tcase_create("parser_info_msg_format");
+    tcase_add_checked_fixture(tc1,
+                              setup_base_tests,
+                              teardown_base_tests);
+    tcase_add_test(tc1, test_info_msg_temporary_string_args);
+    tcase_add_test(tc1, test_info_msg_format_conversions);
+    tcase_add_test(tc1, test_info_msg_eager_fallback);
+
+    TCase *tc2 = tcase_create("parser_info_ctx_state");
+    tcase_add_checked_fixture(tc2,
+                              setup_base_tests,
+                              teardown_base_tests);
+    tcase_add_test(tc2, test_info_ctx_nested_rollback);
+    tcase_add_test(tc2, test_info_ctx_has_after_removal);
+
+    suite_add_tcase(s, tc1);
+    suite_add_tcase(s, tc2);
+
+    return s;
+}
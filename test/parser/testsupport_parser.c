@@ -41,17 +41,17 @@ bool ck_assert_parser_errors_impl(struct info_ctx *info,
                 filename, line,
                 "For parser error number %u: Got:\n\""RFS_PF"\"\n"
                 "but expected no error.", i,
-                RFS_PA(&msg->s)
+                RFS_PA(info_msg_str(msg))
             );
             return false;
         }
         // check for error message string
-        if (!rf_string_equal(&msg->s, &exp_errors[i].s)) {
+        if (!rf_string_equal(info_msg_str(msg), &exp_errors[i].s)) {
             ck_parser_check_abort(
                 filename, line,
                 "For parser error number %u: Got:\n\""RFS_PF"\"\n"
                 "but expected:\n\""RFS_PF"\"", i,
-                RFS_PA(&msg->s),
+                RFS_PA(info_msg_str(msg)),
                 RFS_PA(&exp_errors[i].s)
             );
             return false;
@@ -1,13 +1,31 @@
 #include <check.h>
+#include <dirent.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include <rfbase/string/core.h>
+#include <rfbase/string/corex.h>
 #include <ast/ast.h>
 #include <ast/function.h>
+#include <compiler.h>
+#include <compiler_args.h>
+#include <module.h>
+#include <ir/rir.h>
+#include <ir/rir_block.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ownership/ownership.h>
+#include "../../src/ownership/ow_ctx.h"
+#include "../../src/ownership/ow_dot.h"
+#include "../../src/ownership/ow_graph.h"
+#include "../../src/ownership/ow_summary.h"
 
 #include "testsupport_rir.h"
+#include "../testsupport.h"
 
 #include CLIB_TEST_HELPERS
 
@@ -30,6 +48,516 @@ START_TEST (test_usage_1) {
     ck_assert_createrir_ok();
 } END_TEST
 
+static unsigned test_callgraph_pos(const struct ow_callgraph_order *o, const char *name)
+{
+    unsigned i;
+    bool found;
+    for (i = 0; i < darray_size(o->fns); ++i) {
+        RFS_PUSH();
+        found = rf_string_equal(&darray_item(o->fns, i)->decl.name, RFS("%s", name));
+        RFS_POP();
+        if (found) {
+            return i;
+        }
+    }
+    ck_abort_msg("Function %s not found in the call graph order", name);
+    return 0;
+}
+
+static unsigned test_callgraph_scc(const struct ow_callgraph_order *o, unsigned pos)
+{
+    unsigned i;
+    for (i = 0; i < darray_size(o->scc_ends); ++i) {
+        if (pos < darray_item(o->scc_ends, i)) {
+            return i;
+        }
+    }
+    ck_abort_msg("Position %u is in no component", pos);
+    return 0;
+}
+
+START_TEST (test_ownership_callgraph_order) {
+    static const struct RFstring s = RF_STRING_STATIC_INIT(
+        "fn leaf(a:u32) -> u32 {\n"
+        "    return a + 1\n"
+        "}\n"
+        "fn even(a:u32) -> u32 {\n"
+        "    r:u32 = 1\n"
+        "    if a > 0 {\n"
+        "        r = odd(a - 1)\n"
+        "    }\n"
+        "    return r\n"
+        "}\n"
+        "fn odd(a:u32) -> u32 {\n"
+        "    r:u32 = 0\n"
+        "    if a > 0 {\n"
+        "        r = even(a - 1)\n"
+        "    }\n"
+        "    return r\n"
+        "}\n"
+        "fn main() -> u32 {\n"
+        "    return even(leaf(3))\n"
+        "}\n"
+    );
+    struct rir *r;
+    struct ow_callgraph_order o;
+    front_testdriver_new_ast_main_source(&s);
+    ck_create_get_rir(r, 0);
+    ck_assert(ow_callgraph_order_init(&o, r));
+
+    ck_assert_uint_eq(darray_size(o.fns), 4);
+    ck_assert_uint_eq(darray_size(o.scc_ends), 3);
+    // callees come first and the two recursive functions form one component
+    ck_assert_uint_lt(test_callgraph_pos(&o, "leaf"), test_callgraph_pos(&o, "main"));
+    ck_assert_uint_lt(test_callgraph_pos(&o, "even"), test_callgraph_pos(&o, "main"));
+    ck_assert_uint_eq(
+        test_callgraph_scc(&o, test_callgraph_pos(&o, "even")),
+        test_callgraph_scc(&o, test_callgraph_pos(&o, "odd"))
+    );
+    ck_assert_uint_ne(
+        test_callgraph_scc(&o, test_callgraph_pos(&o, "even")),
+        test_callgraph_scc(&o, test_callgraph_pos(&o, "main"))
+    );
+    // leaf and the recursive pair don't call each other so they can be
+    // analyzed at the same time, before main
+    ck_assert_uint_eq(darray_size(o.scc_levels), 3);
+    ck_assert_uint_eq(
+        darray_item(o.scc_levels, test_callgraph_scc(&o, test_callgraph_pos(&o, "leaf"))), 0
+    );
+    ck_assert_uint_eq(
+        darray_item(o.scc_levels, test_callgraph_scc(&o, test_callgraph_pos(&o, "even"))), 0
+    );
+    ck_assert_uint_eq(
+        darray_item(o.scc_levels, test_callgraph_scc(&o, test_callgraph_pos(&o, "main"))), 1
+    );
+    ow_callgraph_order_deinit(&o);
+} END_TEST
+
+/**
+ * Analyze the modules of the compiler up to and including the one of @a r,
+ * leaving the graphs of @a r in the ownership context. Needs ow_ctx_end().
+ */
+static void test_ownership_analyze(const struct rir *r)
+{
+    struct module **mod;
+    ow_ctx_begin(compiler_args_rir_jobs(compiler_instance_get()->args));
+    darray_foreach(mod, compiler_instance_get()->modules) {
+        if (module_rir_codepath(*mod) == RIRPOS_AST) {
+            ck_assert_msg(ow_ctx_module_pass((*mod)->rir), "Ownership analysis failed");
+        }
+        if ((*mod)->rir == r) {
+            return;
+        }
+    }
+    ck_abort_msg("The module to analyze was not found");
+}
+
+/**
+ * @return The graph of the analyzed module for variable @a name of
+ *         function @a fn
+ */
+static struct ow_graph *test_ownership_graph(const char *fn, const char *name)
+{
+    struct ow_graph **graphs;
+    unsigned int num;
+    unsigned int i;
+    bool found;
+    graphs = ow_ctx_graphs(&num);
+    for (i = 0; i < num; ++i) {
+        RFS_PUSH();
+        found = rf_string_equal(graphs[i]->fn_name, RFS("%s", fn)) &&
+            rf_string_equal(graphs[i]->rec->id, RFS("%s", name));
+        RFS_POP();
+        if (found) {
+            return graphs[i];
+        }
+    }
+    ck_abort_msg("No ownership graph for \"%s\" of %s()", name, fn);
+    return NULL;
+}
+
+static struct rir_fndef *test_ownership_fndef(const struct rir *r, const char *name)
+{
+    struct rir_fndecl *decl;
+    bool found;
+    rf_ilist_for_each(&r->functions, decl, ln) {
+        RFS_PUSH();
+        found = !decl->plain_decl && rf_string_equal(&decl->name, RFS("%s", name));
+        RFS_POP();
+        if (found) {
+            return rir_fndecl_to_fndef(decl);
+        }
+    }
+    ck_abort_msg("Function %s not found in the RIR", name);
+    return NULL;
+}
+
+/**
+ * @return The value of the first expression of type @a type in @a fn
+ */
+static const struct rir_value *test_ownership_expr_val(const struct rir_fndef *fn,
+                                                       enum rir_expression_type type)
+{
+    struct rir_block **b;
+    struct rir_expression *e;
+    darray_foreach(b, fn->blocks) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            if (e->type == type) {
+                return &e->val;
+            }
+        }
+    }
+    ck_abort_msg("No expression of the requested type was found");
+    return NULL;
+}
+
+START_TEST (test_ownership_value_in_many_graphs) {
+    static const struct RFstring s = RF_STRING_STATIC_INIT(
+        "fn pick(a:u32, b:u32) -> u32 {\n"
+        "    return a + b\n"
+        "}\n"
+        "fn main() -> u32 {\n"
+        "    return pick(1, 2)\n"
+        "}\n"
+    );
+    struct rir *r;
+    struct ow_graph *ga;
+    struct ow_graph *gb;
+    const struct rir_value *sum;
+    front_testdriver_new_ast_main_source(&s);
+    ck_create_get_rir(r, 0);
+    test_ownership_analyze(r);
+
+    ga = test_ownership_graph("pick", "a");
+    gb = test_ownership_graph("pick", "b");
+    ck_assert_uint_lt(ga->idx, gb->idx);
+    // the sum depends on both arguments so it's in the graphs of both
+    sum = test_ownership_expr_val(test_ownership_fndef(r, "pick"), RIR_EXPRESSION_ADD);
+    ck_assert(ownode_objset_has_value(&ga->set, ga->fn_name, sum));
+    ck_assert(ownode_objset_has_value(&gb->set, gb->fn_name, sum));
+    // but later uses of it only follow the graph that was created first
+    ck_assert(ow_graph_has_attr(ga, OW_ATTR_RETURNED));
+    ck_assert(!ow_graph_has_attr(gb, OW_ATTR_RETURNED));
+    ow_ctx_end();
+} END_TEST
+
+START_TEST (test_ownership_passed_as_later_argument) {
+    static const struct RFstring s = RF_STRING_STATIC_INIT(
+        "type person {name:string, age:u32}\n"
+        "fn age_plus(n:u32, p:person) -> u32 {\n"
+        "    return p.age + n\n"
+        "}\n"
+        "fn main() -> u32 {\n"
+        "    p:person = person(\"Lef\", 29)\n"
+        "    return age_plus(1, p)\n"
+        "}\n"
+    );
+    struct rir *r;
+    struct ow_graph *g;
+    struct ow_graph *param;
+    struct ow_passed_loc **ploc;
+    bool found = false;
+    front_testdriver_new_ast_main_source(&s);
+    ck_create_get_rir(r, 0);
+    test_ownership_analyze(r);
+
+    g = test_ownership_graph("main", "p");
+    param = test_ownership_graph("age_plus", "p");
+    ck_assert(ow_graph_has_attr(g, OW_ATTR_PASSED));
+    // the value goes to the graph of the second parameter, not the first
+    darray_foreach(ploc, g->passed_locations) {
+        RFS_PUSH();
+        if (rf_string_equal(&(*ploc)->call->name, RFS("age_plus"))) {
+            ck_assert_uint_eq((*ploc)->idx, 1);
+            ck_assert((*ploc)->node == param->root);
+            ck_assert((*ploc)->node != test_ownership_graph("age_plus", "n")->root);
+            found = true;
+        }
+        RFS_POP();
+    }
+    ck_assert_msg(found, "The call to age_plus() is not a passed location of the value");
+    ow_ctx_end();
+} END_TEST
+
+START_TEST (test_ownership_alloc_location) {
+    static const struct RFstring s = RF_STRING_STATIC_INIT(
+        "type pair {a:u32, b:u32}\n"
+        "fn keep(n:u32, p:pair) -> u32 {\n"
+        "    r:u32 = 0\n"
+        "    if n > 0 {\n"
+        "        r = keep(n - 1, p)\n"
+        "    }\n"
+        "    return r\n"
+        "}\n"
+        "fn make(a:u32) -> pair {\n"
+        "    made:pair = pair(a, 2)\n"
+        "    return made\n"
+        "}\n"
+        "fn escape() -> u32 {\n"
+        "    kept:pair = pair(1, 2)\n"
+        "    return keep(3, kept)\n"
+        "}\n"
+        "fn stays() -> u32 {\n"
+        "    unused:pair = pair(3, 4)\n"
+        "    return 0\n"
+        "}\n"
+        "fn main() -> u32 {\n"
+        "    return escape() + stays()\n"
+        "}\n"
+    );
+    struct rir *r;
+    struct ow_graph *g;
+    front_testdriver_new_ast_main_source(&s);
+    ck_create_get_rir(r, 0);
+    test_ownership_analyze(r);
+
+    // returned so it outlives the function
+    g = test_ownership_graph("make", "made");
+    ck_assert(ow_graph_has_attr(g, OW_ATTR_RETURNED));
+    ck_assert_int_eq(g->obj->expr.alloca.alloc_location, RIR_ALLOC_HEAP);
+    // the recursive call may keep its argument since it has no summary yet
+    g = test_ownership_graph("escape", "kept");
+    ck_assert(ow_graph_has_attr(g, OW_ATTR_ESCAPED));
+    ck_assert_int_eq(g->obj->expr.alloca.alloc_location, RIR_ALLOC_HEAP);
+    // neither returned nor escaping
+    g = test_ownership_graph("stays", "unused");
+    ck_assert(!ow_graph_has_attr(g, OW_ATTR_RETURNED));
+    ck_assert(!ow_graph_has_attr(g, OW_ATTR_ESCAPED));
+    ck_assert_int_eq(g->obj->expr.alloca.alloc_location, RIR_ALLOC_STACK);
+    ow_ctx_end();
+} END_TEST
+
+START_TEST (test_ownership_parallel_modules) {
+    static const struct RFstring helpers = RF_STRING_STATIC_INIT(
+        "module helpers {\n"
+        "fn twice(a:u32) -> u32 {\n"
+        "    return a * 2\n"
+        "}\n"
+        "fn thrice(a:u32) -> u32 {\n"
+        "    return a * 3\n"
+        "}\n"
+        "}\n"
+    );
+    static const struct RFstring s = RF_STRING_STATIC_INIT(
+        "import helpers\n"
+        "type person {name:string, age:u32}\n"
+        "fn older(p:person) -> u32 {\n"
+        "    return twice(p.age)\n"
+        "}\n"
+        "fn younger(p:person) -> u32 {\n"
+        "    return thrice(p.age)\n"
+        "}\n"
+        "fn main() -> u32 {\n"
+        "    p:person = person(\"Lef\", 29)\n"
+        "    print(p.name)\n"
+        "    return older(p) + younger(p)\n"
+        "}\n"
+    );
+    struct rir *r;
+    struct ow_graph **graphs;
+    unsigned int num;
+    unsigned int i;
+    front_testdriver_new_ast_source(&helpers, false);
+    front_testdriver_new_ast_main_source(&s);
+    compiler_instance_get()->args->rir_jobs->ival[0] = 4;
+    ck_assert_createrir_ok();
+    r = front_testdriver_module()->rir;
+
+    // every module is analyzed by several threads and their pools are
+    // freed before the next module
+    ck_assert(ownership_pass(compiler_instance_get()));
+
+    // the graphs of the last module, merged from the contexts of the
+    // threads, stay until the end of the analysis
+    test_ownership_analyze(r);
+    graphs = ow_ctx_graphs(&num);
+    for (i = 0; i < num; ++i) {
+        ck_assert_uint_eq(graphs[i]->idx, i);
+    }
+    ck_assert(ow_graph_has_attr(test_ownership_graph("main", "p"), OW_ATTR_PASSED));
+    ck_assert(test_ownership_graph("older", "p"));
+    ck_assert(test_ownership_graph("younger", "p"));
+    ow_ctx_end();
+} END_TEST
+
+static const struct RFstring s_dot = RF_STRING_STATIC_INIT(
+    "type person {name:string, age:u32}\n"
+    "fn age(p:person) -> u32 {\n"
+    "    return p.age\n"
+    "}\n"
+    "fn main() -> u32 {\n"
+    "    p:person = person(\"Lef\", 29)\n"
+    "    return age(p)\n"
+    "}\n"
+);
+
+/**
+ * @return The contents of the file at @a path. Free them with free().
+ */
+static char *test_ownership_read_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    char *ret;
+    long size;
+    ck_assert_msg(f, "Could not open \"%s\"", path);
+    ck_assert(fseek(f, 0, SEEK_END) == 0);
+    size = ftell(f);
+    ck_assert(size >= 0);
+    rewind(f);
+    ret = malloc(size + 1);
+    ck_assert(ret);
+    ck_assert_uint_eq(fread(ret, 1, size, f), size);
+    ret[size] = '\0';
+    fclose(f);
+    return ret;
+}
+
+static unsigned test_ownership_count_str(const char *s, const char *sub)
+{
+    unsigned n = 0;
+    while ((s = strstr(s, sub))) {
+        ++n;
+        s += strlen(sub);
+    }
+    return n;
+}
+
+/**
+ * Check that @a dot has the graphs of the functions of s_dot, all in one
+ * graph named after the module
+ */
+static void test_ownership_check_dot(const char *dot, const struct rir *r)
+{
+    RFS_PUSH();
+    ck_assert_uint_eq(test_ownership_count_str(dot, "digraph "), 1);
+    ck_assert(strstr(
+        dot,
+        rf_string_data(RFS_NT_OR_DIE("digraph \""RFS_PF"\" {\n", RFS_PA(&r->name)))
+    ) == dot);
+    RFS_POP();
+    ck_assert_uint_eq(test_ownership_count_str(dot, "subgraph \"cluster_age\""), 1);
+    ck_assert_uint_eq(test_ownership_count_str(dot, "subgraph \"cluster_main\""), 1);
+    ck_assert_uint_ne(test_ownership_count_str(dot, " -> "), 0);
+}
+
+START_TEST (test_ownership_dot_write) {
+    struct rir *r;
+    struct RFstringx dot;
+    struct ow_graph **graphs;
+    unsigned int num;
+    char path[] = "/tmp/refu_test_ownership_XXXXXX";
+    char *contents;
+    int fd;
+    front_testdriver_new_ast_main_source(&s_dot);
+    ck_create_get_rir(r, 0);
+    test_ownership_analyze(r);
+    graphs = ow_ctx_graphs(&num);
+    ck_assert_uint_ne(num, 0);
+
+    ck_assert(rf_stringx_init_buff(&dot, 1024, ""));
+    ck_assert(ow_graphs_to_dot(&dot, &r->name, graphs, num));
+    fd = mkstemp(path);
+    ck_assert(fd != -1);
+    close(fd);
+    RFS_PUSH();
+    ck_assert(ow_dot_write(RF_STRX2STR(&dot), RFS("%s", path)));
+    RFS_POP();
+    contents = test_ownership_read_file(path);
+    unlink(path);
+    // the file holds exactly the DOT text
+    ck_assert_uint_eq(strlen(contents), rf_string_length_bytes(RF_STRX2STR(&dot)));
+    ck_assert(memcmp(contents, rf_string_data(RF_STRX2STR(&dot)), strlen(contents)) == 0);
+    test_ownership_check_dot(contents, r);
+    free(contents);
+    rf_stringx_deinit(&dot);
+    ow_ctx_end();
+} END_TEST
+
+#if RF_OPTION_OWNERSHIP_DOT
+/**
+ * @return The number of ownership DOT files in the working directory. If
+ *         @a remove is true they also get removed.
+ */
+static unsigned test_ownership_dot_files(bool remove)
+{
+    DIR *d = opendir(".");
+    struct dirent *ent;
+    size_t len;
+    unsigned n = 0;
+    ck_assert(d);
+    while ((ent = readdir(d))) {
+        len = strlen(ent->d_name);
+        if (strncmp(ent->d_name, "ownership_", 10) == 0 &&
+            len > 4 && strcmp(ent->d_name + len - 4, ".dot") == 0) {
+            ++n;
+            if (remove) {
+                unlink(ent->d_name);
+            }
+        }
+    }
+    closedir(d);
+    return n;
+}
+
+START_TEST (test_ownership_dot_file) {
+    struct rir *r;
+    char *contents;
+    front_testdriver_new_ast_main_source(&s_dot);
+    ck_create_get_rir(r, 0);
+    test_ownership_dot_files(true);
+    ck_assert(ownership_pass(compiler_instance_get()));
+
+    // one file for the whole module, not one per function
+    ck_assert_uint_eq(test_ownership_dot_files(false), 1);
+    RFS_PUSH();
+    contents = test_ownership_read_file(
+        rf_string_data(RFS_NT_OR_DIE("ownership_"RFS_PF".dot", RFS_PA(&r->name)))
+    );
+    RFS_POP();
+    test_ownership_check_dot(contents, r);
+    free(contents);
+    test_ownership_dot_files(true);
+} END_TEST
+#endif
+
+#define TEST_OWNERSHIP_BENCH_ALLOCAS 3000
+
+START_TEST (test_ownership_many_allocas_benchmark) {
+    struct RFstringx src;
+    struct timespec start;
+    struct timespec end;
+    unsigned i;
+    ck_assert(rf_stringx_init_buff(
+        &src,
+        TEST_OWNERSHIP_BENCH_ALLOCAS * 64,
+        "type person {name:string, age:u32}\n"
+        "fn main() -> u32{\n"
+    ));
+    // every alloca gets its own graph and every use of it is an operand
+    // that needs to find that graph
+    RFS_PUSH();
+    for (i = 0; i < TEST_OWNERSHIP_BENCH_ALLOCAS; ++i) {
+        ck_assert(rf_stringx_append(
+            &src,
+            RFS("    p%u:person = person(\"a\", %u)\n    print(p%u.name)\n", i, i, i)
+        ));
+    }
+    RFS_POP();
+    ck_assert(rf_stringx_append_cstr(&src, "    return 0\n}\n"));
+    front_testdriver_new_ast_main_source(RF_STRX2STR(&src));
+    ck_assert_createrir_ok();
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ck_assert(ownership_pass(compiler_instance_get()));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf(
+        "ownership analysis of %u allocas: %.3f ms\n",
+        TEST_OWNERSHIP_BENCH_ALLOCAS,
+        (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0
+    );
+    rf_stringx_deinit(&src);
+} END_TEST
+
 Suite *ownership_suite_create(void)
 {
     Suite *s = suite_create("ownership");
@@ -39,8 +567,38 @@ Suite *ownership_suite_create(void)
                               setup_rir_tests,
                               teardown_rir_tests);
     tcase_add_test(tc1, test_usage_1);
+    tcase_add_test(tc1, test_ownership_callgraph_order);
+
+    TCase *tc2 = tcase_create("ownership_graphs");
+    tcase_add_checked_fixture(tc2,
+                              setup_rir_tests,
+                              teardown_rir_tests);
+    tcase_add_test(tc2, test_ownership_value_in_many_graphs);
+    tcase_add_test(tc2, test_ownership_passed_as_later_argument);
+    tcase_add_test(tc2, test_ownership_alloc_location);
+    tcase_add_test(tc2, test_ownership_parallel_modules);
+
+    TCase *tc3 = tcase_create("ownership_dot");
+    tcase_add_checked_fixture(tc3,
+                              setup_rir_tests_no_stdlib,
+                              teardown_rir_tests);
+    tcase_add_test(tc3, test_ownership_dot_write);
+#if RF_OPTION_OWNERSHIP_DOT
+    tcase_add_test(tc3, test_ownership_dot_file);
+#endif
 
     suite_add_tcase(s, tc1);
+    suite_add_tcase(s, tc2);
+    suite_add_tcase(s, tc3);
+
+    if (testsupport_benchmarks_enabled()) {
+        TCase *tc_bench = tcase_create("ownership_benchmarks");
+        tcase_add_checked_fixture(tc_bench,
+                                  setup_rir_tests,
+                                  teardown_rir_tests);
+        tcase_add_test(tc_bench, test_ownership_many_allocas_benchmark);
+        suite_add_tcase(s, tc_bench);
+    }
 
     return s;
 }
@@ -0,0 +1,241 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rfbase/string/core.h>
+
+#include <ir/rir.h>
+#include <ir/rir_binary.h>
+#include <ir/rir_function.h>
+
+#include "testsupport_rir.h"
+#include "../testsupport.h"
+
+#include CLIB_TEST_HELPERS
+
+#define TEST_BINARY_LOAD_ITERATIONS 100
+
+static const struct RFstring s_program = RF_STRING_STATIC_INIT(
+    "type foo {a:i32, b:f64}\n"
+    "fn add(a:i32, b:i32) -> i32 {\n"
+    "    return a + b\n"
+    "}\n"
+    "fn main() -> u32 {\n"
+    "    f:foo = foo(1, 2.5)\n"
+    "    arr:u32[3] = [1, 2, 3]\n"
+    "    sum:u32 = 0\n"
+    "    for a in arr {\n"
+    "        sum = sum + a\n"
+    "    }\n"
+    "    if add(f.a, 3) > 2 {\n"
+    "        return 1\n"
+    "    }\n"
+    "    return sum\n"
+    "}\n"
+);
+
+static const struct RFstring s_rir = RF_STRING_STATIC_INIT(
+    "$gstr_3855993015 = global(string, \"false\")\n"
+    "$gstr_3784272022 = global(string, \"foo\")\n"
+    "$gstr_706834940 = global(string, \"true\")\n"
+    "$internal_struct_4260204557 = uniondef(i64, u64, string)\n"
+    "fndef(other_function; string*; u32)\n"
+    "{\n"
+    "%function_start\n"
+    "    $3 = convert(14, u32)\n"
+    "    write(u32*, $1, $3)\n"
+    "    branch(%function_end)\n"
+    "%function_end\n"
+    "    $2 = read($1)\n"
+    "    return($2)\n"
+    "}\n"
+);
+
+static double test_elapsed_ms(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000.0 +
+        (end->tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static void ck_rir_equal_str(struct rir *expected, struct rir *got)
+{
+    struct RFstring *expected_s = rir_tostring(expected);
+    struct RFstring *got_s = rir_tostring(got);
+    ck_assert_msg(expected_s && got_s, "Could not turn the rir into a string");
+    ck_assert_msg(
+        rf_string_equal(expected_s, got_s),
+        "Binary rir round trip mismatch.\nExpected:\n"RFS_PF"\nGot:\n"RFS_PF,
+        RFS_PA(expected_s), RFS_PA(got_s)
+    );
+}
+
+static struct rir *ck_rir_binary_roundtrip(struct rir *r, struct rir_binary_buff *buff)
+{
+    struct rir_binary *rb;
+    struct rir *loaded;
+    darray_init(*buff);
+    ck_assert_msg(rir_binary_serialize(r, buff), "Failed to serialize the rir");
+    rb = rir_binary_open_buffer(
+        &darray_item(*buff, 0),
+        darray_size(*buff) * sizeof(uint32_t),
+        &r->dependencies
+    );
+    ck_assert_msg(rb, "Failed to open the serialized rir");
+    ck_assert_msg(rir_binary_materialize_all(rb), "Failed to materialize the rir");
+    loaded = rir_binary_rir(rb);
+    rir_binary_close(rb);
+    return loaded;
+}
+
+START_TEST (test_rir_binary_roundtrip_from_ast) {
+    struct rir *r;
+    struct rir *loaded;
+    struct rir_binary_buff buff;
+    front_testdriver_new_ast_main_source(&s_program);
+    ck_create_get_rir(r, 0);
+
+    loaded = ck_rir_binary_roundtrip(r, &buff);
+    ck_rir_equal_str(r, loaded);
+    rir_destroy(loaded);
+    darray_free(buff);
+} END_TEST
+
+START_TEST (test_rir_binary_lazy_file) {
+    struct rir *r;
+    struct rir_binary *rb;
+    struct rir_fndecl *decl;
+    struct rir_fndef *def;
+    char path[] = "/tmp/refu_test_rir_binary_XXXXXX";
+    int fd;
+    front_testdriver_new_ast_main_source(&s_program);
+    ck_create_get_rir(r, 0);
+
+    fd = mkstemp(path);
+    ck_assert_int_ne(fd, -1);
+    close(fd);
+    const struct RFstring spath = RF_STRING_SHALLOW_INIT_CSTR(path);
+    ck_assert_msg(rir_binary_write(r, &spath), "Failed to write the binary rir");
+    rb = rir_binary_open(&spath, &r->dependencies);
+    ck_assert_msg(rb, "Failed to open the binary rir file");
+
+    // bodies are only loaded on demand
+    rf_ilist_for_each(&rir_binary_rir(rb)->functions, decl, ln) {
+        if (!decl->plain_decl) {
+            def = rir_fndecl_to_fndef(decl);
+            ck_assert_uint_eq(darray_size(def->blocks), 0);
+            ck_assert(rir_binary_materialize(rb, def));
+            ck_assert_uint_ne(darray_size(def->blocks), 0);
+            // a second time is a no-op
+            ck_assert(rir_binary_materialize(rb, def));
+        }
+    }
+    ck_rir_equal_str(r, rir_binary_rir(rb));
+    rir_destroy(rir_binary_rir(rb));
+    rir_binary_close(rb);
+    unlink(path);
+} END_TEST
+
+START_TEST (test_rir_binary_roundtrip_from_rir) {
+    struct rir *r;
+    struct rir *loaded;
+    struct rir_binary_buff buff;
+    front_testdriver_new_rir_source(&s_rir, true);
+    ck_create_get_rir(r, 0);
+
+    loaded = ck_rir_binary_roundtrip(r, &buff);
+    ck_rir_equal_str(r, loaded);
+    rir_destroy(loaded);
+    darray_free(buff);
+} END_TEST
+
+START_TEST (test_rir_binary_reject_corrupt) {
+    struct rir *r;
+    struct rir_binary_buff buff;
+    uint32_t saved;
+    front_testdriver_new_ast_main_source(&s_program);
+    ck_create_get_rir(r, 0);
+
+    darray_init(buff);
+    ck_assert(rir_binary_serialize(r, &buff));
+    // wrong magic
+    saved = darray_item(buff, 0);
+    darray_item(buff, 0) = ~saved;
+    ck_assert(!rir_binary_open_buffer(&darray_item(buff, 0), darray_size(buff) * sizeof(uint32_t), NULL));
+    darray_item(buff, 0) = saved;
+    // truncated
+    ck_assert(!rir_binary_open_buffer(&darray_item(buff, 0), (darray_size(buff) - 1) * sizeof(uint32_t), NULL));
+    darray_free(buff);
+} END_TEST
+
+START_TEST (test_rir_binary_load_benchmark) {
+    struct rir *r;
+    struct rir_binary *rb;
+    struct rir_binary_buff buff;
+    struct timespec start;
+    struct timespec end;
+    double parse_ms;
+    double load_ms;
+    unsigned i;
+    front_testdriver_new_rir_source(&s_rir, true);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ck_create_get_rir(r, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    parse_ms = test_elapsed_ms(&start, &end);
+
+    darray_init(buff);
+    ck_assert(rir_binary_serialize(r, &buff));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < TEST_BINARY_LOAD_ITERATIONS; ++i) {
+        rb = rir_binary_open_buffer(
+            &darray_item(buff, 0),
+            darray_size(buff) * sizeof(uint32_t),
+            &r->dependencies
+        );
+        ck_assert(rb);
+        ck_assert(rir_binary_materialize_all(rb));
+        rir_destroy(rir_binary_rir(rb));
+        rir_binary_close(rb);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    load_ms = test_elapsed_ms(&start, &end) / TEST_BINARY_LOAD_ITERATIONS;
+    printf(
+        "rir load time: textual front end %.3f ms, binary %.3f ms (%u bytes)\n",
+        parse_ms, load_ms, (unsigned)(darray_size(buff) * sizeof(uint32_t))
+    );
+    darray_free(buff);
+} END_TEST
+
+Suite *rir_binary_suite_create(void)
+{
+    Suite *s = suite_create("rir_binary");
+
+    TCase *tc1 = tcase_create("rir_binary_from_ast");
+    tcase_add_checked_fixture(tc1,
+                              setup_rir_tests_no_stdlib,
+                              teardown_rir_tests);
+    tcase_add_test(tc1, test_rir_binary_roundtrip_from_ast);
+    tcase_add_test(tc1, test_rir_binary_lazy_file);
+    tcase_add_test(tc1, test_rir_binary_reject_corrupt);
+
+    TCase *tc2 = tcase_create("rir_binary_from_rir");
+    tcase_add_checked_fixture(tc2,
+                              setup_rir_tests_no_stdlib,
+                              teardown_rir_tests);
+    tcase_add_test(tc2, test_rir_binary_roundtrip_from_rir);
+
+    suite_add_tcase(s, tc1);
+    suite_add_tcase(s, tc2);
+
+    if (testsupport_benchmarks_enabled()) {
+        TCase *tc_bench = tcase_create("rir_binary_benchmarks");
+        tcase_add_checked_fixture(tc_bench,
+                                  setup_rir_tests_no_stdlib,
+                                  teardown_rir_tests);
+        tcase_add_test(tc_bench, test_rir_binary_load_benchmark);
+        suite_add_tcase(s, tc_bench);
+    }
+    return s;
+}
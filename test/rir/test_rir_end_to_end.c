@@ -42,6 +42,37 @@ START_TEST (test_rir_end_to_end_simple_module1) {
 
 } END_TEST
 
+START_TEST (test_rir_end_to_end_switch) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rir",
+
+            "fndef(main; nil; u32)\n"
+            "{\n"
+            "%function_start\n"
+            "    $2 = add(1, 1)\n"
+            "    switch($2, %label_3, 1, %label_1, 2, %label_2)\n"
+            "%label_1\n"
+            "    $3 = convert(10, u32)\n"
+            "    write(u32*, $0, $3)\n"
+            "    branch(%function_end)\n"
+            "%label_2\n"
+            "    $4 = convert(20, u32)\n"
+            "    write(u32*, $0, $4)\n"
+            "    branch(%function_end)\n"
+            "%label_3\n"
+            "    $5 = convert(30, u32)\n"
+            "    write(u32*, $0, $5)\n"
+            "    branch(%function_end)\n"
+            "%function_end\n"
+            "    $1 = read($0)\n"
+            "    return($1)\n"
+            "}\n"
+        )
+    };
+    ck_end_to_end_run(inputs, 20, NULL, "--rir test_input_file.rir");
+} END_TEST
+
 Suite *rir_end_to_end_suite_create(void)
 {
     Suite *s = suite_create("rir_end_to_end");
@@ -51,6 +82,7 @@ Suite *rir_end_to_end_suite_create(void)
                               setup_end_to_end_tests,
                               teardown_end_to_end_tests);
     tcase_add_test(tc1, test_rir_end_to_end_simple_module1);
+    tcase_add_test(tc1, test_rir_end_to_end_switch);
 
     suite_add_tcase(s, tc1);
     return s;
@@ -0,0 +1,224 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rfbase/string/core.h>
+
+#include <ir/rir.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/rir_interp.h>
+#include <ir/passes/rir_passes.h>
+#include <utils/stats.h>
+
+#include "testsupport_rir.h"
+#include "../testsupport.h"
+
+#include CLIB_TEST_HELPERS
+
+static const struct RFstring s_program = RF_STRING_STATIC_INIT(
+    "type foo {a:u32, b:u32}\n"
+    "fn scale(a:u32, b:u32) -> u32 {\n"
+    "    return a * b + 1\n"
+    "}\n"
+    "fn div(a:u32, b:u32) -> u32 {\n"
+    "    return a / b\n"
+    "}\n"
+    "fn main() -> u32 {\n"
+    "    f:foo = foo(3, 4)\n"
+    "    arr:u32[4] = [1, 2, 3, 4]\n"
+    "    sum:u32 = 0\n"
+    "    for a in arr {\n"
+    "        sum = sum + a\n"
+    "    }\n"
+    "    if sum > 5 {\n"
+    "        sum = sum + scale(f.a, f.b)\n"
+    "    }\n"
+    "    return sum\n"
+    "}\n"
+);
+
+static const struct RFstring s_fold = RF_STRING_STATIC_INIT(
+    "fn square(a:u32) -> u32 {\n"
+    "    return a * a\n"
+    "}\n"
+    "fn main() -> u32 {\n"
+    "    return square(6)\n"
+    "}\n"
+);
+
+static const struct RFstring s_main = RF_STRING_STATIC_INIT("main");
+static const struct RFstring s_scale = RF_STRING_STATIC_INIT("scale");
+static const struct RFstring s_div = RF_STRING_STATIC_INIT("div");
+
+START_TEST (test_rir_interp_run_main) {
+    struct rir *r;
+    struct rir_interp *in;
+    int retcode = 0;
+    front_testdriver_new_ast_main_source(&s_program);
+    ck_create_get_rir(r, 0);
+
+    in = rir_interp_create(r);
+    ck_assert(in);
+    ck_assert_msg(rir_interp_run_main(in, &retcode), "Failed to interpret main()");
+    ck_assert_int_eq(retcode, 23);
+    rir_interp_destroy(in);
+} END_TEST
+
+START_TEST (test_rir_interp_call) {
+    struct rir *r;
+    struct rir_interp *in;
+    const struct rir_fndef *fn;
+    union rir_interp_cell args[2];
+    union rir_interp_cell ret;
+    front_testdriver_new_ast_main_source(&s_program);
+    ck_create_get_rir(r, 0);
+
+    in = rir_interp_create(r);
+    ck_assert(in);
+    fn = rir_interp_fndef(in, &s_scale);
+    ck_assert(fn);
+    ck_assert(rir_interp_fn_is_pure(in, fn));
+    args[0].u = 7;
+    args[1].u = 6;
+    ck_assert(rir_interp_call(in, fn, args, &ret));
+    ck_assert_uint_eq(ret.u, 43);
+    // unsigned arithmetic wraps around at the width of the type
+    args[0].u = UINT32_MAX;
+    args[1].u = 2;
+    ck_assert(rir_interp_call(in, fn, args, &ret));
+    ck_assert_uint_eq(ret.u, UINT32_MAX);
+    rir_interp_destroy(in);
+} END_TEST
+
+START_TEST (test_rir_interp_errors) {
+    struct rir *r;
+    struct rir_interp *in;
+    const struct rir_fndef *fn;
+    union rir_interp_cell args[2];
+    union rir_interp_cell ret;
+    int retcode;
+    front_testdriver_new_ast_main_source(&s_program);
+    ck_create_get_rir(r, 0);
+
+    in = rir_interp_create(r);
+    ck_assert(in);
+    fn = rir_interp_fndef(in, &s_div);
+    ck_assert(fn);
+    args[0].u = 5;
+    args[1].u = 0;
+    ck_assert(!rir_interp_call(in, fn, args, &ret));
+    ck_assert(rir_interp_error(in));
+
+    // the loop of main() can't finish in a single block
+    rir_interp_set_step_limit(in, 1);
+    ck_assert(!rir_interp_run_main(in, &retcode));
+    // a failed call does not affect the next one
+    rir_interp_set_step_limit(in, 0);
+    ck_assert(rir_interp_run_main(in, &retcode));
+    ck_assert_int_eq(retcode, 23);
+    rir_interp_destroy(in);
+} END_TEST
+
+START_TEST (test_rir_interp_fold_pure_call) {
+    struct rir *r;
+    struct rir_interp *in;
+    struct rir_passes_stats stats;
+    const struct rir_fndef *fn;
+    struct rir_block **b;
+    struct rir_expression *e;
+    int retcode = 0;
+    front_testdriver_new_ast_main_source(&s_fold);
+    ck_create_get_rir(r, 0);
+
+    rir_passes_stats_init(&stats);
+    ck_assert(rir_passes_run_module(r, &stats));
+
+    in = rir_interp_create(r);
+    ck_assert(in);
+    fn = rir_interp_fndef(in, &s_main);
+    ck_assert(fn);
+    darray_foreach(b, fn->blocks) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            ck_assert_msg(e->type != RIR_EXPRESSION_CALL,
+                          "A call to a pure function was not folded");
+        }
+    }
+    ck_assert(rir_interp_run_main(in, &retcode));
+    ck_assert_int_eq(retcode, 36);
+    rir_interp_destroy(in);
+} END_TEST
+
+START_TEST (test_rir_passes_phases) {
+    static const char *passes[] = {
+        "inline", "constfold", "mem2reg", "copyelim", "dce", "loopopt"
+    };
+    struct rir *r;
+    struct rir_passes_stats stats;
+    FILE *f;
+    char *out;
+    const char *pos;
+    char name[32];
+    long size;
+    unsigned i;
+    front_testdriver_new_ast_main_source(&s_fold);
+    ck_create_get_rir(r, 0);
+
+    stats_enable();
+    stats_phase_begin("rir_passes");
+    rir_passes_stats_init(&stats);
+    ck_assert(rir_passes_run_module(r, &stats));
+    stats_phase_end();
+
+    ck_assert(f = tmpfile());
+    stats_print(f, STATS_FORMAT_JSON);
+    size = ftell(f);
+    ck_assert(size > 0);
+    rewind(f);
+    ck_assert(out = malloc(size + 1));
+    ck_assert_uint_eq(fread(out, 1, size, f), size);
+    out[size] = '\0';
+    fclose(f);
+    // every pass is a child of the phase it runs in, the only top level one
+    ck_assert_msg(strncmp(out, "{\"phases\":[{\"name\":\"rir_passes\",", 32) == 0,
+                  "Unexpected start of the statistics:\n%s", out);
+    ck_assert_msg(pos = strstr(out, "\"children\":[{"),
+                  "The passes are not nested in rir_passes:\n%s", out);
+    for (i = 0; i < sizeof(passes) / sizeof(passes[0]); ++i) {
+        snprintf(name, sizeof(name), "{\"name\":\"%s\",", passes[i]);
+        ck_assert_msg(strstr(pos, name),
+                      "No phase for pass \"%s\" in:\n%s", passes[i], out);
+    }
+    // constfold runs twice per function and accumulates in a single phase
+    pos = strstr(pos, "{\"name\":\"constfold\",");
+    ck_assert(pos);
+    ck_assert(!strstr(pos + 1, "{\"name\":\"constfold\","));
+    free(out);
+    stats_deinit();
+} END_TEST
+
+Suite *rir_interp_suite_create(void)
+{
+    Suite *s = suite_create("rir_interp");
+
+    TCase *tc1 = tcase_create("rir_interp_run");
+    tcase_add_checked_fixture(tc1,
+                              setup_rir_tests_no_stdlib,
+                              teardown_rir_tests);
+    tcase_add_test(tc1, test_rir_interp_run_main);
+    tcase_add_test(tc1, test_rir_interp_call);
+    tcase_add_test(tc1, test_rir_interp_errors);
+
+    TCase *tc2 = tcase_create("rir_interp_fold");
+    tcase_add_checked_fixture(tc2,
+                              setup_rir_tests_no_stdlib,
+                              teardown_rir_tests);
+    tcase_add_test(tc2, test_rir_interp_fold_pure_call);
+    tcase_add_test(tc2, test_rir_passes_phases);
+
+    suite_add_tcase(s, tc1);
+    suite_add_tcase(s, tc2);
+    return s;
+}
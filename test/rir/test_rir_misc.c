@@ -1,13 +1,24 @@
 #include <check.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <rfbase/string/core.h>
+#include <argtable/argtable3.h>
 #include <ast/ast.h>
 #include <ast/function.h>
+#include <compiler.h>
+#include <compiler_args.h>
+#include <module.h>
+#include <ir/rir_function.h>
+#include <ir/rir_interp.h>
+#include <ir/rir_object.h>
+#include <ir/rir_typedef.h>
+#include <utils/stats.h>
 
 #include "testsupport_rir.h"
+#include "../testsupport.h"
 
 #include CLIB_TEST_HELPERS
 
@@ -104,6 +115,203 @@ START_TEST (test_rir_type_map2) {
     rirtype_strmap_free(&map);
 } END_TEST
 
+START_TEST (test_rir_parallel_lowering) {
+    static const struct RFstring s = RF_STRING_STATIC_INIT(
+        "fn add(a:u32, b:u32) -> u32 {\n"
+        "    return a + b\n"
+        "}\n"
+        "fn sub(a:u32, b:u32) -> u32 {\n"
+        "    return a - b\n"
+        "}\n"
+        "fn mul(a:u32, b:u32) -> u32 {\n"
+        "    return a * b\n"
+        "}\n"
+        "fn main() -> u32 {\n"
+        "    return sub(mul(add(1, 2), 5), 3)\n"
+        "}\n"
+    );
+    static const struct RFstring names[] = {
+        RF_STRING_STATIC_INIT("add"),
+        RF_STRING_STATIC_INIT("sub"),
+        RF_STRING_STATIC_INIT("mul"),
+        RF_STRING_STATIC_INIT("main")
+    };
+    struct rir *r;
+    struct rir_fndecl *decl;
+    struct rir_interp *in;
+    unsigned i = 0;
+    int retcode = 0;
+    front_testdriver_new_ast_main_source(&s);
+    compiler_instance_get()->args->rir_jobs->ival[0] = 4;
+    ck_create_get_rir(r, 0);
+
+    // functions keep their source order no matter which thread lowered them
+    rf_ilist_for_each(&r->functions, decl, ln) {
+        ck_assert_uint_lt(i, 4);
+        ck_assert(rf_string_equal(&decl->name, &names[i]));
+        ck_assert_uint_ne(darray_size(rir_fndecl_to_fndef(decl)->blocks), 0);
+        ++i;
+    }
+    ck_assert_uint_eq(i, 4);
+
+    in = rir_interp_create(r);
+    ck_assert(in);
+    ck_assert(rir_interp_run_main(in, &retcode));
+    ck_assert_int_eq(retcode, 12);
+    rir_interp_destroy(in);
+} END_TEST
+
+static const struct RFstring s_jobs_program = RF_STRING_STATIC_INIT(
+    "type pair {a:u32, s:string}\n"
+    "fn first(a:u32) -> u32 {\n"
+    "    s:string = \"first\"\n"
+    "    if a > 3 {\n"
+    "        return a * 2\n"
+    "    } elif a > 1 {\n"
+    "        return a + 1\n"
+    "    }\n"
+    "    return a\n"
+    "}\n"
+    "fn second(a:u32) -> u32 {\n"
+    "    p:pair = pair(a, \"second\")\n"
+    "    if p.a == 2 {\n"
+    "        return 7\n"
+    "    }\n"
+    "    return p.a\n"
+    "}\n"
+    "fn third(a:u32) -> u32 {\n"
+    "    s:string = \"first\"\n"
+    "    t:string = \"third\"\n"
+    "    if a < 10 {\n"
+    "        return second(a)\n"
+    "    }\n"
+    "    return first(a)\n"
+    "}\n"
+    "fn main() -> u32 {\n"
+    "    return third(first(2))\n"
+    "}\n"
+);
+
+/**
+ * Lower s_jobs_program with @a jobs threads and copy what --print-rir would
+ * show into @a out
+ */
+static void test_rir_tostring_with_jobs(int jobs, struct RFstring *out)
+{
+    struct rir *r;
+    struct RFstring *str;
+    front_testdriver_new_ast_main_source(&s_jobs_program);
+    compiler_instance_get()->args->rir_jobs->ival[0] = jobs;
+    ck_create_get_rir(r, 0);
+    ck_assert((str = rir_tostring(r)));
+    ck_assert(rf_string_copy_in(out, str));
+}
+
+START_TEST (test_rir_parallel_lowering_same_output) {
+    struct RFstring sequential;
+    struct RFstring parallel;
+    test_rir_tostring_with_jobs(1, &sequential);
+    // a fresh compiler instance, so that nothing is left from the first run
+    teardown_rir_tests();
+    setup_rir_tests_no_stdlib();
+    test_rir_tostring_with_jobs(4, &parallel);
+
+    ck_assert_msg(
+        rf_string_equal(&sequential, &parallel),
+        "The RIR lowered with 1 and 4 jobs differs.\n"
+        "With 1 job:\n"RFS_PF"\nWith 4 jobs:\n"RFS_PF,
+        RFS_PA(&sequential), RFS_PA(&parallel)
+    );
+    rf_string_deinit(&sequential);
+    rf_string_deinit(&parallel);
+} END_TEST
+
+START_TEST (test_rir_parallel_lowering_stats) {
+    static const struct RFstring s = RF_STRING_STATIC_INIT(
+        "fn add(a:u32, b:u32) -> u32 {\n"
+        "    return a + b\n"
+        "}\n"
+        "fn sub(a:u32, b:u32) -> u32 {\n"
+        "    return a - b\n"
+        "}\n"
+        "fn mul(a:u32, b:u32) -> u32 {\n"
+        "    return a * b\n"
+        "}\n"
+        "fn main() -> u32 {\n"
+        "    return sub(mul(add(1, 2), 5), 3)\n"
+        "}\n"
+    );
+    struct rir *r;
+    struct rir_object *obj;
+    FILE *f;
+    char *out;
+    char *pos;
+    long size;
+    unsigned long long counted;
+    unsigned long long objects = 0;
+    front_testdriver_new_ast_main_source(&s);
+    compiler_instance_get()->args->rir_jobs->ival[0] = 4;
+    stats_enable();
+    stats_phase_begin("rir");
+    ck_create_get_rir(r, 0);
+    stats_phase_end();
+    rf_ilist_for_each(&r->objects, obj, ln) {
+        ++objects;
+    }
+
+    ck_assert(f = tmpfile());
+    stats_print(f, STATS_FORMAT_JSON);
+    size = ftell(f);
+    ck_assert(size > 0);
+    rewind(f);
+    ck_assert(out = malloc(size + 1));
+    ck_assert_uint_eq(fread(out, 1, size, f), size);
+    out[size] = '\0';
+    fclose(f);
+    ck_assert(pos = strstr(out, "{\"name\":\"rir\","));
+    ck_assert(pos = strstr(pos, "\"rir_objects\":"));
+    counted = strtoull(pos + strlen("\"rir_objects\":"), NULL, 10);
+    // the objects the lowering threads created reach the phase once they
+    // flush their counters. More may have been created and freed.
+    ck_assert_uint_ne(objects, 0);
+    ck_assert_msg(counted >= objects,
+                  "Counted %llu rir objects but the module has %llu",
+                  counted, objects);
+    free(out);
+    stats_deinit();
+} END_TEST
+
+START_TEST (test_rir_typedefs_shared_with_dependencies) {
+    static const struct RFstring s = RF_STRING_STATIC_INIT(
+        "type foo {a:u32, b:string}\n"
+        "fn main() -> u32 {\n"
+        "    f:foo = foo(1, \"hi\")\n"
+        "    print(f.b)\n"
+        "    return f.a\n"
+        "}\n"
+    );
+    struct rir *r;
+    struct rir *stdlib;
+    struct rir_typedef *def;
+    struct rir_typedef **idef;
+    front_testdriver_new_ast_main_source(&s);
+    ck_assert_createrir_ok();
+    r = front_testdriver_module()->rir;
+    ck_assert_uint_ne(darray_size(r->dependencies), 0);
+    stdlib = darray_item(r->dependencies, 0);
+
+    // the stdlib typedefs are the very same objects, not copies
+    ck_assert_uint_ne(darray_size(r->imported_typedefs), 0);
+    darray_foreach(idef, r->imported_typedefs) {
+        ck_assert(*idef == rir_typedef_byname(stdlib, &(*idef)->name));
+        ck_assert(*idef == rir_typedef_byname(r, &(*idef)->name));
+    }
+    // and the module only owns its own
+    rf_ilist_for_each(&r->typedefs, def, ln) {
+        ck_assert(!rir_typedef_byname(stdlib, &def->name));
+    }
+} END_TEST
+
 Suite *rir_misctest_suite_create(void)
 {
     Suite *s = suite_create("rir_miscellaneous_tests");
@@ -113,7 +321,23 @@ Suite *rir_misctest_suite_create(void)
     tcase_add_test(tc1, test_rir_type_map1);
     tcase_add_test(tc1, test_rir_type_map2);
 
+    TCase *tc2 = tcase_create("rir_parallel_lowering");
+    tcase_add_checked_fixture(tc2,
+                              setup_rir_tests_no_stdlib,
+                              teardown_rir_tests);
+    tcase_add_test(tc2, test_rir_parallel_lowering);
+    tcase_add_test(tc2, test_rir_parallel_lowering_same_output);
+    tcase_add_test(tc2, test_rir_parallel_lowering_stats);
+
+    TCase *tc3 = tcase_create("rir_typedef_registry");
+    tcase_add_checked_fixture(tc3,
+                              setup_rir_tests,
+                              teardown_rir_tests);
+    tcase_add_test(tc3, test_rir_typedefs_shared_with_dependencies);
+
     suite_add_tcase(s, tc1);
+    suite_add_tcase(s, tc2);
+    suite_add_tcase(s, tc3);
 
     return s;
 }
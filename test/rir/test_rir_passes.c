@@ -0,0 +1,427 @@
+#include <check.h>
+#include <stdbool.h>
+
+#include <rfbase/string/core.h>
+
+#include <module.h>
+#include <ir/rir.h>
+#include <ir/rir_code.h>
+#include <ir/rir_expression.h>
+#include <ir/rir_function.h>
+#include <ir/passes/rir_passes.h>
+#include "../../src/ir/passes/rir_cfg.h"
+#include "../../src/ir/passes/rir_loopinfo.h"
+#include "../../src/ir/passes/rir_pass_utils.h"
+
+#include "testsupport_rir.h"
+#include "../end_to_end/testsupport_end_to_end.h"
+
+#include CLIB_TEST_HELPERS
+
+static const struct RFstring s_ifelse = RF_STRING_STATIC_INIT(
+    "fn foo(a:u32) -> u32 {\n"
+    "    b:u32 = 1\n"
+    "    if a > 5 {\n"
+    "        b = 2\n"
+    "    } elif a > 2 {\n"
+    "        b = b + 5\n"
+    "    } else {\n"
+    "        b = 3\n"
+    "    }\n"
+    "    return b\n"
+    "}\n"
+);
+
+static const struct RFstring s_sumcall = RF_STRING_STATIC_INIT(
+    "fn add(a:u32, b:u32) -> u32 {\n"
+    "    return a + b\n"
+    "}\n"
+    "fn main() -> u32 {\n"
+    "    a:i64 = 3245\n"
+    "    print(a)\n"
+    "    print(\"x\")\n"
+    "    return add(2, 3)\n"
+    "}\n"
+);
+
+static const struct RFstring s_arrloop = RF_STRING_STATIC_INIT(
+    "fn foo() -> u32 {\n"
+    "    arr:u32[4] = [1, 2, 3, 4]\n"
+    "    sum:u32 = 0\n"
+    "    for a in arr {\n"
+    "        sum = sum + a\n"
+    "    }\n"
+    "    return sum\n"
+    "}\n"
+);
+
+static const struct RFstring s_retstruct = RF_STRING_STATIC_INIT(
+    "type pair {a:u32, b:u32}\n"
+    "fn make(a:u32) -> pair {\n"
+    "    return pair(a, 2)\n"
+    "}\n"
+);
+
+static const struct RFstring s_foo = RF_STRING_STATIC_INIT("foo");
+static const struct RFstring s_make = RF_STRING_STATIC_INIT("make");
+static const struct RFstring s_main = RF_STRING_STATIC_INIT("main");
+static const struct RFstring s_print_int64 = RF_STRING_STATIC_INIT("rf_stdlib_print_int64");
+static const struct RFstring s_print_string = RF_STRING_STATIC_INIT("rf_stdlib_print_string");
+
+static struct rir_fndef *test_get_fndef(struct rir *r, const struct RFstring *name)
+{
+    struct rir_fndecl *decl;
+    rf_ilist_for_each(&r->functions, decl, ln) {
+        if (!decl->plain_decl && rf_string_equal(&decl->name, name)) {
+            return rir_fndecl_to_fndef(decl);
+        }
+    }
+    ck_abort_msg("Could not find function \""RFS_PF"\" in the RIR", RFS_PA(name));
+    return NULL;
+}
+
+START_TEST (test_rir_cfg_dominators) {
+    struct rir *r;
+    struct rir_cfg cfg;
+    struct rir_cfg_node *n;
+    struct rir_cfg_node **p;
+    struct rir_cfg_node **f;
+    struct rir_cfg_node *entry;
+    bool found;
+    front_testdriver_new_ast_main_source(&s_ifelse);
+    ck_create_get_rir(r, 0);
+    ck_assert(rir_cfg_init(&cfg, test_get_fndef(r, &s_foo)));
+
+    entry = darray_item(cfg.rpo, 0);
+    ck_assert(entry == &darray_item(cfg.nodes, 0));
+    ck_assert(entry->idom == NULL);
+    darray_foreach(n, cfg.nodes) {
+        if (!rir_cfg_node_reachable(n)) {
+            continue;
+        }
+        ck_assert(rir_cfg_dominates(entry, n));
+        if (n != entry) {
+            ck_assert_msg(n->idom, "Reachable block without an immediate dominator");
+            ck_assert(n->idom->rpo < n->rpo);
+        }
+        // a join point is in the frontier of every predecessor that does
+        // not dominate it
+        if (darray_size(n->preds) < 2) {
+            continue;
+        }
+        darray_foreach(p, n->preds) {
+            if (rir_cfg_dominates(*p, n)) {
+                continue;
+            }
+            found = false;
+            darray_foreach(f, (*p)->frontier) {
+                found = found || *f == n;
+            }
+            ck_assert_msg(found, "Join block missing from a predecessor's dominance frontier");
+        }
+    }
+    rir_cfg_deinit(&cfg);
+} END_TEST
+
+START_TEST (test_rir_code_uses) {
+    struct rir *r;
+    struct rir_fndef *fn;
+    struct rir_code code;
+    struct rir_code_block *cb;
+    struct rir_instr *instr;
+    struct rir_instr *def;
+    const struct rir_value *v;
+    uint32_t var_operands = 0;
+    uint32_t uses = 0;
+    uint32_t instrs = 0;
+    uint32_t i;
+    unsigned n;
+    front_testdriver_new_ast_main_source(&s_ifelse);
+    ck_create_get_rir(r, 0);
+    fn = test_get_fndef(r, &s_foo);
+    ck_assert(rir_code_init(&code, fn));
+
+    ck_assert_uint_eq(darray_size(code.blocks), darray_size(fn->blocks));
+    darray_foreach(cb, code.blocks) {
+        ck_assert_uint_eq(cb->first, instrs);
+        rir_code_foreach_block_instr(&code, cb, instr) {
+            ck_assert(darray_item(code.blocks, instr->block).block == cb->block);
+            ck_assert_uint_eq(instr->op, instr->expr->type);
+            for (n = 0; n < instr->ops_num; ++n) {
+                if (rir_instr_ops(&code, instr)[n] >= code.vars_num) {
+                    continue;
+                }
+                v = rir_instr_operand(&code, instr, n);
+                ck_assert_uint_ne(rir_code_uses_num(&code, v), 0);
+                ++var_operands;
+                if ((def = rir_code_def(&code, v))) {
+                    ck_assert(&def->expr->val == v);
+                    ck_assert(def < instr || def->block != instr->block);
+                }
+            }
+            ++instrs;
+        }
+        if (cb->exit_op < code.vars_num) {
+            ++var_operands;
+        }
+    }
+    ck_assert_uint_eq(instrs, darray_size(code.instrs));
+    ck_assert_uint_eq(instrs, rir_fndef_expressions_num(fn));
+    // every use of a variable is linked in its list exactly once
+    for (i = 0; i < code.vars_num; ++i) {
+        uses += darray_item(code.uses_num, i);
+    }
+    ck_assert_uint_ne(uses, 0);
+    ck_assert_uint_eq(uses, var_operands);
+    rir_code_deinit(&code);
+} END_TEST
+
+START_TEST (test_rir_mem2reg_ifelse) {
+    struct rir *r;
+    struct rir_fndef *fn;
+    struct rir_passes_stats stats;
+    struct rir_block **b;
+    struct rir_expression *e;
+    unsigned phis = 0;
+    front_testdriver_new_ast_main_source(&s_ifelse);
+    ck_create_get_rir(r, 0);
+    fn = test_get_fndef(r, &s_foo);
+
+    rir_passes_stats_init(&stats);
+    ck_assert(rir_passes_run_module(r, &stats));
+    darray_foreach(b, fn->blocks) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            if (e->type == RIR_EXPRESSION_PHI) {
+                ++phis;
+                ck_assert_uint_ne(rir_phi_incoming_num(&e->phi), 0);
+            }
+            ck_assert_msg(
+                e->type != RIR_EXPRESSION_ALLOCA || !rir_type_is_elementary(e->alloca.type),
+                "An elementary local variable was not promoted"
+            );
+        }
+    }
+    ck_assert_uint_ne(phis, 0);
+} END_TEST
+
+START_TEST (test_rir_mem2reg_loop_run) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+
+            "fn main()->u32{\n"
+            "    arr:u32[5] = [1, 2, 3, 4, 5]\n"
+            "    sum:u32 = 0\n"
+            "    for a in arr {\n"
+            "        sum = sum + a\n"
+            "    }\n"
+            "    if sum > 10 { sum = sum - 10 }\n"
+            "    return sum\n"
+            "}")
+    };
+    ck_end_to_end_run(inputs, 5);
+} END_TEST
+
+START_TEST (test_rir_inline_sum_call) {
+    struct rir_fndef *fn;
+    struct rir_passes_stats stats;
+    struct rir_block **b;
+    struct rir_expression *e;
+    bool found_int64 = false;
+    bool found_string = false;
+    front_testdriver_new_ast_main_source(&s_sumcall);
+    ck_assert_createrir_ok();
+    fn = test_get_fndef(front_testdriver_module()->rir, &s_main);
+
+    rir_passes_stats_init(&stats);
+    ck_assert(rir_passes_run_module(front_testdriver_module()->rir, &stats));
+    darray_foreach(b, fn->blocks) {
+        // the match on the sum type's index is resolved at the call site
+        ck_assert((*b)->exit.type != RIR_BLOCK_EXIT_SWITCH);
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            if (e->type != RIR_EXPRESSION_CALL) {
+                continue;
+            }
+            ck_assert_msg(e->call.foreign, "Call to \""RFS_PF"\" was not inlined",
+                          RFS_PA(&e->call.name));
+            found_int64 = found_int64 || rf_string_equal(&e->call.name, &s_print_int64);
+            found_string = found_string || rf_string_equal(&e->call.name, &s_print_string);
+        }
+    }
+    ck_assert(found_int64);
+    ck_assert(found_string);
+} END_TEST
+
+START_TEST (test_rir_inline_sum_call_run) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+
+            "fn add(a:u32, b:u32) -> u32 {\n"
+            "    return a + b\n"
+            "}\n"
+            "fn main()->u32{\n"
+            "    a:i64 = 3245\n"
+            "    print(a)\n"
+            "    print(\"x\")\n"
+            "    return add(2, 3)\n"
+            "}")
+    };
+    static const struct RFstring output = RF_STRING_STATIC_INIT("3245x");
+    ck_end_to_end_run(inputs, 5, &output);
+} END_TEST
+
+START_TEST (test_rir_loops_array_iv) {
+    struct rir *r;
+    struct rir_fndef *fn;
+    struct rir_passes_stats stats;
+    struct rir_cfg cfg;
+    struct rir_loopinfo li;
+    struct rir_loop *l;
+    const struct rir_loop_iv *iv;
+    struct rir_cfg_node **n;
+    struct rir_expression *e;
+    unsigned objidx = 0;
+    front_testdriver_new_ast_main_source(&s_arrloop);
+    ck_create_get_rir(r, 0);
+    fn = test_get_fndef(r, &s_foo);
+
+    rir_passes_stats_init(&stats);
+    ck_assert(rir_passes_run_module(r, &stats));
+    ck_assert(rir_cfg_init(&cfg, fn));
+    ck_assert(rir_loopinfo_init(&li, &cfg));
+    ck_assert_uint_eq(darray_size(li.loops), 1);
+    l = darray_item(li.loops, 0);
+    ck_assert(l->preheader);
+    ck_assert(l->innermost);
+    ck_assert_uint_eq(l->depth, 1);
+    ck_assert_uint_eq(darray_size(l->latches), 1);
+
+    // the index of the loop counts from 0 up to the array's size
+    ck_assert_uint_eq(darray_size(l->ivs), 1);
+    iv = &darray_item(l->ivs, 0);
+    ck_assert_int_eq(iv->init, 0);
+    ck_assert_int_eq(iv->step, 1);
+    ck_assert(iv->bounded);
+    ck_assert_int_eq(iv->bound, 4);
+
+    darray_foreach(n, l->blocks) {
+        rf_ilist_for_each(&(*n)->block->expressions, e, ln) {
+            if (e->type == RIR_EXPRESSION_OBJIDX) {
+                ++objidx;
+                ck_assert_msg(e->objidx.inbounds, "Array access with the loop index not proven in bounds");
+            }
+        }
+    }
+    ck_assert_uint_eq(objidx, 1);
+    ck_assert(darray_item(l->latches, 0)->block->exit.branch.vectorize);
+    rir_loopinfo_deinit(&li);
+    rir_cfg_deinit(&cfg);
+} END_TEST
+
+START_TEST (test_rir_loops_nested_run) {
+    struct test_input_pair inputs[] = {
+        TEST_DECL_SRC(
+            "test_input_file.rf",
+
+            "fn main()->u32{\n"
+            "    arr:u32[3] = [1, 2, 3]\n"
+            "    sum:u32 = 0\n"
+            "    for a in arr {\n"
+            "        for b in arr {\n"
+            "            sum = sum + a * b\n"
+            "        }\n"
+            "    }\n"
+            "    return sum\n"
+            "}")
+    };
+    ck_end_to_end_run(inputs, 36);
+} END_TEST
+
+START_TEST (test_rir_copyelim_retslot) {
+    struct rir *r;
+    struct rir_fndef *fn;
+    struct rir_passes_stats stats;
+    struct rir_block **b;
+    struct rir_expression *e;
+    front_testdriver_new_ast_main_source(&s_retstruct);
+    ck_create_get_rir(r, 0);
+    fn = test_get_fndef(r, &s_make);
+    ck_assert(fn->retslot_val);
+
+    rir_passes_stats_init(&stats);
+    ck_assert(rir_passes_run_module(r, &stats));
+    // the pair is built in the return slot so nothing is copied into it
+    darray_foreach(b, fn->blocks) {
+        rf_ilist_for_each(&(*b)->expressions, e, ln) {
+            ck_assert_msg(e->type != RIR_EXPRESSION_WRITE || e->write.memory != fn->retslot_val,
+                          "The return slot is still written as a whole");
+            ck_assert_msg(e->type != RIR_EXPRESSION_ALLOCA,
+                          "The returned value still has its own allocation");
+        }
+    }
+} END_TEST
+
+Suite *rir_passes_suite_create(void)
+{
+    Suite *s = suite_create("rir_passes");
+
+    TCase *tc1 = tcase_create("rir_cfg");
+    tcase_add_checked_fixture(tc1,
+                              setup_rir_tests_no_stdlib,
+                              teardown_rir_tests);
+    tcase_add_test(tc1, test_rir_cfg_dominators);
+    tcase_add_test(tc1, test_rir_code_uses);
+
+    TCase *tc2 = tcase_create("rir_mem2reg");
+    tcase_add_checked_fixture(tc2,
+                              setup_rir_tests_no_stdlib,
+                              teardown_rir_tests);
+    tcase_add_test(tc2, test_rir_mem2reg_ifelse);
+
+    TCase *tc3 = tcase_create("rir_mem2reg_end_to_end");
+    tcase_add_checked_fixture(tc3,
+                              setup_end_to_end_tests,
+                              teardown_end_to_end_tests);
+    tcase_add_test(tc3, test_rir_mem2reg_loop_run);
+
+    TCase *tc4 = tcase_create("rir_inline");
+    tcase_add_checked_fixture(tc4,
+                              setup_rir_tests,
+                              teardown_rir_tests);
+    tcase_add_test(tc4, test_rir_inline_sum_call);
+
+    TCase *tc5 = tcase_create("rir_inline_end_to_end");
+    tcase_add_checked_fixture(tc5,
+                              setup_end_to_end_tests,
+                              teardown_end_to_end_tests);
+    tcase_add_test(tc5, test_rir_inline_sum_call_run);
+
+    TCase *tc6 = tcase_create("rir_loops");
+    tcase_add_checked_fixture(tc6,
+                              setup_rir_tests_no_stdlib,
+                              teardown_rir_tests);
+    tcase_add_test(tc6, test_rir_loops_array_iv);
+
+    TCase *tc7 = tcase_create("rir_loops_end_to_end");
+    tcase_add_checked_fixture(tc7,
+                              setup_end_to_end_tests,
+                              teardown_end_to_end_tests);
+    tcase_add_test(tc7, test_rir_loops_nested_run);
+
+    TCase *tc8 = tcase_create("rir_copyelim");
+    tcase_add_checked_fixture(tc8,
+                              setup_rir_tests_no_stdlib,
+                              teardown_rir_tests);
+    tcase_add_test(tc8, test_rir_copyelim_retslot);
+
+    suite_add_tcase(s, tc1);
+    suite_add_tcase(s, tc2);
+    suite_add_tcase(s, tc3);
+    suite_add_tcase(s, tc4);
+    suite_add_tcase(s, tc5);
+    suite_add_tcase(s, tc6);
+    suite_add_tcase(s, tc7);
+    suite_add_tcase(s, tc8);
+    return s;
+}
@@ -136,6 +136,7 @@ struct rir_fndef *testsupport_rir_add_fndef_impl(
     }
 
     // let's use same initialization rir parsing uses
+    rir_data_curr_fn(&get_rir_testdriver()->pctx) = def;
     if (!rir_fndecl_init(
             &def->decl,
             &sname,
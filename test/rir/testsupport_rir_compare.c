@@ -138,7 +138,8 @@ static bool ckr_compare_value(
         return false;
     }
 
-    if (!rf_string_equal(&got->id, &expect->id)) {
+    RFS_PUSH();
+    if (!rf_string_equal(rir_value_string(got), rir_value_string(expect))) {
         ck_abort_at(
             file,
             line,
@@ -149,8 +150,10 @@ static bool ckr_compare_value(
             RFS_PA(rir_value_string(expect)),
             RFS_PA(rir_value_string(got))
         );
+        RFS_POP();
         return false;
     }
+    RFS_POP();
 
     if (!rir_type_identical(got->type, expect->type)) {
         ck_abort_at(
@@ -488,6 +491,62 @@ static bool ckr_compare_returnstmt(
     return true;
 }
 
+static bool ckr_compare_switch(
+    struct rir_switch *got,
+    struct rir_switch *expect,
+    const char* file,
+    unsigned int line,
+    const struct RFstring *intro
+)
+{
+    unsigned int i;
+    ckr_compare_value(
+        got->cond,
+        expect->cond,
+        file,
+        line,
+        RFS(RFS_PF". At the condition. ", RFS_PA(intro))
+    );
+    ckr_compare_value(
+        got->fallthrough,
+        expect->fallthrough,
+        file,
+        line,
+        RFS(RFS_PF". At the fallthrough. ", RFS_PA(intro))
+    );
+    if (rir_switch_cases_num(got) != rir_switch_cases_num(expect)) {
+        ck_abort_at(
+            file,
+            line,
+            "Failure at RIR switch comparison",
+            RFS_PF". Expected %u cases but got %u.",
+            RFS_PA(intro),
+            rir_switch_cases_num(expect),
+            rir_switch_cases_num(got)
+        );
+        return false;
+    }
+    for (i = 0; i < rir_switch_cases_num(got); ++i) {
+        ckr_compare_value(
+            darray_item(got->cases, i).val,
+            darray_item(expect->cases, i).val,
+            file,
+            line,
+            RFS(RFS_PF". At the value of the "RFS_PF" case. ",
+                RFS_PA(intro), RFS_PA(rf_string_ordinal(i + 1)))
+        );
+        ckr_compare_value(
+            darray_item(got->cases, i).dst,
+            darray_item(expect->cases, i).dst,
+            file,
+            line,
+            RFS(RFS_PF". At the label of the "RFS_PF" case. ",
+                RFS_PA(intro), RFS_PA(rf_string_ordinal(i + 1)))
+        );
+    }
+    return true;
+}
+
 static bool ckr_compare_block(
     struct rir_block *got,
     struct rir_block *expect,
@@ -573,6 +632,17 @@ static bool ckr_compare_block(
                 RFS_PA(fn_name))
         );
         break;
+    case RIR_BLOCK_EXIT_SWITCH:
+        ckr_compare_switch(
+            &got->exit.switchbr,
+            &expect->exit.switchbr,
+            file,
+            line,
+            RFS("At the switch of the "RFS_PF" block of function \""RFS_PF"\"",
+                RFS_PA(rf_string_ordinal(bl_idx)),
+                RFS_PA(fn_name))
+        );
+        break;
     case RIR_BLOCK_EXIT_RETURN:
         ckr_compare_returnstmt(
             &got->exit.retstmt,
@@ -872,6 +942,40 @@ bool ckr_compare_expression(
         );
         break;
 
+    case RIR_EXPRESSION_PHI:
+    {
+        unsigned int i;
+        if (rir_phi_incoming_num(&got->phi) != rir_phi_incoming_num(&expect->phi)) {
+            ck_abort_at(
+                file,
+                line,
+                "Failure at a RIR phi() comparison",
+                RFS_PF" expected %u incoming values but got %u.",
+                RFS_PA(intro),
+                rir_phi_incoming_num(&expect->phi),
+                rir_phi_incoming_num(&got->phi)
+            );
+            return false;
+        }
+        for (i = 0; i < rir_phi_incoming_num(&got->phi); ++i) {
+            ckr_compare_value(
+                darray_item(got->phi.incoming, i).val,
+                darray_item(expect->phi.incoming, i).val,
+                file,
+                line,
+                RFS(RFS_PF". At the %u incoming value of a phi()", RFS_PA(intro), i)
+            );
+            ckr_compare_value(
+                darray_item(got->phi.incoming, i).block,
+                darray_item(expect->phi.incoming, i).block,
+                file,
+                line,
+                RFS(RFS_PF". At the %u incoming block of a phi()", RFS_PA(intro), i)
+            );
+        }
+    }
+        break;
+
         // should not get to such a comparison
     case RIR_EXPRESSION_RETURN:
     case RIR_EXPRESSION_CONSTANT:
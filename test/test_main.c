@@ -6,6 +6,7 @@
 
 Suite *lexer_suite_create(void);
 Suite *frontend_input_suite_create(void);
+Suite *stats_suite_create(void);
 Suite *parser_typedesc_suite_create(void);
 Suite *parser_generics_suite_create(void);
 Suite *parser_function_suite_create(void);
@@ -17,6 +18,7 @@ Suite *parser_ifexpr_suite_create(void);
 Suite *parser_matchexpr_suite_create(void);
 Suite *parser_modules_suite_create(void);
 Suite *parser_misc_suite_create(void);
+Suite *parser_info_suite_create(void);
 
 Suite *analyzer_symboltable_suite_create(void);
 Suite *analyzer_typecheck_suite_create(void);
@@ -27,6 +29,7 @@ Suite *analyzer_typecheck_functions_suite_create(void);
 Suite *analyzer_typecheck_matchexpr_suite_create(void);
 Suite *analyzer_typecheck_operators_suite_create(void);
 Suite *analyzer_modules_suite_create(void);
+Suite *analyzer_diagnostics_suite_create(void);
 
 Suite *types_suite_create(void);
 Suite *type_set_suite_create(void);
@@ -36,11 +39,17 @@ Suite *rir_creation_simple_suite_create(void);
 Suite *rir_parsing_suite_create(void);
 Suite *rir_end_to_end_suite_create(void);
 Suite *rir_misctest_suite_create(void);
+Suite *rir_passes_suite_create(void);
+Suite *rir_binary_suite_create(void);
+Suite *rir_interp_suite_create(void);
 
 Suite *ownership_suite_create(void);
 
+Suite *backend_llvm_types_suite_create(void);
+
 Suite *end_to_end_basic_suite_create(void);
 Suite *end_to_end_module_suite_create(void);
+Suite *end_to_end_cache_suite_create(void);
 
 static const char *SILENT = "CK_SILENT";
 static const char *MINIMAL = "CK_MINIMAL";
@@ -92,6 +101,7 @@ int main(int argc, char **argv)
     printf("\n\n=== Running refulang tests ===\n");
     SRunner *sr = srunner_create(lexer_suite_create());
     srunner_add_suite(sr, frontend_input_suite_create());
+    srunner_add_suite(sr, stats_suite_create());
     srunner_add_suite(sr, parser_typedesc_suite_create());
     srunner_add_suite(sr, parser_generics_suite_create());
     srunner_add_suite(sr, parser_function_suite_create());
@@ -103,6 +113,7 @@ int main(int argc, char **argv)
     srunner_add_suite(sr, parser_matchexpr_suite_create());
     srunner_add_suite(sr, parser_modules_suite_create());
     srunner_add_suite(sr, parser_misc_suite_create());
+    srunner_add_suite(sr, parser_info_suite_create());
 
     srunner_add_suite(sr, analyzer_symboltable_suite_create());
     srunner_add_suite(sr, analyzer_typecheck_suite_create());
@@ -113,6 +124,7 @@ int main(int argc, char **argv)
     srunner_add_suite(sr, analyzer_typecheck_matchexpr_suite_create());
     srunner_add_suite(sr, analyzer_typecheck_operators_suite_create());
     srunner_add_suite(sr, analyzer_modules_suite_create());
+    srunner_add_suite(sr, analyzer_diagnostics_suite_create());
 
     srunner_add_suite(sr, types_suite_create());
     srunner_add_suite(sr, type_set_suite_create());
@@ -122,11 +134,17 @@ int main(int argc, char **argv)
     srunner_add_suite(sr, rir_parsing_suite_create());
     srunner_add_suite(sr, rir_end_to_end_suite_create());
     srunner_add_suite(sr, rir_misctest_suite_create());
+    srunner_add_suite(sr, rir_passes_suite_create());
+    srunner_add_suite(sr, rir_binary_suite_create());
+    srunner_add_suite(sr, rir_interp_suite_create());
     
     srunner_add_suite(sr, ownership_suite_create());
 
+    srunner_add_suite(sr, backend_llvm_types_suite_create());
+
     srunner_add_suite(sr, end_to_end_basic_suite_create());
     srunner_add_suite(sr, end_to_end_module_suite_create());
+    srunner_add_suite(sr, end_to_end_cache_suite_create());
 
     srunner_set_fork_status (sr, fork_type);
     srunner_run_all(sr, print_type);
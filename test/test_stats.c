@@ -0,0 +1,123 @@
+#include <check.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/stats.h>
+
+#include "testsupport.h"
+
+#include CLIB_TEST_HELPERS
+
+/**
+ * @return What stats_print() writes in @a format. Free it with free().
+ */
+static char *test_stats_output(enum stats_format format)
+{
+    FILE *f = tmpfile();
+    char *ret;
+    long size;
+    ck_assert(f);
+    stats_print(f, format);
+    ck_assert(fseek(f, 0, SEEK_END) == 0);
+    size = ftell(f);
+    ck_assert(size >= 0);
+    rewind(f);
+    ret = malloc(size + 1);
+    ck_assert(ret);
+    ck_assert_uint_eq(fread(ret, 1, size, f), size);
+    ret[size] = '\0';
+    fclose(f);
+    return ret;
+}
+
+/**
+ * Assert that @a expected comes somewhere after @a *pos and move @a *pos
+ * right after it
+ */
+#define ck_assert_stats_next(pos_, expected_)                           \
+    do {                                                                \
+        const char *found_ = strstr(*(pos_), expected_);                \
+        ck_assert_msg(found_, "\"%s\" not found in:\n%s", expected_, *(pos_)); \
+        *(pos_) = found_ + strlen(expected_);                           \
+    } while (0)
+
+START_TEST (test_stats_json_phase_tree) {
+    char *out;
+    const char *pos;
+    stats_enable();
+    stats_phase_begin("outer");
+    stats_add(STATS_TOKENS, 3);
+    stats_phase_begin("inner");
+    stats_add(STATS_AST_NODES, 2);
+    stats_phase_end();
+    // same name and parent so it accumulates in the same phase
+    stats_phase_begin("inner");
+    stats_add(STATS_AST_NODES, 1);
+    stats_phase_end();
+    stats_phase_end();
+    stats_phase_begin("other");
+    stats_phase_end();
+
+    out = test_stats_output(STATS_FORMAT_JSON);
+    pos = out;
+    ck_assert_msg(strncmp(out, "{\"phases\":[{\"name\":\"outer\",", 27) == 0,
+                  "Unexpected start of the statistics:\n%s", out);
+    ck_assert_stats_next(&pos, "\"calls\":1,");
+    ck_assert_stats_next(&pos, "\"counters\":{\"tokens\":3,\"ast_nodes\":3,");
+    ck_assert_stats_next(&pos, "\"children\":[{\"name\":\"inner\",");
+    ck_assert_stats_next(&pos, "\"calls\":2,");
+    ck_assert_stats_next(&pos, "\"counters\":{\"tokens\":0,\"ast_nodes\":3,");
+    ck_assert_stats_next(&pos, "\"children\":[]}]},{\"name\":\"other\",");
+    ck_assert_stats_next(&pos, "\"children\":[]}]}\n");
+    ck_assert_str_eq(pos, "");
+    free(out);
+    stats_deinit();
+} END_TEST
+
+static void *test_stats_thread(void *unused)
+{
+    (void)unused;
+    stats_add(STATS_RIR_OBJECTS, 5);
+    stats_thread_flush();
+    // counted after the flush so it never reaches the totals
+    stats_add(STATS_RIR_OBJECTS, 7);
+    return NULL;
+}
+
+START_TEST (test_stats_thread_flush) {
+    pthread_t thread;
+    char *out;
+    const char *pos;
+    stats_enable();
+    stats_phase_begin("threads");
+    ck_assert_int_eq(pthread_create(&thread, NULL, test_stats_thread, NULL), 0);
+    ck_assert_int_eq(pthread_join(thread, NULL), 0);
+    stats_add(STATS_RIR_OBJECTS, 1);
+    stats_phase_end();
+
+    out = test_stats_output(STATS_FORMAT_JSON);
+    pos = out;
+    ck_assert_stats_next(&pos, "{\"name\":\"threads\",");
+    ck_assert_stats_next(&pos, "\"rir_objects\":6,");
+    free(out);
+    stats_deinit();
+} END_TEST
+
+Suite *stats_suite_create(void)
+{
+    Suite *s = suite_create("stats");
+
+    TCase *tc1 = tcase_create("stats_phases");
+    tcase_add_checked_fixture(tc1,
+                              setup_base_tests,
+                              teardown_base_tests);
+    tcase_add_test(tc1, test_stats_json_phase_tree);
+    tcase_add_test(tc1, test_stats_thread_flush);
+
+    suite_add_tcase(s, tc1);
+
+    return s;
+}
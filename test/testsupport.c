@@ -3,6 +3,7 @@
 #include <rfbase/refu.h>
 
 #include <check.h>
+#include <stdlib.h>
 
 void setup_base_tests()
 {
@@ -17,3 +18,9 @@ void teardown_base_tests()
 {
     rf_deinit();
 }
+
+bool testsupport_benchmarks_enabled()
+{
+    const char *v = getenv("REFU_TEST_BENCHMARKS");
+    return v && *v && *v != '0';
+}
@@ -4,10 +4,18 @@
 #include <rfbase/preprocessor/rf_xmacro_argcount.h>
 #include <rfbase/string/common.h>
 #include <check.h>
+#include <stdbool.h>
 
 void setup_base_tests();
 void teardown_base_tests();
 
+/**
+ * Benchmarks print their timings so they are only added to their suites if
+ * REFU_TEST_BENCHMARKS is set in the environment. `test.sh --benchmarks`
+ * sets it.
+ */
+bool testsupport_benchmarks_enabled();
+
 /**
  * Abort test at a specific location with a specific message
  */